@@ -0,0 +1,69 @@
+#!/bin/bash -e
+#
+# Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# Offsets vs. payloads: runs siege.x open loop at the same --rate against a dataset service,
+# once referencing the images by sysv_offset and once with --send_payload, and prints the
+# achieved rate and p99 latency of both as a markdown table for the README.
+#
+#   ./bench_dataset.sh <engine> <dataset_dir> <shape> [rate] [batch_size] [duration]
+#
+ENGINE=${1:?engine}
+DATASET_DIR=${2:?dataset_dir}
+SHAPE=${3:?shape, e.g. 3,224,224}
+RATE=${4:-2500}
+BATCH_SIZE=${5:-8}
+DURATION=${6:-30}
+BUILD=${BUILD:-/work/build/examples/02_TensorRT_GRPC}
+
+cleanup() {
+  kill $(jobs -p) ||:
+}
+trap "cleanup" EXIT SIGINT SIGTERM
+
+${BUILD}/dataset-grpc.x --dataset_dir=${DATASET_DIR} --shape=${SHAPE} --port=4444 &
+wait-for-it.sh localhost:4444 --timeout=0 -- echo "Dataset service is ready."
+${BUILD}/inference-grpc.x --engine=${ENGINE} --dataset=127.0.0.1:4444 &
+wait-for-it.sh localhost:50051 --timeout=0 -- echo "Inference service is ready."
+
+REPORTS=$(mktemp -d)
+for MODE in offsets payloads; do
+  FLAGS=""
+  if [ ${MODE} == "payloads" ]; then FLAGS="--send_payload"; fi
+  ${BUILD}/siege.x --dataset=127.0.0.1:4444 --batch_size=${BATCH_SIZE} --rate=${RATE} \
+    --duration=${DURATION} --json=${REPORTS}/${MODE}.json ${FLAGS}
+done
+
+echo
+echo "| siege ($(nproc) cores, batch ${BATCH_SIZE}) | offered req/s | achieved req/s | p99 ms |"
+echo "| ----------------------------- | ------------- | -------------- | ------ |"
+for MODE in offsets payloads; do
+  python3 -c "import json, sys; r = json.load(open(sys.argv[1])); \
+print('| %s | %d | %.0f | %.1f |' % (sys.argv[2], r['offered_rate'], r['achieved_rate'], \
+r['latency_us']['p99'] / 1000))" ${REPORTS}/${MODE}.json ${MODE}
+done
+rm -rf ${REPORTS}
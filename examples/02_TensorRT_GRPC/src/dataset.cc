@@ -0,0 +1,266 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/memory/allocator.h"
+#include "tensorrt/laboratory/core/memory/copy.h"
+#include "tensorrt/laboratory/core/memory/mapped_file.h"
+#include "tensorrt/laboratory/core/memory/system_v.h"
+#include "tensorrt/laboratory/core/resources.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+#include "nvrpc/service.h"
+
+#include "dataset.grpc.pb.h"
+#include "dataset.pb.h"
+
+using nvrpc::Context;
+using nvrpc::Executor;
+using nvrpc::Server;
+using trtlab::Allocator;
+using trtlab::MappedFile;
+using trtlab::Resources;
+using trtlab::SystemV;
+using trtlab::ThreadPool;
+
+/*
+ * SharedMemoryDataSet Service
+ *
+ * Loads a directory of preprocessed tensors into a single System V segment and serves the
+ * index of the segment.  The dataset directory holds one subdirectory per label, each with
+ * one file per image containing the raw tensor exactly as it is fed to the engine:
+ *
+ *   dataset/daisy/0001.bin
+ *   dataset/daisy/0002.bin
+ *   dataset/roses/0001.bin
+ *
+ * Images are placed back to back, each aligned to --alignment bytes, and are copied into the
+ * segment from memory mapped files by --load_threads workers.  Image sizes must be multiples
+ * of --alignment so a batch of consecutive images is one contiguous, unpadded range.
+ * Inference services and siege tools on the same host attach to the segment (see dataset.h)
+ * and send sysv_offsets.
+ */
+
+DEFINE_string(dataset_dir, "", "Directory of <label>/<image> preprocessed tensors");
+DEFINE_string(shape, "", "Comma separated tensor shape reported for every image, e.g. 3,224,224");
+DEFINE_int32(load_threads, 4, "Number of threads loading images into shared memory");
+DEFINE_int32(alignment, 256, "Byte alignment of each image in the segment");
+DEFINE_int32(port, 4444, "Port to listen for gRPC requests");
+
+namespace {
+std::vector<std::string> ListDirectory(const std::string& path, bool directories)
+{
+    std::vector<std::string> entries;
+    auto dir = opendir(path.c_str());
+    CHECK(dir) << "Unable to open directory " << path;
+    while(auto entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if(name == "." || name == "..")
+        {
+            continue;
+        }
+        struct stat stats;
+        CHECK_EQ(stat((path + "/" + name).c_str(), &stats), 0);
+        if(S_ISDIR(stats.st_mode) == directories)
+        {
+            entries.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+std::vector<int> ParseShape(const std::string& shape)
+{
+    std::vector<int> dims;
+    std::istringstream stream(shape);
+    std::string dim;
+    while(std::getline(stream, dim, ','))
+    {
+        dims.push_back(std::stoi(dim));
+    }
+    return dims;
+}
+
+size_t FileSize(const std::string& path)
+{
+    struct stat stats;
+    CHECK_EQ(stat(path.c_str(), &stats), 0) << "Unable to stat " << path;
+    return stats.st_size;
+}
+} // namespace
+
+class DataSetResources : public Resources
+{
+  public:
+    DataSetResources(const std::string& root, int load_threads, size_t alignment)
+    {
+        // build the index first so the segment is sized and allocated once
+        auto shape = ParseShape(FLAGS_shape);
+        size_t offset = 0;
+        for(const auto& label : ListDirectory(root, true))
+        {
+            auto label_index = m_Info.labels_size();
+            m_Info.add_labels(label);
+            for(const auto& filename : ListDirectory(root + "/" + label, false))
+            {
+                // an empty file holds no tensor and cannot be mapped
+                auto size = FileSize(root + "/" + label + "/" + filename);
+                if(size == 0)
+                {
+                    LOG(WARNING) << "Skipping empty file " << label << "/" << filename;
+                    continue;
+                }
+                // a batch is addressed by the offset of its first image, so padding between
+                // images would shift every image after the first
+                CHECK_EQ(size % alignment, 0UL)
+                    << label << "/" << filename << " is " << size << " bytes, not a multiple of "
+                    << "--alignment=" << alignment;
+                auto image = m_Info.add_images();
+                image->set_filename(label + "/" + filename);
+                image->set_label_index(label_index);
+                image->set_size(size);
+                image->set_sysv_offset(offset);
+                for(auto dim : shape)
+                {
+                    image->add_shape(dim);
+                }
+                offset += size;
+            }
+        }
+        CHECK(m_Info.images_size()) << "No images found in " << root;
+        LOG(INFO) << "Loading " << m_Info.images_size() << " images in " << m_Info.labels_size()
+                  << " labels; " << trtlab::BytesToString(offset);
+
+        m_Segment = std::make_unique<Allocator<SystemV>>(offset);
+        m_Info.set_sysv_key(m_Segment->ShmID());
+
+        // each worker copies a strided subset of the images; files are read through mappings
+        // so the only copy is from the page cache into the segment
+        auto start = std::chrono::steady_clock::now();
+        {
+            ThreadPool workers(load_threads);
+            std::vector<std::future<void>> loaded;
+            for(int t = 0; t < load_threads; t++)
+            {
+                loaded.push_back(workers.enqueue([this, &root, t, load_threads] {
+                    for(int i = t; i < m_Info.images_size(); i += load_threads)
+                    {
+                        const auto& image = m_Info.images(i);
+                        auto file = MappedFile::Open(root + "/" + image.filename());
+                        CHECK_EQ(file->Size(), image.size()) << image.filename() << " changed";
+                        trtlab::Copy(*m_Segment, image.sysv_offset(), *file, 0, image.size());
+                    }
+                }));
+            }
+            for(auto& f : loaded)
+            {
+                f.get();
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        LOG(INFO) << "Loaded dataset into shm_id=" << m_Segment->ShmID() << " in "
+                  << elapsed.count() << " seconds";
+    }
+
+    const Info& GetInfo() const { return m_Info; }
+
+  private:
+    Info m_Info;
+    std::unique_ptr<Allocator<SystemV>> m_Segment;
+};
+
+class GetInfoContext final : public Context<InfoRequest, Info, DataSetResources>
+{
+    void ExecuteRPC(RequestType& request, ResponseType& response) final override
+    {
+        // image_size = 0 requests the whole index; otherwise only images of that many bytes
+        const auto& info = GetResources()->GetInfo();
+        if(request.image_size() == 0)
+        {
+            response = info;
+        }
+        else
+        {
+            response.set_handle(info.handle());
+            response.set_sysv_key(info.sysv_key());
+            *response.mutable_labels() = info.labels();
+            for(const auto& image : info.images())
+            {
+                if(image.size() == request.image_size())
+                {
+                    *response.add_images() = image;
+                }
+            }
+        }
+        FinishResponse();
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    FLAGS_alsologtostderr = 1; // Log to console
+    ::google::InitGoogleLogging("dataset");
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    CHECK(!FLAGS_dataset_dir.empty()) << "--dataset_dir is required";
+
+    std::ostringstream ip_port;
+    ip_port << "0.0.0.0:" << FLAGS_port;
+    Server server(ip_port.str());
+
+    LOG(INFO) << "Register Service (SharedMemoryDataSet) with Server";
+    auto dataset = server.RegisterAsyncService<SharedMemoryDataSet>();
+    auto rpcGetInfo =
+        dataset->RegisterRPC<GetInfoContext>(&SharedMemoryDataSet::AsyncService::RequestGetInfo);
+
+    auto resources =
+        std::make_shared<DataSetResources>(FLAGS_dataset_dir, FLAGS_load_threads, FLAGS_alignment);
+
+    auto executor = server.RegisterExecutor(new Executor(1));
+    executor->RegisterContexts(rpcGetInfo, resources, 4);
+
+    LOG(INFO) << "Running Server";
+    server.Run();
+}
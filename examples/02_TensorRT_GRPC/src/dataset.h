@@ -0,0 +1,72 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <memory>
+#include <string>
+
+#include <glog/logging.h>
+#include <grpcpp/grpcpp.h>
+
+#include "tensorrt/laboratory/core/memory/system_v.h"
+
+#include "dataset.grpc.pb.h"
+#include "dataset.pb.h"
+
+/*
+ * Client side of the SharedMemoryDataSet service (dataset.cc)
+ *
+ * The dataset server owns a System V segment holding every image of the dataset back to back.
+ * Info::sysv_key is the shm_id of that segment and Image::sysv_offset the byte offset of each
+ * image in it, so a process on the same host attaches once and afterwards references images
+ * by offset instead of shipping their bytes in every request.
+ */
+struct SharedMemoryDataSetClient
+{
+    explicit SharedMemoryDataSetClient(const std::string& address, uint32_t image_size = 0)
+    {
+        InfoRequest request;
+        request.set_image_size(image_size);
+        grpc::ClientContext context;
+        auto channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+        auto stub = SharedMemoryDataSet::NewStub(channel);
+        auto status = stub->GetInfo(&context, request, &info);
+        CHECK(status.ok()) << "Dataset shared memory request to " << address
+                           << " failed: " << status.error_message();
+        LOG(INFO) << "Attaching dataset segment shm_id=" << info.sysv_key() << " with "
+                  << info.images_size() << " images";
+        segment = trtlab::SystemV::Attach(info.sysv_key());
+    }
+
+    const void* Data(const Image& image) const
+    {
+        CHECK_LE(image.sysv_offset() + image.size(), segment->Size());
+        return static_cast<const char*>(segment->Data()) + image.sysv_offset();
+    }
+
+    Info info;
+    trtlab::DescriptorHandle<trtlab::SystemV> segment;
+};
@@ -25,6 +25,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "nvml.h"
+#include <cuda_runtime.h>
 #include <chrono>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -38,27 +39,34 @@
 #include "tensorrt/laboratory/core/memory/allocator.h"
 #include "tensorrt/laboratory/cuda/device_info.h"
 #include "tensorrt/laboratory/cuda/memory/cuda_pinned_host.h"
+#include "tensorrt/laboratory/cuda/stream_trace.h"
 #include "tensorrt/laboratory/inference_manager.h"
 #include "tensorrt/laboratory/runtime.h"
 
 #include "nvrpc/context.h"
 #include "nvrpc/executor.h"
+#include "nvrpc/metrics.h"
 #include "nvrpc/server.h"
 #include "nvrpc/service.h"
 
+#include "dataset.h"
 #include "metrics.h"
 
 using nvrpc::AsyncRPC;
 using nvrpc::AsyncService;
 using nvrpc::Context;
 using nvrpc::Executor;
+using nvrpc::MetricsServer;
 using nvrpc::Server;
 using trtlab::Affinity;
 using trtlab::Allocator;
 using trtlab::CudaPinnedHostMemory;
 using trtlab::DeviceInfo;
 using trtlab::Metrics;
+using trtlab::RequestTrace;
+using trtlab::StreamTrace;
 using trtlab::ThreadPool;
+using trtlab::TraceScope;
 using trtlab::TensorRT::InferenceManager;
 using trtlab::TensorRT::ManagedRuntime;
 using trtlab::TensorRT::Model;
@@ -106,6 +114,11 @@ static auto& power_gauge_fam =
     prometheus::BuildGauge().Name("yais_gpus_power_usage").Register(registry);
 static auto& power_gauge = power_gauge_fam.Add({{"gpu", "0"}});
 
+// nvrpc Metrics - time spent blocked on the limited resources below; served together with the
+//                 per-context request latency and queue depths on --nvrpc_metrics
+static auto& buffers_wait = nvrpc::Metrics::ResourceWait("buffers");
+static auto& execution_contexts_wait = nvrpc::Metrics::ResourceWait("execution_contexts");
+
 /*
  * External Data Source
  *
@@ -113,7 +126,7 @@ static auto& power_gauge = power_gauge_fam.Add({{"gpu", "0"}});
  * Example: the results of an image decode service could use this mechanism to transfer
  *          large tensors to an inference service by simply passing an offset.
  */
-float* GetSharedMemory(const std::string& address);
+float* GetSharedMemory(const std::string& address, size_t* bytes);
 
 /*
  * YAIS Resources - TensorRT InferenceManager + ThreadPools + External Datasource
@@ -122,17 +135,25 @@ class FlowersResources : public InferenceManager
 {
   public:
     explicit FlowersResources(int max_executions, int max_buffers, int nCuda, int nResp,
-                              float* sysv_data)
+                              float* sysv_data, size_t sysv_bytes)
         : InferenceManager(max_executions, max_buffers), m_CudaThreadPool(nCuda),
-          m_ResponseThreadPool(nResp), m_SharedMemory(sysv_data)
+          m_ResponseThreadPool(nResp), m_SharedMemory(sysv_data), m_SharedMemorySize(sysv_bytes)
     {
     }
 
     ThreadPool& GetCudaThreadPool() { return m_CudaThreadPool; }
     ThreadPool& GetResponseThreadPool() { return m_ResponseThreadPool; }
 
+    // true if size bytes at offset_in_bytes lie within the segment and are float aligned
+    bool ValidSysvRange(size_t offset_in_bytes, size_t size) const
+    {
+        return offset_in_bytes % sizeof(float) == 0 && offset_in_bytes <= m_SharedMemorySize &&
+               size <= m_SharedMemorySize - offset_in_bytes;
+    }
+
     float* GetSysvOffset(size_t offset_in_bytes)
     {
+        DCHECK(ValidSysvRange(offset_in_bytes, 0));
         return &m_SharedMemory[offset_in_bytes / sizeof(float)];
     }
 
@@ -140,6 +161,7 @@ class FlowersResources : public InferenceManager
     ThreadPool m_CudaThreadPool;
     ThreadPool m_ResponseThreadPool;
     float* m_SharedMemory;
+    size_t m_SharedMemorySize;
 };
 
 /*
@@ -149,23 +171,62 @@ class FlowersContext final : public Context<BatchInput, BatchPredictions, Flower
 {
     void ExecuteRPC(RequestType& input, ResponseType& output) final override
     {
+        // the host input is bound to the inline tensor or to the shared memory it references,
+        // so either must cover the whole batch
+        auto model = GetResources()->GetModel("flowers");
+        auto expected = input.batch_size() * model->GetBinding(0).bytesPerBatchItem;
+        if(input.data().size() && input.data().size() != expected)
+        {
+            FinishWithError(::grpc::Status(
+                ::grpc::StatusCode::INVALID_ARGUMENT,
+                "data holds " + std::to_string(input.data().size()) + " bytes; expected " +
+                    std::to_string(expected) + " for batch_size " +
+                    std::to_string(input.batch_size())));
+            return;
+        }
+        if(!input.data().size() && !GetResources()->ValidSysvRange(input.sysv_offset(), expected))
+        {
+            FinishWithError(::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT,
+                                           "sysv_offset " + std::to_string(input.sysv_offset()) +
+                                               " is misaligned or " + std::to_string(expected) +
+                                               " bytes past it overrun the shared memory"));
+            return;
+        }
         // Executing on a Executor threads - we don't want to block message handling, so we offload
         GetResources()->GetCudaThreadPool().enqueue([this, &input, &output]() {
-            // Executed on a thread from CudaThreadPool
+            // Executed on a thread from CudaThreadPool; sampled requests trace their stages
+            TraceScope trace(TraceId());
             auto model = GetResources()->GetModel("flowers");
-            auto buffers = GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
+            auto buffers = buffers_wait.Time([this] {
+                return GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
+            });
             auto bindings = buffers->CreateBindings(model);
             bindings->SetBatchSize(input.batch_size());
-            bindings->SetHostAddress(0, GetResources()->GetSysvOffset(input.sysv_offset()));
+            // requests either carry the input tensor or reference it in shared memory
+            if(input.data().size())
+            {
+                bindings->SetHostAddress(0, (void*)input.data().data());
+            }
+            else
+            {
+                bindings->SetHostAddress(0, GetResources()->GetSysvOffset(input.sysv_offset()));
+            }
+            StreamTrace stream(TraceId(), bindings->Stream());
             bindings->CopyToDevice(bindings->InputBindings());
-            auto ctx =
-                GetResources()->GetExecutionContext(model); // <=== Limited Resource; May Block !!!
+            stream.Mark("h2d");
+            auto ctx = execution_contexts_wait.Time([this, &model] {
+                return GetResources()->GetExecutionContext(model); // <=== May Block !!!
+            });
+            stream.Mark("launch");
             ctx->Infer(bindings);
+            stream.Mark("compute");
             bindings->CopyFromDevice(bindings->OutputBindings());
+            stream.Mark("d2h");
             // All Async CUDA work has been queued - this thread's work is done.
             GetResources()->GetResponseThreadPool().enqueue([this, &input, &output, model, bindings,
                                                              ctx]() mutable {
                 // Executed on a thread from ResponseThreadPool
+                TraceScope trace(TraceId());
                 auto compute_time = ctx->Synchronize();
                 ctx.reset(); // Finished with the Execution Context - Release it to competing
                              // threads
@@ -227,7 +288,7 @@ static bool ValidateBytes(const char* flagname, const std::string& value)
 
 DEFINE_string(engine, "/path/to/tensorrt.engine", "TensorRT serialized engine");
 DEFINE_validator(engine, &ValidateEngine);
-DEFINE_string(dataset, "127.0.0.1:4444", "GRPC Dataset/SharedMemory Service Address");
+DEFINE_string(dataset, "", "GRPC Dataset/SharedMemory Service Address, e.g. 127.0.0.1:4444");
 DEFINE_int32(contexts, 1, "Number of Execution Contexts");
 DEFINE_int32(buffers, 0, "Number of Input/Output Buffers");
 DEFINE_string(runtime, "default", "TensorRT Runtime");
@@ -238,7 +299,10 @@ DEFINE_int32(postprocessing_threads, 2, "Number of postprocessing threads");
 DEFINE_string(max_recv_bytes, "10MiB", "Maximum number of bytes for incoming messages");
 DEFINE_validator(max_recv_bytes, &ValidateBytes);
 DEFINE_int32(port, 50051, "Port to listen for gRPC requests");
+DEFINE_string(unix_socket, "", "Listen on this Unix domain socket path instead of --port");
 DEFINE_int32(metrics, 50078, "Port to expose metrics for scraping");
+DEFINE_int32(nvrpc_metrics, 50079, "Port to expose nvrpc metrics for scraping");
+DEFINE_double(trace_sample_rate, 0.0, "Fraction of requests traced; GET /trace on nvrpc_metrics");
 
 int main(int argc, char* argv[])
 {
@@ -252,11 +316,13 @@ int main(int argc, char* argv[])
 
     // Enable metrics on port
     Metrics::Initialize(FLAGS_metrics);
+    MetricsServer nvrpc_metrics(FLAGS_nvrpc_metrics);
+    RequestTrace::SetSampleRate(FLAGS_trace_sample_rate);
 
-    // Create a gRPC server bound to IP:PORT
+    // Create a gRPC server bound to IP:PORT, or to a socket for clients on the same host
     std::ostringstream ip_port;
     ip_port << "0.0.0.0:" << FLAGS_port;
-    Server server(ip_port.str());
+    Server server(FLAGS_unix_socket.empty() ? ip_port.str() : "unix:" + FLAGS_unix_socket);
 
     // Modify MaxReceiveMessageSize
     auto bytes = trtlab::StringToBytes(FLAGS_max_recv_bytes);
@@ -284,12 +350,15 @@ int main(int argc, char* argv[])
 
     // Initialize Resources
     LOG(INFO) << "Initializing Resources for RPC (flowers::Inference::Compute)";
+    size_t sysv_bytes = 0;
+    auto sysv_data = GetSharedMemory(FLAGS_dataset, &sysv_bytes);
     auto rpcResources = std::make_shared<FlowersResources>(
         FLAGS_contexts, // number of IExecutionContexts - scratch space for DNN activations
         buffers, // number of host/device buffers for input/output tensors
         FLAGS_kernel_launching_threads, // number of threads used to execute cuda kernel launches
         FLAGS_postprocessing_threads, // number of threads used to write and complete responses
-        GetSharedMemory(FLAGS_dataset) // pointer to data in shared memory
+        sysv_data, // pointer to data in shared memory
+        sysv_bytes // size of the shared memory; requests are checked against it
     );
 
     std::shared_ptr<Runtime> runtime;
@@ -331,29 +400,25 @@ int main(int argc, char* argv[])
     });
 }
 
-static auto pinned_memory = std::make_unique<Allocator<CudaPinnedHostMemory>>(1024 * 1024 * 1024);
-
-float* GetSharedMemory(const std::string& address)
+float* GetSharedMemory(const std::string& address, size_t* bytes)
 {
-    /* data in shared memory should go here - for the sake of quick examples just use and emptry
-     * array */
-    pinned_memory->Fill((char)0);
-    return (float*)pinned_memory->Data();
-    // the following code connects to a shared memory service to allow for non-serialized transfers
-    // between microservices
-    /*
-    InfoRequest request;
-    Info reply;
-    grpc::ClientContext context;
-    auto channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
-    auto stub = SharedMemoryDataSet::NewStub(channel);
-    auto status = stub->GetInfo(&context, request, &reply);
-    CHECK(status.ok()) << "Dataset shared memory request failed";
-    DLOG(INFO) << "SysV ShmKey: " << reply.sysv_key();
-    int shmid = shmget(reply.sysv_key(), 0, 0);
-    DLOG(INFO) << "SysV ShmID: " << shmid;
-    float* data = (float*) shmat(shmid, 0, 0);
-    CHECK(data) << "SysV Attached failed";
-    return data;
-    */
+    if(address.empty())
+    {
+        // no dataset service; requests reference a zero filled pinned buffer
+        static auto pinned_memory =
+            std::make_unique<Allocator<CudaPinnedHostMemory>>(1024 * 1024 * 1024);
+        pinned_memory->Fill((char)0);
+        *bytes = pinned_memory->Size();
+        return (float*)pinned_memory->Data();
+    }
+
+    // attach to the segment of a SharedMemoryDataSet service (dataset.cc) for non-serialized
+    // transfers between microservices; registering it lets the H2D copies DMA directly
+    static auto dataset = std::make_unique<SharedMemoryDataSetClient>(address);
+    auto& segment = dataset->segment;
+    CHECK_EQ(cudaHostRegister(segment->Data(), segment->Size(), cudaHostRegisterDefault),
+             cudaSuccess)
+        << "Unable to register the dataset segment with CUDA";
+    *bytes = segment->Size();
+    return (float*)segment->Data();
 }
@@ -44,7 +44,10 @@
  *
  */
 
+
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -52,259 +55,152 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
-#include <grpc/support/log.h>
 #include <grpcpp/grpcpp.h>
-#include <thread>
 
+#include "dataset.h"
 #include "inference.grpc.pb.h"
 
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/client/load_generator.h"
 #include "tensorrt/laboratory/core/utils.h"
 
-using grpc::Channel;
-using grpc::ClientAsyncResponseReader;
-using grpc::ClientContext;
-using grpc::CompletionQueue;
-using grpc::Status;
+using nvrpc::client::ClientUnary;
+using nvrpc::client::CreateChannel;
+using nvrpc::client::Executor;
+using nvrpc::client::LoadGenerator;
+using nvrpc::client::LoadTarget;
+using nvrpc::client::UnaryLoadTarget;
 using ssd::BatchInput;
 using ssd::BatchPredictions;
 using ssd::Inference;
 
-static int g_BatchSize = 1;
-
-class GreeterClient
-{
-  public:
-    explicit GreeterClient(std::shared_ptr<Channel> channel, int max_outstanding)
-        : stub_(Inference::NewStub(channel)), m_OutstandingMessageCount(0),
-          m_MaxOutstandingMessageCount(max_outstanding)
-    {
-    }
-
-    // Assembles the client's payload and sends it to the server.
-    void SayHello(const size_t batch_id, const int batch_size, char* bytes, uint64_t total)
-    {
-        // Data we are sending to the server.
-        {
-            std::unique_lock<std::mutex> lock(m_Mutex);
-            m_OutstandingMessageCount++;
-            while(m_OutstandingMessageCount >= m_MaxOutstandingMessageCount)
-            {
-                LOG_FIRST_N(WARNING, 10) << "Initiated Backoff - (Siege Rate > Server Compute "
-                                            "Rate) - Server Queues are full.";
-                m_Condition.wait(lock);
-            }
-        }
-
-        auto start = std::chrono::high_resolution_clock::now();
-
-        BatchInput request;
-        request.set_batch_id(batch_id);
-        request.set_batch_size(batch_size);
-        if(total)
-        {
-            request.set_data(bytes, total);
-        }
-
-        // Call object to store rpc data
-        AsyncClientCall* call = new AsyncClientCall;
-
-        // stub_->PrepareAsyncSayHello() creates an RPC object, returning
-        // an instance to store in "call" but does not actually start the RPC
-        // Because we are using the asynchronous API, we need to hold on to
-        // the "call" instance in order to get updates on the ongoing RPC.
-        call->response_reader = stub_->PrepareAsyncCompute(&call->context, request, &cq_);
-
-        // StartCall initiates the RPC call
-        call->response_reader->StartCall();
-
-        // Request that, upon completion of the RPC, "reply" be updated with the
-        // server's response; "status" with the indication of whether the operation
-        // was successful. Tag the request with the memory address of the call object.
-        call->response_reader->Finish(&call->reply, &call->status, (void*)call);
-
-        float elapsed =
-            std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
-        m_RequestCalls++;
-        m_TotalRequestTime += elapsed;
-        // LOG_EVERY_N(INFO, 200) << "Request overhead: " << m_TotalRequestTime/m_RequestCalls;
-    }
-
-    // Loop while listening for completed responses.
-    // Prints out the response from the server.
-    void AsyncCompleteRpc()
-    {
-        void* got_tag;
-        bool ok = false;
-        size_t cntr = 0;
-        auto start = std::chrono::steady_clock::now();
-        float last = 0.0;
-
-        // Block until the next result is available in the completion queue "cq".
-        while(cq_.Next(&got_tag, &ok))
-        {
-            // The tag in this example is the memory location of the call object
-            AsyncClientCall* call = static_cast<AsyncClientCall*>(got_tag);
-
-            // Verify that the request was completed successfully. Note that "ok"
-            // corresponds solely to the request for updates introduced by Finish().
-            GPR_ASSERT(ok);
-
-            if(call->status.ok())
-            {
-                // std::cout << "Greeter received: " << call->reply.batch_id() << std::endl;
-            }
-            else
-            {
-                std::cout << "RPC failed" << std::endl;
-            }
-            // Once we're complete, deallocate the call object.
-            delete call;
-
-            cntr++;
-            float elapsed =
-                std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
-            if(elapsed - last > 0.5)
-            {
-                LOG(INFO) << "avg. rate: " << (float)cntr / (elapsed - last) << "( "
-                          << (float)(cntr * g_BatchSize) / (elapsed - last) << " inf/sec)";
-                last = elapsed;
-                cntr = 0;
-            }
-
-            {
-                std::unique_lock<std::mutex> lock(m_Mutex);
-                m_OutstandingMessageCount--;
-            }
-            m_Condition.notify_one();
-        }
-    }
-
-    void Shutdown() { cq_.Shutdown(); }
-
-  private:
-    // struct for keeping state and data information
-    struct AsyncClientCall
-    {
-        // Container for the data we expect from the server.
-        BatchPredictions reply;
-
-        // Context for the client. It could be used to convey extra information to
-        // the server and/or tweak certain RPC behaviors.
-        ClientContext context;
-
-        // Storage for the status of the RPC upon completion.
-        Status status;
-
-        std::unique_ptr<ClientAsyncResponseReader<BatchPredictions>> response_reader;
-    };
-
-    // Out of the passed in Channel comes the stub, stored here, our view of the
-    // server's exposed services.
-    std::unique_ptr<Inference::Stub> stub_;
-
-    // The producer-consumer queue we use to communicate asynchronously with the
-    // gRPC runtime.
-    CompletionQueue cq_;
-
-    // mutex to help control rate
-    std::mutex m_Mutex;
-    std::condition_variable m_Condition;
-    int m_OutstandingMessageCount;
-    int m_MaxOutstandingMessageCount;
-    float m_TotalRequestTime;
-    size_t m_RequestCalls;
-};
-
 static bool ValidateBytes(const char* flagname, const std::string& value)
 {
     trtlab::StringToBytes(value);
     return true;
 }
 
-DEFINE_int32(count, 1000000, "number of grpc messages to send");
-DEFINE_int32(batch_size, 1, "batch_size");
-DEFINE_int32(max_outstanding, 950, "maximum outstanding requests");
 DEFINE_int32(port, 50051, "server_port");
-DEFINE_double(rate, 1.0, "messages per second");
-DEFINE_double(max_rate, 100000, "maximum number of messages per second when func is applied");
-DEFINE_double(alpha, 0, "alpha");
-DEFINE_double(beta, 1, "beta");
-DEFINE_string(func, "constant", "constant, linear or cyclic");
+DEFINE_string(unix_socket, "", "connect to this Unix domain socket path instead of --port");
+DEFINE_double(rate, 1000, "requests per second offered to the server");
+DEFINE_string(arrivals, "poisson", "poisson or constant inter-arrival times");
+DEFINE_double(duration, 10, "seconds to send requests for");
+DEFINE_double(warmup, 1, "seconds at the start of --duration whose requests are not recorded");
+DEFINE_int32(threads, 1, "sender threads; each sends an equal share of --rate");
+DEFINE_int32(channels, 1, "gRPC channels, i.e. connections, requests are spread over");
+DEFINE_int32(client_threads, 1, "threads completing responses");
+DEFINE_int32(batch_size, 1, "batch_size");
 DEFINE_string(bytes, "0B", "add extra bytes to the request payload");
 DEFINE_validator(bytes, &ValidateBytes);
+DEFINE_string(dataset, "", "SharedMemoryDataSet service address; requests reference its images");
+DEFINE_bool(send_payload, false, "with --dataset, copy the images into the request payload");
+DEFINE_string(json, "", "write the report to this file instead of stdout");
 
 int main(int argc, char** argv)
 {
     FLAGS_alsologtostderr = 1; // It will dump to console
     ::google::ParseCommandLineFlags(&argc, &argv, true);
-
-    g_BatchSize = FLAGS_batch_size;
+    CHECK_LT(FLAGS_warmup, FLAGS_duration) << "--warmup is part of --duration";
 
     auto bytes = trtlab::StringToBytes(FLAGS_bytes);
-    char extra_bytes[bytes];
+    auto extra_bytes = std::make_shared<std::string>(bytes, '\0');
     if(bytes)
         LOG(INFO) << "Sending an addition " << trtlab::BytesToString(bytes)
                   << " bytes in request payload";
 
-    // using a fixed rate of 15us per rpc call.  i could adjust dynamically as i'm tracking
-    // the call overhead, but it's close enough.
-    auto start = std::chrono::system_clock::now();
-    auto walltime = [start]() -> double {
-        return std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
-    };
-    std::map<std::string, std::function<double()>> rates_by_name;
-    rates_by_name["constant"] = []() -> double { return std::min(FLAGS_rate, FLAGS_max_rate); };
-    rates_by_name["linear"] = [start, walltime]() -> double {
-        return std::min(FLAGS_rate + (FLAGS_alpha / 60.0) * walltime(), FLAGS_max_rate);
-    };
-    rates_by_name["cyclic"] = [start, walltime]() -> double {
-        return std::min(FLAGS_rate + FLAGS_alpha *
-                                         std::sin(2.0 * 3.14159 * (FLAGS_beta / 60.0) * walltime()),
-                        FLAGS_max_rate);
-    };
-    auto search = rates_by_name.find(FLAGS_func);
-    if(search == rates_by_name.end())
+    // With a dataset, each request is a batch of consecutive images referenced by the sysv_offset
+    // of the first, or with --send_payload the same bytes shipped in the request; comparing the
+    // two measures the cost of serializing the inputs.
+    std::shared_ptr<SharedMemoryDataSetClient> dataset;
+    if(!FLAGS_dataset.empty())
     {
-        LOG(FATAL) << "--func must be constant, linear or cyclic; your value = " << FLAGS_func;
+        dataset = std::make_shared<SharedMemoryDataSetClient>(FLAGS_dataset);
+        CHECK_GE(dataset->info.images_size(), FLAGS_batch_size);
+        LOG(INFO) << (FLAGS_send_payload ? "Sending image payloads" : "Sending image offsets");
     }
-    auto sleepy = [search]() -> double {
-        auto sleep_time = ((std::chrono::seconds(1) / std::max((search->second)(), 2.0))) -
-                          std::chrono::microseconds(15);
-        return std::chrono::duration<double>(sleep_time).count();
+
+    auto counter = std::make_shared<std::atomic<size_t>>(0);
+    auto request_fn = [dataset, extra_bytes, counter]() {
+        auto i = (*counter)++;
+        BatchInput request;
+        request.set_batch_id(i);
+        request.set_batch_size(FLAGS_batch_size);
+        if(dataset)
+        {
+            auto batches = dataset->info.images_size() / FLAGS_batch_size;
+            auto begin = (i % batches) * FLAGS_batch_size;
+            request.set_sysv_offset(dataset->info.images(begin).sysv_offset());
+            if(FLAGS_send_payload)
+            {
+                // the same bytes the offset references: the server packs images back to back
+                size_t total = 0;
+                for(int j = 0; j < FLAGS_batch_size; j++)
+                {
+                    total += dataset->info.images(begin + j).size();
+                }
+                auto data = request.mutable_data();
+                data->reserve(total);
+                for(int j = 0; j < FLAGS_batch_size; j++)
+                {
+                    const auto& image = dataset->info.images(begin + j);
+                    data->append(static_cast<const char*>(dataset->Data(image)), image.size());
+                }
+            }
+        }
+        // padding travels in its own field so it is never mistaken for the input tensor
+        if(extra_bytes->size())
+        {
+            request.set_padding(*extra_bytes);
+        }
+        return request;
     };
 
-    // Instantiate the client. It requires a channel, out of which the actual RPCs
-    // are created. This channel models a connection to an endpoint (in this case,
-    // localhost at port 50051). We indicate that the channel isn't authenticated
-    // (use of InsecureChannelCredentials()).
+    // one client per channel; the executor threads complete the responses of all of them
     std::ostringstream ip_port;
     ip_port << "localhost:" << FLAGS_port;
-
-    grpc::ChannelArguments ch_args;
-    ch_args.SetMaxReceiveMessageSize(-1);
-    GreeterClient greeter(
-        grpc::CreateCustomChannel(ip_port.str(), grpc::InsecureChannelCredentials(), ch_args),
-        FLAGS_max_outstanding);
-
-    // Spawn reader thread that loops indefinitely
-    std::thread thread_ = std::thread(&GreeterClient::AsyncCompleteRpc, &greeter);
-
-    for(size_t i = 0; i < FLAGS_count; i++)
+    auto address = FLAGS_unix_socket.empty() ? ip_port.str() : "unix:" + FLAGS_unix_socket;
+    auto executor = std::make_shared<Executor>(FLAGS_client_threads);
+    std::vector<std::shared_ptr<LoadTarget>> targets;
+    for(int i = 0; i < FLAGS_channels; i++)
     {
-        greeter.SayHello(i, FLAGS_batch_size, extra_bytes, bytes); // The actual RPC call!
-        auto start = std::chrono::high_resolution_clock::now();
-        while(std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start)
-                  .count() < sleepy())
-        {
-            std::this_thread::yield();
-        }
+        // distinct channel arguments keep gRPC from sharing one connection between channels
+        grpc::ChannelArguments ch_args;
+        ch_args.SetMaxReceiveMessageSize(-1);
+        ch_args.SetInt("siege.channel", i);
+        std::shared_ptr<Inference::Stub> stub = Inference::NewStub(CreateChannel(address, ch_args));
+        auto prepare_fn = [stub](::grpc::ClientContext* context, const BatchInput& request,
+                                 ::grpc::CompletionQueue* cq) {
+            return stub->PrepareAsyncCompute(context, request, cq);
+        };
+        auto client = std::make_shared<ClientUnary<BatchInput, BatchPredictions>>(prepare_fn,
+                                                                                   executor);
+        targets.push_back(
+            std::make_shared<UnaryLoadTarget<BatchInput, BatchPredictions>>(client, request_fn));
     }
 
-    greeter.Shutdown();
-    thread_.join(); // blocks forever
-    auto elapsed = walltime();
-    std::cout << FLAGS_count << " requests in " << elapsed
-              << "seconds; inf/sec: " << FLAGS_count * FLAGS_batch_size / elapsed << std::endl;
-
-    return 0;
+    LoadGenerator::Options options;
+    options.rate = FLAGS_rate;
+    options.arrivals = LoadGenerator::ArrivalsFromString(FLAGS_arrivals);
+    options.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(FLAGS_duration));
+    options.warmup = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(FLAGS_warmup));
+    options.threads = FLAGS_threads;
+
+    LOG(INFO) << "Offering " << FLAGS_rate << " requests/sec (" << FLAGS_arrivals << ") for "
+              << FLAGS_duration << " seconds over " << FLAGS_channels << " channel(s)";
+    auto report = LoadGenerator(options).Run(targets);
+    LOG(INFO) << report.completed * FLAGS_batch_size / report.elapsed << " inf/sec";
+
+    if(FLAGS_json.empty())
+    {
+        std::cout << report.ToJSON();
+    }
+    else
+    {
+        std::ofstream(FLAGS_json) << report.ToJSON();
+    }
+    return report.errors || report.outstanding ? 1 : 0;
 }
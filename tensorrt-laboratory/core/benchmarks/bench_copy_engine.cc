@@ -0,0 +1,91 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+#include "tensorrt/laboratory/core/memory/allocator.h"
+#include "tensorrt/laboratory/core/memory/copy_engine.h"
+#include "tensorrt/laboratory/core/memory/malloc.h"
+
+using namespace trtlab;
+
+namespace {
+struct Buffers
+{
+    Buffers(size_t size) : src(size), dst(size)
+    {
+        src.Fill(1);
+        dst.Fill(0);
+    }
+    Allocator<Malloc> src;
+    Allocator<Malloc> dst;
+};
+
+void CopyArgs(benchmark::internal::Benchmark* b)
+{
+    b->RangeMultiplier(8)->Range(4 * 1024, 256 * 1024 * 1024);
+}
+} // namespace
+
+static void BM_Copy_Memcpy(benchmark::State& state)
+{
+    Buffers buffers(state.range(0));
+    for(auto _ : state)
+    {
+        std::memcpy(buffers.dst.Data(), buffers.src.Data(), state.range(0));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Copy_Streaming(benchmark::State& state)
+{
+    Buffers buffers(state.range(0));
+    for(auto _ : state)
+    {
+        CopyEngine::StreamingCopy(buffers.dst.Data(), buffers.src.Data(), state.range(0));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Copy_CopyEngine(benchmark::State& state)
+{
+    Buffers buffers(state.range(0));
+    CopyEngine engine(Affinity::GetAffinity());
+    for(auto _ : state)
+    {
+        engine.Copy(buffers.dst, 0, buffers.src, 0, state.range(0));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Copy_Memcpy)->Apply(CopyArgs)->UseRealTime();
+BENCHMARK(BM_Copy_Streaming)->Apply(CopyArgs)->UseRealTime();
+BENCHMARK(BM_Copy_CopyEngine)->Apply(CopyArgs)->UseRealTime();
@@ -26,6 +26,7 @@
  */
 #include <benchmark/benchmark.h>
 
+#include "tensorrt/laboratory/core/affinity.h"
 #include "tensorrt/laboratory/core/memory/allocator.h"
 #include "tensorrt/laboratory/core/memory/malloc.h"
 #include "tensorrt/laboratory/core/memory/system_v.h"
@@ -52,5 +53,46 @@ static void BM_Memory_SystemV_descriptor(benchmark::State& state)
     }
 }
 
+/*
+ * Startup cost of a large host allocation that is fully faulted in before first use; the
+ * argument is the allocation size in GiB.  Fill(0) is the single threaded idiom used by the
+ * examples, FirstTouch spreads the faults over every cpu in the process affinity mask.
+ */
+static void BM_Memory_Malloc_SerialFill(benchmark::State& state)
+{
+    size_t size = state.range(0) << 30;
+    for(auto _ : state)
+    {
+        Allocator<Malloc> memory(size);
+        memory.Fill(0);
+    }
+}
+
+static void BM_Memory_Malloc_FirstTouchZero(benchmark::State& state)
+{
+    size_t size = state.range(0) << 30;
+    FirstTouch touch(Affinity::GetAffinity(), true);
+    for(auto _ : state)
+    {
+        Allocator<Malloc> memory(size, touch);
+    }
+}
+
+static void BM_Memory_Malloc_FirstTouchPrefault(benchmark::State& state)
+{
+    size_t size = state.range(0) << 30;
+    FirstTouch touch(Affinity::GetAffinity());
+    for(auto _ : state)
+    {
+        Allocator<Malloc> memory(size, touch);
+    }
+}
+
 BENCHMARK(BM_Memory_SystemMalloc);
-BENCHMARK(BM_Memory_SystemV_descriptor);
\ No newline at end of file
+BENCHMARK(BM_Memory_SystemV_descriptor);
+BENCHMARK(BM_Memory_Malloc_SerialFill)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Memory_Malloc_FirstTouchZero)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Memory_Malloc_FirstTouchPrefault)
+    ->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,158 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/response_cache.h"
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using trtlab::RequestDigest;
+using trtlab::ResponseCache;
+using trtlab::ResponseCacheKey;
+
+namespace {
+
+constexpr std::size_t kInputs = 1024;
+constexpr std::size_t kOutputs = 64;
+constexpr std::size_t kDistinct = 4096;
+
+using Output = std::vector<float>;
+
+// CPU stand-in for a model: one dense layer, kInputs x kOutputs multiply-adds
+Output Compute(const std::vector<float>& weights, const std::vector<float>& input)
+{
+    Output output(kOutputs);
+    for(std::size_t o = 0; o < kOutputs; o++)
+    {
+        float sum = 0.0f;
+        for(std::size_t i = 0; i < kInputs; i++)
+        {
+            sum += weights[o * kInputs + i] * input[i];
+        }
+        output[o] = std::max(sum, 0.0f);
+    }
+    return output;
+}
+
+// inverse CDF sampling of a Zipf distribution over [0, n)
+class Zipf
+{
+  public:
+    Zipf(std::size_t n, double s) : m_Cdf(n)
+    {
+        double sum = 0.0;
+        for(std::size_t k = 0; k < n; k++)
+        {
+            sum += 1.0 / std::pow(k + 1, s);
+            m_Cdf[k] = sum;
+        }
+        for(auto& p : m_Cdf)
+        {
+            p /= sum;
+        }
+    }
+
+    template<typename Generator>
+    std::size_t operator()(Generator& generator)
+    {
+        auto u = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+        auto k = std::lower_bound(m_Cdf.begin(), m_Cdf.end(), u) - m_Cdf.begin();
+        return std::min<std::size_t>(k, m_Cdf.size() - 1);
+    }
+
+  private:
+    std::vector<double> m_Cdf;
+};
+
+} // namespace
+
+// requests for kDistinct inputs of 4 KiB drawn with Zipf exponent state.range(1) / 100;
+// state.range(0) is the cache capacity in KiB, 0 disables the cache
+static void BM_ResponseCache_Zipf(benchmark::State& state)
+{
+    using clock = std::chrono::steady_clock;
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> weights(kInputs * kOutputs);
+    for(auto& w : weights)
+    {
+        w = uniform(generator);
+    }
+    std::vector<std::vector<float>> inputs(kDistinct, std::vector<float>(kInputs));
+    for(auto& input : inputs)
+    {
+        for(auto& x : input)
+        {
+            x = uniform(generator);
+        }
+    }
+
+    Zipf zipf(kDistinct, state.range(1) / 100.0);
+    const std::size_t capacity = state.range(0) << 10;
+    ResponseCache<Output> cache(capacity);
+    std::vector<double> latencies;
+
+    for(auto _ : state)
+    {
+        const auto& input = inputs[zipf(generator)];
+        auto start = clock::now();
+        std::shared_ptr<const Output> output;
+        ResponseCacheKey key;
+        if(capacity)
+        {
+            key = ResponseCacheKey{
+                "dense", "1", RequestDigest().Append(input.data(), input.size() * sizeof(float))};
+            output = cache.Find(key);
+        }
+        if(!output)
+        {
+            output = std::make_shared<const Output>(Compute(weights, input));
+            if(capacity)
+            {
+                cache.Insert(key, output, kOutputs * sizeof(float));
+            }
+        }
+        benchmark::DoNotOptimize(output->data());
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(clock::now() - start).count());
+    }
+
+    auto stats = cache.GetStats();
+    auto lookups = stats.hits + stats.misses;
+    state.counters["hit_rate"] = lookups ? static_cast<double>(stats.hits) / lookups : 0.0;
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p50_us"] = latencies[latencies.size() / 2];
+    state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+}
+BENCHMARK(BM_ResponseCache_Zipf)
+    ->ArgNames({"cache_kib", "zipf_s"})
+    ->Args({0, 100})
+    ->Args({64, 100})
+    ->Args({256, 100})
+    ->Args({64, 120})
+    ->UseRealTime();
@@ -53,4 +53,23 @@ static void BM_HybridThreadPool_Enqueue(benchmark::State& state)
         future.get();
     }
 }
-BENCHMARK(BM_HybridThreadPool_Enqueue);
\ No newline at end of file
+BENCHMARK(BM_HybridThreadPool_Enqueue);
+
+static void BM_InstrumentedThreadPool_Enqueue(benchmark::State& state)
+{
+    using trtlab::BaseThreadPool;
+    using trtlab::ThreadPoolStats;
+    auto pool =
+        std::make_unique<BaseThreadPool<std::mutex, std::condition_variable, ThreadPoolStats>>(1);
+
+    for(auto _ : state)
+    {
+        auto future = pool->enqueue([] {});
+        future.get();
+    }
+
+    auto stats = pool->Stats().GetSnapshot();
+    state.counters["wait_p50_ns"] = stats.wait.Percentile(50);
+    state.counters["run_p50_ns"] = stats.run.Percentile(50);
+}
+BENCHMARK(BM_InstrumentedThreadPool_Enqueue);
@@ -0,0 +1,88 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/timer_wheel.h"
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+using trtlab::TimerWheel;
+
+static std::vector<std::chrono::milliseconds> RandomTimeouts(std::size_t count)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> dist(1, 60000);
+    std::vector<std::chrono::milliseconds> timeouts(count);
+    for(auto& t : timeouts)
+    {
+        t = std::chrono::milliseconds(dist(rng));
+    }
+    return timeouts;
+}
+
+static void BM_TimerWheel_ScheduleCancel(benchmark::State& state)
+{
+    const std::size_t count = state.range(0);
+    auto timeouts = RandomTimeouts(count);
+    auto start = TimerWheel::clock::now();
+    TimerWheel wheel(std::chrono::milliseconds(1), start);
+    std::vector<TimerWheel::TimerId> ids(count);
+
+    for(auto _ : state)
+    {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            ids[i] = wheel.Schedule(start + timeouts[i], [] {});
+        }
+        for(std::size_t i = 0; i < count; i++)
+        {
+            wheel.Cancel(ids[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+BENCHMARK(BM_TimerWheel_ScheduleCancel)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+static void BM_TimerWheel_ScheduleFire(benchmark::State& state)
+{
+    const std::size_t count = state.range(0);
+    auto timeouts = RandomTimeouts(count);
+    auto start = TimerWheel::clock::now();
+    std::size_t fired = 0;
+
+    for(auto _ : state)
+    {
+        TimerWheel wheel(std::chrono::milliseconds(1), start);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            wheel.Schedule(start + timeouts[i], [&fired] { fired++; });
+        }
+        wheel.Advance(start + std::chrono::seconds(61));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    benchmark::DoNotOptimize(fired);
+}
+BENCHMARK(BM_TimerWheel_ScheduleFire)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
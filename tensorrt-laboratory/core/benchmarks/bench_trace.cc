@@ -0,0 +1,56 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/trace.h"
+#include <benchmark/benchmark.h>
+
+using trtlab::RequestTrace;
+using trtlab::TraceScope;
+using trtlab::TraceSpan;
+
+// The tracing cost of one request of the InferRunner pipeline: sampled once where it enters
+// the process, then handed across three thread pools recording a span per stage.
+static void BM_RequestTrace_Request(benchmark::State& state)
+{
+    RequestTrace::SetSampleRate(state.range(0) / 10000.0);
+    for(auto _ : state)
+    {
+        TraceScope request(RequestTrace::Sample());
+        for(int pool = 0; pool < 3; pool++)
+        {
+            auto trace = RequestTrace::Current();
+            auto queued = RequestTrace::Stamp(trace);
+            TraceScope scope(trace);
+            RequestTrace::RecordSince(trace, "queue", queued);
+            TraceSpan first("stage");
+            TraceSpan second("stage");
+        }
+    }
+    RequestTrace::SetSampleRate(0.0);
+    state.SetItemsProcessed(state.iterations());
+}
+// sample rate in basis points: off, 1% and every request
+BENCHMARK(BM_RequestTrace_Request)->Arg(0)->Arg(100)->Arg(10000);
@@ -26,12 +26,572 @@
  */
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/utils.h"
 
 namespace trtlab {
 
-template<typename CompleterFn>
+template<typename T>
+class AsyncFuture;
+
+template<typename T>
+class AsyncPromise;
+
+namespace detail {
+
+struct AsyncUnit
+{
+};
+
+template<typename T>
+using AsyncStorage = std::conditional_t<std::is_void<T>::value, AsyncUnit, T>;
+
+/**
+ * @brief Shared state between an AsyncPromise and its AsyncFuture
+ *
+ * The producer and the consumer race on a single atomic.  Both sides publish their
+ * half (value or continuation) and then attempt to CAS the state out of Pending.  Exactly
+ * one side wins; the loser is responsible for running the continuation.  No mutex is
+ * taken on either path.
+ *
+ * - continuation attached first: the producer runs it inline on the completing thread
+ * - value set first: the consumer runs it inline on the attaching thread
+ */
+template<typename T>
+class AsyncSharedState
+{
+    enum class State : int
+    {
+        Pending,
+        Continuation,
+        Ready
+    };
+
+  public:
+    AsyncSharedState() : m_State(State::Pending) {}
+
+    DELETE_COPYABILITY(AsyncSharedState);
+    DELETE_MOVEABILITY(AsyncSharedState);
+
+    template<typename... Args>
+    void SetValue(Args&&... args)
+    {
+        CHECK(!m_Value && !m_Exception) << "AsyncPromise already satisfied";
+        m_Value.emplace(std::forward<Args>(args)...);
+        Complete();
+    }
+
+    void SetException(std::exception_ptr exception)
+    {
+        CHECK(!m_Value && !m_Exception) << "AsyncPromise already satisfied";
+        m_Exception = exception;
+        Complete();
+    }
+
+    void SetContinuation(std::function<void()> continuation)
+    {
+        CHECK(!m_Continuation) << "AsyncFuture supports only a single continuation";
+        m_Continuation = std::move(continuation);
+        auto expected = State::Pending;
+        if(!m_State.compare_exchange_strong(expected, State::Continuation,
+                                            std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            DCHECK(expected == State::Ready);
+            RunContinuation();
+        }
+    }
+
+    bool IsReady() const { return m_State.load(std::memory_order_acquire) == State::Ready; }
+    bool HasException() const { return (bool)m_Exception; }
+    std::exception_ptr Exception() const { return m_Exception; }
+
+    AsyncStorage<T>& Value()
+    {
+        if(m_Exception) std::rethrow_exception(m_Exception);
+        return *m_Value;
+    }
+
+  private:
+    void Complete()
+    {
+        auto expected = State::Pending;
+        if(!m_State.compare_exchange_strong(expected, State::Ready, std::memory_order_acq_rel,
+                                            std::memory_order_acquire))
+        {
+            DCHECK(expected == State::Continuation);
+            m_State.store(State::Ready, std::memory_order_release);
+            RunContinuation();
+        }
+    }
+
+    void RunContinuation()
+    {
+        // moving the continuation out of the state breaks the state -> continuation -> state
+        // reference cycle formed by continuations that capture their source state
+        auto continuation = std::move(m_Continuation);
+        m_Continuation = nullptr;
+        continuation();
+    }
+
+    std::atomic<State> m_State;
+    std::optional<AsyncStorage<T>> m_Value;
+    std::exception_ptr m_Exception;
+    std::function<void()> m_Continuation;
+};
+
+template<typename T, typename F>
+struct AsyncContinuationResult
+{
+    using type = std::invoke_result_t<F, T>;
+};
+
+template<typename F>
+struct AsyncContinuationResult<void, F>
+{
+    using type = std::invoke_result_t<F>;
+};
+
+template<typename T>
+struct AsyncWhenAllResult
+{
+    using type = std::vector<T>;
+};
+
+template<>
+struct AsyncWhenAllResult<void>
+{
+    using type = void;
+};
+
+template<typename T>
+struct AsyncWhenAnyResult
+{
+    using type = std::pair<std::size_t, T>;
+};
+
+template<>
+struct AsyncWhenAnyResult<void>
+{
+    using type = std::size_t;
+};
+
+// Evaluates fn with the value held by source and stores the result (or the exception) in next
+template<typename T, typename R, typename F>
+void AsyncFulfill(AsyncSharedState<T>& source, AsyncSharedState<R>& next, F& fn)
+{
+    if(source.HasException())
+    {
+        next.SetException(source.Exception());
+        return;
+    }
+    try
+    {
+        if constexpr(std::is_void<T>::value && std::is_void<R>::value)
+        {
+            fn();
+            next.SetValue();
+        }
+        else if constexpr(std::is_void<T>::value)
+        {
+            next.SetValue(fn());
+        }
+        else if constexpr(std::is_void<R>::value)
+        {
+            fn(std::move(source.Value()));
+            next.SetValue();
+        }
+        else
+        {
+            next.SetValue(fn(std::move(source.Value())));
+        }
+    }
+    catch(...)
+    {
+        next.SetException(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Continuation-based future
+ *
+ * Lightweight alternative to std::future/std::shared_future that never requires a thread to
+ * be parked in order to chain work.  Continuations attached with then() are executed either
+ * inline on the thread that completes the AsyncPromise, inline on the calling thread if the
+ * value is already available, or enqueued on a user provided executor.
+ *
+ * Any object exposing an `enqueue(F&&)` method, e.g. ThreadPool, is a valid executor.  The
+ * executor must outlive the pending continuation.
+ *
+ * An AsyncFuture is single consumer: exactly one of then(), get() or a when_all/when_any may
+ * consume it.  wait() may be called before get().
+ *
+ * @tparam T
+ */
+template<typename T>
+class AsyncFuture
+{
+  public:
+    using ValueType = T;
+
+    AsyncFuture() = default;
+    AsyncFuture(AsyncFuture&&) noexcept = default;
+    AsyncFuture& operator=(AsyncFuture&&) noexcept = default;
+
+    DELETE_COPYABILITY(AsyncFuture);
+
+    bool valid() const { return (bool)m_State; }
+
+    bool is_ready() const
+    {
+        CHECK(valid());
+        return m_State->IsReady();
+    }
+
+    /**
+     * @brief Block the calling thread until the value is available
+     *
+     * Blocking is opt-in; the mutex/condition pair only exists on this path.
+     */
+    void wait() const
+    {
+        CHECK(valid());
+        if(m_State->IsReady()) return;
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool done = false;
+        m_State->SetContinuation([&mutex, &cond, &done] {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cond.notify_one();
+        });
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&done] { return done; });
+    }
+
+    /**
+     * @brief Block until ready, then return the value or rethrow the stored exception
+     *
+     * Consumes the future.
+     */
+    T get()
+    {
+        wait();
+        auto state = std::move(m_State);
+        if constexpr(std::is_void<T>::value)
+        {
+            state->Value();
+        }
+        else
+        {
+            return std::move(state->Value());
+        }
+    }
+
+    /**
+     * @brief Attach a continuation which is executed inline by whichever thread completes
+     * the value, or immediately on the calling thread if the value is already available.
+     *
+     * Keep inline continuations short; they run on the producer's thread.
+     */
+    template<typename F>
+    auto then(F fn) -> AsyncFuture<typename detail::AsyncContinuationResult<T, F>::type>
+    {
+        return Chain([](std::function<void()>&& task) { task(); }, std::move(fn));
+    }
+
+    /**
+     * @brief Attach a continuation which is enqueued on executor when the value is ready
+     */
+    template<typename Executor, typename F>
+    auto then(Executor& executor, F fn)
+        -> AsyncFuture<typename detail::AsyncContinuationResult<T, F>::type>
+    {
+        return Chain(
+            [&executor](std::function<void()>&& task) { executor.enqueue(std::move(task)); },
+            std::move(fn));
+    }
+
+  private:
+    AsyncFuture(std::shared_ptr<detail::AsyncSharedState<T>> state) : m_State(std::move(state)) {}
+
+    template<typename Launcher, typename F>
+    auto Chain(Launcher launch, F fn)
+        -> AsyncFuture<typename detail::AsyncContinuationResult<T, F>::type>
+    {
+        using R = typename detail::AsyncContinuationResult<T, F>::type;
+        CHECK(valid());
+        auto source = std::move(m_State);
+        auto next = std::make_shared<detail::AsyncSharedState<R>>();
+        auto raw = source.get();
+        raw->SetContinuation([source, next, launch, fn]() mutable {
+            try
+            {
+                launch([source, next, fn]() mutable { detail::AsyncFulfill(*source, *next, fn); });
+            }
+            catch(...)
+            {
+                // the executor refused the work, e.g. enqueue on a stopped ThreadPool
+                next->SetException(std::current_exception());
+            }
+        });
+        return AsyncFuture<R>(std::move(next));
+    }
+
+    std::shared_ptr<detail::AsyncSharedState<T>> m_State;
+
+    template<typename U>
+    friend class AsyncFuture;
+    friend class AsyncPromise<T>;
+    template<typename U>
+    friend AsyncFuture<typename detail::AsyncWhenAllResult<U>::type>
+        when_all(std::vector<AsyncFuture<U>>);
+    template<typename U>
+    friend AsyncFuture<typename detail::AsyncWhenAnyResult<U>::type>
+        when_any(std::vector<AsyncFuture<U>>);
+};
+
+/**
+ * @brief Producer side of an AsyncFuture
+ *
+ * Method names mirror std::promise so AsyncPromise can be used as a drop-in promise type,
+ * see AsyncCompute.  Destroying an unsatisfied AsyncPromise stores a broken_promise
+ * std::future_error so downstream continuations are always released.
+ *
+ * @tparam T
+ */
+template<typename T>
+class AsyncPromise
+{
+  public:
+    AsyncPromise()
+        : m_State(std::make_shared<detail::AsyncSharedState<T>>()), m_Retrieved(false),
+          m_Satisfied(false)
+    {
+    }
+    AsyncPromise(AsyncPromise&& other) noexcept
+        : m_State(std::move(other.m_State)), m_Retrieved(other.m_Retrieved),
+          m_Satisfied(other.m_Satisfied)
+    {
+    }
+    AsyncPromise& operator=(AsyncPromise&& other) noexcept
+    {
+        Abandon();
+        m_State = std::move(other.m_State);
+        m_Retrieved = other.m_Retrieved;
+        m_Satisfied = other.m_Satisfied;
+        return *this;
+    }
+    virtual ~AsyncPromise() { Abandon(); }
+
+    DELETE_COPYABILITY(AsyncPromise);
+
+    AsyncFuture<T> get_future()
+    {
+        CHECK(m_State);
+        CHECK(!m_Retrieved) << "AsyncFuture already retrieved";
+        m_Retrieved = true;
+        return AsyncFuture<T>(m_State);
+    }
+
+    template<typename... Args>
+    void set_value(Args&&... args)
+    {
+        CHECK(m_State);
+        m_Satisfied = true;
+        m_State->SetValue(std::forward<Args>(args)...);
+    }
+
+    void set_exception(std::exception_ptr exception)
+    {
+        CHECK(m_State);
+        m_Satisfied = true;
+        m_State->SetException(exception);
+    }
+
+  private:
+    void Abandon()
+    {
+        if(m_State && !m_Satisfied)
+        {
+            m_Satisfied = true;
+            m_State->SetException(std::make_exception_ptr(
+                std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    std::shared_ptr<detail::AsyncSharedState<T>> m_State;
+    bool m_Retrieved;
+    bool m_Satisfied;
+};
+
+/**
+ * @brief AsyncFuture that is already satisfied with value
+ */
+template<typename T>
+AsyncFuture<std::decay_t<T>> make_ready_async_future(T&& value)
+{
+    AsyncPromise<std::decay_t<T>> promise;
+    promise.set_value(std::forward<T>(value));
+    return promise.get_future();
+}
+
+inline AsyncFuture<void> make_ready_async_future()
+{
+    AsyncPromise<void> promise;
+    promise.set_value();
+    return promise.get_future();
+}
+
+/**
+ * @brief AsyncFuture which completes when all of futures have completed
+ *
+ * The values are returned in the order of the input futures.  If any future holds an
+ * exception, the first exception observed is propagated.
+ */
+template<typename T>
+AsyncFuture<typename detail::AsyncWhenAllResult<T>::type>
+    when_all(std::vector<AsyncFuture<T>> futures)
+{
+    using R = typename detail::AsyncWhenAllResult<T>::type;
+
+    struct Shared
+    {
+        Shared(std::size_t count) : remaining(count), failed(false), values(count) {}
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed;
+        std::exception_ptr exception;
+        std::vector<std::optional<detail::AsyncStorage<T>>> values;
+        std::shared_ptr<detail::AsyncSharedState<R>> next;
+    };
+
+    auto shared = std::make_shared<Shared>(futures.size());
+    shared->next = std::make_shared<detail::AsyncSharedState<R>>();
+    AsyncFuture<R> result(shared->next);
+
+    auto finish = [](Shared& shared) {
+        if(shared.exception)
+        {
+            shared.next->SetException(shared.exception);
+        }
+        else if constexpr(std::is_void<T>::value)
+        {
+            shared.next->SetValue();
+        }
+        else
+        {
+            std::vector<T> values;
+            values.reserve(shared.values.size());
+            for(auto& value : shared.values)
+            {
+                values.push_back(std::move(*value));
+            }
+            shared.next->SetValue(std::move(values));
+        }
+    };
+
+    if(futures.empty())
+    {
+        finish(*shared);
+        return result;
+    }
+
+    for(std::size_t i = 0; i < futures.size(); i++)
+    {
+        CHECK(futures[i].valid());
+        auto source = std::move(futures[i].m_State);
+        auto raw = source.get();
+        raw->SetContinuation([source, shared, finish, i]() mutable {
+            if(source->HasException())
+            {
+                if(!shared->failed.exchange(true, std::memory_order_acq_rel))
+                {
+                    shared->exception = source->Exception();
+                }
+            }
+            else
+            {
+                shared->values[i].emplace(std::move(source->Value()));
+            }
+            source.reset();
+            if(shared->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                finish(*shared);
+            }
+        });
+    }
+    return result;
+}
+
+/**
+ * @brief AsyncFuture which completes when the first of futures completes
+ *
+ * The result holds the index of the winning future (and its value for non-void T).  If the
+ * winning future holds an exception, it is propagated.
+ */
+template<typename T>
+AsyncFuture<typename detail::AsyncWhenAnyResult<T>::type>
+    when_any(std::vector<AsyncFuture<T>> futures)
+{
+    using R = typename detail::AsyncWhenAnyResult<T>::type;
+    CHECK(!futures.empty()) << "when_any requires at least one future";
+
+    struct Shared
+    {
+        Shared() : done(false) {}
+        std::atomic<bool> done;
+        std::shared_ptr<detail::AsyncSharedState<R>> next;
+    };
+
+    auto shared = std::make_shared<Shared>();
+    shared->next = std::make_shared<detail::AsyncSharedState<R>>();
+    AsyncFuture<R> result(shared->next);
+
+    for(std::size_t i = 0; i < futures.size(); i++)
+    {
+        CHECK(futures[i].valid());
+        auto source = std::move(futures[i].m_State);
+        auto raw = source.get();
+        raw->SetContinuation([source, shared, i]() mutable {
+            if(shared->done.exchange(true, std::memory_order_acq_rel))
+            {
+                source.reset();
+                return;
+            }
+            if(source->HasException())
+            {
+                shared->next->SetException(source->Exception());
+            }
+            else if constexpr(std::is_void<T>::value)
+            {
+                shared->next->SetValue(i);
+            }
+            else
+            {
+                shared->next->SetValue(i, std::move(source->Value()));
+            }
+            source.reset();
+            shared->next.reset();
+        });
+    }
+    return result;
+}
+
+template<typename CompleterFn, template<typename> class PromiseType = std::promise>
 struct AsyncCompute;
 
 template<typename CompleterFn>
@@ -47,10 +607,21 @@ struct AsyncComputeWrapper<void(Args...)>
         using UserFn = ResultType(Args...);
         return std::make_shared<AsyncCompute<UserFn>>(f);
     }
+
+    /**
+     * @brief Same as Wrap, but the returned compute object yields an AsyncFuture
+     */
+    template<typename F>
+    static auto WrapAsync(F&& f)
+    {
+        using ResultType = typename std::result_of<F(Args...)>::type;
+        using UserFn = ResultType(Args...);
+        return std::make_shared<AsyncCompute<UserFn, AsyncPromise>>(f);
+    }
 };
 
-template<typename... Args>
-struct AsyncCompute<void(Args...)>
+template<template<typename> class PromiseType, typename... Args>
+struct AsyncCompute<void(Args...), PromiseType>
 {
     using CallingFn = std::function<void(Args...)>;
     using WrappedFn = std::function<void(Args...)>;
@@ -63,17 +634,17 @@ struct AsyncCompute<void(Args...)>
         };
     }
 
-    std::future<void> Future() { return m_Promise.get_future(); }
+    auto Future() { return m_Promise.get_future(); }
 
     void operator()(Args&&... args) { m_WrappedFn(args...); }
 
   private:
     WrappedFn m_WrappedFn;
-    std::promise<void> m_Promise;
+    PromiseType<void> m_Promise;
 };
 
-template<typename ResultType, typename... Args>
-struct AsyncCompute<ResultType(Args...)>
+template<template<typename> class PromiseType, typename ResultType, typename... Args>
+struct AsyncCompute<ResultType(Args...), PromiseType>
 {
     using CallingFn = std::function<ResultType(Args...)>;
     using WrappedFn = std::function<void(Args...)>;
@@ -85,13 +656,13 @@ struct AsyncCompute<ResultType(Args...)>
         };
     }
 
-    std::future<ResultType> Future() { return m_Promise.get_future(); }
+    auto Future() { return m_Promise.get_future(); }
 
     void operator()(Args&&... args) { m_WrappedFn(args...); }
 
   private:
     WrappedFn m_WrappedFn;
-    std::promise<ResultType> m_Promise;
+    PromiseType<ResultType> m_Promise;
 };
 
-} // namespace trtlab
\ No newline at end of file
+} // namespace trtlab
@@ -0,0 +1,158 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Lock-free log-linear Histogram
+ *
+ * Values are binned into power-of-two ranges, each split into SubBuckets linear sub-buckets,
+ * giving a relative error of at most 1/SubBuckets over the full 64-bit range.  Recording
+ * is a handful of relaxed atomic increments and is safe to call concurrently from any
+ * number of threads.  GetSnapshot may be called at any time; the snapshot is not an atomic
+ * cut across all buckets, but every recorded value is eventually observed.
+ */
+class Histogram
+{
+  public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int Buckets = (64 - SubBucketBits + 1) * SubBuckets;
+
+    Histogram() : m_Count(0), m_Sum(0), m_Max(0)
+    {
+        for(auto& bucket : m_Buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    DELETE_COPYABILITY(Histogram);
+    DELETE_MOVEABILITY(Histogram);
+
+    void Record(std::uint64_t value) noexcept
+    {
+        m_Buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_Count.fetch_add(1, std::memory_order_relaxed);
+        m_Sum.fetch_add(value, std::memory_order_relaxed);
+        auto max = m_Max.load(std::memory_order_relaxed);
+        while(value > max &&
+              !m_Max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    struct Snapshot
+    {
+        Snapshot() : count(0), sum(0), max(0), buckets(Buckets, 0) {}
+
+        std::uint64_t count;
+        std::uint64_t sum;
+        std::uint64_t max;
+        std::vector<std::uint64_t> buckets;
+
+        double Mean() const { return count ? (double)sum / (double)count : 0.0; }
+
+        /**
+         * @brief Upper bound of the bucket holding the p-th percentile, p in [0, 100]
+         */
+        std::uint64_t Percentile(double p) const
+        {
+            if(!count) return 0;
+            auto target = (std::uint64_t)(p / 100.0 * count + 0.5);
+            target = target ? target : 1;
+            std::uint64_t seen = 0;
+            for(int i = 0; i < Buckets; i++)
+            {
+                seen += buckets[i];
+                if(seen >= target)
+                {
+                    auto upper = BucketUpperBound(i);
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+
+        Snapshot& operator+=(const Snapshot& other)
+        {
+            count += other.count;
+            sum += other.sum;
+            max = max > other.max ? max : other.max;
+            for(int i = 0; i < Buckets; i++)
+            {
+                buckets[i] += other.buckets[i];
+            }
+            return *this;
+        }
+    };
+
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        for(int i = 0; i < Buckets; i++)
+        {
+            snapshot.buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = m_Count.load(std::memory_order_relaxed);
+        snapshot.sum = m_Sum.load(std::memory_order_relaxed);
+        snapshot.max = m_Max.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    static inline int BucketIndex(std::uint64_t value) noexcept
+    {
+        if(value < SubBuckets) return (int)value;
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SubBucketBits;
+        return (shift + 1) * SubBuckets + (int)((value >> shift) & (SubBuckets - 1));
+    }
+
+    static inline std::uint64_t BucketUpperBound(int index) noexcept
+    {
+        if(index < SubBuckets) return index;
+        int shift = index / SubBuckets - 1;
+        std::uint64_t lower = (std::uint64_t)(SubBuckets + index % SubBuckets) << shift;
+        return lower + ((std::uint64_t)1 << shift) - 1;
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, Buckets> m_Buckets;
+    std::atomic<std::uint64_t> m_Count;
+    std::atomic<std::uint64_t> m_Sum;
+    std::atomic<std::uint64_t> m_Max;
+};
+
+} // namespace trtlab
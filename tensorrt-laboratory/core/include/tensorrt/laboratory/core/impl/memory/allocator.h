@@ -25,22 +25,40 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <type_traits>
+#include <utility>
 
 #include <glog/logging.h>
 
+#include "tensorrt/laboratory/core/memory/host_memory.h"
+
 namespace trtlab {
 
 // Allocator
 
 template<typename MemoryType>
-Allocator<MemoryType>::Allocator(size_t size) : MemoryType(this->Allocate(size), size, true)
+Allocator<MemoryType>::Allocator(size_t size)
+    : MemoryType(this->Allocate(size), size, true), m_Accounted(MemoryAccounting::Enabled())
 {
+    if(m_Accounted)
+    {
+        TypeAccount().Allocated(this->Size());
+    }
     DLOG(INFO) << "Allocator<" << this->Type() << "> size_ctor [" << this
                << "]: ptr=" << this->Data() << "; size=" << this->Size();
 }
 
 template<typename MemoryType>
-Allocator<MemoryType>::Allocator(Allocator&& other) noexcept : MemoryType(std::move(other))
+Allocator<MemoryType>::Allocator(size_t size, const FirstTouch& touch) : Allocator(size)
+{
+    static_assert(std::is_base_of<HostMemory, MemoryType>::value,
+                  "FirstTouch requires host memory");
+    touch.Apply(this->Data(), this->Size());
+}
+
+template<typename MemoryType>
+Allocator<MemoryType>::Allocator(Allocator&& other) noexcept
+    : MemoryType(std::move(other)), m_Accounted(std::exchange(other.m_Accounted, false))
 {
     DLOG(INFO) << "Allocator<" << this->Type() << "> mv_ctor [" << this << "]: ptr=" << this->Data()
                << "; size=" << this->Size();
@@ -50,6 +68,7 @@ template<typename MemoryType>
 Allocator<MemoryType>& Allocator<MemoryType>::operator=(Allocator<MemoryType>&& other) noexcept
 {
     MemoryType::operator=(std::move(other));
+    m_Accounted = std::exchange(other.m_Accounted, false);
     return *this;
 }
 
@@ -61,7 +80,18 @@ Allocator<MemoryType>::~Allocator()
         DLOG(INFO) << "~Allocator<" << this->Type() << "> [" << this << "]: ptr=" << this->Data()
                    << "; size=" << this->Size();
         this->Free();
+        if(m_Accounted)
+        {
+            TypeAccount().Released(this->Size());
+        }
     }
 }
 
+template<typename MemoryType>
+MemoryAccount& Allocator<MemoryType>::TypeAccount() const
+{
+    static MemoryAccount& account = MemoryAccounting::ForType(this->Type());
+    return account;
+}
+
 } // namespace trtlab
\ No newline at end of file
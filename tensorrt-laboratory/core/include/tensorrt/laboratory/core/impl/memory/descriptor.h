@@ -26,15 +26,36 @@
  */
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+
 #include <glog/logging.h>
 
 namespace trtlab {
 
 // Descriptor
 
+template<typename MemoryType>
+Descriptor<MemoryType>::Descriptor(MemoryType&& other, const char* desc)
+    : MemoryType(std::move(other)), m_Desc(&TypeTag(desc))
+{
+    DLOG(INFO) << "Descriptor<" << this->Type() << "> mem_ctor [" << this
+               << "]: ptr=" << this->Data() << "; size=" << this->Size();
+}
+
+template<class MemoryType>
+Descriptor<MemoryType>::Descriptor(void* ptr, size_t size, const char* desc)
+    : MemoryType(ptr, size, false), m_Desc(&TypeTag(desc))
+{
+    DLOG(INFO) << "Descriptor<" << this->Type() << "> ptr_size_ctor [" << this
+               << "]: ptr=" << this->Data() << "; size=" << this->Size();
+}
+
 template<typename MemoryType>
 Descriptor<MemoryType>::Descriptor(MemoryType&& other, const std::string& desc)
-    : MemoryType(std::move(other)), m_Desc(MemoryType::Type() + "(" + desc + ")")
+    : MemoryType(std::move(other)),
+      m_Desc(&detail::InternDescriptorType(MemoryType::Type(), desc.c_str()))
 {
     DLOG(INFO) << "Descriptor<" << this->Type() << "> mem_ctor [" << this
                << "]: ptr=" << this->Data() << "; size=" << this->Size();
@@ -42,14 +63,16 @@ Descriptor<MemoryType>::Descriptor(MemoryType&& other, const std::string& desc)
 
 template<class MemoryType>
 Descriptor<MemoryType>::Descriptor(void* ptr, size_t size, const std::string& desc)
-    : MemoryType(ptr, size, false), m_Desc(MemoryType::Type() + "(" + desc + ")")
+    : MemoryType(ptr, size, false),
+      m_Desc(&detail::InternDescriptorType(MemoryType::Type(), desc.c_str()))
 {
     DLOG(INFO) << "Descriptor<" << this->Type() << "> ptr_size_ctor [" << this
                << "]: ptr=" << this->Data() << "; size=" << this->Size();
 }
 
 template<class MemoryType>
-Descriptor<MemoryType>::Descriptor(Descriptor&& other) noexcept : MemoryType(std::move(other))
+Descriptor<MemoryType>::Descriptor(Descriptor&& other) noexcept
+    : MemoryType(std::move(other)), m_Desc(other.m_Desc)
 {
     DLOG(INFO) << "Descriptor<" << this->Type() << "> mv_ctor [" << this
                << "]: ptr=" << this->Data() << "; size=" << this->Size();
@@ -59,6 +82,7 @@ template<class MemoryType>
 Descriptor<MemoryType>& Descriptor<MemoryType>::operator=(Descriptor<MemoryType>&& other) noexcept
 {
     MemoryType::operator=(std::move(other));
+    m_Desc = other.m_Desc;
     return *this;
 }
 
@@ -72,7 +96,80 @@ Descriptor<MemoryType>::~Descriptor()
 template<class MemoryType>
 const std::string& Descriptor<MemoryType>::Type() const
 {
-    return m_Desc;
+    return *m_Desc;
+}
+
+template<class MemoryType>
+const std::string& Descriptor<MemoryType>::TypeTag(const char* desc) const
+{
+    // direct mapped on the address of desc and verified against its contents, so a reused
+    // buffer at a cached address never returns a stale tag
+    struct Entry
+    {
+        const char* desc;
+        const std::string* tag;
+    };
+    static thread_local std::array<Entry, 8> cache = {};
+    auto& entry = cache[(reinterpret_cast<std::uintptr_t>(desc) >> 3) % cache.size()];
+    if(entry.desc != desc || !TagMatches(*entry.tag, desc))
+    {
+        entry.tag = &detail::InternDescriptorType(MemoryType::Type(), desc);
+        entry.desc = desc;
+    }
+    return *entry.tag;
+}
+
+template<class MemoryType>
+bool Descriptor<MemoryType>::TagMatches(const std::string& tag, const char* desc) const
+{
+    // tag is "MemoryType(desc)"
+    auto offset = MemoryType::Type().size() + 1;
+    auto length = std::strlen(desc);
+    return tag.size() == offset + length + 1 && tag.compare(offset, length, desc) == 0;
+}
+
+// PooledStorage
+
+template<typename T>
+void* PooledStorage<T>::operator new(std::size_t size)
+{
+    auto& list = LocalFreeList();
+    if(size != sizeof(T) || !list.head)
+    {
+        return ::operator new(size);
+    }
+    auto block = list.head;
+    list.head = block->next;
+    list.count--;
+    return block;
+}
+
+template<typename T>
+void PooledStorage<T>::operator delete(void* ptr, std::size_t size)
+{
+    auto& list = LocalFreeList();
+    if(size != sizeof(T) || list.count >= MaxCached)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+    auto block = static_cast<Block*>(ptr);
+    block->next = list.head;
+    list.head = block;
+    list.count++;
+}
+
+template<typename T>
+PooledStorage<T>::FreeList::~FreeList()
+{
+    while(head)
+    {
+        auto next = head->next;
+        ::operator delete(head);
+        head = next;
+    }
+    // descriptors released later during thread exit go straight to the heap
+    count = MaxCached;
 }
 
 } // namespace trtlab
\ No newline at end of file
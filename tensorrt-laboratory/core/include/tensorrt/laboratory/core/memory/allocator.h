@@ -27,6 +27,9 @@
 #pragma once
 #include <cstddef>
 
+#include "tensorrt/laboratory/core/memory/first_touch.h"
+#include "tensorrt/laboratory/core/memory/memory_accounting.h"
+
 namespace trtlab {
 
 template<class MemoryType>
@@ -34,6 +37,11 @@ class Allocator final : public MemoryType
 {
   public:
     Allocator(size_t size);
+
+    /**
+     * @brief Allocate host memory and fault it in, or zero it, in parallel; see FirstTouch
+     */
+    Allocator(size_t size, const FirstTouch& touch);
     virtual ~Allocator() override;
 
     Allocator(Allocator&& other) noexcept;
@@ -41,6 +49,13 @@ class Allocator final : public MemoryType
 
     Allocator(const Allocator&) = delete;
     Allocator& operator=(const Allocator&) = delete;
+
+  private:
+    // Account of MemoryType in the MemoryAccounting registry
+    MemoryAccount& TypeAccount() const;
+
+    // Allocations made while MemoryAccounting was disabled are not released from the account
+    bool m_Accounted;
 };
 
 } // namespace trtlab
@@ -30,6 +30,11 @@
 
 namespace trtlab {
 
+/**
+ * @brief Host to host copy; uses the default CopyEngine when one has been set
+ */
+void HostCopy(void* dst, const void* src, size_t size);
+
 void Copy(HostMemory& dst, size_t dst_offset, const HostMemory& src, size_t src_offset,
           size_t size);
 
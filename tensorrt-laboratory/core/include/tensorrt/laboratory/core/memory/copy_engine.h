@@ -0,0 +1,110 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <memory>
+
+#include "tensorrt/laboratory/core/affinity.h"
+#include "tensorrt/laboratory/core/memory/host_memory.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Host to host copy engine for large buffers
+ *
+ * Copies smaller than the streaming threshold are a plain memcpy.  Larger copies use
+ * non-temporal (streaming) stores that bypass the cache hierarchy, which is the right choice
+ * for destinations written once and not read back by the CPU, e.g. input bindings staged for
+ * an H2D transfer.  Copies larger than the parallel threshold are split into chunks of at
+ * least ChunkSize bytes, split on page boundaries of the destination, which are copied
+ * concurrently by the workers and the calling thread.
+ *
+ * Construct the engine from the CPUs of the NUMA node that owns the buffers, e.g.
+ * `CopyEngine(Affinity::GetCpusByNuma(0))`, so each worker is pinned local to the memory.
+ *
+ * Copy blocks until the copy completes and must not be called from the engine's workers.
+ */
+class CopyEngine
+{
+  public:
+    static constexpr size_t DefaultStreamingThreshold = 1024 * 1024;
+    static constexpr size_t DefaultParallelThreshold = 4 * 1024 * 1024;
+    static constexpr size_t DefaultChunkSize = 1024 * 1024;
+
+    /**
+     * @brief Creates a worker pinned to each CPU of cpus
+     */
+    CopyEngine(const CpuSet& cpus);
+
+    /**
+     * @brief Uses an existing ThreadPool; the pool should not be shared with callers of Copy
+     */
+    CopyEngine(std::shared_ptr<ThreadPool> workers);
+
+    ~CopyEngine() {}
+
+    DELETE_COPYABILITY(CopyEngine);
+    DELETE_MOVEABILITY(CopyEngine);
+
+    void Copy(void* dst, const void* src, size_t size);
+    void Copy(HostMemory& dst, size_t dst_offset, const HostMemory& src, size_t src_offset,
+              size_t size);
+
+    size_t StreamingThreshold() const { return m_StreamingThreshold; }
+    size_t ParallelThreshold() const { return m_ParallelThreshold; }
+    size_t ChunkSize() const { return m_ChunkSize; }
+
+    void SetStreamingThreshold(size_t bytes) { m_StreamingThreshold = bytes; }
+    void SetParallelThreshold(size_t bytes) { m_ParallelThreshold = bytes; }
+    void SetChunkSize(size_t bytes);
+
+    /**
+     * @brief Single threaded copy using non-temporal stores where the CPU supports them
+     */
+    static void StreamingCopy(void* dst, const void* src, size_t size);
+
+    /**
+     * @brief Engine used by trtlab::Copy and HostCopy for host to host copies
+     *
+     * Without a default engine those copies are a plain memcpy.  Set the default engine at
+     * startup; engines that were installed are kept alive for the life of the program.
+     */
+    static void SetDefault(std::shared_ptr<CopyEngine> engine);
+    static CopyEngine* Default();
+
+  private:
+    void CopyRange(void* dst, const void* src, size_t size, bool streaming);
+
+    std::shared_ptr<ThreadPool> m_Workers;
+    size_t m_StreamingThreshold;
+    size_t m_ParallelThreshold;
+    size_t m_ChunkSize;
+};
+
+} // namespace trtlab
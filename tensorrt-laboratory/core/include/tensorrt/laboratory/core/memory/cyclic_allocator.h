@@ -141,6 +141,23 @@ class CyclicAllocator
 
     auto Alignment() { return m_Alignment; }
 
+    /**
+     * @brief Account the segments to a named owner; see MemoryStack::TrackUsage
+     *
+     * Each segment records its utilization when it is recycled, which is the fraction of the
+     * segment lost to fragmentation when it rotated.  Applies to segments as they are rotated
+     * in; call before the first Allocate to account the current segment as well.
+     */
+    void TrackUsage(const std::string& owner)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Account = MemoryAccounting::Enabled() ? &MemoryAccounting::ForOwner(owner) : nullptr;
+        if(m_CurrentSegment && !m_CurrentSegment->Allocated())
+        {
+            m_CurrentSegment->TrackUsage(m_Account);
+        }
+    }
+
   private:
     // The returned shared_ptr<MemoryType> holds a reference to the RotatingSegment object
     // which ensures the RotatingSegment cannot be returned to the Pool until all its
@@ -158,7 +175,9 @@ class CyclicAllocator
             m_CurrentSegment.reset(); // explicitily drop the current segment -> returns to pool
             m_CurrentSegment = InternalPopSegment(); // get the next segment from pool
         }
-        auto retval = m_CurrentSegment->Allocate(size);
+        // descriptors hold the handle popped from the pool so the segment is only recycled
+        // after all of its descriptors are released
+        auto retval = m_CurrentSegment->Allocate(size, m_CurrentSegment);
         // TODO: proactive release should be dependent the recent allocations statistics
         if(!m_CurrentSegment->Available())
         {
@@ -183,6 +202,7 @@ class CyclicAllocator
             DLOG(INFO) << "Returning RotatingSegment " << segment << " to Pool";
             segment->Reset();
         });
+        val->TrackUsage(m_Account);
         DLOG(INFO) << "Acquired RotatingSegment " << val.get() << " from Pool";
         return val;
     }
@@ -196,6 +216,7 @@ class CyclicAllocator
     std::shared_ptr<Pool<RotatingSegment>> m_Segments;
     std::shared_ptr<RotatingSegment> m_CurrentSegment;
     std::mutex m_Mutex;
+    MemoryAccount* m_Account = nullptr;
     const size_t m_MaximumAllocationSize;
     size_t m_Alignment;
 };
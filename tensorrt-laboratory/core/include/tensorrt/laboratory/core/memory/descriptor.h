@@ -25,14 +25,33 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <cstddef>
 #include <memory>
+#include <string>
 
 namespace trtlab {
 
+namespace detail {
+// Interned "MemoryType(desc)" type name; the returned reference is valid for the program
+const std::string& InternDescriptorType(const std::string& memory_type, const char* desc);
+} // namespace detail
+
+/**
+ * @brief Exposes memory owned by another object
+ *
+ * Type() of a descriptor is an interned tag shared by all descriptors of the same memory type
+ * and description, so constructing a descriptor does not allocate a string.  Prefer the
+ * `const char*` constructors with a string literal; their tags are cached per thread by the
+ * address of the description and checked against its contents on every hit.  The
+ * `std::string` constructors look the tag up on every call, under a shared lock.  Interned
+ * tags are never released, so descriptions should name a use rather than carry per-call data.
+ */
 template<typename MemoryType>
 class Descriptor : public MemoryType
 {
   protected:
+    Descriptor(MemoryType&&, const char*);
+    Descriptor(void*, size_t, const char*);
     Descriptor(MemoryType&&, const std::string&);
     Descriptor(void*, size_t, const std::string&);
 
@@ -47,12 +66,54 @@ class Descriptor : public MemoryType
     const std::string& Type() const final override;
 
   private:
-    std::string m_Desc;
+    const std::string& TypeTag(const char* desc) const;
+    bool TagMatches(const std::string& tag, const char* desc) const;
+
+    const std::string* m_Desc;
 };
 
 template<typename MemoryType>
 using DescriptorHandle = std::unique_ptr<MemoryType>;
 
+/**
+ * @brief Recycles the storage of a descriptor type through a per-thread free list
+ *
+ * A descriptor class deriving from PooledStorage<Self> is created by `new`/`make_unique` from
+ * blocks previously released on the same thread, so short lived descriptors, e.g. stack
+ * sub-allocations, do not touch the global heap in steady state.  Blocks released on a
+ * thread are cached by that thread, up to MaxCached blocks; the rest go back to the heap.
+ *
+ * @tparam T the descriptor class; classes further derived from T use the global heap
+ */
+template<typename T>
+class PooledStorage
+{
+  public:
+    static constexpr std::size_t MaxCached = 1024;
+
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size);
+
+  private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct FreeList
+    {
+        ~FreeList();
+        Block* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    static FreeList& LocalFreeList()
+    {
+        static thread_local FreeList list;
+        return list;
+    }
+};
+
 } // namespace trtlab
 
 #include "tensorrt/laboratory/core/impl/memory/descriptor.h"
\ No newline at end of file
@@ -0,0 +1,110 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <cstddef>
+#include <memory>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+// affinity.h and thread_pool.h are left to the translation units using these
+struct CpuSet;
+
+/**
+ * @brief Parallel, NUMA local first touch of freshly allocated host memory
+ *
+ * Linux places a page on the NUMA node of the CPU that first writes to it.  FirstTouch
+ * splits a range into contiguous page aligned slices and faults each slice in from a worker
+ * pinned to one of `cpus`, so the pages land on the node owning those CPUs and the cost of
+ * faulting them in is paid at startup, in parallel, instead of by the first requests.
+ *
+ * ```
+ * Allocator<Malloc> memory(4 * 1024 * 1024 * 1024UL, FirstTouch::OnNumaNode(0));
+ * ```
+ */
+class FirstTouch
+{
+  public:
+    /**
+     * @param cpus one worker is pinned to each cpu
+     * @param zero write zeros to the entire range; otherwise one byte per page is written
+     */
+    FirstTouch(const CpuSet& cpus, bool zero = false);
+
+    static FirstTouch OnNumaNode(int numa_node, bool zero = false);
+
+    /**
+     * @brief Fault in, or zero, [ptr, ptr + size)
+     */
+    void Apply(void* ptr, size_t size) const;
+
+    const CpuSet& Cpus() const { return *m_Cpus; }
+    bool Zero() const { return m_Zero; }
+
+  private:
+    std::shared_ptr<const CpuSet> m_Cpus;
+    bool m_Zero;
+};
+
+/**
+ * @brief Workers pinned to a set of cpus, kept for repeated parallel fills
+ *
+ * Starting and joining a worker per cpu costs more than zeroing a few MiB, so owners that
+ * zero large ranges over and over, e.g. MemoryStack::Reset(true), are handed one FillWorkers,
+ * typically one per NUMA node shared by every stack first touched on that node.
+ */
+class FillWorkers
+{
+  public:
+    FillWorkers(const CpuSet& cpus);
+    ~FillWorkers();
+
+    DELETE_COPYABILITY(FillWorkers);
+    DELETE_MOVEABILITY(FillWorkers);
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> m_Impl;
+
+    friend void ParallelFill(void*, size_t, char, FillWorkers&);
+};
+
+/**
+ * @brief memset of [ptr, ptr + size) split across workers pinned to cpus
+ *
+ * Parallel counterpart of HostMemory::Fill for large ranges.  Starts and joins one worker per
+ * cpu; callers that fill repeatedly should keep a FillWorkers and use the overload below.
+ */
+void ParallelFill(void* ptr, size_t size, char value, const CpuSet& cpus);
+
+/**
+ * @brief memset of [ptr, ptr + size) split across the workers of a FillWorkers
+ */
+void ParallelFill(void* ptr, size_t size, char value, FillWorkers& workers);
+
+} // namespace trtlab
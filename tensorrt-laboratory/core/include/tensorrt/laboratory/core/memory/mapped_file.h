@@ -0,0 +1,71 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <string>
+#include <utility>
+
+#include "tensorrt/laboratory/core/memory/descriptor.h"
+#include "tensorrt/laboratory/core/memory/host_memory.h"
+
+namespace trtlab {
+
+/**
+ * @brief Read-only HostMemory backed by a memory-mapped file
+ *
+ * The file is mapped privately with PROT_READ and advised MADV_SEQUENTIAL and MADV_WILLNEED,
+ * so pages are read ahead from the page cache as the mapping is consumed rather than copied
+ * into a separate buffer.  With populate, MAP_POPULATE faults the whole file in before Open
+ * returns, trading a longer open for no page faults on first access.
+ *
+ * The memory is read-only; writing to it, including Fill, raises SIGSEGV.
+ */
+class MappedFile : public HostMemory
+{
+  protected:
+    MappedFile(const std::string& path, bool populate);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept = delete;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  public:
+    virtual ~MappedFile() override;
+    const std::string& Type() const override;
+
+    static DescriptorHandle<MappedFile> Open(const std::string& path, bool populate = false);
+
+    const std::string& Path() const { return m_Path; }
+
+  private:
+    MappedFile(std::pair<void*, size_t> mapping, const std::string& path);
+
+    std::string m_Path;
+};
+
+} // namespace trtlab
@@ -0,0 +1,124 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trtlab {
+
+/**
+ * @brief Usage counters of one memory type or one named owner
+ *
+ * All updates are relaxed atomics; counters are exact, but a snapshot taken while other
+ * threads allocate is not a consistent cut across counters.
+ */
+class MemoryAccount
+{
+  public:
+    enum class Kind
+    {
+        MemoryType,
+        Owner
+    };
+
+    struct Snapshot
+    {
+        std::string name;
+        Kind kind;
+        std::size_t live_bytes;
+        std::size_t peak_bytes;
+        std::size_t allocations;
+        std::size_t releases;
+
+        // MemoryStack utilization sampled at Reset(); zero when the account has no stacks
+        std::size_t resets;
+        double mean_used_at_reset;
+        std::size_t peak_bytes_at_reset;
+        std::size_t capacity;
+
+        double MeanUtilizationAtReset() const;
+        double PeakUtilizationAtReset() const;
+    };
+
+    MemoryAccount(std::string name, Kind kind);
+
+    void Allocated(std::size_t bytes);
+    void Released(std::size_t bytes);
+
+    /**
+     * @brief Record the bytes in use on a stack of `capacity` bytes when it is Reset
+     */
+    void StackReset(std::size_t used, std::size_t capacity);
+
+    Snapshot GetSnapshot() const;
+    const std::string& Name() const { return m_Name; }
+
+  private:
+    const std::string m_Name;
+    const Kind m_Kind;
+    std::atomic<std::int64_t> m_LiveBytes;
+    std::atomic<std::int64_t> m_PeakBytes;
+    std::atomic<std::size_t> m_Allocations;
+    std::atomic<std::size_t> m_Releases;
+    std::atomic<std::size_t> m_Resets;
+    std::atomic<std::size_t> m_UsedAtReset;
+    std::atomic<std::size_t> m_PeakAtReset;
+    std::atomic<std::size_t> m_Capacity;
+};
+
+/**
+ * @brief Opt-in, process wide registry of MemoryAccounts
+ *
+ * When enabled, Allocator<MemoryType> accounts every allocation to the account of its memory
+ * type, and MemoryStacks and CyclicAllocators given an owner name with TrackUsage account
+ * their sub-allocations and the utilization at Reset to the owner's account.  While disabled
+ * the cost on those paths is a relaxed load.  Allocations made while accounting was disabled
+ * are not accounted when released.
+ */
+class MemoryAccounting
+{
+  public:
+    static void Enable(bool enabled = true);
+    static bool Enabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+    // Accounts are created on first use and live for the program; cache the reference
+    static MemoryAccount& ForType(const std::string& memory_type);
+    static MemoryAccount& ForOwner(const std::string& owner);
+
+    /**
+     * @brief Snapshot of every account; memory types first, then owners, sorted by name
+     */
+    static std::vector<MemoryAccount::Snapshot> GetSnapshot();
+
+  private:
+    static std::atomic<bool> s_Enabled;
+};
+
+} // namespace trtlab
@@ -25,14 +25,32 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 
 #include <glog/logging.h>
 
 #include "tensorrt/laboratory/core/memory/allocator.h"
+#include "tensorrt/laboratory/core/memory/first_touch.h"
+#include "tensorrt/laboratory/core/memory/memory_accounting.h"
+#include "tensorrt/laboratory/core/utils.h"
 
 namespace trtlab {
 
+/**
+ * @brief Saved stack pointer returned by MemoryStack::Mark
+ *
+ * Marks nest: rolling back to a mark also discards every mark taken after it.  A mark is
+ * invalidated by Rollback to itself or to an earlier mark and by Reset.
+ */
+struct StackMark
+{
+    size_t offset;
+    size_t depth;
+    std::uint64_t epoch;
+};
+
 /**
  * @brief General MemoryStack
  *
@@ -58,7 +76,7 @@ class MemoryStack
 
     MemoryStack(std::unique_ptr<MemoryType> memory)
         : m_Memory(std::move(memory)), m_CurrentPointer(m_Memory->Data()), m_CurrentSize(0),
-          m_Alignment(m_Memory->DefaultAlignment())
+          m_Alignment(m_Memory->DefaultAlignment()), m_Depth(0), m_Epoch(0), m_Account(nullptr)
     {
         CHECK(m_Memory);
     }
@@ -67,6 +85,16 @@ class MemoryStack
     {
     }
 
+    /**
+     * @brief Construct a host MemoryStack whose memory is first touched on touch.Cpus()
+     *
+     * Pair with SetFillWorkers on the same cpus so Reset(true) keeps the pages on their node.
+     */
+    MemoryStack(size_t size, const FirstTouch& touch)
+        : MemoryStack(std::move(std::make_unique<Allocator<MemoryType>>(size, touch)))
+    {
+    }
+
     virtual ~MemoryStack() {}
 
     using BaseType = typename MemoryType::BaseType;
@@ -103,9 +131,56 @@ class MemoryStack
      * @brief Reset the memory stack
      *
      * This operation resets the stack pointer to the base pointer of the memory allocation.
+     * All outstanding marks are invalidated.
+     *
+     * With writeZeros, the memory is zeroed by the FillWorkers given to SetFillWorkers, if
+     * any, and otherwise by MemoryType::Fill.
      */
     void Reset(bool writeZeros = false);
 
+    /**
+     * @brief Zero host stacks on Reset(true) in parallel with workers shared with other stacks
+     *
+     * Opt-in for large stacks; use workers pinned to the cpus the stack was first touched on.
+     */
+    void SetFillWorkers(std::shared_ptr<FillWorkers> workers)
+    {
+        static_assert(std::is_base_of<HostMemory, MemoryType>::value,
+                      "FillWorkers require host memory");
+        m_FillWorkers = std::move(workers);
+    }
+
+    /**
+     * @brief Save the current stack pointer
+     *
+     * Allocations made after the mark can be reclaimed with Rollback without releasing the
+     * allocations made before it, e.g. scratch used during pre-processing of a request.
+     */
+    StackMark Mark();
+
+    /**
+     * @brief Return the stack pointer to a mark
+     *
+     * Discards all allocations made after the mark.  A MemoryStack hands out raw pointers, so
+     * it is the caller's responsibility that none of them are used after the rollback.
+     *
+     * @return true; the return type matches SmartStack::Rollback, which can refuse
+     */
+    bool Rollback(const StackMark& mark);
+
+    /**
+     * @brief Discard a mark, and every mark taken after it, without moving the stack pointer
+     *
+     * Allocations made after the mark are kept and now belong to the enclosing mark.  Used
+     * when a rollback is refused so the mark does not stay outstanding.
+     */
+    void Unmark(const StackMark& mark);
+
+    /**
+     * @brief Number of marks currently outstanding
+     */
+    size_t Depth() const { return m_Depth; }
+
     /**
      * @brief Get Size of the Memory Stack
      */
@@ -130,11 +205,85 @@ class MemoryStack
 
     const MemoryType& Memory() const { return *m_Memory; }
 
+    /**
+     * @brief Account allocations and the utilization at Reset to a named owner
+     *
+     * Only takes effect if MemoryAccounting is enabled when called, so a stack is either
+     * accounted for its whole life or not at all.  Bytes are released from the account when
+     * they are reclaimed by Rollback or Reset.
+     */
+    void TrackUsage(const std::string& owner)
+    {
+        TrackUsage(MemoryAccounting::Enabled() ? &MemoryAccounting::ForOwner(owner) : nullptr);
+    }
+
+    void TrackUsage(MemoryAccount* account)
+    {
+        CHECK_EQ(m_CurrentSize, 0UL) << "TrackUsage must be called on an empty stack";
+        m_Account = MemoryAccounting::Enabled() ? account : nullptr;
+    }
+
+  protected:
+    void CheckMark(const StackMark& mark) const
+    {
+        CHECK_EQ(mark.epoch, m_Epoch) << "StackMark was invalidated by Reset";
+        CHECK_GT(mark.depth, 0UL);
+        CHECK_LE(mark.depth, m_Depth) << "StackMark was invalidated by an earlier Rollback";
+        CHECK_LE(mark.offset, m_CurrentSize);
+    }
+
   private:
     std::unique_ptr<MemoryType> m_Memory;
     void* m_CurrentPointer;
     size_t m_CurrentSize;
     size_t m_Alignment;
+    size_t m_Depth;
+    std::uint64_t m_Epoch;
+    MemoryAccount* m_Account;
+    std::shared_ptr<FillWorkers> m_FillWorkers;
+};
+
+/**
+ * @brief RAII scope of scratch allocations on a MemoryStack or SmartStack
+ *
+ * Takes a mark on construction and rolls the stack back to it on destruction.  Scopes nest;
+ * inner scopes must be destroyed before outer scopes.  If a SmartStack refuses the rollback
+ * because a descriptor allocated in the scope is still alive, the mark is discarded and the
+ * scratch is held by the enclosing scope, or by the owner of the stack at the outermost scope.
+ *
+ * @tparam StackType MemoryStack<MemoryType> or SmartStack<MemoryType>
+ */
+template<typename StackType>
+class ScopedArena
+{
+  public:
+    ScopedArena(StackType& stack) : m_Stack(stack), m_Mark(stack.Mark()) {}
+
+    ~ScopedArena()
+    {
+        if(!m_Stack.Rollback(m_Mark))
+        {
+            m_Stack.Unmark(m_Mark);
+            LOG(WARNING) << "ScopedArena rollback refused; descriptors allocated in the scope "
+                         << "are still alive";
+        }
+    }
+
+    DELETE_COPYABILITY(ScopedArena);
+    DELETE_MOVEABILITY(ScopedArena);
+
+    auto Allocate(size_t size) { return m_Stack.Allocate(size); }
+
+    /**
+     * @brief Bytes allocated on the stack since the scope was entered
+     */
+    size_t Allocated() const { return m_Stack.Allocated() - m_Mark.offset; }
+
+    StackType& Stack() { return m_Stack; }
+
+  private:
+    StackType& m_Stack;
+    StackMark m_Mark;
 };
 
 // Template Implementations
@@ -154,18 +303,67 @@ void* MemoryStack<MemoryType>::Allocate(size_t size)
     size = (remainder == 0) ? size : size + m_Alignment - remainder;
     m_CurrentPointer = static_cast<unsigned char*>(m_CurrentPointer) + size;
     m_CurrentSize += size;
+    if(m_Account)
+    {
+        m_Account->Allocated(size);
+    }
     return return_ptr;
 }
 
 template<class MemoryType>
 void MemoryStack<MemoryType>::Reset(bool writeZeros)
 {
+    if(m_Account)
+    {
+        m_Account->StackReset(m_CurrentSize, Size());
+        if(m_CurrentSize)
+        {
+            m_Account->Released(m_CurrentSize);
+        }
+    }
     m_CurrentPointer = m_Memory->Data();
     m_CurrentSize = 0;
+    m_Depth = 0;
+    m_Epoch++;
     if(writeZeros)
     {
+        if constexpr(std::is_base_of<HostMemory, MemoryType>::value)
+        {
+            if(m_FillWorkers)
+            {
+                ParallelFill(m_Memory->Data(), Size(), 0, *m_FillWorkers);
+                return;
+            }
+        }
         m_Memory->Fill(0);
     }
 }
 
+template<class MemoryType>
+StackMark MemoryStack<MemoryType>::Mark()
+{
+    return StackMark{m_CurrentSize, ++m_Depth, m_Epoch};
+}
+
+template<class MemoryType>
+bool MemoryStack<MemoryType>::Rollback(const StackMark& mark)
+{
+    CheckMark(mark);
+    if(m_Account && m_CurrentSize > mark.offset)
+    {
+        m_Account->Released(m_CurrentSize - mark.offset);
+    }
+    m_CurrentPointer = static_cast<unsigned char*>(m_Memory->Data()) + mark.offset;
+    m_CurrentSize = mark.offset;
+    m_Depth = mark.depth - 1;
+    return true;
+}
+
+template<class MemoryType>
+void MemoryStack<MemoryType>::Unmark(const StackMark& mark)
+{
+    CheckMark(mark);
+    m_Depth = mark.depth - 1;
+}
+
 } // namespace trtlab
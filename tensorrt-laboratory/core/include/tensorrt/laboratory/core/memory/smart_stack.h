@@ -25,6 +25,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 
 #include <glog/logging.h>
@@ -43,23 +47,33 @@ class SmartStack : public MemoryStack<MemoryType>,
     using MemoryStack<MemoryType>::MemoryStack;
     using MemoryStack<MemoryType>::Allocate;
 
-    class StackDescriptorImpl : public Descriptor<MemoryType>
+    class StackDescriptorImpl : public Descriptor<MemoryType>,
+                                public PooledStorage<StackDescriptorImpl>
     {
       public:
         StackDescriptorImpl(std::shared_ptr<const SmartStack<MemoryType>> stack, void* ptr,
                             size_t size)
-            : Descriptor<MemoryType>(ptr, size, "SmartStack"), m_Stack(stack),
-              m_Offset(Stack().Offset(this->Data()))
+            : Descriptor<MemoryType>(ptr, size, "SmartStack"), m_Stack(std::move(stack)),
+              m_Offset(Stack().Offset(this->Data())), m_Depth(m_Stack->Depth()),
+              m_Generation(m_Stack->Acquired(m_Depth))
         {
         }
 
         StackDescriptorImpl(StackDescriptorImpl&& other)
-            : MemoryType(std::move(other)), m_Offset{std::exchange(other.m_Offset, 0)},
-              m_Stack{std::exchange(other.m_Stack, nullptr)}
+            : Descriptor<MemoryType>(std::move(other)),
+              m_Stack{std::exchange(other.m_Stack, nullptr)},
+              m_Offset{std::exchange(other.m_Offset, 0)}, m_Depth{other.m_Depth},
+              m_Generation{other.m_Generation}
         {
         }
 
-        virtual ~StackDescriptorImpl() override {}
+        virtual ~StackDescriptorImpl() override
+        {
+            if(m_Stack)
+            {
+                m_Stack->Released(m_Depth, m_Generation);
+            }
+        }
 
         size_t Offset() const { return m_Offset; }
 
@@ -68,6 +82,8 @@ class SmartStack : public MemoryStack<MemoryType>,
       private:
         std::shared_ptr<const SmartStack<MemoryType>> m_Stack;
         size_t m_Offset;
+        size_t m_Depth;
+        std::uint32_t m_Generation;
 
         friend class SmartStack<MemoryType>;
     };
@@ -76,28 +92,179 @@ class SmartStack : public MemoryStack<MemoryType>,
     using StackType = std::shared_ptr<SmartStack<MemoryType>>;
     using StackDescriptor = std::unique_ptr<StackDescriptorImpl>;
 
+    // Maximum number of nested marks; each level tracks its live descriptors
+    static constexpr size_t MaxDepth = 16;
+
     static StackType Create(size_t size) { return StackType(new SmartStack(size)); }
     static StackType Create(std::unique_ptr<MemoryType> memory)
     {
         return StackType(new SmartStack(memory));
     }
 
-    StackDescriptor Allocate(size_t size)
+    StackDescriptor Allocate(size_t size) { return Allocate(size, this->shared_from_this()); }
+
+    /**
+     * @brief Allocate a descriptor that holds a reference to `stack` rather than this stack
+     *
+     * For stacks shared through a handle other than the one they were created with, e.g. a
+     * segment popped from a Pool whose deleter recycles the segment; the descriptors must
+     * keep that handle alive so the stack is not recycled while they are in use.
+     */
+    StackDescriptor Allocate(size_t size, std::shared_ptr<const SmartStack<MemoryType>> stack)
     {
+        CHECK_EQ(stack.get(), this);
         CHECK_LE(size, this->Available());
 
         auto ptr = MemoryStack<MemoryType>::Allocate(size);
-        auto stack = this->shared_from_this();
 
         // Special Descriptor derived from MemoryType that hold a reference to the MemoryStack,
         // and who's destructor does not try to free the MemoryType memory.
-        auto ret = std::make_unique<StackDescriptorImpl>(stack, ptr, size);
+        // Descriptor storage is pooled per thread, so no heap allocation in steady state.
+        auto ret = std::make_unique<StackDescriptorImpl>(std::move(stack), ptr, size);
 
         DLOG(INFO) << "Allocated " << ret->Size() << " starting at " << ret->Data()
-                   << " on SmartStack " << stack.get();
+                   << " on SmartStack " << this;
+
+        return ret;
+    }
+
+    /**
+     * @brief Save the current stack pointer; see MemoryStack::Mark
+     */
+    StackMark Mark()
+    {
+        CHECK_LT(this->Depth(), MaxDepth) << "SmartStack marks nested too deeply";
+        return MemoryStack<MemoryType>::Mark();
+    }
+
+    /**
+     * @brief Return the stack pointer to a mark; see MemoryStack::Rollback
+     *
+     * The rollback is refused, leaving the stack unchanged, while any descriptor allocated
+     * after the mark is still alive.
+     *
+     * @return false if the rollback was refused
+     */
+    bool Rollback(const StackMark& mark)
+    {
+        this->CheckMark(mark);
+        for(auto depth = mark.depth; depth <= this->Depth(); depth++)
+        {
+            if(Count(m_LiveDescriptors[depth].load(std::memory_order_acquire)))
+            {
+                DLOG(INFO) << "Rollback refused; "
+                           << Count(m_LiveDescriptors[depth].load(std::memory_order_relaxed))
+                           << " live descriptors at depth " << depth;
+                return false;
+            }
+        }
+        for(auto depth = mark.depth + 1; depth <= MaxDepth; depth++)
+        {
+            if(m_FoldedDepth[depth] >= mark.depth &&
+               m_FoldedDescriptors[depth].load(std::memory_order_acquire))
+            {
+                DLOG(INFO) << "Rollback refused; descriptors of a discarded mark at depth "
+                           << depth << " are still alive";
+                return false;
+            }
+        }
+        return MemoryStack<MemoryType>::Rollback(mark);
+    }
+
+    /**
+     * @brief Discard a mark without moving the stack pointer; see MemoryStack::Unmark
+     *
+     * Descriptors allocated after the mark that are still alive are charged to the enclosing
+     * mark, so a rollback to it is refused until they are released.
+     */
+    void Unmark(const StackMark& mark)
+    {
+        this->CheckMark(mark);
+        auto parent = mark.depth - 1;
+        for(auto depth = mark.depth + 1; depth <= MaxDepth; depth++)
+        {
+            if(m_FoldedDepth[depth] >= mark.depth)
+            {
+                m_FoldedDepth[depth] = parent;
+            }
+        }
+        for(auto depth = mark.depth; depth <= this->Depth(); depth++)
+        {
+            // bump the generation so descriptors of the discarded mark release into the
+            // folded count rather than the count of the next mark taken at this depth
+            auto live = m_LiveDescriptors[depth].load(std::memory_order_relaxed);
+            live = m_LiveDescriptors[depth].exchange(Pack(Generation(live) + 1, 0),
+                                                     std::memory_order_acq_rel);
+            if(Count(live))
+            {
+                m_FoldedDescriptors[depth].fetch_add(Count(live), std::memory_order_acq_rel);
+                m_FoldedDepth[depth] = std::max(m_FoldedDepth[depth], parent);
+            }
+        }
+        MemoryStack<MemoryType>::Unmark(mark);
+    }
+
+    /**
+     * @brief Reset the stack pointer and discard every mark; see MemoryStack::Reset
+     *
+     * Descriptors still alive are charged to the base of the stack, which is never rolled
+     * back, rather than to the marks taken after the reset at their depth.
+     */
+    void Reset(bool writeZeros = false)
+    {
+        for(size_t depth = 0; depth <= MaxDepth; depth++)
+        {
+            // as in Unmark, but every descriptor is folded into the base of the stack, which
+            // is never rolled back; the folded counts are kept, not cleared, since descriptors
+            // alive across the reset are still released into them
+            auto live = m_LiveDescriptors[depth].load(std::memory_order_relaxed);
+            live = m_LiveDescriptors[depth].exchange(Pack(Generation(live) + 1, 0),
+                                                     std::memory_order_acq_rel);
+            if(Count(live))
+            {
+                m_FoldedDescriptors[depth].fetch_add(Count(live), std::memory_order_acq_rel);
+            }
+            m_FoldedDepth[depth] = 0;
+        }
+        MemoryStack<MemoryType>::Reset(writeZeros);
+    }
 
-        return std::move(ret);
+  private:
+    // Each depth packs the generation of its current mark with the count of live descriptors
+    // allocated under it.  Descriptors of an earlier generation were folded by Unmark.
+    static std::uint64_t Pack(std::uint32_t generation, std::uint32_t count)
+    {
+        return (static_cast<std::uint64_t>(generation) << 32) | count;
     }
+    static std::uint32_t Generation(std::uint64_t live) { return live >> 32; }
+    static std::uint32_t Count(std::uint64_t live) { return live & 0xFFFFFFFF; }
+
+    // Descriptors may be released from any thread
+    std::uint32_t Acquired(size_t depth) const
+    {
+        return Generation(m_LiveDescriptors[depth].fetch_add(1, std::memory_order_relaxed));
+    }
+    void Released(size_t depth, std::uint32_t generation) const
+    {
+        auto live = m_LiveDescriptors[depth].load(std::memory_order_relaxed);
+        while(Generation(live) == generation)
+        {
+            if(m_LiveDescriptors[depth].compare_exchange_weak(live, live - 1,
+                                                              std::memory_order_release,
+                                                              std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+        m_FoldedDescriptors[depth].fetch_sub(1, std::memory_order_release);
+    }
+
+    mutable std::array<std::atomic<std::uint64_t>, MaxDepth + 1> m_LiveDescriptors = {};
+
+    // Live descriptors of discarded marks and the depth of the mark now holding them; a depth
+    // that has been discarded more than once keeps the deepest holder, which is conservative
+    mutable std::array<std::atomic<size_t>, MaxDepth + 1> m_FoldedDescriptors = {};
+    std::array<size_t, MaxDepth + 1> m_FoldedDepth = {};
 };
 
 } // namespace trtlab
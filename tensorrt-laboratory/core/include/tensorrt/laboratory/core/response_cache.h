@@ -0,0 +1,319 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Keyed 128-bit digest of a request made of several buffers (SipHash-2-4-128)
+ *
+ * Buffers are digested in place, without copying the request.  Append prefixes each part
+ * with its size, so a request has exactly one encoding whatever the sizes of its parts.
+ *
+ * The default key is drawn at random once per process: without it, requests cannot be
+ * crafted to collide, and two different requests collide by accident with probability 2^-128.
+ */
+class RequestDigest
+{
+  public:
+    RequestDigest();
+    RequestDigest(std::uint64_t k0, std::uint64_t k1);
+
+    // size, then the bytes of one part of the request
+    RequestDigest& Append(const void* data, std::size_t size);
+
+    // bytes appended to the message as they are, for parts of a fixed size
+    RequestDigest& Update(const void* data, std::size_t size);
+
+    std::pair<std::uint64_t, std::uint64_t> Finish() const;
+
+  private:
+    void Compress(std::uint64_t m);
+
+    std::uint64_t m_V[4];
+    std::uint64_t m_Tail;
+    std::size_t m_Length;
+};
+
+/**
+ * @brief Identifies a response by the model that computed it and the digest of the request
+ */
+struct ResponseCacheKey
+{
+    ResponseCacheKey() = default;
+
+    ResponseCacheKey(std::string model, std::string version, const RequestDigest& digest)
+        : model(std::move(model)), version(std::move(version))
+    {
+        std::tie(hash, check) = digest.Finish();
+    }
+
+    std::string model;
+    std::string version;
+    // halves of the RequestDigest; hash locates the key, both identify it
+    std::uint64_t hash = 0;
+    std::uint64_t check = 0;
+
+    bool operator==(const ResponseCacheKey& other) const
+    {
+        return hash == other.hash && check == other.check && model == other.model &&
+               version == other.version;
+    }
+};
+
+struct ResponseCacheKeyHash
+{
+    std::size_t operator()(const ResponseCacheKey& key) const { return key.hash; }
+};
+
+/**
+ * @brief Memory-bounded cache of the responses to byte-identical requests
+ *
+ * Each entry is charged the bytes given to Insert plus EntryOverhead() and the heap storage
+ * of its model and version names, so that small responses cannot grow the cache past its
+ * capacity.  Once the charge exceeds the capacity, the least recently used entries are
+ * evicted; with a ttl, entries also expire ttl after they were inserted.
+ *
+ * The cache is split into shards by key hash, each with its own lock, LRU list and an equal
+ * share of the capacity.  Values are shared_ptr<const T>: a hit does not copy the response
+ * and an evicted response lives on until its last reader lets go.
+ */
+template<typename T>
+class ResponseCache
+{
+  public:
+    using clock = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+    using duration = clock::duration;
+
+    struct Stats
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t expirations = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /**
+     * @param capacity bytes across all shards
+     * @param ttl zero keeps entries until they are evicted
+     * @param shards reduced, if needed, so that every shard can hold at least one entry
+     */
+    ResponseCache(std::size_t capacity, duration ttl = duration::zero(), std::size_t shards = 16)
+        : m_Ttl(ttl),
+          m_Shards(std::max<std::size_t>(std::min(shards, capacity / (EntryOverhead() + 1)), 1))
+    {
+        shards = m_Shards.size();
+        for(auto& shard : m_Shards)
+        {
+            shard.capacity = capacity / shards;
+        }
+    }
+    virtual ~ResponseCache() {}
+
+    DELETE_COPYABILITY(ResponseCache);
+    DELETE_MOVEABILITY(ResponseCache);
+
+    /**
+     * @brief The cached response to key, or nullptr on a miss
+     */
+    std::shared_ptr<const T> Find(const ResponseCacheKey& key, time_point now = clock::now())
+    {
+        auto& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto search = shard.index.find(&key);
+        if(search == shard.index.end())
+        {
+            shard.stats.misses++;
+            return nullptr;
+        }
+        auto entry = search->second;
+        if(m_Ttl != duration::zero() && entry->expires <= now)
+        {
+            shard.Erase(entry);
+            shard.stats.expirations++;
+            shard.stats.misses++;
+            return nullptr;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+        shard.stats.hits++;
+        return entry->value;
+    }
+
+    /**
+     * @brief Cache value as the response to key, replacing any previous one
+     *
+     * Entries whose charge is larger than a shard's share of the capacity are not cached.
+     */
+    void Insert(const ResponseCacheKey& key, std::shared_ptr<const T> value, std::size_t bytes,
+                time_point now = clock::now())
+    {
+        auto& shard = GetShard(key);
+        auto charge = bytes + EntryOverhead() + HeapBytes(key.model) + HeapBytes(key.version);
+        if(charge > shard.capacity)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto search = shard.index.find(&key);
+        if(search != shard.index.end())
+        {
+            shard.Erase(search->second);
+        }
+        // the entry holds the only copy of the key; the index points into it
+        shard.lru.push_front(Entry{key, std::move(value), charge, now + m_Ttl});
+        shard.index.emplace(&shard.lru.front().key, shard.lru.begin());
+        shard.bytes += charge;
+        while(shard.bytes > shard.capacity)
+        {
+            shard.Erase(std::prev(shard.lru.end()));
+            shard.stats.evictions++;
+        }
+    }
+
+    void Clear()
+    {
+        for(auto& shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.lru.clear();
+            shard.bytes = 0;
+        }
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        for(auto& shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.hits += shard.stats.hits;
+            stats.misses += shard.stats.misses;
+            stats.evictions += shard.stats.evictions;
+            stats.expirations += shard.stats.expirations;
+            stats.entries += shard.index.size();
+            stats.bytes += shard.bytes;
+        }
+        return stats;
+    }
+
+    /**
+     * @brief Bytes charged to every entry for its bookkeeping, besides its value
+     *
+     * The LRU list node holding the entry and its key, the index node pointing at it, its
+     * bucket and the allocator header of both nodes.
+     */
+    static constexpr std::size_t EntryOverhead()
+    {
+        return sizeof(Entry) + 2 * sizeof(void*) + sizeof(typename Index::value_type) +
+               3 * sizeof(void*) + 2 * MallocHeader;
+    }
+
+  private:
+    static constexpr std::size_t MallocHeader = 16;
+    struct Entry
+    {
+        ResponseCacheKey key;
+        std::shared_ptr<const T> value;
+        std::size_t bytes;
+        time_point expires;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const ResponseCacheKey* key) const { return key->hash; }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const ResponseCacheKey* a, const ResponseCacheKey* b) const
+        {
+            return *a == *b;
+        }
+    };
+
+    using Index =
+        std::unordered_map<const ResponseCacheKey*, typename std::list<Entry>::iterator, KeyHash,
+                           KeyEqual>;
+
+    // heap storage of a name; short names are stored inline and cost nothing extra
+    static std::size_t HeapBytes(const std::string& name)
+    {
+        auto object = reinterpret_cast<const char*>(&name);
+        auto data = name.data();
+        auto inline_data = data >= object && data < object + sizeof(name);
+        return inline_data ? 0 : name.capacity() + 1 + MallocHeader;
+    }
+
+    struct Shard
+    {
+        using iterator = typename std::list<Entry>::iterator;
+
+        void Erase(iterator entry)
+        {
+            bytes -= entry->bytes;
+            index.erase(&entry->key);
+            lru.erase(entry);
+        }
+
+        mutable std::mutex mutex;
+        // most recently used first
+        std::list<Entry> lru;
+        Index index;
+        std::size_t bytes = 0;
+        std::size_t capacity = 0;
+        Stats stats;
+    };
+
+    Shard& GetShard(const ResponseCacheKey& key)
+    {
+        // the low bits pick the hash table bucket within the shard
+        return m_Shards[(key.hash >> 32) % m_Shards.size()];
+    }
+
+    duration m_Ttl;
+    std::vector<Shard> m_Shards;
+};
+
+} // namespace trtlab
@@ -0,0 +1,190 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/response_cache.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Coalesces concurrent executions of identical requests
+ *
+ * While a key is in flight, every Join for that key attaches to the execution in flight
+ * instead of starting another.  The first caller to Join is the leader: it executes the
+ * request and publishes the result with Complete, or an exception with Fail.  Every caller's
+ * callback, the leader's included, then receives the same shared result or exception.
+ *
+ * The key is released on Complete or Fail, so later requests execute afresh; pair with a
+ * ResponseCache to reuse finished results as well.  Callbacks run on the thread completing
+ * the flight, outside the lock.  A leader whose work continues on other threads should land
+ * the flight through a Guard, so the key is not held forever if that work is dropped.
+ */
+template<typename T, typename Key = ResponseCacheKey, typename Hash = ResponseCacheKeyHash>
+class SingleFlight
+{
+  public:
+    using Result = std::shared_ptr<const T>;
+    using Callback = std::function<void(const Result&, std::exception_ptr)>;
+
+    SingleFlight() : m_Executions(0), m_Coalesced(0) {}
+    virtual ~SingleFlight() {}
+
+    DELETE_COPYABILITY(SingleFlight);
+    DELETE_MOVEABILITY(SingleFlight);
+
+    /**
+     * @brief Attach callback to the flight for key
+     *
+     * @return true if the caller leads the flight and must Complete or Fail it
+     */
+    bool Join(const Key& key, Callback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto flight = m_Flights.try_emplace(key);
+        flight.first->second.push_back(std::move(callback));
+        flight.second ? m_Executions++ : m_Coalesced++;
+        return flight.second;
+    }
+
+    void Complete(const Key& key, Result result) { Land(key, std::move(result), nullptr); }
+    void Fail(const Key& key, std::exception_ptr exception) { Land(key, nullptr, exception); }
+
+    /**
+     * @brief Lands the leader's flight once; fails it with broken_promise if destroyed first
+     *
+     * Captured by the work executing the flight, the guard dies with that work when it is
+     * dropped without completing, e.g. when a stage throws inside a ThreadPool task.
+     */
+    class Guard
+    {
+      public:
+        Guard(SingleFlight& flights, Key key) : m_Flights(&flights), m_Key(std::move(key)) {}
+        ~Guard()
+        {
+            Fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+
+        DELETE_COPYABILITY(Guard);
+        DELETE_MOVEABILITY(Guard);
+
+        // only the first of Complete and Fail lands the flight; later calls are ignored
+        void Complete(Result result)
+        {
+            if(auto flights = m_Flights.exchange(nullptr))
+            {
+                flights->Complete(m_Key, std::move(result));
+            }
+        }
+        void Fail(std::exception_ptr exception)
+        {
+            if(auto flights = m_Flights.exchange(nullptr))
+            {
+                flights->Fail(m_Key, exception);
+            }
+        }
+
+      private:
+        std::atomic<SingleFlight*> m_Flights;
+        Key m_Key;
+    };
+
+    /**
+     * @brief Blocking form: the leader runs fn inline and every caller waits for its result
+     *
+     * Exceptions thrown by fn are rethrown to every caller.
+     */
+    template<typename Fn>
+    Result Do(const Key& key, Fn fn)
+    {
+        auto promise = std::make_shared<std::promise<Result>>();
+        auto future = promise->get_future();
+        auto leader = Join(key, [promise](const Result& result, std::exception_ptr exception) {
+            exception ? promise->set_exception(exception) : promise->set_value(result);
+        });
+        if(leader)
+        {
+            try
+            {
+                Complete(key, std::make_shared<const T>(fn()));
+            }
+            catch(...)
+            {
+                Fail(key, std::current_exception());
+            }
+        }
+        return future.get();
+    }
+
+    // flights led and callers attached to a flight in progress
+    std::size_t Executions() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Executions;
+    }
+    std::size_t Coalesced() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Coalesced;
+    }
+
+  private:
+    void Land(const Key& key, Result result, std::exception_ptr exception)
+    {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto search = m_Flights.find(key);
+            CHECK(search != m_Flights.end()) << "no flight in progress for key";
+            callbacks = std::move(search->second);
+            m_Flights.erase(search);
+        }
+        for(auto& callback : callbacks)
+        {
+            callback(result, exception);
+        }
+    }
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<Key, std::vector<Callback>, Hash> m_Flights;
+    std::size_t m_Executions;
+    std::size_t m_Coalesced;
+};
+
+} // namespace trtlab
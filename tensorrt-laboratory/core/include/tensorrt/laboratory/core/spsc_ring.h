@@ -0,0 +1,153 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Bounded, lock-free, single-producer / single-consumer ring
+ *
+ * Slots are constructed once, up front, and reused: TryPush move-assigns into a slot and the
+ * consumer operates on the element in place via Front before releasing it with Pop.  A popped
+ * slot keeps whatever storage its element owned until it is overwritten, so message types
+ * whose move assignment swaps buffers (e.g. protobuf) circulate without heap allocations.
+ *
+ * Exactly one thread at a time may push and one thread at a time may consume; callers with
+ * several producers or consumers must serialize them.  The capacity is rounded up to a power
+ * of two.
+ */
+template<typename T>
+class SpscRing
+{
+  public:
+    explicit SpscRing(std::size_t capacity)
+        : m_Slots(RoundUp(capacity)), m_Mask(m_Slots.size() - 1), m_Head(0), m_Tail(0),
+          m_CachedHead(0), m_CachedTail(0)
+    {
+    }
+
+    DELETE_COPYABILITY(SpscRing);
+    DELETE_MOVEABILITY(SpscRing);
+
+    /**
+     * @brief Producer: append value; returns false, leaving value untouched, if the ring is full
+     */
+    bool TryPush(T&& value)
+    {
+        auto tail = m_Tail.load(std::memory_order_relaxed);
+        if(tail - m_CachedHead == m_Slots.size())
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if(tail - m_CachedHead == m_Slots.size())
+            {
+                return false;
+            }
+        }
+        m_Slots[tail & m_Mask] = std::move(value);
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer: oldest element, or nullptr if the ring is empty
+     *
+     * The element stays valid, and is not touched by the producer, until Pop.
+     */
+    T* Front() { return Peek(0); }
+
+    /**
+     * @brief Consumer: the element i places behind the oldest, or nullptr
+     */
+    T* Peek(std::size_t i)
+    {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        if(m_CachedTail - head <= i)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if(m_CachedTail - head <= i)
+            {
+                return nullptr;
+            }
+        }
+        return &m_Slots[(head + i) & m_Mask];
+    }
+
+    /**
+     * @brief Consumer: release the oldest element; the ring must not be empty
+     */
+    void Pop()
+    {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        DCHECK_NE(head, m_Tail.load(std::memory_order_acquire)) << "Pop on an empty SpscRing";
+        m_Head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of elements; exact only when called by the producer or the consumer with
+     * the other side idle
+     */
+    std::size_t Size() const
+    {
+        return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+    std::size_t Capacity() const { return m_Slots.size(); }
+
+  private:
+    static std::size_t RoundUp(std::size_t capacity)
+    {
+        CHECK_GT(capacity, 0);
+        std::size_t size = 1;
+        while(size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    std::vector<T> m_Slots;
+    const std::size_t m_Mask;
+
+    // head is written by the consumer and tail by the producer; each side keeps a cached copy
+    // of the other's index so the shared cache lines are only read when the ring looks full
+    // or empty
+    alignas(64) std::atomic<std::size_t> m_Head;
+    alignas(64) std::atomic<std::size_t> m_Tail;
+    alignas(64) std::size_t m_CachedHead; // producer
+    alignas(64) std::size_t m_CachedTail; // consumer
+};
+
+} // namespace trtlab
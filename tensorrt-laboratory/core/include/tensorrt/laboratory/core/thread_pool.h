@@ -56,10 +56,12 @@
 //   * Added CPU affinity options to the constructor
 //   * Added Size() method to get thread count
 //   * Implemented transwarp::executor protocol
+//   * Added optional per-task instrumentation via the StatsType policy
 //
 #pragma once
 
 #include "tensorrt/laboratory/core/affinity.h"
+#include "tensorrt/laboratory/core/thread_pool_stats.h"
 #include "tensorrt/laboratory/core/utils.h"
 
 #include <future>
@@ -69,10 +71,14 @@
 
 namespace trtlab {
 
-template<typename MutexType, typename ConditionType>
+template<typename MutexType, typename ConditionType, typename StatsType = NullThreadPoolStats>
 class BaseThreadPool;
 
+#ifdef TRTLAB_THREAD_POOL_STATS
+using ThreadPool = BaseThreadPool<std::mutex, std::condition_variable, ThreadPoolStats>;
+#else
 using ThreadPool = BaseThreadPool<std::mutex, std::condition_variable>;
+#endif
 
 /**
  * @brief Manages a Pool of Threads that consume a shared work Queue
@@ -81,8 +87,11 @@ using ThreadPool = BaseThreadPool<std::mutex, std::condition_variable>;
  * the YAIS examples and tests.  The library is entirely a BYO-resources;
  * however, this implemenation is provided as a convenience class.  Many thanks
  * to the original authors for a beautifully designed class.
+ *
+ * StatsType selects the per-task instrumentation policy.  The default NullThreadPoolStats
+ * compiles to the uninstrumented pool; ThreadPoolStats records queue wait and run times.
  */
-template<typename MutexType, typename ConditionType>
+template<typename MutexType, typename ConditionType, typename StatsType>
 class BaseThreadPool
 {
   public:
@@ -146,6 +155,11 @@ class BaseThreadPool
      */
     int Size();
 
+    /**
+     * @brief Per-task instrumentation; call GetSnapshot() when StatsType is ThreadPoolStats
+     */
+    const StatsType& Stats() const { return m_Stats; }
+
 #ifdef USE_TRANSWARP
     // transwarp interface: get_name, execute
 
@@ -176,12 +190,14 @@ class BaseThreadPool
     MutexType m_QueueMutex;
     ConditionType m_Condition;
     bool stop;
+
+    StatsType m_Stats;
 };
 
 // add new work item to the pool
-template<typename MutexType, typename ConditionType>
+template<typename MutexType, typename ConditionType, typename StatsType>
 template<class F, class... Args>
-auto BaseThreadPool<MutexType, ConditionType>::enqueue(F&& f, Args&&... args)
+auto BaseThreadPool<MutexType, ConditionType, StatsType>::enqueue(F&& f, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using return_type = typename std::result_of<F(Args...)>::type;
@@ -196,20 +212,32 @@ auto BaseThreadPool<MutexType, ConditionType>::enqueue(F&& f, Args&&... args)
         // don't allow enqueueing after stopping the pool
         if(stop) throw std::runtime_error("enqueue on stopped BaseThreadPool");
 
-        tasks.emplace([task]() { (*task)(); });
+        if constexpr(StatsType::Enabled)
+        {
+            auto enqueued_at = m_Stats.Enqueued(tasks.size() + 1);
+            tasks.emplace([this, task, enqueued_at]() {
+                auto started_at = m_Stats.Started(enqueued_at);
+                (*task)();
+                m_Stats.Finished(started_at);
+            });
+        }
+        else
+        {
+            tasks.emplace([task]() { (*task)(); });
+        }
     }
     m_Condition.notify_one();
     return res;
 }
 
-template<typename MutexType, typename ConditionType>
-BaseThreadPool<MutexType, ConditionType>::BaseThreadPool(size_t nThreads)
+template<typename MutexType, typename ConditionType, typename StatsType>
+BaseThreadPool<MutexType, ConditionType, StatsType>::BaseThreadPool(size_t nThreads)
     : BaseThreadPool(nThreads, Affinity::GetAffinity())
 {
 }
 
-template<typename MutexType, typename ConditionType>
-BaseThreadPool<MutexType, ConditionType>::BaseThreadPool(size_t nThreads,
+template<typename MutexType, typename ConditionType, typename StatsType>
+BaseThreadPool<MutexType, ConditionType, StatsType>::BaseThreadPool(size_t nThreads,
                                                          const CpuSet& affinity_mask)
     : stop(false)
 {
@@ -219,8 +247,9 @@ BaseThreadPool<MutexType, ConditionType>::BaseThreadPool(size_t nThreads,
     }
 }
 
-template<typename MutexType, typename ConditionType>
-BaseThreadPool<MutexType, ConditionType>::BaseThreadPool(const CpuSet& cpus) : stop(false)
+template<typename MutexType, typename ConditionType, typename StatsType>
+BaseThreadPool<MutexType, ConditionType, StatsType>::BaseThreadPool(const CpuSet& cpus)
+    : stop(false)
 {
     auto exclusive = cpus.GetAllocator();
     for(size_t i = 0; i < exclusive.size(); i++)
@@ -231,8 +260,8 @@ BaseThreadPool<MutexType, ConditionType>::BaseThreadPool(const CpuSet& cpus) : s
     }
 }
 
-template<typename MutexType, typename ConditionType>
-void BaseThreadPool<MutexType, ConditionType>::CreateThread(const CpuSet& affinity_mask)
+template<typename MutexType, typename ConditionType, typename StatsType>
+void BaseThreadPool<MutexType, ConditionType, StatsType>::CreateThread(const CpuSet& affinity_mask)
 {
     workers.emplace_back([this, affinity_mask]() {
         Affinity::SetAffinity(affinity_mask);
@@ -255,8 +284,8 @@ void BaseThreadPool<MutexType, ConditionType>::CreateThread(const CpuSet& affini
 }
 
 // the destructor joins all threads
-template<typename MutexType, typename ConditionType>
-BaseThreadPool<MutexType, ConditionType>::~BaseThreadPool()
+template<typename MutexType, typename ConditionType, typename StatsType>
+BaseThreadPool<MutexType, ConditionType, StatsType>::~BaseThreadPool()
 {
     {
         std::lock_guard<MutexType> lock(m_QueueMutex);
@@ -270,8 +299,8 @@ BaseThreadPool<MutexType, ConditionType>::~BaseThreadPool()
     }
 }
 
-template<typename MutexType, typename ConditionType>
-int BaseThreadPool<MutexType, ConditionType>::Size()
+template<typename MutexType, typename ConditionType, typename StatsType>
+int BaseThreadPool<MutexType, ConditionType, StatsType>::Size()
 {
     return workers.size();
 }
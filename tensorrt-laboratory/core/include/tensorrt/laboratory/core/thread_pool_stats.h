@@ -0,0 +1,140 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "tensorrt/laboratory/core/histogram.h"
+#include "tensorrt/laboratory/core/tsc_clock.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Default BaseThreadPool statistics policy - records nothing
+ *
+ * BaseThreadPool compiles the instrumentation out entirely when StatsType::Enabled is false;
+ * the enqueued task is exactly the uninstrumented lambda.
+ */
+struct NullThreadPoolStats
+{
+    static constexpr bool Enabled = false;
+};
+
+/**
+ * @brief Per-task BaseThreadPool instrumentation
+ *
+ * Each task is stamped with the TscClock when it is enqueued, when a worker starts it and
+ * when it finishes.  Queue wait and run times (in nanoseconds) feed lock-free Histograms;
+ * enqueue/complete counts and the maximum observed queue depth are kept as relaxed
+ * atomic counters.  All values can be read at any time via GetSnapshot.
+ *
+ * Enabled for the ThreadPool alias by building with TRTLAB_THREAD_POOL_STATS, or per pool
+ * by naming it as the StatsType of a BaseThreadPool.
+ */
+class ThreadPoolStats
+{
+  public:
+    static constexpr bool Enabled = true;
+
+    ThreadPoolStats()
+        : m_NanosecondsPerTick(TscClock::NanosecondsPerTick()), m_CreatedAt(TscClock::Now()),
+          m_Enqueued(0), m_Completed(0), m_MaxQueueDepth(0)
+    {
+    }
+
+    DELETE_COPYABILITY(ThreadPoolStats);
+    DELETE_MOVEABILITY(ThreadPoolStats);
+
+    struct Snapshot
+    {
+        std::uint64_t enqueued;
+        std::uint64_t completed;
+        std::uint64_t max_queue_depth;
+        double uptime; // seconds
+        Histogram::Snapshot wait; // nanoseconds
+        Histogram::Snapshot run; // nanoseconds
+
+        std::uint64_t Pending() const { return enqueued - completed; }
+        double Throughput() const { return uptime > 0 ? completed / uptime : 0.0; }
+    };
+
+    // Called with the queue lock held
+    std::uint64_t Enqueued(std::size_t queue_depth) noexcept
+    {
+        m_Enqueued.fetch_add(1, std::memory_order_relaxed);
+        if(queue_depth > m_MaxQueueDepth.load(std::memory_order_relaxed))
+        {
+            m_MaxQueueDepth.store(queue_depth, std::memory_order_relaxed);
+        }
+        return TscClock::Now();
+    }
+
+    std::uint64_t Started(std::uint64_t enqueued_at) noexcept
+    {
+        auto now = TscClock::Now();
+        m_Wait.Record(ToNanoseconds(now - enqueued_at));
+        return now;
+    }
+
+    void Finished(std::uint64_t started_at) noexcept
+    {
+        m_Run.Record(ToNanoseconds(TscClock::Now() - started_at));
+        m_Completed.fetch_add(1, std::memory_order_release);
+    }
+
+    // completed is loaded first: the histograms read after it hold at least the samples of
+    // every task it counts, and enqueued at least as many tasks
+    Snapshot GetSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.completed = m_Completed.load(std::memory_order_acquire);
+        snapshot.wait = m_Wait.GetSnapshot();
+        snapshot.run = m_Run.GetSnapshot();
+        snapshot.enqueued = m_Enqueued.load(std::memory_order_relaxed);
+        snapshot.max_queue_depth = m_MaxQueueDepth.load(std::memory_order_relaxed);
+        snapshot.uptime = ToNanoseconds(TscClock::Now() - m_CreatedAt) * 1.0e-9;
+        return snapshot;
+    }
+
+  private:
+    inline std::uint64_t ToNanoseconds(std::uint64_t ticks) const
+    {
+        return (std::uint64_t)(ticks * m_NanosecondsPerTick);
+    }
+
+    const double m_NanosecondsPerTick;
+    const std::uint64_t m_CreatedAt;
+    std::atomic<std::uint64_t> m_Enqueued;
+    std::atomic<std::uint64_t> m_Completed;
+    std::atomic<std::uint64_t> m_MaxQueueDepth;
+    Histogram m_Wait;
+    Histogram m_Run;
+};
+
+} // namespace trtlab
@@ -0,0 +1,176 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Hierarchical Timer Wheel
+ *
+ * Four levels of 256 slots, each level covering 256x the span of the level below, for a
+ * total horizon of 2^32 ticks (~49 days at the default 1ms resolution); timers beyond the
+ * horizon are parked in the top level and re-cascaded until they come into range.
+ *
+ * Schedule and Cancel are O(1): timers are nodes of a slab-allocated, index-linked list
+ * threaded through the slots, and a TimerId carries a generation count so cancelling an
+ * already fired or recycled timer is a safe no-op.  Advance fires every timer whose
+ * deadline has passed; it jumps from one occupied slot to the next using the occupancy
+ * bitmap, so idle ticks are skipped and the cost is bounded by the slots cascaded or fired,
+ * not by the time since the last Advance.
+ *
+ * Timers never fire early: deadlines are rounded up to the next tick.
+ *
+ * TimerWheel is not thread-safe; the owner is expected to serialize access, e.g. the
+ * nvrpc Executor guards its wheel with a mutex and drives it from its progress engines.
+ */
+class TimerWheel
+{
+  public:
+    using clock = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+    using duration = std::chrono::nanoseconds;
+    using Callback = std::function<void()>;
+    using TimerId = std::uint64_t;
+
+    static constexpr TimerId InvalidTimer = 0;
+
+    TimerWheel(duration resolution = std::chrono::milliseconds(1),
+               time_point now = clock::now());
+    virtual ~TimerWheel() {}
+
+    DELETE_COPYABILITY(TimerWheel);
+    DELETE_MOVEABILITY(TimerWheel);
+
+    /**
+     * @brief Arm a timer which fires on the first Advance at or after deadline
+     */
+    TimerId Schedule(time_point deadline, Callback callback);
+
+    /**
+     * @brief Arm a timer relative to the last time the wheel was advanced
+     */
+    TimerId ScheduleAfter(duration timeout, Callback callback)
+    {
+        return Schedule(m_Origin + Ticks(m_CurrentTick) + timeout, std::move(callback));
+    }
+
+    /**
+     * @brief Disarm a pending timer
+     *
+     * @return true if the timer was pending; false if it has already fired, been cancelled,
+     * or the id is invalid
+     */
+    bool Cancel(TimerId id);
+
+    /**
+     * @brief Fire all timers with deadline <= now by invoking their callbacks inline
+     *
+     * Callbacks may schedule or cancel timers on this wheel.
+     *
+     * @return number of timers fired
+     */
+    std::size_t Advance(time_point now);
+
+    /**
+     * @brief Move the callbacks of all timers with deadline <= now into expired
+     *
+     * Lets the owner run the callbacks after releasing whatever lock guards the wheel.
+     *
+     * @return number of timers expired
+     */
+    std::size_t Advance(time_point now, std::vector<Callback>& expired);
+
+    /**
+     * @brief Earliest time at which Advance might fire a timer; time_point::max() if empty
+     *
+     * Exact for timers in the lowest level.  For higher levels the next cascade point is
+     * returned, which is never later than the true deadline.  This is the value an event
+     * loop should use as its wait deadline.
+     */
+    time_point NextDeadline() const;
+
+    std::size_t Size() const { return m_Size; }
+    bool Empty() const { return m_Size == 0; }
+    duration Resolution() const { return m_Resolution; }
+
+  private:
+    static constexpr int LevelBits = 8;
+    static constexpr int Levels = 4;
+    static constexpr std::uint32_t SlotsPerLevel = 1 << LevelBits;
+    static constexpr std::uint32_t SlotMask = SlotsPerLevel - 1;
+    static constexpr std::uint32_t Slots = Levels * SlotsPerLevel;
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+    struct Node
+    {
+        std::uint64_t expiry;
+        Callback callback;
+        std::uint32_t prev;
+        std::uint32_t next;
+        std::uint32_t generation;
+        std::uint32_t slot;
+    };
+
+    duration Ticks(std::uint64_t ticks) const { return ticks * m_Resolution; }
+
+    std::uint32_t AllocateNode();
+    void ReleaseNode(std::uint32_t index);
+    void Insert(std::uint32_t index);
+    void Unlink(std::uint32_t index);
+    void Cascade(int level, std::uint32_t slot);
+    template<typename OnExpired>
+    std::size_t AdvanceTo(time_point now, OnExpired on_expired);
+
+    // first tick after m_CurrentTick at which a slot fires or cascades; requires m_Size > 0
+    std::uint64_t NextEventTick() const;
+    // distance in slots to the next occupied slot of a level, or 0 if the level is empty
+    std::uint32_t NextOccupied(int level, std::uint32_t current) const;
+    bool Occupied(std::uint32_t slot) const { return m_Occupied[slot / 64] & (1ULL << slot % 64); }
+    void SetOccupied(std::uint32_t slot) { m_Occupied[slot / 64] |= (1ULL << slot % 64); }
+    void ClearOccupied(std::uint32_t slot) { m_Occupied[slot / 64] &= ~(1ULL << slot % 64); }
+
+    const duration m_Resolution;
+    const time_point m_Origin;
+    std::uint64_t m_CurrentTick;
+    std::size_t m_Size;
+
+    std::array<std::uint32_t, Slots> m_Heads;
+    std::array<std::uint64_t, Slots / 64> m_Occupied;
+    std::vector<Node> m_Nodes;
+    std::uint32_t m_FreeList;
+};
+
+} // namespace trtlab
@@ -0,0 +1,181 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include "tensorrt/laboratory/core/tsc_clock.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Sampled per-request tracing of pipeline stages
+ *
+ * A request is sampled once, where it enters the process, and carries its trace Id across
+ * threads: code handing work to another thread captures Current() and re-installs it with
+ * a TraceScope.  Every stage of a sampled request records a span [begin, end) in TscClock
+ * ticks into a lock-free ring owned by the recording thread; unsampled requests have the
+ * Id 0 and cost a thread-local load per stage.
+ *
+ * WriteChromeTrace exports the spans still held by the rings as Chrome trace event JSON,
+ * loadable in chrome://tracing or Perfetto.  Each request is shown as its own process with
+ * one track per thread that worked on it.
+ */
+class RequestTrace
+{
+  public:
+    using Id = std::uint64_t;
+
+    /**
+     * @brief Spans kept per ring; older spans are overwritten
+     *
+     * Each live thread records into a ring of its own.  The ring of an exited thread keeps
+     * its spans until a thread started later reuses it.
+     */
+    static constexpr std::uint64_t RingCapacity = 4096;
+
+    /**
+     * @brief Fraction of requests Sample() selects, clamped to [0, 1]; defaults to 0
+     */
+    static void SetSampleRate(double rate);
+    static double SampleRate();
+
+    /**
+     * @brief A new trace Id for a sampled request; otherwise 0
+     */
+    static Id Sample()
+    {
+        auto threshold = s_Threshold.load(std::memory_order_relaxed);
+        return threshold && NextRandom() <= threshold ? NextId() : 0;
+    }
+
+    /**
+     * @brief Trace of the request the calling thread is working on; 0 if none is sampled
+     */
+    static Id Current() { return t_Current; }
+    static void SetCurrent(Id id) { t_Current = id; }
+
+    /**
+     * @brief Timestamp for a span of trace id; free when the request is not sampled
+     */
+    static std::uint64_t Stamp(Id id) { return id ? TscClock::Now() : 0; }
+
+    /**
+     * @brief Record the span [begin, end) of stage for trace id
+     *
+     * stage must outlive the trace, e.g. a string literal.
+     */
+    static void Record(Id id, const char* stage, std::uint64_t begin, std::uint64_t end)
+    {
+        if(id)
+        {
+            Append(id, stage, begin, end);
+        }
+    }
+
+    /**
+     * @brief Record the span from begin, taken with Stamp(id), to now
+     */
+    static void RecordSince(Id id, const char* stage, std::uint64_t begin)
+    {
+        if(id)
+        {
+            Append(id, stage, begin, TscClock::Now());
+        }
+    }
+
+    /**
+     * @brief Spans of all threads as Chrome trace event JSON
+     */
+    static void WriteChromeTrace(std::ostream&);
+
+  private:
+    // xorshift64*; the state is seeded per thread on first use
+    static std::uint64_t NextRandom()
+    {
+        auto x = t_Random ? t_Random : Seed();
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        t_Random = x;
+        return x * 0x2545F4914F6CDD1DULL;
+    }
+
+    static std::uint64_t Seed();
+    static Id NextId();
+    static void Append(Id, const char*, std::uint64_t, std::uint64_t);
+
+    // Sample() accepts random values <= s_Threshold; 0 disables sampling
+    static inline std::atomic<std::uint64_t> s_Threshold{0};
+    static inline thread_local Id t_Current = 0;
+    static inline thread_local std::uint64_t t_Random = 0;
+};
+
+/**
+ * @brief Installs a trace Id as RequestTrace::Current() for the lifetime of the scope
+ */
+class TraceScope
+{
+  public:
+    TraceScope(RequestTrace::Id id) : m_Previous(RequestTrace::Current())
+    {
+        RequestTrace::SetCurrent(id);
+    }
+    ~TraceScope() { RequestTrace::SetCurrent(m_Previous); }
+
+    DELETE_COPYABILITY(TraceScope);
+    DELETE_MOVEABILITY(TraceScope);
+
+  private:
+    RequestTrace::Id m_Previous;
+};
+
+/**
+ * @brief Records the lifetime of the scope as a stage of the current trace
+ */
+class TraceSpan
+{
+  public:
+    TraceSpan(const char* stage)
+        : m_Id(RequestTrace::Current()), m_Stage(stage), m_Begin(RequestTrace::Stamp(m_Id))
+    {
+    }
+    ~TraceSpan() { RequestTrace::RecordSince(m_Id, m_Stage, m_Begin); }
+
+    DELETE_COPYABILITY(TraceSpan);
+    DELETE_MOVEABILITY(TraceSpan);
+
+  private:
+    RequestTrace::Id m_Id;
+    const char* m_Stage;
+    std::uint64_t m_Begin;
+};
+
+} // namespace trtlab
@@ -25,17 +25,29 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "tensorrt/laboratory/core/memory/copy.h"
+#include "tensorrt/laboratory/core/memory/copy_engine.h"
 
 #include <cstring>
 #include <glog/logging.h>
 
 namespace trtlab {
 
+void HostCopy(void* dst, const void* src, size_t size)
+{
+    auto engine = CopyEngine::Default();
+    if(engine)
+    {
+        engine->Copy(dst, src, size);
+        return;
+    }
+    std::memcpy(dst, src, size);
+}
+
 void Copy(HostMemory& dst, size_t dst_offset, const HostMemory& src, size_t src_offset, size_t size)
 {
     CHECK_LE(size, dst.Size() - dst_offset) << "Copy: dst range is invalid";
     CHECK_LE(size, src.Size() - src_offset) << "Copy: src range is invalid";
-    std::memcpy(dst[dst_offset], src[src_offset], size);
+    HostCopy(dst[dst_offset], src[src_offset], size);
 }
 
 } // namespace trtlab
\ No newline at end of file
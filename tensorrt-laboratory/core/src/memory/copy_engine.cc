@@ -0,0 +1,172 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/copy_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <glog/logging.h>
+
+namespace trtlab {
+
+namespace {
+constexpr size_t PageSize = 4096;
+
+std::atomic<CopyEngine*> s_DefaultEngine(nullptr);
+} // namespace
+
+CopyEngine::CopyEngine(const CpuSet& cpus) : CopyEngine(std::make_shared<ThreadPool>(cpus)) {}
+
+CopyEngine::CopyEngine(std::shared_ptr<ThreadPool> workers)
+    : m_Workers(std::move(workers)), m_StreamingThreshold(DefaultStreamingThreshold),
+      m_ParallelThreshold(DefaultParallelThreshold), m_ChunkSize(DefaultChunkSize)
+{
+}
+
+void CopyEngine::SetChunkSize(size_t bytes)
+{
+    CHECK_GE(bytes, PageSize);
+    m_ChunkSize = bytes;
+}
+
+void CopyEngine::Copy(HostMemory& dst, size_t dst_offset, const HostMemory& src,
+                      size_t src_offset, size_t size)
+{
+    CHECK_LE(size, dst.Size() - dst_offset) << "Copy: dst range is invalid";
+    CHECK_LE(size, src.Size() - src_offset) << "Copy: src range is invalid";
+    Copy(dst[dst_offset], src[src_offset], size);
+}
+
+void CopyEngine::Copy(void* dst, const void* src, size_t size)
+{
+    bool streaming = size >= m_StreamingThreshold;
+    size_t workers = m_Workers ? m_Workers->Size() : 0;
+    if(size < m_ParallelThreshold || !workers)
+    {
+        CopyRange(dst, src, size, streaming);
+        return;
+    }
+
+    // the calling thread copies the first chunk; chunks end on page boundaries of dst, so the
+    // first chunk also takes the bytes before the first page boundary of an unaligned dst
+    size_t tasks = std::min(workers + 1, (size + m_ChunkSize - 1) / m_ChunkSize);
+    size_t per_task = (size + tasks - 1) / tasks;
+    per_task = (per_task + PageSize - 1) & ~(PageSize - 1);
+
+    auto d = static_cast<char*>(dst);
+    auto s = static_cast<const char*>(src);
+    size_t lead = (PageSize - (reinterpret_cast<std::uintptr_t>(d) & (PageSize - 1))) &
+                  (PageSize - 1);
+    size_t first = std::min(lead + per_task, size);
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks - 1);
+    for(size_t offset = first; offset < size; offset += per_task)
+    {
+        auto bytes = std::min(per_task, size - offset);
+        futures.push_back(m_Workers->enqueue([this, d, s, offset, bytes, streaming] {
+            CopyRange(d + offset, s + offset, bytes, streaming);
+        }));
+    }
+    CopyRange(d, s, first, streaming);
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+void CopyEngine::CopyRange(void* dst, const void* src, size_t size, bool streaming)
+{
+    if(streaming)
+    {
+        StreamingCopy(dst, src, size);
+        return;
+    }
+    std::memcpy(dst, src, size);
+}
+
+void CopyEngine::StreamingCopy(void* dst, const void* src, size_t size)
+{
+#if defined(__SSE2__)
+    auto d = static_cast<char*>(dst);
+    auto s = static_cast<const char*>(src);
+
+    // align the destination for the streaming stores
+    size_t head = (16 - (reinterpret_cast<std::uintptr_t>(d) & 15)) & 15;
+    head = std::min(head, size);
+    std::memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+
+    for(size_t blocks = size / 64; blocks; blocks--)
+    {
+        auto s128 = reinterpret_cast<const __m128i*>(s);
+        auto d128 = reinterpret_cast<__m128i*>(d);
+        __m128i r0 = _mm_loadu_si128(s128 + 0);
+        __m128i r1 = _mm_loadu_si128(s128 + 1);
+        __m128i r2 = _mm_loadu_si128(s128 + 2);
+        __m128i r3 = _mm_loadu_si128(s128 + 3);
+        _mm_stream_si128(d128 + 0, r0);
+        _mm_stream_si128(d128 + 1, r1);
+        _mm_stream_si128(d128 + 2, r2);
+        _mm_stream_si128(d128 + 3, r3);
+        d += 64;
+        s += 64;
+    }
+    // order the weakly-ordered streaming stores before any subsequent store, e.g. the
+    // completion of a future observed by another thread
+    _mm_sfence();
+    std::memcpy(d, s, size % 64);
+#else
+    std::memcpy(dst, src, size);
+#endif
+}
+
+void CopyEngine::SetDefault(std::shared_ptr<CopyEngine> engine)
+{
+    static std::mutex mutex;
+    static std::vector<std::shared_ptr<CopyEngine>> installed;
+    std::lock_guard<std::mutex> lock(mutex);
+    s_DefaultEngine.store(engine.get(), std::memory_order_release);
+    if(engine)
+    {
+        installed.push_back(std::move(engine));
+    }
+}
+
+CopyEngine* CopyEngine::Default() { return s_DefaultEngine.load(std::memory_order_acquire); }
+
+} // namespace trtlab
@@ -0,0 +1,81 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/descriptor.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace detail {
+
+namespace {
+// distinct tags past which descriptions are likely built per call rather than per use site
+constexpr std::size_t kManyTags = 1024;
+} // namespace
+
+const std::string& InternDescriptorType(const std::string& memory_type, const char* desc)
+{
+    // tags are never removed, so the keys viewing them and the references handed out stay
+    // valid for the program; a deque does not move its elements as it grows
+    static std::shared_mutex mutex;
+    static std::deque<std::string> storage;
+    static std::unordered_map<std::string_view, const std::string*> tags;
+
+    // assembled in a per-thread buffer, so finding an interned tag neither allocates nor
+    // takes the lock exclusively
+    thread_local std::string key;
+    key.assign(memory_type).append("(").append(desc).append(")");
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto search = tags.find(key);
+        if(search != tags.end())
+        {
+            return *search->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto search = tags.find(key);
+    if(search != tags.end())
+    {
+        return *search->second;
+    }
+    const auto& tag = storage.emplace_back(key);
+    tags.emplace(tag, &tag);
+    LOG_IF(WARNING, tags.size() == kManyTags)
+        << tags.size() << " distinct descriptor types interned; descriptions should name a "
+        << "use, not carry per-call data, since interned types are never released";
+    return tag;
+}
+
+} // namespace detail
+} // namespace trtlab
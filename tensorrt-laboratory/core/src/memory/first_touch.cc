@@ -0,0 +1,122 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/first_touch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include "tensorrt/laboratory/core/affinity.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+
+namespace trtlab {
+
+namespace {
+/**
+ * @brief Run fn(slice_ptr, slice_size) on page aligned slices, one per worker
+ */
+template<typename Fn>
+void ForEachSlice(void* ptr, size_t size, ThreadPool& workers, Fn fn)
+{
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t count = std::max(workers.Size(), 1);
+    size_t per_worker = (size + count - 1) / count;
+    per_worker = (per_worker + page_size - 1) / page_size * page_size;
+
+    auto base = static_cast<char*>(ptr);
+    std::vector<std::future<void>> futures;
+    for(size_t offset = 0; offset < size; offset += per_worker)
+    {
+        auto bytes = std::min(per_worker, size - offset);
+        futures.push_back(workers.enqueue([fn, base, offset, bytes] { fn(base + offset, bytes); }));
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+}
+} // namespace
+
+FirstTouch::FirstTouch(const CpuSet& cpus, bool zero)
+    : m_Cpus(std::make_shared<const CpuSet>(cpus)), m_Zero(zero)
+{
+    CHECK(!cpus.empty()) << "FirstTouch requires at least one cpu";
+}
+
+FirstTouch FirstTouch::OnNumaNode(int numa_node, bool zero)
+{
+    return FirstTouch(Affinity::GetCpusByNuma(numa_node), zero);
+}
+
+void FirstTouch::Apply(void* ptr, size_t size) const
+{
+    if(m_Zero)
+    {
+        ParallelFill(ptr, size, 0, *m_Cpus);
+        return;
+    }
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    ThreadPool workers(*m_Cpus);
+    ForEachSlice(ptr, size, workers, [](char* slice, size_t bytes) {
+        // a write is required; a read would map the shared zero page
+        for(size_t offset = 0; offset < bytes; offset += page_size)
+        {
+            static_cast<volatile char*>(slice)[offset] = 0;
+        }
+    });
+}
+
+struct FillWorkers::Impl
+{
+    Impl(const CpuSet& cpus) : workers(cpus) {}
+    ThreadPool workers;
+};
+
+FillWorkers::FillWorkers(const CpuSet& cpus) : m_Impl(std::make_unique<Impl>(cpus))
+{
+    CHECK(!cpus.empty()) << "FillWorkers requires at least one cpu";
+}
+
+FillWorkers::~FillWorkers() {}
+
+void ParallelFill(void* ptr, size_t size, char value, const CpuSet& cpus)
+{
+    FillWorkers workers(cpus);
+    ParallelFill(ptr, size, value, workers);
+}
+
+void ParallelFill(void* ptr, size_t size, char value, FillWorkers& workers)
+{
+    ForEachSlice(ptr, size, workers.m_Impl->workers,
+                 [value](char* slice, size_t bytes) { std::memset(slice, value, bytes); });
+}
+
+} // namespace trtlab
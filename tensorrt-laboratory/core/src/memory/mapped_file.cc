@@ -0,0 +1,117 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace {
+std::pair<void*, size_t> MapFile(const std::string& path, bool populate)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    CHECK_NE(fd, -1) << "Unable to open " << path << ": " << std::strerror(errno);
+
+    struct stat stats;
+    CHECK_EQ(fstat(fd, &stats), 0) << "Unable to stat " << path << ": " << std::strerror(errno);
+    size_t size = stats.st_size;
+    CHECK_GT(size, 0UL) << "Unable to map empty file " << path;
+
+    int flags = MAP_PRIVATE | (populate ? MAP_POPULATE : 0);
+    void* ptr = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    auto error = errno;
+    // the mapping holds its own reference to the file
+    close(fd);
+    CHECK_NE(ptr, MAP_FAILED) << "Unable to map " << path << ": " << std::strerror(error);
+
+    DLOG_IF(WARNING, madvise(ptr, size, MADV_SEQUENTIAL) != 0) << "MADV_SEQUENTIAL failed";
+    DLOG_IF(WARNING, madvise(ptr, size, MADV_WILLNEED) != 0) << "MADV_WILLNEED failed";
+    DLOG(INFO) << "Mapped " << path << ": ptr=" << ptr << "; size=" << size;
+    return {ptr, size};
+}
+} // namespace
+
+namespace trtlab {
+
+// MappedFile
+
+MappedFile::MappedFile(const std::string& path, bool populate)
+    : MappedFile(MapFile(path, populate), path)
+{
+}
+
+MappedFile::MappedFile(std::pair<void*, size_t> mapping, const std::string& path)
+    : HostMemory(mapping.first, mapping.second, false), m_Path(path)
+{
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : HostMemory(std::move(other)), m_Path(std::move(other.m_Path))
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if(Data())
+    {
+        DLOG(INFO) << "Unmapping " << m_Path;
+        CHECK_EQ(munmap(Data(), Size()), 0);
+    }
+}
+
+const std::string& MappedFile::Type() const
+{
+    static std::string type = "MappedFile";
+    return type;
+}
+
+DescriptorHandle<MappedFile> MappedFile::Open(const std::string& path, bool populate)
+{
+    class DescriptorImpl final : public Descriptor<MappedFile>
+    {
+      public:
+        DescriptorImpl(const std::string& path, bool populate)
+            : Descriptor<MappedFile>(std::move(MappedFile(path, populate)), "Mapped")
+        {
+        }
+        virtual ~DescriptorImpl() override {}
+
+        DescriptorImpl(DescriptorImpl&& other) : Descriptor<MappedFile>(std::move(other)) {}
+
+        DescriptorImpl(const DescriptorImpl&) = delete;
+        DescriptorImpl& operator=(const DescriptorImpl&) = delete;
+    };
+    return std::make_unique<DescriptorImpl>(path, populate);
+}
+
+} // namespace trtlab
@@ -0,0 +1,160 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/memory_accounting.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace trtlab {
+
+namespace {
+template<typename T>
+void UpdateMax(std::atomic<T>& max, T value)
+{
+    auto current = max.load(std::memory_order_relaxed);
+    while(value > current &&
+          !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+struct Registry
+{
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<MemoryAccount>> types;
+    std::map<std::string, std::unique_ptr<MemoryAccount>> owners;
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+MemoryAccount& FindOrCreate(std::map<std::string, std::unique_ptr<MemoryAccount>>& accounts,
+                            const std::string& name, MemoryAccount::Kind kind)
+{
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    auto& account = accounts[name];
+    if(!account)
+    {
+        account = std::make_unique<MemoryAccount>(name, kind);
+    }
+    return *account;
+}
+} // namespace
+
+// MemoryAccount
+
+MemoryAccount::MemoryAccount(std::string name, Kind kind)
+    : m_Name(std::move(name)), m_Kind(kind), m_LiveBytes(0), m_PeakBytes(0), m_Allocations(0),
+      m_Releases(0), m_Resets(0), m_UsedAtReset(0), m_PeakAtReset(0), m_Capacity(0)
+{
+}
+
+void MemoryAccount::Allocated(std::size_t bytes)
+{
+    auto live = m_LiveBytes.fetch_add(bytes, std::memory_order_relaxed) + (std::int64_t)bytes;
+    UpdateMax(m_PeakBytes, live);
+    m_Allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryAccount::Released(std::size_t bytes)
+{
+    m_LiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    m_Releases.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryAccount::StackReset(std::size_t used, std::size_t capacity)
+{
+    m_Resets.fetch_add(1, std::memory_order_relaxed);
+    m_UsedAtReset.fetch_add(used, std::memory_order_relaxed);
+    UpdateMax(m_PeakAtReset, used);
+    UpdateMax(m_Capacity, capacity);
+}
+
+MemoryAccount::Snapshot MemoryAccount::GetSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.name = m_Name;
+    snapshot.kind = m_Kind;
+    snapshot.live_bytes = std::max<std::int64_t>(m_LiveBytes.load(std::memory_order_relaxed), 0);
+    snapshot.peak_bytes = m_PeakBytes.load(std::memory_order_relaxed);
+    snapshot.allocations = m_Allocations.load(std::memory_order_relaxed);
+    snapshot.releases = m_Releases.load(std::memory_order_relaxed);
+    snapshot.resets = m_Resets.load(std::memory_order_relaxed);
+    snapshot.peak_bytes_at_reset = m_PeakAtReset.load(std::memory_order_relaxed);
+    snapshot.capacity = m_Capacity.load(std::memory_order_relaxed);
+    auto used = m_UsedAtReset.load(std::memory_order_relaxed);
+    snapshot.mean_used_at_reset = snapshot.resets ? (double)used / snapshot.resets : 0.0;
+    return snapshot;
+}
+
+double MemoryAccount::Snapshot::MeanUtilizationAtReset() const
+{
+    return capacity ? mean_used_at_reset / capacity : 0.0;
+}
+
+double MemoryAccount::Snapshot::PeakUtilizationAtReset() const
+{
+    return capacity ? (double)peak_bytes_at_reset / capacity : 0.0;
+}
+
+// MemoryAccounting
+
+std::atomic<bool> MemoryAccounting::s_Enabled(false);
+
+void MemoryAccounting::Enable(bool enabled) { s_Enabled.store(enabled); }
+
+MemoryAccount& MemoryAccounting::ForType(const std::string& memory_type)
+{
+    return FindOrCreate(GetRegistry().types, memory_type, MemoryAccount::Kind::MemoryType);
+}
+
+MemoryAccount& MemoryAccounting::ForOwner(const std::string& owner)
+{
+    return FindOrCreate(GetRegistry().owners, owner, MemoryAccount::Kind::Owner);
+}
+
+std::vector<MemoryAccount::Snapshot> MemoryAccounting::GetSnapshot()
+{
+    auto& registry = GetRegistry();
+    std::vector<MemoryAccount::Snapshot> snapshots;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for(const auto& accounts : {&registry.types, &registry.owners})
+    {
+        for(const auto& entry : *accounts)
+        {
+            snapshots.push_back(entry.second->GetSnapshot());
+        }
+    }
+    return snapshots;
+}
+
+} // namespace trtlab
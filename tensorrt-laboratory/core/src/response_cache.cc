@@ -0,0 +1,148 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/response_cache.h"
+
+#include <random>
+
+namespace trtlab {
+
+namespace {
+inline std::uint64_t Rotl(std::uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+inline void SipRound(std::uint64_t* v)
+{
+    v[0] += v[1];
+    v[1] = Rotl(v[1], 13);
+    v[1] ^= v[0];
+    v[0] = Rotl(v[0], 32);
+    v[2] += v[3];
+    v[3] = Rotl(v[3], 16);
+    v[3] ^= v[2];
+    v[0] += v[3];
+    v[3] = Rotl(v[3], 21);
+    v[3] ^= v[0];
+    v[2] += v[1];
+    v[1] = Rotl(v[1], 17);
+    v[1] ^= v[2];
+    v[2] = Rotl(v[2], 32);
+}
+
+const std::pair<std::uint64_t, std::uint64_t>& ProcessKey()
+{
+    static const auto key = [] {
+        std::random_device random;
+        auto word = [&random] { return (std::uint64_t(random()) << 32) | random(); };
+        auto k0 = word();
+        return std::make_pair(k0, word());
+    }();
+    return key;
+}
+} // namespace
+
+RequestDigest::RequestDigest() : RequestDigest(ProcessKey().first, ProcessKey().second) {}
+
+RequestDigest::RequestDigest(std::uint64_t k0, std::uint64_t k1)
+    : m_V{0x736f6d6570736575ULL ^ k0, 0x646f72616e646f6dULL ^ k1 ^ 0xee,
+          0x6c7967656e657261ULL ^ k0, 0x7465646279746573ULL ^ k1},
+      m_Tail(0), m_Length(0)
+{
+}
+
+RequestDigest& RequestDigest::Append(const void* data, std::size_t size)
+{
+    std::uint64_t prefix = size;
+    unsigned char bytes[sizeof(prefix)];
+    for(std::size_t i = 0; i < sizeof(prefix); i++)
+    {
+        bytes[i] = static_cast<unsigned char>(prefix >> (8 * i));
+    }
+    Update(bytes, sizeof(bytes));
+    return Update(data, size);
+}
+
+RequestDigest& RequestDigest::Update(const void* data, std::size_t size)
+{
+    // message words are little endian; m_Tail holds the bytes of the word in progress
+    auto bytes = static_cast<const unsigned char*>(data);
+    auto end = bytes + size;
+    while(bytes != end && m_Length % 8)
+    {
+        m_Tail |= std::uint64_t(*bytes++) << (8 * (m_Length++ % 8));
+        if(m_Length % 8 == 0)
+        {
+            Compress(m_Tail);
+            m_Tail = 0;
+        }
+    }
+    for(; end - bytes >= 8; bytes += 8, m_Length += 8)
+    {
+        std::uint64_t m = 0;
+        for(int i = 0; i < 8; i++)
+        {
+            m |= std::uint64_t(bytes[i]) << (8 * i);
+        }
+        Compress(m);
+    }
+    while(bytes != end)
+    {
+        m_Tail |= std::uint64_t(*bytes++) << (8 * (m_Length++ % 8));
+    }
+    return *this;
+}
+
+void RequestDigest::Compress(std::uint64_t m)
+{
+    m_V[3] ^= m;
+    SipRound(m_V);
+    SipRound(m_V);
+    m_V[0] ^= m;
+}
+
+std::pair<std::uint64_t, std::uint64_t> RequestDigest::Finish() const
+{
+    std::uint64_t v[4] = {m_V[0], m_V[1], m_V[2], m_V[3]};
+    auto b = (std::uint64_t(m_Length) << 56) | m_Tail;
+    v[3] ^= b;
+    SipRound(v);
+    SipRound(v);
+    v[0] ^= b;
+
+    v[2] ^= 0xee;
+    for(int i = 0; i < 4; i++)
+    {
+        SipRound(v);
+    }
+    auto first = v[0] ^ v[1] ^ v[2] ^ v[3];
+    v[1] ^= 0xdd;
+    for(int i = 0; i < 4; i++)
+    {
+        SipRound(v);
+    }
+    return {first, v[0] ^ v[1] ^ v[2] ^ v[3]};
+}
+
+} // namespace trtlab
@@ -0,0 +1,294 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/timer_wheel.h"
+
+#include <glog/logging.h>
+
+namespace trtlab {
+
+TimerWheel::TimerWheel(duration resolution, time_point now)
+    : m_Resolution(resolution), m_Origin(now), m_CurrentTick(0), m_Size(0), m_FreeList(npos)
+{
+    CHECK_GT(resolution.count(), 0) << "TimerWheel resolution must be positive";
+    m_Heads.fill(npos);
+    m_Occupied.fill(0);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(time_point deadline, Callback callback)
+{
+    // round up so timers never fire early; past deadlines fire on the next tick
+    auto elapsed = std::chrono::duration_cast<duration>(deadline - m_Origin);
+    std::uint64_t expiry = 0;
+    if(elapsed.count() > 0)
+    {
+        expiry = (elapsed.count() + m_Resolution.count() - 1) / m_Resolution.count();
+    }
+    if(expiry <= m_CurrentTick)
+    {
+        expiry = m_CurrentTick + 1;
+    }
+
+    auto index = AllocateNode();
+    auto& node = m_Nodes[index];
+    node.expiry = expiry;
+    node.callback = std::move(callback);
+    Insert(index);
+    m_Size++;
+    return ((TimerId)node.generation << 32) | (TimerId)(index + 1);
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    std::uint32_t index = (std::uint32_t)(id & 0xFFFFFFFF) - 1;
+    std::uint32_t generation = (std::uint32_t)(id >> 32);
+    if(id == InvalidTimer || index >= m_Nodes.size()) return false;
+    auto& node = m_Nodes[index];
+    if(node.generation != generation || node.slot == npos) return false;
+    Unlink(index);
+    node.callback = nullptr;
+    ReleaseNode(index);
+    m_Size--;
+    return true;
+}
+
+std::size_t TimerWheel::Advance(time_point now)
+{
+    std::vector<Callback> expired;
+    auto count = Advance(now, expired);
+    for(auto& callback : expired)
+    {
+        callback();
+    }
+    return count;
+}
+
+std::size_t TimerWheel::Advance(time_point now, std::vector<Callback>& expired)
+{
+    return AdvanceTo(now, [&expired](Callback&& callback) {
+        expired.push_back(std::move(callback));
+    });
+}
+
+template<typename OnExpired>
+std::size_t TimerWheel::AdvanceTo(time_point now, OnExpired on_expired)
+{
+    if(now <= m_Origin) return 0;
+    std::uint64_t target =
+        std::chrono::duration_cast<duration>(now - m_Origin).count() / m_Resolution.count();
+
+    if(m_Size == 0)
+    {
+        // nothing to cascade or fire; jump straight to the target tick
+        m_CurrentTick = target > m_CurrentTick ? target : m_CurrentTick;
+        return 0;
+    }
+
+    std::size_t fired = 0;
+    while(m_CurrentTick < target && m_Size)
+    {
+        // jump over the idle ticks to the next tick that fires or cascades a slot, so the
+        // cost of an advance does not grow with the time since the last one
+        auto tick = NextEventTick();
+        if(tick > target) break;
+        m_CurrentTick = tick;
+
+        // cascade higher levels whose slot boundary is this tick, outermost first
+        if((tick & SlotMask) == 0)
+        {
+            int level = 1;
+            while(level < Levels - 1 && ((tick >> (LevelBits * level)) & SlotMask) == 0)
+            {
+                level++;
+            }
+            for(; level >= 1; level--)
+            {
+                Cascade(level, (tick >> (LevelBits * level)) & SlotMask);
+            }
+        }
+
+        auto slot = (std::uint32_t)(tick & SlotMask);
+        auto index = m_Heads[slot];
+        m_Heads[slot] = npos;
+        ClearOccupied(slot);
+        while(index != npos)
+        {
+            auto& node = m_Nodes[index];
+            auto next = node.next;
+            DCHECK_EQ(node.expiry, tick);
+            on_expired(std::move(node.callback));
+            node.callback = nullptr;
+            ReleaseNode(index);
+            m_Size--;
+            fired++;
+            index = next;
+        }
+    }
+
+    if(m_CurrentTick < target) m_CurrentTick = target;
+    return fired;
+}
+
+TimerWheel::time_point TimerWheel::NextDeadline() const
+{
+    if(m_Size == 0) return time_point::max();
+    return m_Origin + Ticks(NextEventTick());
+}
+
+std::uint64_t TimerWheel::NextEventTick() const
+{
+    std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+    for(int level = 0; level < Levels; level++)
+    {
+        auto shift = LevelBits * level;
+        auto current = (std::uint32_t)((m_CurrentTick >> shift) & SlotMask);
+        auto k = NextOccupied(level, current);
+        if(k)
+        {
+            std::uint64_t tick = ((m_CurrentTick >> shift) + k) << shift;
+            best = tick < best ? tick : best;
+        }
+        if(level == 0)
+        {
+            // no higher level can cascade before the next level 1 boundary
+            auto boundary = ((m_CurrentTick >> LevelBits) + 1) << LevelBits;
+            if(best < boundary) break;
+        }
+    }
+    return best;
+}
+
+std::uint32_t TimerWheel::NextOccupied(int level, std::uint32_t current) const
+{
+    // search the slots after the current slot, wrapping around to the current slot, one
+    // bitmap word at a time
+    for(std::uint32_t k = 1; k <= SlotsPerLevel;)
+    {
+        auto slot = (current + k) & SlotMask;
+        auto word = m_Occupied[(level * SlotsPerLevel + slot) / 64] >> (slot % 64);
+        if(word)
+        {
+            auto distance = k + (std::uint32_t)__builtin_ctzll(word);
+            return distance <= SlotsPerLevel ? distance : 0;
+        }
+        k += 64 - slot % 64;
+    }
+    return 0;
+}
+
+std::uint32_t TimerWheel::AllocateNode()
+{
+    if(m_FreeList != npos)
+    {
+        auto index = m_FreeList;
+        m_FreeList = m_Nodes[index].next;
+        return index;
+    }
+    CHECK_LT(m_Nodes.size(), npos - 1) << "TimerWheel node limit reached";
+    m_Nodes.emplace_back();
+    auto& node = m_Nodes.back();
+    node.generation = 1;
+    node.slot = npos;
+    return m_Nodes.size() - 1;
+}
+
+void TimerWheel::ReleaseNode(std::uint32_t index)
+{
+    auto& node = m_Nodes[index];
+    node.generation++;
+    node.slot = npos;
+    node.prev = npos;
+    node.next = m_FreeList;
+    m_FreeList = index;
+}
+
+void TimerWheel::Insert(std::uint32_t index)
+{
+    auto& node = m_Nodes[index];
+    DCHECK_GE(node.expiry, m_CurrentTick);
+    auto delta = node.expiry - m_CurrentTick;
+
+    std::uint32_t slot;
+    int level = 0;
+    while(level < Levels - 1 && delta >= (1ULL << (LevelBits * (level + 1))))
+    {
+        level++;
+    }
+    if(level == Levels - 1 && delta >= (1ULL << (LevelBits * Levels)))
+    {
+        // beyond the horizon: park in the furthest top level slot and re-cascade later
+        slot = ((m_CurrentTick >> (LevelBits * level)) + SlotMask) & SlotMask;
+    }
+    else
+    {
+        slot = (node.expiry >> (LevelBits * level)) & SlotMask;
+    }
+    slot += level * SlotsPerLevel;
+
+    node.slot = slot;
+    node.prev = npos;
+    node.next = m_Heads[slot];
+    if(node.next != npos)
+    {
+        m_Nodes[node.next].prev = index;
+    }
+    m_Heads[slot] = index;
+    SetOccupied(slot);
+}
+
+void TimerWheel::Unlink(std::uint32_t index)
+{
+    auto& node = m_Nodes[index];
+    if(node.prev != npos)
+    {
+        m_Nodes[node.prev].next = node.next;
+    }
+    else
+    {
+        m_Heads[node.slot] = node.next;
+        if(node.next == npos) ClearOccupied(node.slot);
+    }
+    if(node.next != npos)
+    {
+        m_Nodes[node.next].prev = node.prev;
+    }
+}
+
+void TimerWheel::Cascade(int level, std::uint32_t slot)
+{
+    auto global = level * SlotsPerLevel + slot;
+    auto index = m_Heads[global];
+    m_Heads[global] = npos;
+    ClearOccupied(global);
+    while(index != npos)
+    {
+        auto next = m_Nodes[index].next;
+        Insert(index);
+        index = next;
+    }
+}
+
+} // namespace trtlab
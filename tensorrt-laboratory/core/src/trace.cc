@@ -0,0 +1,277 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/trace.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trtlab {
+
+namespace {
+struct Span
+{
+    std::atomic<RequestTrace::Id> id{0};
+    std::atomic<const char*> stage{nullptr};
+    std::atomic<std::uint64_t> begin{0};
+    std::atomic<std::uint64_t> end{0};
+    std::atomic<int> thread{0};
+};
+
+// Single producer ring written by its owning thread and read by WriteChromeTrace.  The writer
+// bumps m_Begun before it overwrites a slot and m_Head after; a reader discards every span
+// whose slot may have been reused while it was copied, so no span is ever torn.
+class Ring
+{
+  public:
+    Ring() : m_Begun(0), m_Head(0) {}
+
+    void Append(RequestTrace::Id id, const char* stage, std::uint64_t begin, std::uint64_t end,
+                int thread)
+    {
+        auto index = m_Head.load(std::memory_order_relaxed);
+        auto& span = m_Spans[index % RequestTrace::RingCapacity];
+        m_Begun.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        span.id.store(id, std::memory_order_relaxed);
+        span.stage.store(stage, std::memory_order_relaxed);
+        span.begin.store(begin, std::memory_order_relaxed);
+        span.end.store(end, std::memory_order_relaxed);
+        span.thread.store(thread, std::memory_order_relaxed);
+        m_Head.store(index + 1, std::memory_order_release);
+    }
+
+    struct Copy
+    {
+        RequestTrace::Id id;
+        const char* stage;
+        std::uint64_t begin;
+        std::uint64_t end;
+        int thread;
+    };
+
+    void CopyTo(std::vector<Copy>& spans) const
+    {
+        auto head = m_Head.load(std::memory_order_acquire);
+        auto first = head > RequestTrace::RingCapacity ? head - RequestTrace::RingCapacity : 0;
+        std::vector<Copy> copies;
+        copies.reserve(head - first);
+        for(auto index = first; index < head; index++)
+        {
+            const auto& span = m_Spans[index % RequestTrace::RingCapacity];
+            copies.push_back({span.id.load(std::memory_order_relaxed),
+                              span.stage.load(std::memory_order_relaxed),
+                              span.begin.load(std::memory_order_relaxed),
+                              span.end.load(std::memory_order_relaxed),
+                              span.thread.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto begun = m_Begun.load(std::memory_order_relaxed);
+        for(auto index = first; index < head; index++)
+        {
+            if(index + RequestTrace::RingCapacity >= begun)
+            {
+                spans.push_back(copies[index - first]);
+            }
+        }
+    }
+
+  private:
+    std::atomic<std::uint64_t> m_Begun;
+    std::atomic<std::uint64_t> m_Head;
+    std::array<Span, RequestTrace::RingCapacity> m_Spans;
+};
+
+// Rings outlive their threads so the spans of finished threads can still be exported.  A
+// thread returns its ring to the free list when it exits and the next new thread appends to
+// it, so the registry holds one ring per concurrently live tracing thread rather than one
+// per thread ever started.  Spans carry the number of the thread that recorded them, so every
+// thread still has a track of its own.
+struct Registry
+{
+    std::mutex mutex;
+    int threads = 0;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::vector<Ring*> free;
+};
+
+Registry& GetRegistry()
+{
+    static auto registry = new Registry;
+    return *registry;
+}
+
+class RingOwner
+{
+  public:
+    RingOwner()
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        m_Thread = ++registry.threads;
+        if(registry.free.empty())
+        {
+            registry.rings.push_back(std::make_unique<Ring>());
+            m_Ring = registry.rings.back().get();
+        }
+        else
+        {
+            m_Ring = registry.free.back();
+            registry.free.pop_back();
+        }
+    }
+
+    ~RingOwner()
+    {
+        t_Released = true;
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.free.push_back(m_Ring);
+    }
+
+    DELETE_COPYABILITY(RingOwner);
+    DELETE_MOVEABILITY(RingOwner);
+
+    void Append(RequestTrace::Id id, const char* stage, std::uint64_t begin, std::uint64_t end)
+    {
+        m_Ring->Append(id, stage, begin, end, m_Thread);
+    }
+
+    // set once the ring is returned; a span recorded later, by the destructor of another
+    // thread_local, is dropped rather than written to a ring another thread may now own
+    static thread_local bool t_Released;
+
+  private:
+    Ring* m_Ring;
+    int m_Thread;
+};
+
+thread_local bool RingOwner::t_Released = false;
+
+RingOwner* ThreadRing()
+{
+    if(RingOwner::t_Released)
+    {
+        return nullptr;
+    }
+    thread_local RingOwner owner;
+    return &owner;
+}
+
+std::atomic<double> s_SampleRate(0.0);
+} // namespace
+
+void RequestTrace::SetSampleRate(double rate)
+{
+    rate = std::min(std::max(rate, 0.0), 1.0);
+    s_SampleRate = rate;
+    s_Threshold = rate == 1.0 ? std::numeric_limits<std::uint64_t>::max()
+                              : (std::uint64_t)(rate * 18446744073709551616.0);
+}
+
+double RequestTrace::SampleRate() { return s_SampleRate; }
+
+std::uint64_t RequestTrace::Seed()
+{
+    // splitmix64 of the thread id and the clock; never 0
+    auto x = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ TscClock::Now();
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x ? x : 1;
+}
+
+RequestTrace::Id RequestTrace::NextId()
+{
+    static std::atomic<Id> next(1);
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RequestTrace::Append(Id id, const char* stage, std::uint64_t begin, std::uint64_t end)
+{
+    if(auto ring = ThreadRing())
+    {
+        ring->Append(id, stage, begin, end);
+    }
+}
+
+void RequestTrace::WriteChromeTrace(std::ostream& os)
+{
+    std::vector<Ring::Copy> spans;
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(const auto& ring : registry.rings)
+        {
+            ring->CopyTo(spans);
+        }
+    }
+    std::sort(spans.begin(), spans.end(), [](const Ring::Copy& a, const Ring::Copy& b) {
+        return a.id != b.id ? a.id < b.id : a.begin < b.begin;
+    });
+
+    auto origin = std::numeric_limits<std::uint64_t>::max();
+    for(const auto& span : spans)
+    {
+        origin = std::min(origin, span.begin);
+    }
+    auto us_per_tick = TscClock::NanosecondsPerTick() / 1000.0;
+    auto microseconds = [us_per_tick](std::uint64_t ticks) { return ticks * us_per_tick; };
+
+    auto flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char* separator = "";
+    RequestTrace::Id process = 0;
+    for(const auto& span : spans)
+    {
+        if(span.id != process)
+        {
+            process = span.id;
+            os << separator << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << span.id
+               << ",\"args\":{\"name\":\"request " << span.id << "\"}}";
+            separator = ",";
+        }
+        auto end = std::max(span.begin, span.end);
+        os << separator << "\n{\"name\":\"" << span.stage << "\",\"cat\":\"request\",\"ph\":\"X\""
+           << ",\"pid\":" << span.id << ",\"tid\":" << span.thread
+           << ",\"ts\":" << microseconds(span.begin - origin)
+           << ",\"dur\":" << microseconds(end - span.begin) << "}";
+        separator = ",";
+    }
+    os << "\n]}\n";
+    os.flags(flags);
+}
+
+} // namespace trtlab
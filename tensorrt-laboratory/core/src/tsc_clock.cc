@@ -0,0 +1,61 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/tsc_clock.h"
+
+#include <thread>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+
+namespace {
+double Calibrate()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    using clock = std::chrono::steady_clock;
+    auto start_time = clock::now();
+    auto start_ticks = TscClock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto end_ticks = TscClock::Now();
+    auto end_time = clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+    auto ratio = (double)ns / (double)(end_ticks - start_ticks);
+    DLOG(INFO) << "TscClock calibrated: " << 1.0 / ratio << " ticks/ns";
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+} // namespace
+
+double TscClock::NanosecondsPerTick()
+{
+    static const double ratio = Calibrate();
+    return ratio;
+}
+
+} // namespace trtlab
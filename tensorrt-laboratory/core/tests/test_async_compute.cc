@@ -25,8 +25,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 #include <glog/logging.h>
 
 using namespace trtlab;
@@ -93,6 +96,143 @@ TEST_F(TestAsyncCompute, ReturnVoid)
     future.wait();
 }
 
+TEST_F(TestAsyncCompute, AsyncFutureThenBeforeCompletion)
+{
+    AsyncPromise<int> promise;
+    auto main_thread = std::this_thread::get_id();
+    std::thread::id continuation_thread;
+
+    auto future = promise.get_future().then([&continuation_thread](int i) {
+        continuation_thread = std::this_thread::get_id();
+        return i * 2;
+    });
+    EXPECT_FALSE(future.is_ready());
+
+    // the continuation executes inline on the thread that completes the promise
+    std::thread producer([&promise] { promise.set_value(21); });
+    auto producer_thread = producer.get_id();
+    producer.join();
+
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_EQ(future.get(), 42);
+    EXPECT_EQ(continuation_thread, producer_thread);
+    EXPECT_NE(continuation_thread, main_thread);
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureThenAfterCompletion)
+{
+    auto ready = make_ready_async_future(std::string("trtlab"));
+    EXPECT_TRUE(ready.is_ready());
+
+    std::thread::id continuation_thread;
+    auto future = ready.then([&continuation_thread](std::string s) {
+        continuation_thread = std::this_thread::get_id();
+        return s.size();
+    });
+
+    // already satisfied; the continuation runs inline on the attaching thread
+    EXPECT_EQ(continuation_thread, std::this_thread::get_id());
+    EXPECT_EQ(future.get(), 6);
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureThenOnExecutor)
+{
+    ThreadPool workers(2);
+    AsyncPromise<void> promise;
+    std::thread::id continuation_thread;
+
+    auto future = promise.get_future()
+                      .then(workers, [&continuation_thread] {
+                          continuation_thread = std::this_thread::get_id();
+                          return std::make_unique<int>(7);
+                      })
+                      .then([](std::unique_ptr<int> i) { return *i + 1; });
+
+    promise.set_value();
+    EXPECT_EQ(future.get(), 8);
+    EXPECT_NE(continuation_thread, std::this_thread::get_id());
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureExceptionPropagates)
+{
+    AsyncPromise<int> promise;
+    bool skipped = true;
+    auto future = promise.get_future()
+                      .then([](int i) -> int { throw std::runtime_error("bad value"); })
+                      .then([&skipped](int i) { skipped = false; });
+    promise.set_value(1);
+    EXPECT_THROW(future.get(), std::runtime_error);
+    EXPECT_TRUE(skipped);
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureBrokenPromise)
+{
+    AsyncFuture<int> future;
+    {
+        AsyncPromise<int> promise;
+        future = promise.get_future();
+    }
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_THROW(future.get(), std::future_error);
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureWhenAll)
+{
+    ThreadPool workers(4);
+    std::vector<AsyncPromise<int>> promises(16);
+    std::vector<AsyncFuture<int>> futures;
+    for(auto& promise : promises)
+    {
+        futures.push_back(promise.get_future());
+    }
+
+    auto all = when_all(std::move(futures));
+    for(std::size_t i = 0; i < promises.size(); i++)
+    {
+        workers.enqueue([&promises, i] { promises[i].set_value(static_cast<int>(i)); });
+    }
+
+    auto values = all.get();
+    ASSERT_EQ(values.size(), promises.size());
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+        EXPECT_EQ(values[i], static_cast<int>(i));
+    }
+
+    EXPECT_TRUE(when_all(std::vector<AsyncFuture<void>>()).is_ready());
+}
+
+TEST_F(TestAsyncCompute, AsyncFutureWhenAny)
+{
+    std::vector<AsyncPromise<int>> promises(3);
+    std::vector<AsyncFuture<int>> futures;
+    for(auto& promise : promises)
+    {
+        futures.push_back(promise.get_future());
+    }
+
+    auto any = when_any(std::move(futures));
+    EXPECT_FALSE(any.is_ready());
+    promises[1].set_value(11);
+    promises[0].set_value(10);
+    promises[2].set_value(12);
+
+    auto result = any.get();
+    EXPECT_EQ(result.first, 1);
+    EXPECT_EQ(result.second, 11);
+}
+
+TEST_F(TestAsyncCompute, WrapAsync)
+{
+    auto compute =
+        AsyncComputeWrapper<void(int)>::WrapAsync([](int i) -> bool { return (bool)((i % 2) == 0); });
+
+    auto future = compute->Future().then([](bool even) { return even ? "even" : "odd"; });
+    (*compute)(42);
+
+    EXPECT_EQ(std::string(future.get()), "even");
+}
+
 /*
 TEST_F(TestAsyncCompute, ReturnBoolInputs1xInt)
 {
@@ -26,10 +26,15 @@
  */
 #include "tensorrt/laboratory/core/memory/allocator.h"
 #include "tensorrt/laboratory/core/memory/copy.h"
+#include "tensorrt/laboratory/core/memory/copy_engine.h"
 #include "tensorrt/laboratory/core/memory/malloc.h"
+#include "tensorrt/laboratory/core/memory/mapped_file.h"
 #include "tensorrt/laboratory/core/memory/system_v.h"
 #include "tensorrt/laboratory/core/utils.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <list>
 
 #include <gtest/gtest.h>
@@ -171,6 +176,60 @@ TEST_F(TestSystemVMemory, TryAttachingToDeletedSegment)
     EXPECT_DEATH(auto attached = SystemV::Attach(shm_id), "");
 }
 
+class TestMappedFile : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        path = ::testing::TempDir() + "trtlab_test_mapped_file.bin";
+        contents.resize(one_mb + 17);
+        for(size_t i = 0; i < contents.size(); i++)
+        {
+            contents[i] = static_cast<char>(i * 31);
+        }
+        std::ofstream file(path, std::ios::binary);
+        file.write(contents.data(), contents.size());
+    }
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+    std::vector<char> contents;
+};
+
+TEST_F(TestMappedFile, ReadsFileContents)
+{
+    for(bool populate : {false, true})
+    {
+        auto mapped = MappedFile::Open(path, populate);
+        EXPECT_EQ(mapped->Size(), contents.size());
+        EXPECT_EQ(mapped->Path(), path);
+        EXPECT_FALSE(mapped->Allocated());
+        EXPECT_EQ(std::memcmp(mapped->Data(), contents.data(), contents.size()), 0);
+    }
+}
+
+TEST_F(TestMappedFile, OutlivesTheFile)
+{
+    auto mapped = MappedFile::Open(path);
+    std::remove(path.c_str());
+    auto bytes = static_cast<const char*>(mapped->Data());
+    EXPECT_EQ(bytes[contents.size() - 1], contents.back());
+}
+
+TEST_F(TestMappedFile, CopyToMalloc)
+{
+    auto mapped = MappedFile::Open(path);
+    Allocator<Malloc> memory(contents.size());
+    Copy(memory, *mapped, contents.size());
+    EXPECT_EQ(std::memcmp(memory.Data(), contents.data(), contents.size()), 0);
+}
+
+TEST_F(TestMappedFile, MissingFile)
+{
+    EXPECT_DEATH(MappedFile::Open(path + ".missing"), "");
+}
+
 class TestCopy : public ::testing::Test
 {
 };
@@ -202,6 +261,73 @@ TEST_F(TestCopy, MallocToMalloc)
     EXPECT_EQ(m1_array[1024], v1);
 }
 
+TEST_F(TestCopy, CopyEngine)
+{
+    auto engine = std::make_shared<CopyEngine>(std::make_shared<ThreadPool>(3));
+    engine->SetStreamingThreshold(4096);
+    engine->SetParallelThreshold(64 * 1024);
+    engine->SetChunkSize(16 * 1024);
+
+    Allocator<Malloc> src(4 * one_mb);
+    Allocator<Malloc> dst(4 * one_mb);
+    auto s = src.CastToArray<unsigned char>();
+    auto d = dst.CastToArray<unsigned char>();
+    for(size_t i = 0; i < src.Size(); i++)
+    {
+        s[i] = static_cast<unsigned char>(i * 7 + 3);
+    }
+
+    // sizes covering memcpy, streaming and parallel paths with unaligned heads and tails
+    for(size_t size : {1UL, 63UL, 4095UL, 4097UL, 65537UL, 1000003UL, 4 * one_mb - 21})
+    {
+        size_t offset = (size % 2) ? 3 : 0;
+        size = std::min(size, src.Size() - offset);
+        dst.Fill(0);
+        engine->Copy(dst, offset, src, 0, size);
+        EXPECT_EQ(std::memcmp(d + offset, s, size), 0) << size;
+        if(offset)
+        {
+            EXPECT_EQ(d[offset - 1], 0);
+        }
+        if(offset + size < dst.Size())
+        {
+            EXPECT_EQ(d[offset + size], 0) << size;
+        }
+    }
+}
+
+TEST_F(TestCopy, DefaultCopyEngine)
+{
+    EXPECT_EQ(CopyEngine::Default(), nullptr);
+    auto engine = std::make_shared<CopyEngine>(std::make_shared<ThreadPool>(2));
+    engine->SetParallelThreshold(64 * 1024);
+    CopyEngine::SetDefault(engine);
+    EXPECT_EQ(CopyEngine::Default(), engine.get());
+
+    Allocator<Malloc> src(one_mb);
+    Allocator<Malloc> dst(one_mb);
+    src.Fill(42);
+    dst.Fill(0);
+    Copy(dst, src, one_mb);
+    EXPECT_EQ(dst.CastToArray<char>()[one_mb - 1], 42);
+
+    CopyEngine::SetDefault(nullptr);
+    EXPECT_EQ(CopyEngine::Default(), nullptr);
+}
+
+TEST_F(TestCopy, FirstTouch)
+{
+    Allocator<Malloc> prefaulted(16 * one_mb + 123, FirstTouch(Affinity::GetAffinity()));
+    EXPECT_EQ(prefaulted.Size(), 16 * one_mb + 123);
+
+    Allocator<Malloc> zeroed(16 * one_mb + 123, FirstTouch(Affinity::GetAffinity(), true));
+    auto array = zeroed.CastToArray<char>();
+    EXPECT_EQ(std::count(array, array + zeroed.Size(), 0), zeroed.Size());
+
+    ParallelFill(zeroed.Data(), zeroed.Size(), 7, Affinity::GetAffinity());
+    EXPECT_EQ(std::count(array, array + zeroed.Size(), 7), zeroed.Size());
+}
+
 class TestBytesToString : public ::testing::Test
 {
 };
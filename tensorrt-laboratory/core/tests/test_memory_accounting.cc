@@ -0,0 +1,173 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/memory/cyclic_allocator.h"
+#include "tensorrt/laboratory/core/memory/malloc.h"
+#include "tensorrt/laboratory/core/memory/memory_accounting.h"
+#include "tensorrt/laboratory/core/memory/memory_stack.h"
+#include "tensorrt/laboratory/core/memory/system_v.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+using namespace trtlab;
+
+namespace {
+
+static size_t one_mb = 1024 * 1024;
+static size_t quarter_mb = one_mb / 4;
+
+// the registry is process wide; tests compare against a snapshot taken before they run
+template<typename T>
+class TestMemoryAccounting : public ::testing::Test
+{
+  protected:
+    void SetUp() override { MemoryAccounting::Enable(); }
+    void TearDown() override { MemoryAccounting::Enable(false); }
+
+    static std::string Owner(const std::string& name)
+    {
+        Allocator<T> probe(4096);
+        return name + "/" + probe.Type();
+    }
+};
+
+using MemoryTypes = ::testing::Types<Malloc, SystemV>;
+
+TYPED_TEST_CASE(TestMemoryAccounting, MemoryTypes);
+
+TYPED_TEST(TestMemoryAccounting, AllocatorAccountsByType)
+{
+    auto memory = std::make_unique<Allocator<TypeParam>>(one_mb);
+    auto& account = MemoryAccounting::ForType(memory->Type());
+    auto before = account.GetSnapshot();
+    {
+        Allocator<TypeParam> other(one_mb);
+        auto during = account.GetSnapshot();
+        EXPECT_EQ(during.live_bytes, before.live_bytes + one_mb);
+        EXPECT_GE(during.peak_bytes, during.live_bytes);
+        EXPECT_EQ(during.allocations, before.allocations + 1);
+        EXPECT_EQ(during.kind, MemoryAccount::Kind::MemoryType);
+
+        // moves transfer the allocation without accounting it twice
+        auto moved = std::move(other);
+        EXPECT_EQ(account.GetSnapshot().live_bytes, during.live_bytes);
+    }
+    memory.reset();
+    auto after = account.GetSnapshot();
+    EXPECT_EQ(after.live_bytes, before.live_bytes - one_mb);
+    EXPECT_EQ(after.releases, before.releases + 2);
+}
+
+TYPED_TEST(TestMemoryAccounting, DisabledAllocationsAreNotAccounted)
+{
+    MemoryAccounting::Enable(false);
+    auto memory = std::make_unique<Allocator<TypeParam>>(one_mb);
+    auto& account = MemoryAccounting::ForType(memory->Type());
+    MemoryAccounting::Enable();
+    auto before = account.GetSnapshot();
+    memory.reset();
+    auto after = account.GetSnapshot();
+    EXPECT_EQ(after.live_bytes, before.live_bytes);
+    EXPECT_EQ(after.releases, before.releases);
+}
+
+TYPED_TEST(TestMemoryAccounting, StackUtilizationAtReset)
+{
+    auto owner = this->Owner("TestMemoryAccounting.Stack");
+    MemoryStack<TypeParam> stack(one_mb);
+    stack.TrackUsage(owner);
+    auto& account = MemoryAccounting::ForOwner(owner);
+
+    stack.Allocate(quarter_mb);
+    auto mark = stack.Mark();
+    stack.Allocate(quarter_mb);
+    EXPECT_EQ(account.GetSnapshot().live_bytes, 2 * quarter_mb);
+    EXPECT_EQ(account.GetSnapshot().peak_bytes, 2 * quarter_mb);
+
+    stack.Rollback(mark);
+    EXPECT_EQ(account.GetSnapshot().live_bytes, quarter_mb);
+
+    stack.Allocate(2 * quarter_mb);
+    stack.Reset();
+    auto snapshot = account.GetSnapshot();
+    EXPECT_EQ(snapshot.kind, MemoryAccount::Kind::Owner);
+    EXPECT_EQ(snapshot.live_bytes, 0);
+    EXPECT_EQ(snapshot.peak_bytes, 3 * quarter_mb);
+    EXPECT_EQ(snapshot.allocations, 3);
+    EXPECT_EQ(snapshot.resets, 1);
+    EXPECT_EQ(snapshot.peak_bytes_at_reset, 3 * quarter_mb);
+    EXPECT_EQ(snapshot.capacity, one_mb);
+    EXPECT_DOUBLE_EQ(snapshot.PeakUtilizationAtReset(), 0.75);
+
+    stack.Reset();
+    snapshot = account.GetSnapshot();
+    EXPECT_EQ(snapshot.resets, 2);
+    EXPECT_DOUBLE_EQ(snapshot.MeanUtilizationAtReset(), 0.375);
+}
+
+TYPED_TEST(TestMemoryAccounting, CyclicAllocatorSegments)
+{
+    auto owner = this->Owner("TestMemoryAccounting.Cyclic");
+    CyclicAllocator<TypeParam> allocator(3, one_mb);
+    allocator.TrackUsage(owner);
+    auto& account = MemoryAccounting::ForOwner(owner);
+
+    {
+        // the third allocation does not fit and rotates the segment
+        auto d0 = allocator.Allocate(3 * quarter_mb);
+        auto d1 = allocator.Allocate(quarter_mb / 2);
+        auto d2 = allocator.Allocate(quarter_mb);
+        auto snapshot = account.GetSnapshot();
+        EXPECT_EQ(snapshot.live_bytes, 3 * quarter_mb + quarter_mb / 2 + quarter_mb);
+        EXPECT_EQ(snapshot.resets, 0);
+    }
+
+    // the first segment is recycled once its descriptors are released
+    auto snapshot = account.GetSnapshot();
+    EXPECT_EQ(snapshot.resets, 1);
+    EXPECT_EQ(snapshot.peak_bytes_at_reset, 3 * quarter_mb + quarter_mb / 2);
+    EXPECT_EQ(snapshot.live_bytes, quarter_mb);
+
+    auto all = MemoryAccounting::GetSnapshot();
+    auto found = std::find_if(all.begin(), all.end(), [&owner](const auto& s) {
+        return s.name == owner && s.kind == MemoryAccount::Kind::Owner;
+    });
+    ASSERT_NE(found, all.end());
+    EXPECT_EQ(found->allocations, 3);
+}
+
+TYPED_TEST(TestMemoryAccounting, UntrackedWhenDisabled)
+{
+    MemoryAccounting::Enable(false);
+    auto owner = this->Owner("TestMemoryAccounting.Disabled");
+    MemoryStack<TypeParam> stack(one_mb);
+    stack.TrackUsage(owner);
+    stack.Allocate(quarter_mb);
+    EXPECT_EQ(MemoryAccounting::ForOwner(owner).GetSnapshot().allocations, 0);
+}
+
+} // namespace
@@ -24,12 +24,18 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#include "tensorrt/laboratory/core/affinity.h"
 #include "tensorrt/laboratory/core/memory/cyclic_allocator.h"
 #include "tensorrt/laboratory/core/memory/malloc.h"
 #include "tensorrt/laboratory/core/memory/memory_stack.h"
 #include "tensorrt/laboratory/core/memory/smart_stack.h"
 #include "tensorrt/laboratory/core/memory/system_v.h"
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 using namespace trtlab;
@@ -84,6 +90,50 @@ TEST_F(TestMemoryStack, AllocateAndReset)
     EXPECT_EQ(p0, p1);
 }
 
+TEST_F(TestMemoryStack, ResetWritesZeros)
+{
+    auto check_zeroed = [](MemoryStack<Malloc>& stack) {
+        // twice, so the shared workers are reused
+        for(int pass = 0; pass < 2; pass++)
+        {
+            auto size = stack.Size();
+            auto ptr = static_cast<unsigned char*>(stack.Allocate(size));
+            std::memset(ptr, 0xFF, size);
+            stack.Reset(true);
+            EXPECT_EQ(0, stack.Allocated());
+            auto nonzero = std::find_if(ptr, ptr + size, [](unsigned char c) { return c; });
+            EXPECT_EQ(ptr + size, nonzero) << "offset " << nonzero - ptr << " of " << size;
+        }
+    };
+
+    // MemoryType::Fill
+    MemoryStack<Malloc> serial(one_mb);
+    check_zeroed(serial);
+
+    // one set of workers shared by several stacks
+    auto workers = std::make_shared<FillWorkers>(Affinity::GetAffinity());
+    for(auto size : {one_mb + 123, 16 * one_mb})
+    {
+        MemoryStack<Malloc> stack(size);
+        stack.SetFillWorkers(workers);
+        check_zeroed(stack);
+    }
+}
+
+TEST_F(TestMemoryStack, FirstTouchResetWritesZeros)
+{
+    // zeroed from the cpus it was first touched on
+    FirstTouch touch(Affinity::GetAffinity());
+    auto size = 16 * one_mb;
+    MemoryStack<Malloc> stack(size, touch);
+    stack.SetFillWorkers(std::make_shared<FillWorkers>(touch.Cpus()));
+    auto ptr = static_cast<unsigned char*>(stack.Allocate(size));
+    std::memset(ptr, 0xFF, size);
+    stack.Reset(true);
+    auto nonzero = std::find_if(ptr, ptr + size, [](unsigned char c) { return c; });
+    EXPECT_EQ(ptr + size, nonzero) << "offset " << nonzero - ptr << " of " << size;
+}
+
 TEST_F(TestMemoryStack, Unaligned)
 {
     auto p0 = stack->Allocate(1);
@@ -101,6 +151,69 @@ TEST_F(TestMemoryStack, Unaligned)
     EXPECT_EQ(stack->Offset(p1), stack->Alignment());
 }
 
+TEST_F(TestMemoryStack, MarkAndRollback)
+{
+    auto p0 = stack->Allocate(1024);
+    auto mark = stack->Mark();
+    EXPECT_EQ(1, stack->Depth());
+    auto p1 = stack->Allocate(4096);
+    EXPECT_EQ(1024 + 4096, stack->Allocated());
+    EXPECT_TRUE(stack->Rollback(mark));
+    EXPECT_EQ(0, stack->Depth());
+    EXPECT_EQ(1024, stack->Allocated());
+    auto p2 = stack->Allocate(1);
+    EXPECT_EQ(p1, p2);
+    EXPECT_EQ(stack->Offset(p0), 0);
+}
+
+TEST_F(TestMemoryStack, NestedScopedArenas)
+{
+    stack->Allocate(1024);
+    {
+        ScopedArena<MemoryStack<Malloc>> outer(*stack);
+        auto p0 = outer.Allocate(1024);
+        {
+            ScopedArena<MemoryStack<Malloc>> inner(*stack);
+            inner.Allocate(2048);
+            EXPECT_EQ(2048, inner.Allocated());
+            EXPECT_EQ(3072, outer.Allocated());
+            EXPECT_EQ(2, stack->Depth());
+        }
+        EXPECT_EQ(1024, outer.Allocated());
+        EXPECT_EQ(1, stack->Depth());
+        {
+            ScopedArena<MemoryStack<Malloc>> inner(*stack);
+            auto p1 = inner.Allocate(1);
+            EXPECT_EQ(stack->Offset(p1), stack->Offset(p0) + 1024);
+        }
+    }
+    EXPECT_EQ(0, stack->Depth());
+    EXPECT_EQ(1024, stack->Allocated());
+}
+
+TEST_F(TestMemoryStack, RollbackToOuterMark)
+{
+    auto outer = stack->Mark();
+    stack->Allocate(1024);
+    auto inner = stack->Mark();
+    stack->Allocate(1024);
+    EXPECT_TRUE(stack->Rollback(outer));
+    EXPECT_EQ(0, stack->Allocated());
+    EXPECT_EQ(0, stack->Depth());
+    // inner was discarded along with outer
+    EXPECT_DEATH(stack->Rollback(inner), "");
+}
+
+TEST_F(TestMemoryStack, ResetInvalidatesMarks)
+{
+    auto mark = stack->Mark();
+    stack->Allocate(1024);
+    stack->Reset();
+    EXPECT_EQ(0, stack->Depth());
+    stack->Mark();
+    EXPECT_DEATH(stack->Rollback(mark), "");
+}
+
 TEST_F(TestSmartStack, EmptyOnCreate)
 {
     ASSERT_EQ(one_mb, stack->Size());
@@ -153,4 +266,205 @@ TEST_F(TestSmartStack, Unaligned)
     stack.reset();
 }
 
-} // namespace
\ No newline at end of file
+TEST_F(TestSmartStack, InternedTypeAndPooledDescriptors)
+{
+    auto p0 = stack->Allocate(1);
+    auto p1 = stack->Allocate(1);
+    EXPECT_EQ(p0->Type(), "SystemV(SmartStack)");
+    // all descriptors share one interned type tag
+    EXPECT_EQ(&p0->Type(), &p1->Type());
+
+    // released descriptor storage is reused by the next allocation on this thread
+    auto* storage = p1.get();
+    p1.reset();
+    auto p2 = stack->Allocate(1);
+    EXPECT_EQ(p2.get(), storage);
+    EXPECT_EQ(p2->Type(), "SystemV(SmartStack)");
+}
+
+TEST_F(TestSmartStack, TypeInternedAcrossThreads)
+{
+    std::string desc = "interned";
+    const auto& tag = detail::InternDescriptorType("SystemV", desc.c_str());
+    EXPECT_EQ(tag, "SystemV(interned)");
+    EXPECT_NE(&tag, &detail::InternDescriptorType("Malloc", desc.c_str()));
+
+    std::vector<const std::string*> tags(8);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < tags.size(); i++)
+    {
+        threads.emplace_back([&tags, i] {
+            for(int j = 0; j < 1000; j++)
+            {
+                tags[i] = &detail::InternDescriptorType("SystemV", "interned");
+            }
+        });
+    }
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+    for(auto* interned : tags)
+    {
+        EXPECT_EQ(interned, &tag);
+    }
+}
+
+TEST_F(TestSmartStack, TypeTagOfReusedBuffer)
+{
+    class NamedDescriptor : public Descriptor<Malloc>
+    {
+      public:
+        NamedDescriptor(void* ptr, size_t size, const char* desc)
+            : Descriptor<Malloc>(ptr, size, desc)
+        {
+        }
+    };
+
+    // the same buffer address holding different descriptions must not share a cached tag
+    char desc[16];
+    std::strcpy(desc, "First");
+    NamedDescriptor first(nullptr, 0, desc);
+    std::strcpy(desc, "Second");
+    NamedDescriptor second(nullptr, 0, desc);
+    EXPECT_EQ(first.Type(), "Malloc(First)");
+    EXPECT_EQ(second.Type(), "Malloc(Second)");
+}
+
+TEST_F(TestSmartStack, RollbackRefusedWhileDescriptorsAlive)
+{
+    auto p0 = stack->Allocate(1024);
+    auto mark = stack->Mark();
+    auto p1 = stack->Allocate(1024);
+    auto p2 = stack->Allocate(1024);
+
+    EXPECT_FALSE(stack->Rollback(mark));
+    EXPECT_EQ(3072, stack->Allocated());
+    EXPECT_EQ(1, stack->Depth());
+
+    p1.reset();
+    EXPECT_FALSE(stack->Rollback(mark));
+    p2.reset();
+    EXPECT_TRUE(stack->Rollback(mark));
+    EXPECT_EQ(1024, stack->Allocated());
+
+    // descriptors allocated before the mark do not block the rollback
+    EXPECT_EQ(p0->Offset(), 0);
+}
+
+TEST_F(TestSmartStack, NestedScopedArenas)
+{
+    using Arena = ScopedArena<SmartStack<SystemV>>;
+    auto persistent = stack->Allocate(1024);
+    {
+        Arena outer(*stack);
+        auto scratch = outer.Allocate(4096);
+        {
+            Arena inner(*stack);
+            auto tmp = inner.Allocate(4096);
+            EXPECT_EQ(tmp->Offset(), 1024 + 4096);
+            EXPECT_EQ(2, stack->Depth());
+        }
+        EXPECT_EQ(1024 + 4096, stack->Allocated());
+        {
+            Arena inner(*stack);
+            auto tmp = inner.Allocate(1);
+            EXPECT_EQ(tmp->Offset(), 1024 + 4096);
+        }
+    }
+    EXPECT_EQ(1024, stack->Allocated());
+    EXPECT_EQ(0, stack->Depth());
+}
+
+TEST_F(TestSmartStack, ScopedArenaHoldsEscapedDescriptors)
+{
+    using Arena = ScopedArena<SmartStack<SystemV>>;
+    SmartStack<SystemV>::StackDescriptor escaped;
+    {
+        Arena outer(*stack);
+        {
+            Arena inner(*stack);
+            escaped = inner.Allocate(1024);
+        }
+        // the inner rollback was refused, so the escaped descriptor is still backed
+        EXPECT_EQ(1024, stack->Allocated());
+        auto next = outer.Allocate(1);
+        EXPECT_EQ(next->Offset(), 1024);
+    }
+    // as was the outer rollback; both marks were discarded
+    EXPECT_EQ(1024 + stack->Alignment(), stack->Allocated());
+    EXPECT_EQ(0, stack->Depth());
+    escaped.reset();
+    stack->Reset();
+    EXPECT_EQ(0, stack->Depth());
+}
+
+TEST_F(TestSmartStack, EscapedDescriptorsFoldIntoEnclosingMark)
+{
+    using Arena = ScopedArena<SmartStack<SystemV>>;
+    auto persistent = stack->Allocate(1024);
+    auto outer = stack->Mark();
+    std::vector<SmartStack<SystemV>::StackDescriptor> escaped;
+    for(std::size_t i = 0; i < 4 * SmartStack<SystemV>::MaxDepth; i++)
+    {
+        Arena arena(*stack);
+        auto scratch = arena.Allocate(1);
+        escaped.push_back(arena.Allocate(1));
+    }
+    // every refused rollback popped its mark
+    EXPECT_EQ(1, stack->Depth());
+
+    // a scope whose descriptors are all released still rolls back
+    auto allocated = stack->Allocated();
+    {
+        Arena arena(*stack);
+        auto scratch = arena.Allocate(1024);
+    }
+    EXPECT_EQ(allocated, stack->Allocated());
+
+    // the escaped descriptors now hold the enclosing mark
+    EXPECT_FALSE(stack->Rollback(outer));
+    escaped.pop_back();
+    EXPECT_FALSE(stack->Rollback(outer));
+    escaped.clear();
+    EXPECT_TRUE(stack->Rollback(outer));
+    EXPECT_EQ(1024, stack->Allocated());
+    EXPECT_EQ(0, stack->Depth());
+}
+
+TEST_F(TestSmartStack, ResetReleasesMarks)
+{
+    using Arena = ScopedArena<SmartStack<SystemV>>;
+    auto mark = stack->Mark();
+    auto held = stack->Allocate(1);
+    std::vector<SmartStack<SystemV>::StackDescriptor> escaped;
+    {
+        Arena arena(*stack);
+        escaped.push_back(arena.Allocate(1));
+    }
+    EXPECT_FALSE(stack->Rollback(mark));
+
+    // descriptors alive across the reset do not hold the marks taken after it
+    stack->Reset();
+    EXPECT_EQ(0, stack->Depth());
+    mark = stack->Mark();
+    auto scratch = stack->Allocate(1);
+    scratch.reset();
+    {
+        auto inner = stack->Mark();
+        EXPECT_TRUE(stack->Rollback(inner));
+    }
+    EXPECT_TRUE(stack->Rollback(mark));
+
+    // and release without disturbing the counts of the marks that reused their depth
+    mark = stack->Mark();
+    auto live = stack->Allocate(1);
+    held.reset();
+    escaped.clear();
+    EXPECT_FALSE(stack->Rollback(mark));
+    live.reset();
+    EXPECT_TRUE(stack->Rollback(mark));
+    EXPECT_EQ(0, stack->Allocated());
+}
+
+} // namespace
@@ -140,11 +140,11 @@ TEST_F(TestPool, PopOnReturnWithCapture)
     ASSERT_EQ(1, obj.use_count());
 
     // Capture obj in onReturn lambda
-    auto from_p2_0 = p2->Pop([obj](Object* obj) {});
+    auto from_p2_0 = p2->Pop([obj](Object* ptr) {});
     ASSERT_EQ(2, obj.use_count());
 
     // Capture obj again a second onReturn lambda
-    auto from_p2_1 = p2->Pop([obj](Object* obj) {});
+    auto from_p2_1 = p2->Pop([obj](Object* ptr) {});
     ASSERT_EQ(3, obj.use_count());
 
     // Free one of the resources that captured obj
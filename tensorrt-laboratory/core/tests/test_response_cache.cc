@@ -0,0 +1,228 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/response_cache.h"
+#include "gtest/gtest.h"
+
+using namespace trtlab;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Cache = ResponseCache<std::string>;
+
+ResponseCacheKey Key(const std::string& input, const std::string& model = "model")
+{
+    return ResponseCacheKey{model, "1", RequestDigest().Append(input.data(), input.size())};
+}
+
+std::shared_ptr<const std::string> Value(const std::string& value)
+{
+    return std::make_shared<const std::string>(value);
+}
+
+std::pair<std::uint64_t, std::uint64_t> Digest(const std::string& input)
+{
+    return RequestDigest().Append(input.data(), input.size()).Finish();
+}
+
+TEST(TestResponseCache, RequestDigest)
+{
+    // SipHash-2-4-128 reference vectors: key 00..0f, messages 00..n-1
+    std::string message;
+    for(char c = 0; c < 15; c++)
+    {
+        message.push_back(c);
+    }
+    auto reference = [](const std::string& message) {
+        return RequestDigest(0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL)
+            .Update(message.data(), message.size())
+            .Finish();
+    };
+    using Digest128 = std::pair<std::uint64_t, std::uint64_t>;
+    EXPECT_EQ(reference(""), Digest128(0xe6a825ba047f81a3ULL, 0x930255c71472f66dULL));
+    EXPECT_EQ(reference(message), Digest128(0x11a8b03399e99354ULL, 0xd9c3cf970fec087eULL));
+
+    // the message may be streamed in parts of any size
+    RequestDigest streamed(0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL);
+    streamed.Update(message.data(), 3).Update(message.data() + 3, 9).Update(message.data() + 12, 3);
+    EXPECT_EQ(streamed.Finish(), reference(message));
+
+    std::string input(1027, 'x');
+    auto digest = Digest(input);
+    EXPECT_EQ(digest, Digest(input));
+    // every byte, including the unaligned tail, contributes
+    for(std::size_t i : {0UL, 512UL, 1024UL, 1026UL})
+    {
+        auto changed = input;
+        changed[i] = 'y';
+        EXPECT_NE(digest, Digest(changed)) << i;
+    }
+    EXPECT_NE(digest, Digest(input.substr(1)));
+
+    // parts are length prefixed, so moving bytes between them changes the digest
+    auto split = [](const std::string& a, const std::string& b) {
+        return RequestDigest().Append(a.data(), a.size()).Append(b.data(), b.size()).Finish();
+    };
+    EXPECT_NE(split("ab", "c"), split("a", "bc"));
+    EXPECT_NE(split("abc", ""), Digest("abc"));
+
+    // the default key is random per process, not fixed
+    EXPECT_NE(Digest(""), reference(""));
+}
+
+TEST(TestResponseCache, HitAndMiss)
+{
+    Cache cache(1 << 20, Cache::duration::zero(), 1);
+    EXPECT_EQ(cache.Find(Key("a")), nullptr);
+    cache.Insert(Key("a"), Value("A"), 1);
+    ASSERT_NE(cache.Find(Key("a")), nullptr);
+    EXPECT_EQ(*cache.Find(Key("a")), "A");
+    // the model name and version are part of the key
+    EXPECT_EQ(cache.Find(Key("a", "other")), nullptr);
+    auto key = Key("a");
+    key.version = "2";
+    EXPECT_EQ(cache.Find(key), nullptr);
+
+    cache.Insert(Key("a"), Value("A2"), 2);
+    EXPECT_EQ(*cache.Find(Key("a")), "A2");
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 3);
+    EXPECT_EQ(stats.misses, 3);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(stats.bytes, 2 + Cache::EntryOverhead());
+}
+
+TEST(TestResponseCache, KeyComparesWholeDigest)
+{
+    Cache cache(1 << 20, Cache::duration::zero(), 1);
+    cache.Insert(Key("a"), Value("A"), 1);
+
+    // a different request whose digest shares the first half is a miss
+    auto forged = Key("b");
+    forged.hash = Key("a").hash;
+    EXPECT_EQ(cache.Find(forged), nullptr);
+    cache.Insert(forged, Value("B"), 1);
+    EXPECT_EQ(*cache.Find(Key("a")), "A");
+    EXPECT_EQ(*cache.Find(forged), "B");
+    EXPECT_EQ(cache.GetStats().entries, 2);
+}
+
+TEST(TestResponseCache, EvictsLeastRecentlyUsed)
+{
+    auto overhead = Cache::EntryOverhead();
+    Cache cache(300 + 3 * overhead, Cache::duration::zero(), 1);
+    cache.Insert(Key("a"), Value("A"), 100);
+    cache.Insert(Key("b"), Value("B"), 100);
+    cache.Insert(Key("c"), Value("C"), 100);
+    auto held = cache.Find(Key("a"));
+
+    cache.Insert(Key("d"), Value("D"), 150);
+    EXPECT_NE(cache.Find(Key("a")), nullptr);
+    EXPECT_EQ(cache.Find(Key("b")), nullptr);
+    EXPECT_EQ(cache.Find(Key("c")), nullptr);
+    EXPECT_NE(cache.Find(Key("d")), nullptr);
+
+    // too large to cache at all
+    cache.Insert(Key("e"), Value("E"), 301 + 2 * overhead);
+    EXPECT_EQ(cache.Find(Key("e")), nullptr);
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.evictions, 2);
+    EXPECT_EQ(stats.bytes, 250 + 2 * overhead);
+
+    // evicted values live on while held
+    cache.Clear();
+    EXPECT_EQ(*held, "A");
+    EXPECT_EQ(cache.GetStats().entries, 0);
+}
+
+TEST(TestResponseCache, Expires)
+{
+    Cache cache(1 << 20, 10ms);
+    auto start = Cache::clock::now();
+    cache.Insert(Key("a"), Value("A"), 1, start);
+    EXPECT_NE(cache.Find(Key("a"), start + 9ms), nullptr);
+    EXPECT_EQ(cache.Find(Key("a"), start + 10ms), nullptr);
+    EXPECT_EQ(cache.Find(Key("a"), start), nullptr);
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.expirations, 1);
+    EXPECT_EQ(stats.entries, 0);
+    EXPECT_EQ(stats.bytes, 0);
+}
+
+TEST(TestResponseCache, FewerBytesThanShards)
+{
+    // every shard must hold an entry, so a small capacity uses fewer shards
+    Cache cache(4 * (Cache::EntryOverhead() + 1), Cache::duration::zero(), 16);
+    cache.Insert(Key("a"), Value("A"), 1);
+    EXPECT_EQ(*cache.Find(Key("a")), "A");
+}
+
+TEST(TestResponseCache, Shards)
+{
+    auto charge = 10 + Cache::EntryOverhead();
+    Cache cache(16 * 100 * charge, Cache::duration::zero(), 16);
+    for(int i = 0; i < 10000; i++)
+    {
+        cache.Insert(Key(std::to_string(i)), Value(std::to_string(i)), 10);
+    }
+    auto stats = cache.GetStats();
+    EXPECT_LE(stats.bytes, 16 * 100 * charge);
+    // keys spread over every shard, so close to the full capacity is in use
+    EXPECT_GT(stats.entries, 1500);
+    EXPECT_EQ(stats.entries + stats.evictions, 10000);
+}
+
+TEST(TestResponseCache, TinyEntriesStayUnderCapacity)
+{
+    // health probe sized responses are dwarfed by the bookkeeping of their entries
+    const std::size_t capacity = 64 * 1024;
+    Cache cache(capacity, Cache::duration::zero(), 4);
+    for(int i = 0; i < 100000; i++)
+    {
+        cache.Insert(Key(std::to_string(i)), Value("ok"), 2);
+    }
+    auto stats = cache.GetStats();
+    EXPECT_LE(stats.bytes, capacity);
+    EXPECT_LE(stats.entries * (2 + Cache::EntryOverhead()), capacity);
+    EXPECT_GT(stats.entries, 0);
+
+    // names too long to be stored inline are charged as well
+    std::string model(200, 'm');
+    Cache named(capacity, Cache::duration::zero(), 4);
+    for(int i = 0; i < 100000; i++)
+    {
+        named.Insert(Key(std::to_string(i), model), Value("ok"), 2);
+    }
+    stats = named.GetStats();
+    EXPECT_LE(stats.bytes, capacity);
+    EXPECT_LE(stats.entries * (2 + Cache::EntryOverhead() + model.size()), capacity);
+}
+
+} // namespace
@@ -0,0 +1,205 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/single_flight.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+using namespace trtlab;
+
+namespace {
+
+using Flights = SingleFlight<std::vector<float>>;
+
+ResponseCacheKey Key(std::uint64_t input)
+{
+    return ResponseCacheKey{"model", "1", RequestDigest().Update(&input, sizeof(input))};
+}
+
+// CPU stand-in for a model
+std::vector<float> Compute(std::uint64_t input)
+{
+    std::vector<float> output(256);
+    for(std::size_t i = 0; i < output.size(); i++)
+    {
+        output[i] = static_cast<float>(input * i % 97);
+    }
+    return output;
+}
+
+TEST(TestSingleFlight, OneExecutionPerKey)
+{
+    constexpr int threads = 16;
+    constexpr int keys = 4;
+    Flights flights;
+    std::atomic<int> executions[keys] = {};
+    std::vector<Flights::Result> results(threads);
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t] {
+            auto input = t % keys;
+            results[t] = flights.Do(Key(input), [&, input] {
+                executions[input]++;
+                // hold the flight open until every duplicate has attached to it
+                while(flights.Executions() + flights.Coalesced() < threads)
+                {
+                    std::this_thread::yield();
+                }
+                return Compute(input);
+            });
+        });
+    }
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    EXPECT_EQ(flights.Executions(), keys);
+    EXPECT_EQ(flights.Coalesced(), threads - keys);
+    for(int k = 0; k < keys; k++)
+    {
+        EXPECT_EQ(executions[k], 1);
+    }
+    for(int t = 0; t < threads; t++)
+    {
+        ASSERT_NE(results[t], nullptr);
+        EXPECT_EQ(*results[t], Compute(t % keys));
+        // every waiter shares the leader's result
+        EXPECT_EQ(results[t], results[t % keys]);
+    }
+}
+
+TEST(TestSingleFlight, ErrorsReachEveryWaiter)
+{
+    constexpr int threads = 8;
+    Flights flights;
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&] {
+            try
+            {
+                flights.Do(Key(0), [&]() -> std::vector<float> {
+                    while(flights.Executions() + flights.Coalesced() < threads)
+                    {
+                        std::this_thread::yield();
+                    }
+                    throw std::runtime_error("model failed");
+                });
+            }
+            catch(const std::runtime_error& e)
+            {
+                EXPECT_STREQ(e.what(), "model failed");
+                failures++;
+            }
+        });
+    }
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+    EXPECT_EQ(failures, threads);
+    EXPECT_EQ(flights.Executions(), 1);
+
+    // the failed flight has landed; the next request executes afresh
+    EXPECT_EQ(*flights.Do(Key(0), [] { return Compute(0); }), Compute(0));
+    EXPECT_EQ(flights.Executions(), 2);
+}
+
+TEST(TestSingleFlight, JoinAndComplete)
+{
+    Flights flights;
+    int called = 0;
+    Flights::Result shared;
+    auto callback = [&](const Flights::Result& result, std::exception_ptr exception) {
+        EXPECT_EQ(exception, nullptr);
+        shared = result;
+        called++;
+    };
+
+    EXPECT_TRUE(flights.Join(Key(1), callback));
+    EXPECT_FALSE(flights.Join(Key(1), callback));
+    int failed = 0;
+    EXPECT_TRUE(flights.Join(Key(2), [&](const Flights::Result& result, std::exception_ptr e) {
+        EXPECT_EQ(result, nullptr);
+        EXPECT_NE(e, nullptr);
+        failed++;
+    }));
+    EXPECT_EQ(called, 0);
+
+    auto result = std::make_shared<const std::vector<float>>(Compute(1));
+    flights.Complete(Key(1), result);
+    EXPECT_EQ(called, 2);
+    EXPECT_EQ(shared, result);
+
+    flights.Fail(Key(2), std::make_exception_ptr(std::runtime_error("failed")));
+    EXPECT_EQ(failed, 1);
+    EXPECT_EQ(called, 2);
+}
+
+TEST(TestSingleFlight, GuardFailsDroppedFlight)
+{
+    Flights flights;
+    std::exception_ptr failure;
+    EXPECT_TRUE(flights.Join(Key(1), [&](const Flights::Result& result, std::exception_ptr e) {
+        EXPECT_EQ(result, nullptr);
+        failure = e;
+    }));
+
+    // work holding the guard is dropped before it completes, e.g. by a throwing pool task
+    std::function<void()> work = [guard = std::make_shared<Flights::Guard>(flights, Key(1))] {
+        guard->Complete(std::make_shared<const std::vector<float>>(Compute(1)));
+    };
+    work = nullptr;
+    ASSERT_NE(failure, nullptr);
+    EXPECT_THROW(std::rethrow_exception(failure), std::future_error);
+
+    // the key is free again and a guard that lands only lands once
+    int called = 0;
+    EXPECT_TRUE(flights.Join(Key(1), [&](const Flights::Result& result, std::exception_ptr e) {
+        EXPECT_NE(result, nullptr);
+        EXPECT_EQ(e, nullptr);
+        called++;
+    }));
+    {
+        Flights::Guard guard(flights, Key(1));
+        guard.Complete(std::make_shared<const std::vector<float>>(Compute(1)));
+        guard.Fail(std::make_exception_ptr(std::runtime_error("late")));
+    }
+    EXPECT_EQ(called, 1);
+    EXPECT_EQ(flights.Executions(), 2);
+}
+
+} // namespace
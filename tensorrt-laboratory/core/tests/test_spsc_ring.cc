@@ -0,0 +1,117 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/spsc_ring.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+
+using namespace trtlab;
+
+namespace {
+
+TEST(TestSpscRing, FifoUntilFull)
+{
+    SpscRing<int> ring(3);
+    EXPECT_EQ(ring.Capacity(), 4);
+    EXPECT_TRUE(ring.Empty());
+    EXPECT_EQ(ring.Front(), nullptr);
+
+    for(int i = 0; i < 4; i++)
+    {
+        int value = i;
+        EXPECT_TRUE(ring.TryPush(std::move(value)));
+    }
+    int rejected = 4;
+    EXPECT_FALSE(ring.TryPush(std::move(rejected)));
+    EXPECT_EQ(ring.Size(), 4);
+    EXPECT_EQ(*ring.Peek(3), 3);
+    EXPECT_EQ(ring.Peek(4), nullptr);
+
+    for(int i = 0; i < 4; i++)
+    {
+        ASSERT_NE(ring.Front(), nullptr);
+        EXPECT_EQ(*ring.Front(), i);
+        ring.Pop();
+    }
+    EXPECT_TRUE(ring.Empty());
+
+    // wraps around
+    EXPECT_TRUE(ring.TryPush(std::move(rejected)));
+    EXPECT_EQ(*ring.Front(), 4);
+}
+
+TEST(TestSpscRing, SlotsAreReused)
+{
+    SpscRing<std::string> ring(1);
+    std::string first(1024, 'a');
+    auto storage = first.data();
+    ASSERT_TRUE(ring.TryPush(std::move(first)));
+    auto slot = ring.Front();
+    EXPECT_EQ(slot->data(), storage);
+    ring.Pop();
+
+    // the popped slot holds the next element
+    std::string second(1024, 'b');
+    ASSERT_TRUE(ring.TryPush(std::move(second)));
+    EXPECT_EQ(ring.Front(), slot);
+    EXPECT_EQ(*slot, std::string(1024, 'b'));
+}
+
+TEST(TestSpscRing, ConcurrentProducerConsumer)
+{
+    constexpr std::size_t count = 1 << 20;
+    SpscRing<std::size_t> ring(64);
+
+    std::thread producer([&ring] {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            auto value = i;
+            while(!ring.TryPush(std::move(value)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::size_t expected = 0;
+    while(expected < count)
+    {
+        auto value = ring.Front();
+        if(!value)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(*value, expected++);
+        ring.Pop();
+    }
+    producer.join();
+    EXPECT_TRUE(ring.Empty());
+}
+
+} // namespace
@@ -28,6 +28,10 @@
 #include "tensorrt/laboratory/core/thread_pool.h"
 #include "gtest/gtest.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using namespace trtlab;
 
 class TestThreadPool : public ::testing::Test
@@ -105,4 +109,69 @@ TEST_F(TestThreadPool, CaptureThis)
     obj.reset();
     EXPECT_EQ(future.get(), 42);
     LOG(INFO) << "done";
-}
\ No newline at end of file
+}
+
+TEST_F(TestThreadPool, InstrumentedPool)
+{
+    using InstrumentedPool = BaseThreadPool<std::mutex, std::condition_variable, ThreadPoolStats>;
+    auto pool = std::make_unique<InstrumentedPool>(1);
+
+    // block the only worker so the remaining tasks accumulate in the queue
+    std::promise<void> gate;
+    auto blocked = gate.get_future().share();
+    std::vector<std::future<void>> futures;
+    futures.push_back(pool->enqueue([blocked] { blocked.wait(); }));
+    for(int i = 0; i < 9; i++)
+    {
+        futures.push_back(
+            pool->enqueue([] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    gate.set_value();
+    for(auto& f : futures)
+    {
+        f.get();
+    }
+
+    // the packaged_task fulfils its future before the worker records Finished()
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(pool->Stats().GetSnapshot().completed < 10 &&
+          std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+
+    auto stats = pool->Stats().GetSnapshot();
+    EXPECT_EQ(stats.enqueued, 10);
+    EXPECT_EQ(stats.completed, 10);
+    EXPECT_EQ(stats.Pending(), 0);
+    EXPECT_GE(stats.max_queue_depth, 9);
+    EXPECT_EQ(stats.wait.count, 10);
+    EXPECT_EQ(stats.run.count, 10);
+    // the last task waited for the 10ms gate plus 8 x 1ms tasks
+    EXPECT_GE(stats.wait.max, 10000000);
+    EXPECT_GE(stats.run.Percentile(50), 900000);
+    EXPECT_GT(stats.Throughput(), 0.0);
+}
+
+TEST(TestHistogram, Percentiles)
+{
+    Histogram histogram;
+    for(std::uint64_t i = 1; i <= 10000; i++)
+    {
+        histogram.Record(i);
+    }
+    auto snapshot = histogram.GetSnapshot();
+    EXPECT_EQ(snapshot.count, 10000);
+    EXPECT_EQ(snapshot.max, 10000);
+    EXPECT_DOUBLE_EQ(snapshot.Mean(), 5000.5);
+    // log-linear buckets bound the relative error by 1/SubBuckets
+    EXPECT_NEAR(snapshot.Percentile(50), 5000, 5000 / Histogram::SubBuckets);
+    EXPECT_NEAR(snapshot.Percentile(99), 9900, 9900 / Histogram::SubBuckets);
+    EXPECT_EQ(snapshot.Percentile(100), 10000);
+
+    for(int i = 0; i < Histogram::Buckets; i++)
+    {
+        EXPECT_EQ(Histogram::BucketIndex(Histogram::BucketUpperBound(i)), i);
+    }
+}
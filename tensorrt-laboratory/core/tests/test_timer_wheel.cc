@@ -0,0 +1,236 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/timer_wheel.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace trtlab;
+using namespace std::chrono_literals;
+
+namespace {
+
+class TestTimerWheel : public ::testing::Test
+{
+  protected:
+    void SetUp() override { start = TimerWheel::clock::now(); }
+
+    TimerWheel::time_point start;
+};
+
+TEST_F(TestTimerWheel, FiresAtDeadline)
+{
+    TimerWheel wheel(1ms, start);
+    int fired = 0;
+    wheel.Schedule(start + 10ms, [&fired] { fired++; });
+    EXPECT_EQ(wheel.Size(), 1);
+    EXPECT_EQ(wheel.NextDeadline(), start + 10ms);
+
+    EXPECT_EQ(wheel.Advance(start + 9ms), 0);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.Advance(start + 10ms), 1);
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(wheel.Empty());
+    EXPECT_EQ(wheel.NextDeadline(), TimerWheel::time_point::max());
+}
+
+TEST_F(TestTimerWheel, NeverFiresEarly)
+{
+    TimerWheel wheel(1ms, start);
+    int fired = 0;
+    // rounded up to the 2ms tick
+    wheel.Schedule(start + 1500us, [&fired] { fired++; });
+    wheel.Advance(start + 1999us);
+    EXPECT_EQ(fired, 0);
+    wheel.Advance(start + 2ms);
+    EXPECT_EQ(fired, 1);
+
+    // deadlines in the past fire on the next tick
+    wheel.Schedule(start, [&fired] { fired++; });
+    wheel.Advance(start + 2ms);
+    EXPECT_EQ(fired, 1);
+    wheel.Advance(start + 3ms);
+    EXPECT_EQ(fired, 2);
+}
+
+TEST_F(TestTimerWheel, Cancel)
+{
+    TimerWheel wheel(1ms, start);
+    int fired = 0;
+    auto a = wheel.Schedule(start + 5ms, [&fired] { fired += 1; });
+    auto b = wheel.Schedule(start + 5ms, [&fired] { fired += 10; });
+    auto c = wheel.Schedule(start + 5s, [&fired] { fired += 100; });
+
+    EXPECT_TRUE(wheel.Cancel(b));
+    EXPECT_FALSE(wheel.Cancel(b));
+    EXPECT_TRUE(wheel.Cancel(c));
+    EXPECT_FALSE(wheel.Cancel(TimerWheel::InvalidTimer));
+    EXPECT_EQ(wheel.Size(), 1);
+
+    wheel.Advance(start + 10s);
+    EXPECT_EQ(fired, 1);
+
+    // a fired timer cannot be cancelled, even after its node is recycled
+    EXPECT_FALSE(wheel.Cancel(a));
+    auto d = wheel.Schedule(start + 11s, [] {});
+    EXPECT_NE(a, d);
+    EXPECT_FALSE(wheel.Cancel(a));
+    EXPECT_TRUE(wheel.Cancel(d));
+}
+
+TEST_F(TestTimerWheel, CascadeAcrossLevels)
+{
+    TimerWheel wheel(1ms, start);
+    std::vector<std::chrono::milliseconds> deadlines = {1ms,     255ms,    256ms,   257ms,
+                                                        65535ms, 65536ms,  70000ms, 16777216ms,
+                                                        20000000ms};
+    std::vector<TimerWheel::time_point> fired_at;
+    TimerWheel::time_point now = start;
+    for(auto d : deadlines)
+    {
+        wheel.Schedule(start + d, [&fired_at, &now] { fired_at.push_back(now); });
+    }
+
+    // step the wheel by its next deadline; the reported deadline must never be late
+    while(!wheel.Empty())
+    {
+        auto next = wheel.NextDeadline();
+        ASSERT_GT(next, now);
+        now = next;
+        wheel.Advance(now);
+    }
+
+    ASSERT_EQ(fired_at.size(), deadlines.size());
+    for(std::size_t i = 0; i < deadlines.size(); i++)
+    {
+        EXPECT_EQ(fired_at[i], start + deadlines[i]);
+    }
+}
+
+TEST_F(TestTimerWheel, RandomDeadlines)
+{
+    TimerWheel wheel(1ms, start);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> dist(1, 200000);
+    std::vector<TimerWheel::time_point> deadlines;
+    std::vector<TimerWheel::TimerId> ids;
+    std::size_t fired = 0;
+    std::size_t late = 0;
+    TimerWheel::time_point now = start;
+
+    for(int i = 0; i < 10000; i++)
+    {
+        auto deadline = start + std::chrono::milliseconds(dist(rng));
+        ids.push_back(wheel.Schedule(deadline, [&now, &fired, &late, deadline] {
+            fired++;
+            if(now != deadline) late++;
+        }));
+    }
+    // cancel every third timer
+    std::size_t cancelled = 0;
+    for(std::size_t i = 0; i < ids.size(); i += 3)
+    {
+        EXPECT_TRUE(wheel.Cancel(ids[i]));
+        cancelled++;
+    }
+
+    while(!wheel.Empty())
+    {
+        now = wheel.NextDeadline();
+        wheel.Advance(now);
+    }
+    EXPECT_EQ(fired + cancelled, ids.size());
+    EXPECT_EQ(late, 0);
+}
+
+TEST_F(TestTimerWheel, CallbackReschedules)
+{
+    TimerWheel wheel(1ms, start);
+    int count = 0;
+    std::function<void()> periodic = [&] {
+        if(++count < 5) wheel.ScheduleAfter(10ms, periodic);
+    };
+    wheel.Schedule(start + 10ms, periodic);
+    for(int i = 1; i <= 100; i++)
+    {
+        wheel.Advance(start + std::chrono::milliseconds(i));
+    }
+    EXPECT_EQ(count, 5);
+    EXPECT_TRUE(wheel.Empty());
+}
+
+TEST_F(TestTimerWheel, ScheduleAfterLongIdle)
+{
+    // an idle owner need not advance the wheel, so the first timer after a week is inserted
+    // against a stale tick; advancing to it must not step through every idle tick
+    TimerWheel wheel(1ms, start);
+    auto idle = start + std::chrono::hours(24 * 7);
+    int fired = 0;
+    wheel.Schedule(idle + 5ms, [&fired] { fired++; });
+    wheel.Schedule(idle + 1h, [&fired] { fired++; });
+
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_EQ(wheel.Advance(idle + 4ms), 0);
+    EXPECT_EQ(wheel.Advance(idle + 5ms), 1);
+    EXPECT_EQ(wheel.Advance(idle + 2h), 1);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    EXPECT_EQ(fired, 2);
+    EXPECT_LT(elapsed, 50ms);
+}
+
+TEST_F(TestTimerWheel, CoarseAdvances)
+{
+    // advancing in large, irregular steps fires each timer on the first advance past it
+    TimerWheel wheel(1ms, start);
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int> deadline_ms(1, 5000000);
+    std::uniform_int_distribution<int> step_ms(1, 100000);
+    std::vector<std::chrono::milliseconds> deadlines;
+    std::vector<std::chrono::milliseconds> fired_at;
+    auto now = 0ms;
+    for(int i = 0; i < 1000; i++)
+    {
+        std::chrono::milliseconds deadline(deadline_ms(rng));
+        deadlines.push_back(deadline);
+        wheel.Schedule(start + deadline, [&fired_at, &now] { fired_at.push_back(now); });
+    }
+    while(!wheel.Empty())
+    {
+        now += std::chrono::milliseconds(step_ms(rng));
+        wheel.Advance(start + now);
+    }
+    std::sort(deadlines.begin(), deadlines.end());
+    ASSERT_EQ(fired_at.size(), deadlines.size());
+    for(std::size_t i = 0; i < deadlines.size(); i++)
+    {
+        EXPECT_GE(fired_at[i], deadlines[i]);
+        EXPECT_LT(fired_at[i] - deadlines[i], 100000ms);
+    }
+}
+
+} // namespace
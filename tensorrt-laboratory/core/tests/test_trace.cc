@@ -0,0 +1,201 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/trace.h"
+#include "gtest/gtest.h"
+
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace trtlab;
+
+namespace {
+
+class TestRequestTrace : public ::testing::Test
+{
+  protected:
+    void TearDown() override { RequestTrace::SetSampleRate(0.0); }
+
+    static std::string ChromeTrace()
+    {
+        std::ostringstream os;
+        RequestTrace::WriteChromeTrace(os);
+        return os.str();
+    }
+
+    static int CountSpans(const std::string& trace, RequestTrace::Id id)
+    {
+        auto pattern = "\"pid\":" + std::to_string(id) + ",\"tid\"";
+        int count = 0;
+        for(auto pos = trace.find(pattern); pos != std::string::npos;
+            pos = trace.find(pattern, pos + 1))
+        {
+            count++;
+        }
+        return count;
+    }
+};
+
+TEST_F(TestRequestTrace, SampleRate)
+{
+    RequestTrace::SetSampleRate(0.0);
+    for(int i = 0; i < 1000; i++)
+    {
+        EXPECT_EQ(RequestTrace::Sample(), 0);
+    }
+
+    RequestTrace::SetSampleRate(1.0);
+    std::set<RequestTrace::Id> ids;
+    for(int i = 0; i < 1000; i++)
+    {
+        auto id = RequestTrace::Sample();
+        EXPECT_NE(id, 0);
+        ids.insert(id);
+    }
+    EXPECT_EQ(ids.size(), 1000);
+
+    RequestTrace::SetSampleRate(0.25);
+    EXPECT_DOUBLE_EQ(RequestTrace::SampleRate(), 0.25);
+    int sampled = 0;
+    for(int i = 0; i < 100000; i++)
+    {
+        sampled += RequestTrace::Sample() ? 1 : 0;
+    }
+    EXPECT_GT(sampled, 23000);
+    EXPECT_LT(sampled, 27000);
+
+    RequestTrace::SetSampleRate(2.0);
+    EXPECT_DOUBLE_EQ(RequestTrace::SampleRate(), 1.0);
+}
+
+TEST_F(TestRequestTrace, ScopesNest)
+{
+    EXPECT_EQ(RequestTrace::Current(), 0);
+    {
+        TraceScope outer(7);
+        EXPECT_EQ(RequestTrace::Current(), 7);
+        {
+            TraceScope inner(9);
+            EXPECT_EQ(RequestTrace::Current(), 9);
+        }
+        EXPECT_EQ(RequestTrace::Current(), 7);
+    }
+    EXPECT_EQ(RequestTrace::Current(), 0);
+}
+
+TEST_F(TestRequestTrace, UnsampledRequestsRecordNothing)
+{
+    auto before = ChromeTrace();
+    {
+        TraceSpan span("unsampled");
+    }
+    RequestTrace::Record(0, "unsampled", 1, 2);
+    EXPECT_EQ(ChromeTrace(), before);
+    EXPECT_EQ(before.find("unsampled"), std::string::npos);
+}
+
+TEST_F(TestRequestTrace, ChromeTraceFollowsRequestAcrossThreads)
+{
+    RequestTrace::SetSampleRate(1.0);
+    auto id = RequestTrace::Sample();
+    {
+        TraceScope scope(id);
+        TraceSpan span("receive");
+        std::thread worker([trace = RequestTrace::Current()] {
+            TraceScope scope(trace);
+            TraceSpan span("compute");
+        });
+        worker.join();
+    }
+
+    auto trace = ChromeTrace();
+    EXPECT_EQ(trace.compare(0, 15, "{\"displayTimeUn"), 0);
+    EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+    EXPECT_NE(trace.find("\"args\":{\"name\":\"request " + std::to_string(id) + "\"}"),
+              std::string::npos);
+    EXPECT_EQ(CountSpans(trace, id), 2);
+
+    // spans of one request are recorded by different threads, i.e. land on different tracks
+    auto receive = trace.find("{\"name\":\"receive\"");
+    auto compute = trace.find("{\"name\":\"compute\"");
+    ASSERT_NE(receive, std::string::npos);
+    ASSERT_NE(compute, std::string::npos);
+    auto tid = [&trace](std::size_t pos) {
+        auto begin = trace.find("\"tid\":", pos) + 6;
+        return trace.substr(begin, trace.find(',', begin) - begin);
+    };
+    EXPECT_NE(tid(receive), tid(compute));
+}
+
+TEST_F(TestRequestTrace, RingKeepsNewestSpans)
+{
+    RequestTrace::SetSampleRate(1.0);
+    auto oldest = RequestTrace::Sample();
+    auto newest = RequestTrace::Sample();
+    std::thread writer([oldest, newest] {
+        RequestTrace::Record(oldest, "overwritten", 0, 1);
+        for(std::uint64_t i = 0; i < RequestTrace::RingCapacity; i++)
+        {
+            RequestTrace::Record(newest, "kept", TscClock::Now(), TscClock::Now());
+        }
+    });
+    writer.join();
+
+    auto trace = ChromeTrace();
+    EXPECT_EQ(CountSpans(trace, oldest), 0);
+    EXPECT_EQ(CountSpans(trace, newest), RequestTrace::RingCapacity);
+}
+
+TEST_F(TestRequestTrace, ExitedThreadsRingIsReused)
+{
+    RequestTrace::SetSampleRate(1.0);
+    auto first = RequestTrace::Sample();
+    auto second = RequestTrace::Sample();
+    std::thread([first] {
+        for(std::uint64_t i = 0; i < RequestTrace::RingCapacity; i++)
+        {
+            RequestTrace::Record(first, "exited", TscClock::Now(), TscClock::Now());
+        }
+    }).join();
+
+    // the spans of an exited thread are still exported
+    EXPECT_EQ(CountSpans(ChromeTrace(), first), RequestTrace::RingCapacity);
+
+    // the next thread appends to the ring the first one returned, on a track of its own
+    std::thread([second] { RequestTrace::Record(second, "reused", 0, 1); }).join();
+    auto trace = ChromeTrace();
+    EXPECT_EQ(CountSpans(trace, first), RequestTrace::RingCapacity - 1);
+    EXPECT_EQ(CountSpans(trace, second), 1);
+    auto tid = [&trace](RequestTrace::Id id) {
+        auto pattern = "\"pid\":" + std::to_string(id) + ",\"tid\":";
+        auto begin = trace.find(pattern) + pattern.size();
+        return trace.substr(begin, trace.find(',', begin) - begin);
+    };
+    EXPECT_NE(tid(first), tid(second));
+}
+
+} // namespace
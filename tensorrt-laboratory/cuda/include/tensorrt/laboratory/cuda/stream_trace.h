@@ -0,0 +1,74 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "tensorrt/laboratory/core/trace.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Device side stages of a sampled request
+ *
+ * Work launched on a stream completes asynchronously, so timing the launching thread says
+ * little about it.  StreamTrace enqueues host functions stamping when the stream reaches the
+ * start and each Mark; stage i spans from mark i-1 to mark i.  The spans are recorded by
+ * the CUDA callback thread once the stream passes Finish(), called by the destructor if
+ * needed.  Nothing is enqueued for unsampled requests.  Marks past MaxStages are dropped.
+ */
+class StreamTrace
+{
+  public:
+    static constexpr int MaxStages = 8;
+
+    StreamTrace(RequestTrace::Id id, cudaStream_t stream);
+    ~StreamTrace();
+
+    DELETE_COPYABILITY(StreamTrace);
+    DELETE_MOVEABILITY(StreamTrace);
+
+    /**
+     * @brief End the current stage when the stream reaches this point; stage must be a literal
+     */
+    void Mark(const char* stage);
+    void Finish();
+
+    /**
+     * @brief Number of marks dropped because the timeline already held MaxStages stages
+     */
+    int Dropped() const { return m_Dropped; }
+
+  private:
+    struct Timeline;
+    cudaStream_t m_Stream;
+    Timeline* m_Timeline; // owned by the stream once Finish is enqueued
+    int m_Dropped;
+};
+
+} // namespace trtlab
@@ -0,0 +1,95 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/cuda/stream_trace.h"
+
+#include <glog/logging.h>
+
+namespace trtlab {
+
+struct StreamTrace::Timeline
+{
+    RequestTrace::Id id;
+    int marks;
+    const char* stages[MaxStages + 1];
+    std::uint64_t stamps[MaxStages + 1];
+
+    static void Stamp(void* stamp) { *static_cast<std::uint64_t*>(stamp) = TscClock::Now(); }
+
+    static void Record(void* data)
+    {
+        auto timeline = static_cast<Timeline*>(data);
+        for(int i = 1; i < timeline->marks; i++)
+        {
+            RequestTrace::Record(timeline->id, timeline->stages[i], timeline->stamps[i - 1],
+                                 timeline->stamps[i]);
+        }
+        delete timeline;
+    }
+};
+
+StreamTrace::StreamTrace(RequestTrace::Id id, cudaStream_t stream)
+    : m_Stream(stream), m_Timeline(nullptr), m_Dropped(0)
+{
+    if(id)
+    {
+        m_Timeline = new Timeline{id, 0};
+        Mark(nullptr);
+    }
+}
+
+StreamTrace::~StreamTrace() { Finish(); }
+
+void StreamTrace::Mark(const char* stage)
+{
+    if(!m_Timeline)
+    {
+        return;
+    }
+    if(m_Timeline->marks > MaxStages)
+    {
+        // mark 0 is the start, so the timeline is full after MaxStages stages
+        LOG_IF(WARNING, m_Dropped++ == 0)
+            << "StreamTrace dropping stages after " << MaxStages << "; first dropped: " << stage;
+        return;
+    }
+    auto mark = m_Timeline->marks++;
+    m_Timeline->stages[mark] = stage;
+    CHECK_EQ(cudaLaunchHostFunc(m_Stream, &Timeline::Stamp, &m_Timeline->stamps[mark]),
+             cudaSuccess);
+}
+
+void StreamTrace::Finish()
+{
+    if(!m_Timeline)
+    {
+        return;
+    }
+    CHECK_EQ(cudaLaunchHostFunc(m_Stream, &Timeline::Record, m_Timeline), cudaSuccess);
+    m_Timeline = nullptr;
+}
+
+} // namespace trtlab
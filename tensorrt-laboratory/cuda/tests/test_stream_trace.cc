@@ -0,0 +1,105 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/cuda/stream_trace.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+
+#include <glog/logging.h>
+
+using namespace trtlab;
+
+namespace {
+
+class TestStreamTrace : public ::testing::Test
+{
+  protected:
+    void SetUp() override { CHECK_EQ(cudaStreamCreate(&m_Stream), cudaSuccess); }
+
+    void TearDown() override
+    {
+        RequestTrace::SetSampleRate(0.0);
+        CHECK_EQ(cudaStreamDestroy(m_Stream), cudaSuccess);
+    }
+
+    static int CountSpans(RequestTrace::Id id)
+    {
+        std::ostringstream os;
+        RequestTrace::WriteChromeTrace(os);
+        auto trace = os.str();
+        auto pattern = "\"pid\":" + std::to_string(id) + ",\"tid\"";
+        int count = 0;
+        for(auto pos = trace.find(pattern); pos != std::string::npos;
+            pos = trace.find(pattern, pos + 1))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    cudaStream_t m_Stream;
+};
+
+TEST_F(TestStreamTrace, RecordsEachStage)
+{
+    RequestTrace::SetSampleRate(1.0);
+    auto id = RequestTrace::Sample();
+    {
+        StreamTrace trace(id, m_Stream);
+        trace.Mark("h2d");
+        trace.Mark("compute");
+        trace.Mark("d2h");
+    }
+    ASSERT_EQ(cudaStreamSynchronize(m_Stream), cudaSuccess);
+    EXPECT_EQ(CountSpans(id), 3);
+}
+
+TEST_F(TestStreamTrace, DropsMarksPastMaxStages)
+{
+    RequestTrace::SetSampleRate(1.0);
+    auto id = RequestTrace::Sample();
+    {
+        StreamTrace trace(id, m_Stream);
+        for(int i = 0; i < StreamTrace::MaxStages + 3; i++)
+        {
+            trace.Mark("stage");
+        }
+        EXPECT_EQ(trace.Dropped(), 3);
+    }
+    ASSERT_EQ(cudaStreamSynchronize(m_Stream), cudaSuccess);
+    EXPECT_EQ(CountSpans(id), StreamTrace::MaxStages);
+}
+
+TEST_F(TestStreamTrace, UnsampledRequestsEnqueueNothing)
+{
+    StreamTrace trace(0, m_Stream);
+    trace.Mark("unsampled");
+    EXPECT_EQ(trace.Dropped(), 0);
+}
+
+} // namespace
@@ -0,0 +1,187 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/balancer.h"
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::client::Balancer;
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+struct ReplicaResources : public ::trtlab::Resources
+{
+    ReplicaResources(std::chrono::milliseconds delay) : delay(delay) {}
+    std::chrono::milliseconds delay;
+};
+
+class ReplicaContext final : public nvrpc::Context<Input, Output, ReplicaResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        auto delay = GetResources()->delay;
+        if(delay.count() == 0)
+        {
+            FinishResponse();
+            return;
+        }
+        ArmTimer(delay, [this] { FinishResponse(); });
+    }
+};
+
+// echo replicas on consecutive ports; the last one responds after a delay
+struct Replicas
+{
+    static constexpr int base_port = 13382;
+    static constexpr std::size_t count = 3;
+
+    Replicas(std::chrono::milliseconds slow)
+    {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            servers.push_back(std::make_unique<nvrpc::Server>(
+                "0.0.0.0:" + std::to_string(base_port + i)));
+            auto& server = *servers.back();
+            auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+            auto service = server.RegisterAsyncService<TestService>();
+            auto rpc =
+                service->RegisterRPC<ReplicaContext>(&TestService::AsyncService::RequestUnary);
+            auto delay = i + 1 == count ? slow : std::chrono::milliseconds(0);
+            executor->RegisterContexts(rpc, std::make_shared<ReplicaResources>(delay), 64);
+            server.AsyncStart();
+        }
+    }
+    ~Replicas()
+    {
+        for(auto& server : servers)
+        {
+            server->Shutdown();
+        }
+    }
+
+    std::vector<std::unique_ptr<nvrpc::Server>> servers;
+};
+
+} // namespace
+
+// state.range(1) callers each issue their next call when the previous one returns, until
+// state.range(2) calls complete per iteration; one of the three replicas responds after 20ms.
+// state.range(0) selects the Balancer::Policy.
+static void BM_Balancer(benchmark::State& state)
+{
+    using clock = std::chrono::steady_clock;
+    Replicas replicas(std::chrono::milliseconds(20));
+    auto balancer =
+        std::make_shared<Balancer>(Replicas::count, static_cast<Balancer::Policy>(state.range(0)));
+
+    std::vector<nvrpc::client::ClientUnary<Input, Output>::PrepareFn> prepare_fns;
+    for(std::size_t i = 0; i < Replicas::count; i++)
+    {
+        std::shared_ptr<TestService::Stub> stub = TestService::NewStub(
+            nvrpc::client::CreateChannel("localhost:" + std::to_string(Replicas::base_port + i)));
+        prepare_fns.push_back([stub](::grpc::ClientContext* context, const Input& request,
+                                     ::grpc::CompletionQueue* cq) {
+            return stub->PrepareAsyncUnary(context, request, cq);
+        });
+    }
+    nvrpc::client::ClientUnary<Input, Output> client(
+        prepare_fns, std::make_shared<nvrpc::client::Executor>(1), balancer);
+
+    const std::size_t count = state.range(2);
+    std::vector<double> latencies;
+    for(auto _ : state)
+    {
+        std::mutex mutex;
+        std::size_t issued = 0;
+        std::size_t completed = 0;
+        std::promise<void> finished;
+        std::function<void()> issue = [&] {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(issued == count)
+                {
+                    return;
+                }
+                ++issued;
+            }
+            auto start = clock::now();
+            client.Enqueue(Input(), [&, start](Input&, Output&, ::grpc::Status& status) {
+                auto latency = std::chrono::duration<double, std::micro>(clock::now() - start);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    latencies.push_back(latency.count());
+                    if(!status.ok())
+                    {
+                        state.SkipWithError("request failed");
+                    }
+                    if(++completed == count)
+                    {
+                        finished.set_value();
+                        return;
+                    }
+                }
+                issue();
+            });
+        };
+        for(int i = 0; i < state.range(1); i++)
+        {
+            issue();
+        }
+        finished.get_future().wait();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    if(!latencies.empty())
+    {
+        state.counters["p50_us"] = latencies[latencies.size() / 2];
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Balancer)
+    ->ArgNames({"policy", "callers", "calls"})
+    ->Args({static_cast<int>(Balancer::Policy::RoundRobin), 4, 500})
+    ->Args({static_cast<int>(Balancer::Policy::LeastOutstanding), 4, 500})
+    ->Args({static_cast<int>(Balancer::Policy::PowerOfTwoChoices), 4, 500})
+    ->UseRealTime();
@@ -0,0 +1,120 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+#include "tensorrt/laboratory/core/resources.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+struct WorkerResources : public ::trtlab::Resources
+{
+    WorkerResources() : pool(16) {}
+    ::trtlab::ThreadPool pool;
+};
+
+// echoes each request after 1ms on a worker thread, standing in for a handler whose latency
+// is not spent on the executor
+template<std::size_t Window>
+class DelayedEchoContext final
+    : public nvrpc::BidirectionalContext<Input, Output, WorkerResources>
+{
+  public:
+    DelayedEchoContext() { SetExecutionWindow(Window); }
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        GetResources()->pool.enqueue([this, &input, &output] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            output.set_batch_id(input.batch_id());
+            FinishResponse(output);
+        });
+    }
+};
+
+} // namespace
+
+// one stream; the client keeps writing while it reads, so throughput is bounded by the window
+template<std::size_t Window>
+static void BM_BidirectionalWindow(benchmark::State& state)
+{
+    nvrpc::Server server("0.0.0.0:13379");
+    auto resources = std::make_shared<WorkerResources>();
+    auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server.RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<DelayedEchoContext<Window>>(
+        &TestService::AsyncService::RequestStreaming);
+    executor->RegisterContexts(rpc, resources, 1);
+    server.AsyncStart();
+
+    auto stub = TestService::NewStub(nvrpc::client::CreateChannel("localhost:13379"));
+    const std::uint64_t count = state.range(0);
+    for(auto _ : state)
+    {
+        ::grpc::ClientContext context;
+        auto stream = stub->Streaming(&context);
+        std::thread writer([&stream, count] {
+            Input input;
+            for(std::uint64_t i = 1; i <= count; i++)
+            {
+                input.set_batch_id(i);
+                stream->Write(input);
+            }
+            stream->WritesDone();
+        });
+        Output output;
+        std::uint64_t received = 0;
+        while(stream->Read(&output))
+        {
+            if(output.batch_id() != ++received)
+            {
+                state.SkipWithError("response out of order");
+            }
+        }
+        writer.join();
+        stream->Finish();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    server.Shutdown();
+}
+BENCHMARK_TEMPLATE(BM_BidirectionalWindow, 1)->Arg(256)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_BidirectionalWindow, 4)->Arg(256)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_BidirectionalWindow, 16)->Arg(256)->UseRealTime();
@@ -0,0 +1,133 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+class StreamingEchoContext final
+    : public nvrpc::StreamingContext<Input, Output, ::trtlab::Resources>
+{
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override
+    {
+        Output output;
+        output.set_batch_id(input.batch_id());
+        stream->WriteResponse(std::move(output));
+    }
+};
+
+} // namespace
+
+// one stream per iteration; the caller writes state.range(0) requests of state.range(1) bytes
+// as fast as ClientStreaming accepts them while the executor thread reads the echoes.
+// state.range(2) is the size of the write ring and state.range(3) enables write coalescing.
+static void BM_ClientStreaming(benchmark::State& state)
+{
+    nvrpc::Server server("0.0.0.0:13380");
+    auto resources = std::make_shared<::trtlab::Resources>();
+    auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server.RegisterAsyncService<TestService>();
+    auto rpc =
+        service->RegisterRPC<StreamingEchoContext>(&TestService::AsyncService::RequestStreaming);
+    executor->RegisterContexts(rpc, resources, 1);
+    server.AsyncStart();
+
+    using clock = std::chrono::steady_clock;
+    const std::size_t count = state.range(0);
+    std::shared_ptr<TestService::Stub> stub =
+        TestService::NewStub(nvrpc::client::CreateChannel("localhost:13380"));
+    auto prepare_fn = [stub](::grpc::ClientContext* context, ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncStreaming(context, cq);
+    };
+    auto client_executor = std::make_shared<nvrpc::client::Executor>(1);
+
+    Input input;
+    input.set_raw_bytes(std::string(state.range(1), 'x'));
+    std::vector<clock::time_point> sent(count);
+    std::vector<double> latencies;
+    latencies.reserve(count);
+
+    for(auto _ : state)
+    {
+        std::size_t received = 0;
+        auto on_recv = [&](Output&& output) {
+            latencies.push_back(
+                std::chrono::duration<double, std::micro>(clock::now() - sent[output.batch_id()])
+                    .count());
+            received++;
+        };
+        nvrpc::client::ClientStreaming<Input, Output> stream(
+            prepare_fn, client_executor, [](Input&&) {}, on_recv, state.range(2));
+        stream.SetWriteCoalescing(state.range(3));
+        for(std::size_t i = 0; i < count; i++)
+        {
+            auto request = input;
+            request.set_batch_id(i);
+            sent[i] = clock::now();
+            stream.Write(std::move(request));
+        }
+        stream.Done().get();
+        if(received != count)
+        {
+            state.SkipWithError("responses missing");
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    if(!latencies.empty())
+    {
+        state.counters["p50_us"] = latencies[latencies.size() / 2];
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * state.range(1));
+    server.Shutdown();
+}
+BENCHMARK(BM_ClientStreaming)
+    ->Args({1000, 0, 64, 0})
+    ->Args({1000, 0, 1024, 0})
+    ->Args({1000, 0, 1024, 1})
+    ->Args({1000, 4 << 10, 64, 0})
+    ->Args({1000, 4 << 10, 1024, 0})
+    ->Args({1000, 4 << 10, 1024, 1})
+    ->UseRealTime();
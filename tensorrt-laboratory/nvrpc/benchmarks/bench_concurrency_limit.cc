@@ -0,0 +1,132 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/client/load_generator.h"
+#include "nvrpc/concurrency_limiter.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+struct WorkerResources : public ::trtlab::Resources
+{
+    WorkerResources() : workers(1) {}
+    ::trtlab::ThreadPool workers;
+};
+
+// 1ms of CPU on a single worker thread; the server handles about 1000 requests per second
+class CpuContext final : public nvrpc::Context<Input, Output, WorkerResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        GetResources()->workers.enqueue([this] {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+            while(std::chrono::steady_clock::now() < deadline)
+            {
+            }
+            FinishResponse();
+        });
+    }
+};
+
+} // namespace
+
+// open-loop load of state.range(0) requests per second on a server with 500 contexts;
+// state.range(1) enables the concurrency limiter.  goodput counts successful responses per
+// second and latency covers successful responses only.
+//
+// The client runs on the same machine.  On a single core, every rejected request still costs
+// a client and a server round trip on the core the handler burns, so goodput with the limiter
+// falls as offered load grows even though the limiter keeps the queue short; the tests use a
+// sleeping handler to measure the limiter without that contention.
+static void BM_ConcurrencyLimit(benchmark::State& state)
+{
+    nvrpc::Server server("0.0.0.0:13386");
+    auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server.RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<CpuContext>(&TestService::AsyncService::RequestUnary);
+    auto limiter = std::make_shared<nvrpc::ConcurrencyLimiter>();
+    if(state.range(1))
+    {
+        rpc->SetConcurrencyLimiter(limiter);
+    }
+    executor->RegisterContexts(rpc, std::make_shared<WorkerResources>(), 500);
+    server.AsyncStart();
+
+    std::shared_ptr<TestService::Stub> stub =
+        TestService::NewStub(nvrpc::client::CreateChannel("localhost:13386"));
+    auto prepare_fn = [stub](::grpc::ClientContext* context, const Input& request,
+                             ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncUnary(context, request, cq);
+    };
+    auto client = std::make_shared<nvrpc::client::ClientUnary<Input, Output>>(
+        prepare_fn, std::make_shared<nvrpc::client::Executor>(1));
+    auto target = std::make_shared<nvrpc::client::UnaryLoadTarget<Input, Output>>(
+        client, [] { return Input(); });
+
+    nvrpc::client::LoadGenerator::Options options;
+    options.rate = state.range(0);
+    options.duration = std::chrono::seconds(4);
+    options.warmup = std::chrono::seconds(1);
+    nvrpc::client::LoadGenerator::Report report;
+    for(auto _ : state)
+    {
+        report = nvrpc::client::LoadGenerator(options).Run({target});
+    }
+
+    state.counters["goodput"] = report.achieved_rate;
+    state.counters["errors"] = report.errors;
+    state.counters["p50_us"] = report.latency.Percentile(50) / 1000;
+    state.counters["p99_us"] = report.latency.Percentile(99) / 1000;
+    state.counters["limit"] = limiter->Limit();
+    server.Shutdown();
+}
+BENCHMARK(BM_ConcurrencyLimit)
+    ->ArgNames({"rate", "limiter"})
+    ->Args({500, 0})
+    ->Args({500, 1})
+    ->Args({2000, 0})
+    ->Args({2000, 1})
+    ->Args({5000, 0})
+    ->Args({5000, 1})
+    ->Iterations(1)
+    ->UseRealTime();
@@ -0,0 +1,121 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/client/retry.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+// stalls one response in twenty, at random, for 20ms
+class StallingContext final : public nvrpc::Context<Input, Output, ::trtlab::Resources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        // a single executor thread
+        static std::minstd_rand random(13);
+        output.set_batch_id(input.batch_id());
+        if(random() % 20)
+        {
+            FinishResponse();
+            return;
+        }
+        ArmTimer(std::chrono::milliseconds(20), [this] { FinishResponse(); });
+    }
+};
+
+} // namespace
+
+// sequential calls to a server which randomly stalls; state.range(0) is the hedge delay in
+// microseconds, 0 disables hedging.  extra_load is the fraction of calls that were hedged.
+static void BM_Hedging(benchmark::State& state)
+{
+    using clock = std::chrono::steady_clock;
+    nvrpc::Server server("0.0.0.0:13385");
+    auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server.RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<StallingContext>(&TestService::AsyncService::RequestUnary);
+    executor->RegisterContexts(rpc, std::make_shared<::trtlab::Resources>(), 64);
+    server.AsyncStart();
+
+    std::shared_ptr<TestService::Stub> stub =
+        TestService::NewStub(nvrpc::client::CreateChannel("localhost:13385"));
+    auto prepare_fn = [stub](::grpc::ClientContext* context, const Input& request,
+                             ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncUnary(context, request, cq);
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(
+        prepare_fn, std::make_shared<nvrpc::client::Executor>(1));
+    nvrpc::client::RetryPolicy policy;
+    policy.budget = std::make_shared<nvrpc::client::RetryBudget>(0.1, 10);
+    if(state.range(0))
+    {
+        policy.max_attempts = 2;
+        policy.hedge_delay = std::chrono::microseconds(state.range(0));
+    }
+    client.SetRetryPolicy(policy);
+
+    auto status_of = [](Input&, Output&, ::grpc::Status& status) { return status; };
+    std::vector<double> latencies;
+    for(auto _ : state)
+    {
+        auto start = clock::now();
+        if(!client.Enqueue(Input(), status_of).get().ok())
+        {
+            state.SkipWithError("request failed");
+        }
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(clock::now() - start).count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    if(!latencies.empty())
+    {
+        state.counters["p50_us"] = latencies[latencies.size() / 2];
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+    }
+    state.counters["extra_load"] =
+        static_cast<double>(policy.budget->Withdrawn()) / state.iterations();
+    server.Shutdown();
+}
+BENCHMARK(BM_Hedging)->ArgName("hedge_us")->Arg(0)->Arg(2000)->Iterations(2000)->UseRealTime();
@@ -0,0 +1,195 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/local_client.h"
+#include "nvrpc/server.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+class EchoContext final : public nvrpc::Context<Input, Output, ::trtlab::Resources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+std::string TcpAddress() { return "localhost:13378"; }
+std::string UnixAddress() { return "unix:/tmp/nvrpc_bench_" + std::to_string(getpid()) + ".sock"; }
+
+// ping-pong service listening on loopback TCP and a Unix domain socket; the local client
+// shares its Executor and Resources
+struct PingPong
+{
+    PingPong() : server("0.0.0.0:13378"), resources(std::make_shared<::trtlab::Resources>())
+    {
+        server.Builder().AddListeningPort(UnixAddress(), ::grpc::InsecureServerCredentials());
+        executor = server.RegisterExecutor(new nvrpc::Executor(1));
+        auto service = server.RegisterAsyncService<TestService>();
+        auto rpc = service->RegisterRPC<EchoContext>(&TestService::AsyncService::RequestUnary);
+        executor->RegisterContexts(rpc, resources, 64);
+        local = std::make_unique<nvrpc::LocalClient<EchoContext>>(executor, resources, 64);
+        server.AsyncStart();
+    }
+
+    ~PingPong()
+    {
+        local.reset();
+        server.Shutdown();
+        unlink(UnixAddress().substr(5).c_str());
+    }
+
+    nvrpc::Server server;
+    std::shared_ptr<::trtlab::Resources> resources;
+    nvrpc::IExecutor* executor;
+    std::unique_ptr<nvrpc::LocalClient<EchoContext>> local;
+};
+
+using RemoteClient = nvrpc::client::ClientUnary<Input, Output>;
+
+std::unique_ptr<RemoteClient> BuildClient(const std::string& address)
+{
+    std::shared_ptr<TestService::Stub> stub =
+        TestService::NewStub(nvrpc::client::CreateChannel(address));
+    auto prepare_fn = [stub](::grpc::ClientContext* context, const Input& request,
+                             ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncUnary(context, request, cq);
+    };
+    return std::make_unique<RemoteClient>(prepare_fn,
+                                          std::make_shared<nvrpc::client::Executor>(1));
+}
+
+Input MakeInput(benchmark::State& state)
+{
+    Input input;
+    input.set_batch_id(1);
+    input.set_raw_bytes(std::string(state.range(0), 'x'));
+    return input;
+}
+
+auto batch_id = [](Input& input, Output& output, ::grpc::Status& status) {
+    return output.batch_id();
+};
+
+// one request in flight at a time
+template<typename Client>
+void Latency(benchmark::State& state, Client& client)
+{
+    auto input = MakeInput(state);
+    for(auto _ : state)
+    {
+        auto request = input;
+        benchmark::DoNotOptimize(client.Enqueue(std::move(request), batch_id).get());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// batches of state.range(1) requests in flight
+template<typename Client>
+void Throughput(benchmark::State& state, Client& client)
+{
+    auto input = MakeInput(state);
+    std::vector<std::shared_future<std::uint64_t>> futures(state.range(1));
+    for(auto _ : state)
+    {
+        for(auto& future : futures)
+        {
+            auto request = input;
+            future = client.Enqueue(std::move(request), batch_id);
+        }
+        for(auto& future : futures)
+        {
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetBytesProcessed(state.iterations() * state.range(1) * state.range(0));
+}
+
+} // namespace
+
+static void BM_PingPong_TCP(benchmark::State& state)
+{
+    PingPong pingpong;
+    auto client = BuildClient(TcpAddress());
+    Latency(state, *client);
+}
+BENCHMARK(BM_PingPong_TCP)->Arg(0)->Arg(4 << 10)->Arg(1 << 20)->UseRealTime();
+
+static void BM_PingPong_UDS(benchmark::State& state)
+{
+    PingPong pingpong;
+    auto client = BuildClient(UnixAddress());
+    Latency(state, *client);
+}
+BENCHMARK(BM_PingPong_UDS)->Arg(0)->Arg(4 << 10)->Arg(1 << 20)->UseRealTime();
+
+static void BM_PingPong_Local(benchmark::State& state)
+{
+    PingPong pingpong;
+    Latency(state, *pingpong.local);
+}
+BENCHMARK(BM_PingPong_Local)->Arg(0)->Arg(4 << 10)->Arg(1 << 20)->UseRealTime();
+
+static void BM_PingPongThroughput_TCP(benchmark::State& state)
+{
+    PingPong pingpong;
+    auto client = BuildClient(TcpAddress());
+    Throughput(state, *client);
+}
+BENCHMARK(BM_PingPongThroughput_TCP)->Args({0, 64})->Args({4 << 10, 64})->UseRealTime();
+
+static void BM_PingPongThroughput_UDS(benchmark::State& state)
+{
+    PingPong pingpong;
+    auto client = BuildClient(UnixAddress());
+    Throughput(state, *client);
+}
+BENCHMARK(BM_PingPongThroughput_UDS)->Args({0, 64})->Args({4 << 10, 64})->UseRealTime();
+
+static void BM_PingPongThroughput_Local(benchmark::State& state)
+{
+    PingPong pingpong;
+    Throughput(state, *pingpong.local);
+}
+BENCHMARK(BM_PingPongThroughput_Local)->Args({0, 64})->Args({4 << 10, 64})->UseRealTime();
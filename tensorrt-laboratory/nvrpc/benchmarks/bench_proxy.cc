@@ -0,0 +1,231 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel.h"
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/proxy.h"
+#include "nvrpc/server.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+using nvrpc::testing::Input;
+using nvrpc::testing::Output;
+using nvrpc::testing::TestService;
+
+namespace {
+
+using RemoteClient = nvrpc::client::ClientUnary<Input, Output>;
+
+std::unique_ptr<RemoteClient> BuildClient(const std::string& address)
+{
+    std::shared_ptr<TestService::Stub> stub =
+        TestService::NewStub(nvrpc::client::CreateChannel(address));
+    auto prepare_fn = [stub](::grpc::ClientContext* context, const Input& request,
+                             ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncUnary(context, request, cq);
+    };
+    return std::make_unique<RemoteClient>(prepare_fn,
+                                          std::make_shared<nvrpc::client::Executor>(1));
+}
+
+class EchoContext final : public nvrpc::Context<Input, Output, ::trtlab::Resources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+struct ForwardingResources : public ::trtlab::Resources
+{
+    ForwardingResources(const std::string& backend) : client(BuildClient(backend)) {}
+    std::unique_ptr<RemoteClient> client;
+};
+
+// the examples/04_Middleman pattern: the request is deserialized by the front end, forwarded
+// to the backend with a typed client, and the response deserialized and serialized once more
+class ForwardingContext final : public nvrpc::Context<Input, Output, ForwardingResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        GetResources()->client->Enqueue(&input, &output,
+                                        [this](Input&, Output&, ::grpc::Status& status) {
+                                            status.ok() ? FinishResponse() : CancelResponse();
+                                        },
+                                        m_Headers);
+    }
+
+    std::map<std::string, std::string> m_Headers;
+};
+
+std::string BackendAddress()
+{
+    return "unix:/tmp/nvrpc_proxy_" + std::to_string(getpid()) + ".sock";
+}
+std::string FrontendAddress() { return "localhost:13381"; }
+
+// echo backend served in-process on a Unix domain socket
+struct Backend
+{
+    Backend() : server(BackendAddress())
+    {
+        auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+        auto service = server.RegisterAsyncService<TestService>();
+        auto rpc = service->RegisterRPC<EchoContext>(&TestService::AsyncService::RequestUnary);
+        executor->RegisterContexts(rpc, std::make_shared<::trtlab::Resources>(), 64);
+        server.AsyncStart();
+    }
+    ~Backend() { server.Shutdown(); }
+
+    nvrpc::Server server;
+};
+
+// byte-level proxy in front of the backend; calls are pumped as streams unless unary is set
+struct ProxyFrontend
+{
+    ProxyFrontend(bool unary) : server("0.0.0.0:13381")
+    {
+        auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+        auto proxy = server.RegisterProxy();
+        proxy->AddRoute("", proxy->AddBackend(nvrpc::client::CreateChannel(BackendAddress())));
+        if(unary)
+        {
+            proxy->AddUnaryMethod("/nvrpc.testing.TestService/Unary");
+        }
+        executor->RegisterContexts(proxy, std::make_shared<::trtlab::Resources>(), 64);
+        server.AsyncStart();
+    }
+    ~ProxyFrontend() { server.Shutdown(); }
+
+    nvrpc::Server server;
+};
+
+// typed forwarder in front of the backend
+struct ForwardingFrontend
+{
+    ForwardingFrontend() : server("0.0.0.0:13381")
+    {
+        auto executor = server.RegisterExecutor(new nvrpc::Executor(1));
+        auto service = server.RegisterAsyncService<TestService>();
+        auto rpc =
+            service->RegisterRPC<ForwardingContext>(&TestService::AsyncService::RequestUnary);
+        executor->RegisterContexts(rpc, std::make_shared<ForwardingResources>(BackendAddress()),
+                                   64);
+        server.AsyncStart();
+    }
+    ~ForwardingFrontend() { server.Shutdown(); }
+
+    nvrpc::Server server;
+};
+
+auto batch_id = [](Input& input, Output& output, ::grpc::Status& status) {
+    return output.batch_id();
+};
+
+// batches of state.range(1) requests of state.range(0) bytes in flight
+void Throughput(benchmark::State& state, const std::string& address)
+{
+    auto client = BuildClient(address);
+    Input input;
+    input.set_batch_id(1);
+    input.set_raw_bytes(std::string(state.range(0), 'x'));
+    std::vector<std::shared_future<std::uint64_t>> futures(state.range(1));
+    for(auto _ : state)
+    {
+        for(auto& future : futures)
+        {
+            auto request = input;
+            future = client->Enqueue(std::move(request), batch_id);
+        }
+        for(auto& future : futures)
+        {
+            if(future.get() != 1)
+            {
+                state.SkipWithError("request failed");
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.SetBytesProcessed(state.iterations() * state.range(1) * state.range(0));
+}
+
+} // namespace
+
+static void BM_Proxy_Direct(benchmark::State& state)
+{
+    Backend backend;
+    Throughput(state, BackendAddress());
+}
+BENCHMARK(BM_Proxy_Direct)
+    ->Args({0, 64})
+    ->Args({4 << 10, 64})
+    ->Args({256 << 10, 16})
+    ->UseRealTime();
+
+static void BM_Proxy_Bytes(benchmark::State& state)
+{
+    Backend backend;
+    ProxyFrontend frontend(false);
+    Throughput(state, FrontendAddress());
+}
+BENCHMARK(BM_Proxy_Bytes)
+    ->Args({0, 64})
+    ->Args({4 << 10, 64})
+    ->Args({256 << 10, 16})
+    ->UseRealTime();
+
+static void BM_Proxy_BytesUnary(benchmark::State& state)
+{
+    Backend backend;
+    ProxyFrontend frontend(true);
+    Throughput(state, FrontendAddress());
+}
+BENCHMARK(BM_Proxy_BytesUnary)
+    ->Args({0, 64})
+    ->Args({4 << 10, 64})
+    ->Args({256 << 10, 16})
+    ->UseRealTime();
+
+static void BM_Proxy_Middleman(benchmark::State& state)
+{
+    Backend backend;
+    ForwardingFrontend frontend;
+    Throughput(state, FrontendAddress());
+}
+BENCHMARK(BM_Proxy_Middleman)
+    ->Args({0, 64})
+    ->Args({4 << 10, 64})
+    ->Args({256 << 10, 16})
+    ->UseRealTime();
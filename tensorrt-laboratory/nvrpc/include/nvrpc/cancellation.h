@@ -0,0 +1,87 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace nvrpc {
+
+/**
+ * @brief Read-only view of the cancellation state of an RPC
+ *
+ * Tokens are cheap to copy and safe to capture in work queued on other threads; a token
+ * outliving its RPC keeps observing the state of that RPC, not the next one to reuse the
+ * Context.  A default constructed token is never cancelled.
+ */
+class CancellationToken
+{
+  public:
+    CancellationToken() = default;
+
+    bool IsCancelled() const { return m_State && m_State->load(std::memory_order_relaxed); }
+
+  private:
+    CancellationToken(std::shared_ptr<const std::atomic<bool>> state) : m_State(std::move(state))
+    {
+    }
+
+    std::shared_ptr<const std::atomic<bool>> m_State;
+
+    friend class CancellationSource;
+};
+
+/**
+ * @brief Owner side of a CancellationToken; one per Context, reset for every RPC
+ *
+ * Reset reuses the shared state unless a token from the previous RPC is still alive, so the
+ * common path does not allocate.
+ */
+class CancellationSource
+{
+  public:
+    CancellationSource() : m_State(std::make_shared<std::atomic<bool>>(false)) {}
+
+    CancellationToken Token() const { return CancellationToken(m_State); }
+    bool IsCancelled() const { return m_State->load(std::memory_order_relaxed); }
+    void Cancel() { m_State->store(true, std::memory_order_relaxed); }
+
+    void Reset()
+    {
+        if(m_State.use_count() == 1)
+        {
+            m_State->store(false, std::memory_order_relaxed);
+            return;
+        }
+        m_State = std::make_shared<std::atomic<bool>>(false);
+    }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> m_State;
+};
+
+} // namespace nvrpc
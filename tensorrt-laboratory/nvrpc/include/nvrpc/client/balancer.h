@@ -0,0 +1,117 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Client-side load balancer over a fixed set of endpoints
+ *
+ * Acquire picks the endpoint for a request and counts it in flight until Release.  Endpoints
+ * are identified by their index, in the order the caller created their stubs.
+ *
+ * - RoundRobin cycles through the endpoints regardless of load.
+ * - LeastOutstanding picks the endpoint with the fewest requests in flight; ties rotate.
+ * - PowerOfTwoChoices picks the less loaded of two endpoints drawn at random, which avoids
+ *   every client herding onto the same least loaded endpoint.
+ *
+ * Endpoints that fail consecutive_failures requests in a row with UNAVAILABLE, UNKNOWN,
+ * INTERNAL or DEADLINE_EXCEEDED are passively ejected for ejection_time, doubled for each
+ * ejection in a row up to 8x.  When every endpoint is ejected, ejections are ignored.
+ *
+ * Acquire and Release are lock-free and safe to call from any thread.
+ */
+class Balancer
+{
+  public:
+    enum class Policy
+    {
+        RoundRobin,
+        LeastOutstanding,
+        PowerOfTwoChoices
+    };
+
+    Balancer(std::size_t endpoints, Policy policy = Policy::PowerOfTwoChoices);
+
+    Balancer(const Balancer&) = delete;
+    Balancer& operator=(const Balancer&) = delete;
+
+    /**
+     * @brief Passive ejection; consecutive_failures of 0 disables it
+     */
+    void SetEjection(std::size_t consecutive_failures, std::chrono::milliseconds ejection_time);
+
+    std::size_t Acquire();
+
+    /**
+     * @brief Ends a request acquired on endpoint
+     *
+     * A request that was not observed, e.g. a hedged attempt cancelled by the client after
+     * another attempt won, only leaves the in flight count; its status does not touch the
+     * endpoint's failure streak or ejection state.
+     */
+    void Release(std::size_t endpoint, const ::grpc::Status&, bool observed = true);
+
+    std::size_t Size() const { return m_Endpoints.size(); }
+    std::size_t InFlight(std::size_t endpoint) const;
+    bool Ejected(std::size_t endpoint) const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct Endpoint
+    {
+        std::atomic<std::size_t> in_flight{0};
+        std::atomic<std::size_t> failures{0};
+        std::atomic<std::size_t> ejections{0};
+        // clock ticks; the endpoint is not picked before then
+        std::atomic<std::int64_t> ejected_until{0};
+    };
+
+    std::size_t Pick(std::int64_t now);
+    bool Available(std::size_t endpoint, std::int64_t now, bool panic) const;
+    // first available endpoint at or after start, wrapping around; start itself when every
+    // endpoint is ejected, so a concurrent ejection can never leave no endpoint to pick
+    std::size_t NextAvailable(std::size_t start, std::int64_t now) const;
+
+    Policy m_Policy;
+    std::vector<Endpoint> m_Endpoints;
+    std::atomic<std::size_t> m_Next;
+    std::size_t m_ConsecutiveFailures;
+    clock::duration m_EjectionTime;
+};
+
+} // namespace client
+} // namespace nvrpc
@@ -25,20 +25,32 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <queue>
 
 #include <grpc++/grpc++.h>
 
 #include "nvrpc/client/base_context.h"
 #include "nvrpc/client/executor.h"
 #include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/spsc_ring.h"
 
 #include <glog/logging.h>
 
 namespace nvrpc {
 namespace client {
 
+/**
+ * @brief Async bidirectional stream
+ *
+ * Requests handed to Write are queued in a lock-free ring of pre-allocated slots which the
+ * completion queue thread drains without taking the stream's mutex; the mutex is only taken
+ * when the writer goes idle, the ring overflows or the stream changes state.  Responses are
+ * read into two alternating buffers and passed to the ReadCallback on the completion queue
+ * thread.
+ */
 template<typename Request, typename Response>
 struct ClientStreaming : public BaseContext
 {
@@ -50,7 +62,9 @@ struct ClientStreaming : public BaseContext
     using ReadCallback = std::function<void(Response&&)>;
     using WriteCallback = std::function<void(Request&&)>;
 
-    ClientStreaming(PrepareFn, std::shared_ptr<Executor>, WriteCallback, ReadCallback);
+    // requests beyond write_ring_size queued behind the writer spill to a locked queue
+    ClientStreaming(PrepareFn, std::shared_ptr<Executor>, WriteCallback, ReadCallback,
+                    std::size_t write_ring_size = 64);
     ~ClientStreaming() { DLOG(INFO) << "ClientStreaming dtor"; }
 
     // void Write(Request*);
@@ -63,6 +77,12 @@ struct ClientStreaming : public BaseContext
 
     bool IsCorked() const { return m_Corked; }
 
+    /**
+     * @brief Let gRPC buffer a write while more requests are queued behind it, so a burst of
+     * writes is flushed in fewer frames and syscalls
+     */
+    void SetWriteCoalescing(bool true_or_false) { m_Coalescing = true_or_false; }
+
     bool ExecutorShouldDeleteContext() const override { return false; }
 
     void ExecutorShouldDeleteContext(bool true_or_false) { m_ShouldDelete = true_or_false; }
@@ -111,30 +131,44 @@ struct ClientStreaming : public BaseContext
     Context m_ReadState;
     Context m_WriteState;
 
+    // guards the stream's state; not taken on a write completing with more requests queued
     std::mutex m_Mutex;
-    std::queue<Response> m_ReadQueue;
-    std::queue<Request> m_WriteQueue;
+
+    // serializes callers of Write, the single producer of m_WriteRing
+    std::mutex m_WriteMutex;
+    ::trtlab::SpscRing<Request> m_WriteRing;
+    std::queue<Request> m_WriteOverflow; // guarded by m_Mutex
+    std::atomic<bool> m_Overflowing;
+    bool m_WritingOverflow;
+
+    // the outstanding read targets one buffer while the other is handed to the ReadCallback
+    Response m_ReadBuffers[2];
+    int m_ReadBuffer;
 
     std::shared_ptr<Executor> m_Executor;
 
     bool m_Corked;
+    bool m_Coalescing;
     bool m_ShouldDelete;
 
-    using ReadHandle = bool;
-    using WriteHandle = bool;
-    using ExecuteHandle = std::function<void()>;
+    using ReadHandle = Response*;
+    using WriteHandle = Request*;
+    using ExecuteHandle = Response*;
     using CloseHandle = bool;
     using FinishHandle = bool;
     using CompleteHandle = bool;
     using Actions = std::tuple<ReadHandle, WriteHandle, ExecuteHandle, CloseHandle, FinishHandle,
                                CompleteHandle>;
 
-    bool m_Reading, m_Writing, m_Finishing, m_Closing, m_ReadsDone, m_WritesDone, m_FinishDone;
+    bool m_Reading, m_Finishing, m_Closing, m_ReadsDone, m_FinishDone;
+    // read without m_Mutex by Write
+    std::atomic<bool> m_Writing, m_WritesDone;
 
     bool (ClientStreaming<Request, Response>::*m_NextState)(bool);
 
     Actions EvaluateState();
     void ForwardProgress(Actions& actions);
+    void WriteRequest(const Request& request, bool more);
 
     bool StateStreamInitialized(bool);
     bool StateReadDone(bool);
@@ -148,11 +182,14 @@ struct ClientStreaming : public BaseContext
 template<typename Request, typename Response>
 ClientStreaming<Request, Response>::ClientStreaming(PrepareFn prepare_fn,
                                                     std::shared_ptr<Executor> executor,
-                                                    WriteCallback OnWrite, ReadCallback OnRead)
+                                                    WriteCallback OnWrite, ReadCallback OnRead,
+                                                    std::size_t write_ring_size)
     : m_Executor(executor), m_PrepareFn(prepare_fn), m_ReadState(this), m_WriteState(this),
-      m_ReadCallback(OnRead), m_WriteCallback(OnWrite), m_Reading(false), m_Writing(false),
-      m_Finishing(false), m_Closing(false), m_ReadsDone(false), m_WritesDone(false),
-      m_FinishDone(false), m_ShouldDelete(false), m_Corked(false)
+      m_ReadCallback(OnRead), m_WriteCallback(OnWrite), m_WriteRing(write_ring_size),
+      m_Overflowing(false), m_WritingOverflow(false), m_ReadBuffer(0), m_Reading(false),
+      m_Writing(false), m_Finishing(false), m_Closing(false), m_ReadsDone(false),
+      m_WritesDone(false), m_FinishDone(false), m_ShouldDelete(false), m_Corked(false),
+      m_Coalescing(false)
 {
     m_NextState = &ClientStreaming<Request, Response>::StateStreamInitialized;
     m_ReadState.m_NextState = &ClientStreaming<Request, Response>::StateInvalid;
@@ -174,9 +211,8 @@ void ClientStreaming<Request, Response>::Write(Request* request)
 template<typename Request, typename Response>
 bool ClientStreaming<Request, Response>::Write(Request&& request)
 {
-    Actions actions;
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::lock_guard<std::mutex> lock(m_WriteMutex);
         DLOG(INFO) << "Writing Request";
 
         if(m_WritesDone)
@@ -185,9 +221,26 @@ bool ClientStreaming<Request, Response>::Write(Request&& request)
             return false;
         }
 
-        m_WriteQueue.push(std::move(request));
-        m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateWriteDone;
+        // once the ring fills, requests queue behind it until the overflow has drained
+        if(m_Overflowing || !m_WriteRing.TryPush(std::move(request)))
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Overflowing = true;
+            m_WriteOverflow.push(std::move(request));
+        }
+    }
 
+    // a busy writer picks the request up when its current write completes; pairs with the
+    // fence in StateWriteDone so that one side always sees the other
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_Writing)
+    {
+        return true;
+    }
+
+    Actions actions;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
         actions = EvaluateState();
     }
     ForwardProgress(actions);
@@ -197,13 +250,17 @@ bool ClientStreaming<Request, Response>::Write(Request&& request)
 template<typename Request, typename Response>
 std::shared_future<::grpc::Status> ClientStreaming<Request, Response>::Done()
 {
+    {
+        // orders WritesDone after the requests of concurrent Writes
+        std::lock_guard<std::mutex> lock(m_WriteMutex);
+        m_WritesDone = true;
+    }
+
     Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
         DLOG(INFO) << "Sending WritesDone - Closing Client -> Server side of the stream";
 
-        m_WritesDone = true;
-
         actions = EvaluateState();
     }
     ForwardProgress(actions);
@@ -220,7 +277,7 @@ template<typename Request, typename Response>
 typename ClientStreaming<Request, Response>::Actions
     ClientStreaming<Request, Response>::EvaluateState()
 {
-    ReadHandle should_read = false;
+    ReadHandle should_read = nullptr;
     WriteHandle should_write = nullptr;
     ExecuteHandle should_execute = nullptr;
     CloseHandle should_close = false;
@@ -235,21 +292,29 @@ typename ClientStreaming<Request, Response>::Actions
     {
         if(!m_Reading && !m_ReadsDone)
         {
-            should_read = true;
+            // only reached from StateReadDone; reads complete one at a time on the stream's
+            // completion queue, so the buffer handed out is not read into until the callback
+            // has returned
             m_Reading = true;
-            m_ReadQueue.emplace();
+            should_execute = &m_ReadBuffers[m_ReadBuffer];
+            m_ReadBuffer ^= 1;
+            should_read = &m_ReadBuffers[m_ReadBuffer];
             m_ReadState.m_NextState = &ClientStreaming<Request, Response>::StateReadDone;
-
-            should_execute = [this, response = std::move(m_ReadQueue.front())]() mutable {
-                m_ReadCallback(std::move(response));
-            };
-            m_ReadQueue.pop();
         }
-        if(!m_Writing && !m_WriteQueue.empty())
+        if(!m_Writing)
         {
-            should_write = true;
-            m_Writing = true;
-            m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateWriteDone;
+            // the ring holds requests older than any in the overflow
+            should_write = m_WriteRing.Front();
+            m_WritingOverflow = !should_write && !m_WriteOverflow.empty();
+            if(m_WritingOverflow)
+            {
+                should_write = &m_WriteOverflow.front();
+            }
+            if(should_write)
+            {
+                m_Writing = true;
+                m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateWriteDone;
+            }
         }
         if(!m_Closing && !m_Writing && m_WritesDone)
         {
@@ -294,21 +359,11 @@ void ClientStreaming<Request, Response>::ForwardProgress(Actions& actions)
     if(should_read)
     {
         DLOG(INFO) << "Posting Read/Recv";
-        m_Stream->Read(&m_ReadQueue.back(), m_ReadState.Tag());
+        m_Stream->Read(should_read, m_ReadState.Tag());
     }
     if(should_write)
     {
-        DLOG(INFO) << "Writing/Sending Request";
-        if(m_Corked)
-        {
-            ::grpc::WriteOptions options;
-            options.set_corked();
-            m_Stream->Write(m_WriteQueue.front(), options, m_WriteState.Tag());
-        }
-        else
-        {
-            m_Stream->Write(m_WriteQueue.front(), m_WriteState.Tag());
-        }
+        WriteRequest(*should_write, !m_WritingOverflow && m_WriteRing.Peek(1));
     }
     if(should_close)
     {
@@ -318,7 +373,7 @@ void ClientStreaming<Request, Response>::ForwardProgress(Actions& actions)
     if(should_execute)
     {
         DLOG(INFO) << "Kicking off Execution of Received Request";
-        should_execute();
+        m_ReadCallback(std::move(*should_execute));
     }
     if(should_finish)
     {
@@ -332,6 +387,23 @@ void ClientStreaming<Request, Response>::ForwardProgress(Actions& actions)
     }
 }
 
+// more: another request is queued behind this one
+template<class Request, class Response>
+void ClientStreaming<Request, Response>::WriteRequest(const Request& request, bool more)
+{
+    DLOG(INFO) << "Writing/Sending Request";
+    ::grpc::WriteOptions options;
+    if(m_Corked)
+    {
+        options.set_corked();
+    }
+    if(m_Coalescing && more)
+    {
+        options.set_buffer_hint();
+    }
+    m_Stream->Write(request, options, m_WriteState.Tag());
+}
+
 template<typename Request, typename Response>
 bool ClientStreaming<Request, Response>::StateStreamInitialized(bool ok)
 {
@@ -349,13 +421,12 @@ bool ClientStreaming<Request, Response>::StateStreamInitialized(bool ok)
         m_NextState = &ClientStreaming<Request, Response>::StateInvalid;
 
         m_Reading = true;
-        m_ReadQueue.emplace();
         m_ReadState.m_NextState = &ClientStreaming<Request, Response>::StateReadDone;
 
         actions = EvaluateState();
     }
     DLOG(INFO) << "Posting Initial Read/Recv";
-    m_Stream->Read(&m_ReadQueue.back(), m_ReadState.Tag());
+    m_Stream->Read(&m_ReadBuffers[m_ReadBuffer], m_ReadState.Tag());
     ForwardProgress(actions);
     return true;
 }
@@ -392,14 +463,31 @@ bool ClientStreaming<Request, Response>::StateReadDone(bool ok)
 template<typename Request, typename Response>
 bool ClientStreaming<Request, Response>::StateWriteDone(bool ok)
 {
+    if(!m_WritingOverflow)
+    {
+        m_WriteRing.Pop();
+        // common case: write the next queued request without taking the mutex
+        auto next = ok ? m_WriteRing.Front() : nullptr;
+        if(next)
+        {
+            WriteRequest(*next, m_WriteRing.Peek(1));
+            return true;
+        }
+    }
+
     Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
         DLOG(INFO) << "WriteDone: " << (ok ? "OK" : "NOT OK");
 
+        if(m_WritingOverflow)
+        {
+            m_WriteOverflow.pop();
+            m_Overflowing = !m_WriteOverflow.empty();
+        }
         m_Writing = false;
-        m_WriteQueue.pop();
         m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateInvalid;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
 
         if(!ok)
         {
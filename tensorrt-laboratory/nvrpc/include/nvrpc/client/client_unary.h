@@ -25,14 +25,20 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <glog/logging.h>
 #include <grpc++/grpc++.h>
 
+#include "nvrpc/client/balancer.h"
 #include "nvrpc/client/base_context.h"
 #include "nvrpc/client/executor.h"
+#include "nvrpc/client/retry.h"
 #include "tensorrt/laboratory/core/async_compute.h"
 
 namespace nvrpc {
@@ -46,34 +52,43 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
         ::grpc::ClientContext*, const Request&, ::grpc::CompletionQueue*)>;
 
     ClientUnary(PrepareFn prepare_fn, std::shared_ptr<Executor> executor)
-        : m_PrepareFn(prepare_fn), m_Executor(executor)
+        : m_PrepareFns{prepare_fn}, m_Executor(executor)
     {
     }
 
+    /**
+     * @brief Spreads calls over several endpoints, one PrepareFn per endpoint
+     *
+     * The balancer picks the endpoint of each call; it may be shared with the clients of
+     * other methods served by the same endpoints so all of their calls count as load.
+     */
+    ClientUnary(std::vector<PrepareFn> prepare_fns, std::shared_ptr<Executor> executor,
+                std::shared_ptr<Balancer> balancer)
+        : m_PrepareFns(std::move(prepare_fns)), m_Executor(executor), m_Balancer(balancer)
+    {
+        CHECK_EQ(m_PrepareFns.size(), m_Balancer->Size()) << "one PrepareFn per endpoint";
+    }
+
     ~ClientUnary() {}
 
+    /**
+     * @brief Retry and hedge calls enqueued from here on; see RetryPolicy
+     *
+     * Must not race with Enqueue.  Attempts refer back to this ClientUnary, which must
+     * outlive the calls it retries or hedges.
+     */
+    void SetRetryPolicy(RetryPolicy policy)
+    {
+        CHECK_GE(policy.max_attempts, 1UL);
+        m_RetryPolicy = std::move(policy);
+    }
+
     template<typename OnReturnFn>
     auto Enqueue(Request* request, Response* response, OnReturnFn on_return, std::map<std::string, std::string>& headers)
     {
         auto wrapped = this->Wrap(on_return);
         auto future = wrapped->Future();
-
-        Context* ctx = new Context;
-        ctx->m_Request = request;
-        ctx->m_Response = response;
-        ctx->m_Callback = [ctx, wrapped]() mutable {
-            (*wrapped)(*ctx->m_Request, *ctx->m_Response, ctx->m_Status);
-        };
-
-        for (auto& header : headers)
-        {
-            ctx->m_Context.AddMetadata(header.first, header.second);
-        }
-
-        ctx->m_Reader = m_PrepareFn(&ctx->m_Context, *ctx->m_Request, m_Executor->GetNextCQ());
-        ctx->m_Reader->StartCall();
-        ctx->m_Reader->Finish(ctx->m_Response, &ctx->m_Status, ctx->Tag());
-
+        Launch(request, response, wrapped, headers);
         return future.share();
     }
 
@@ -98,9 +113,252 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
         return Enqueue(req.get(), resp.get(), extended_on_return, headers);
     }
 
+    /**
+     * @brief Enqueue variants returning a ::trtlab::AsyncFuture
+     *
+     * The result of on_return completes the AsyncFuture from the executor's progress
+     * engine thread, so continuations attached with then() are chained without parking
+     * a thread on a std::shared_future.
+     */
+    template<typename OnReturnFn>
+    auto EnqueueAsync(Request* request, Response* response, OnReturnFn on_return, std::map<std::string, std::string>& headers)
+    {
+        auto wrapped = this->WrapAsync(on_return);
+        auto future = wrapped->Future();
+        Launch(request, response, wrapped, headers);
+        return future;
+    }
+
+    template<typename OnReturnFn>
+    auto EnqueueAsync(Request&& request, OnReturnFn on_return)
+    {
+        std::map<std::string, std::string> empty_headers;
+        return EnqueueAsync(std::move(request), on_return, empty_headers);
+    }
+
+    template<typename OnReturnFn>
+    auto EnqueueAsync(Request&& request, OnReturnFn on_return, std::map<std::string, std::string>& headers)
+    {
+        auto req = std::make_shared<Request>(std::move(request));
+        auto resp = std::make_shared<Response>();
+
+        auto extended_on_return = [req, resp, on_return](Request& request, Response& response,
+                                                         ::grpc::Status& status) mutable -> auto{
+            return on_return(request, response, status);
+        };
+
+        return EnqueueAsync(req.get(), resp.get(), extended_on_return, headers);
+    }
+
   private:
-    PrepareFn m_PrepareFn;
+    template<typename ComputeType>
+    void Launch(Request* request, Response* response, std::shared_ptr<ComputeType> wrapped, std::map<std::string, std::string>& headers)
+    {
+        if(m_RetryPolicy.max_attempts > 1)
+        {
+            auto call = std::make_shared<Call>();
+            call->m_Request = request;
+            call->m_Response = response;
+            call->m_Headers = headers;
+            call->m_Callback = [request, response, wrapped](::grpc::Status& status) mutable {
+                (*wrapped)(*request, *response, status);
+            };
+            LaunchCall(call);
+            return;
+        }
+
+        Context* ctx = new Context;
+        ctx->m_Request = request;
+        ctx->m_Response = response;
+        std::size_t endpoint = 0;
+        if(m_Balancer)
+        {
+            endpoint = m_Balancer->Acquire();
+            // released before on_return so the callback may issue the next call
+            ctx->m_Callback = [ctx, wrapped, balancer = m_Balancer, endpoint]() mutable {
+                balancer->Release(endpoint, ctx->m_Status);
+                (*wrapped)(*ctx->m_Request, *ctx->m_Response, ctx->m_Status);
+            };
+        }
+        else
+        {
+            ctx->m_Callback = [ctx, wrapped]() mutable {
+                (*wrapped)(*ctx->m_Request, *ctx->m_Response, ctx->m_Status);
+            };
+        }
+
+        for (auto& header : headers)
+        {
+            ctx->m_Context.AddMetadata(header.first, header.second);
+        }
+
+        ctx->m_Reader =
+            m_PrepareFns[endpoint](&ctx->m_Context, *ctx->m_Request, m_Executor->GetNextCQ());
+        ctx->m_Reader->StartCall();
+        ctx->m_Reader->Finish(ctx->m_Response, &ctx->m_Status, ctx->Tag());
+    }
+
+    class Attempt;
+
+    // a call sent as one or more attempts; owned by its attempts and its hedge timer
+    struct Call
+    {
+        Request* m_Request;
+        Response* m_Response;
+        std::function<void(::grpc::Status&)> m_Callback;
+        std::map<std::string, std::string> m_Headers;
+
+        std::mutex m_Mutex;
+        std::size_t m_Started = 0;
+        bool m_Done = false;
+        std::vector<Attempt*> m_Outstanding;
+        Executor::TimerId m_HedgeTimer = ::trtlab::TimerWheel::InvalidTimer;
+    };
+
+    void LaunchCall(std::shared_ptr<Call> call)
+    {
+        if(m_RetryPolicy.budget)
+        {
+            m_RetryPolicy.budget->Deposit();
+        }
+        std::lock_guard<std::mutex> lock(call->m_Mutex);
+        StartAttempt(call);
+        ScheduleHedge(call);
+    }
+
+    // requires call->m_Mutex
+    void StartAttempt(const std::shared_ptr<Call>& call)
+    {
+        auto attempt = new Attempt(this, call);
+        call->m_Started++;
+        call->m_Outstanding.push_back(attempt);
+        for(auto& header : call->m_Headers)
+        {
+            attempt->m_Context.AddMetadata(header.first, header.second);
+        }
+        attempt->m_Endpoint = m_Balancer ? m_Balancer->Acquire() : 0;
+        attempt->m_Reader = m_PrepareFns[attempt->m_Endpoint](
+            &attempt->m_Context, *call->m_Request, m_Executor->GetNextCQ());
+        attempt->m_Reader->StartCall();
+        attempt->m_Reader->Finish(&attempt->m_Response, &attempt->m_Status, attempt->Tag());
+    }
+
+    // requires call->m_Mutex
+    void ScheduleHedge(const std::shared_ptr<Call>& call)
+    {
+        if(m_RetryPolicy.hedge_delay.count() <= 0 ||
+           call->m_Started >= m_RetryPolicy.max_attempts)
+        {
+            return;
+        }
+        call->m_HedgeTimer = m_Executor->ScheduleTimer(m_RetryPolicy.hedge_delay, [this, call] {
+            std::lock_guard<std::mutex> lock(call->m_Mutex);
+            call->m_HedgeTimer = ::trtlab::TimerWheel::InvalidTimer;
+            if(call->m_Done || !GrantAttempt())
+            {
+                return;
+            }
+            StartAttempt(call);
+            ScheduleHedge(call);
+        });
+    }
+
+    bool GrantAttempt()
+    {
+        return !m_RetryPolicy.budget || m_RetryPolicy.budget->Withdraw();
+    }
+
+    bool Retryable(const ::grpc::Status& status) const
+    {
+        const auto& codes = m_RetryPolicy.retryable;
+        return std::find(codes.begin(), codes.end(), status.error_code()) != codes.end();
+    }
+
+    // called from the executor as each attempt finishes
+    void AttemptFinished(Attempt* attempt)
+    {
+        auto& status = attempt->m_Status;
+        auto call = attempt->m_Call;
+        std::unique_lock<std::mutex> lock(call->m_Mutex);
+        if(m_Balancer)
+        {
+            // a loser we cancelled says nothing about the health of its endpoint
+            auto observed =
+                !attempt->m_Cancelled || status.error_code() != ::grpc::StatusCode::CANCELLED;
+            m_Balancer->Release(attempt->m_Endpoint, status, observed);
+        }
+        auto& outstanding = call->m_Outstanding;
+        outstanding.erase(std::find(outstanding.begin(), outstanding.end(), attempt));
+        if(call->m_Done)
+        {
+            // lost to another attempt
+            return;
+        }
+        if(!status.ok() && Retryable(status))
+        {
+            if(!outstanding.empty())
+            {
+                // a hedged attempt may still succeed
+                return;
+            }
+            if(call->m_Started < m_RetryPolicy.max_attempts && GrantAttempt())
+            {
+                StartAttempt(call);
+                return;
+            }
+        }
+
+        call->m_Done = true;
+        for(auto other : outstanding)
+        {
+            other->m_Cancelled = true;
+            other->m_Context.TryCancel();
+        }
+        if(call->m_HedgeTimer != ::trtlab::TimerWheel::InvalidTimer)
+        {
+            m_Executor->CancelTimer(call->m_HedgeTimer);
+        }
+        if(status.ok())
+        {
+            *call->m_Response = std::move(attempt->m_Response);
+        }
+        lock.unlock();
+        call->m_Callback(status);
+    }
+
+    class Attempt : public BaseContext
+    {
+        Attempt(ClientUnary* client, std::shared_ptr<Call> call)
+            : m_Client(client), m_Call(std::move(call))
+        {
+        }
+        ~Attempt() override {}
+
+        bool RunNextState(bool ok) final override
+        {
+            m_Client->AttemptFinished(this);
+            return false;
+        }
+
+        bool ExecutorShouldDeleteContext() const override { return true; }
+
+        ClientUnary* m_Client;
+        std::shared_ptr<Call> m_Call;
+        std::size_t m_Endpoint;
+        Response m_Response;
+        ::grpc::Status m_Status;
+        ::grpc::ClientContext m_Context;
+        std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>> m_Reader;
+        // set under the call's mutex when another attempt won and this one was cancelled
+        bool m_Cancelled = false;
+
+        friend class ClientUnary;
+    };
+
+    std::vector<PrepareFn> m_PrepareFns;
     std::shared_ptr<Executor> m_Executor;
+    std::shared_ptr<Balancer> m_Balancer;
+    RetryPolicy m_RetryPolicy;
 
     class Context : public BaseContext
     {
@@ -25,12 +25,17 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <grpc++/grpc++.h>
 
 #include "tensorrt/laboratory/core/thread_pool.h"
+#include "tensorrt/laboratory/core/timer_wheel.h"
 
 namespace nvrpc {
 namespace client {
@@ -53,10 +58,34 @@ class Executor : public std::enable_shared_from_this<Executor>
     void ShutdownAndJoin();
     ::grpc::CompletionQueue* GetNextCQ() const;
 
+    using TimerId = ::trtlab::TimerWheel::TimerId;
+
+    /**
+     * @brief Run callback on a progress engine thread once timeout has elapsed
+     *
+     * Timers still pending when the executor is shutdown never fire.
+     */
+    TimerId ScheduleTimer(std::chrono::nanoseconds timeout, std::function<void()> callback);
+
+    /**
+     * @brief Disarm a pending timer; false if it already fired or was cancelled
+     */
+    bool CancelTimer(TimerId);
+
   private:
     void ProgressEngine(::grpc::CompletionQueue&);
 
-    size_t m_Counter;
+    // AsyncNext deadline for the progress engines; the earliest pending timer
+    std::chrono::system_clock::time_point NextTimerDeadline();
+    void FireTimers(std::vector<::trtlab::TimerWheel::Callback>& expired);
+    void WakeProgressEngine();
+
+    mutable std::atomic<size_t> m_Counter;
+    bool m_Running;
+    std::mutex m_TimerMutex;
+    ::trtlab::TimerWheel m_Timers;
+    std::atomic<std::size_t> m_PendingTimers;
+    std::atomic<bool> m_WakePending;
     std::unique_ptr<::trtlab::ThreadPool> m_ThreadPool;
     std::vector<std::unique_ptr<::grpc::CompletionQueue>> m_CQs;
 };
@@ -0,0 +1,255 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/client/client_unary.h"
+#include "tensorrt/laboratory/core/histogram.h"
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Destination of the requests issued by a LoadGenerator, e.g. a channel or a stream
+ */
+class LoadTarget
+{
+  public:
+    virtual ~LoadTarget() {}
+
+    // called with true or false exactly once, when the request completes or fails
+    using Completion = std::function<void(bool ok)>;
+
+    /**
+     * @brief Issue one request; must not block, the LoadGenerator thread is on a schedule
+     */
+    virtual void Send(Completion) = 0;
+
+    /**
+     * @brief Called once after the run; requests still in flight may be failed
+     */
+    virtual void Finish() {}
+};
+
+/**
+ * @brief Open-loop load generator
+ *
+ * Requests are issued on a schedule fixed up front, constant rate or Poisson arrivals, no
+ * matter how many are still outstanding.  Latency is measured from the time a request was
+ * intended to be sent, so a stalled client or a saturated server shows up as queueing
+ * delay instead of silently lowering the offered rate (coordinated omission).  The time
+ * from the actual send is reported separately as the service time.
+ *
+ * Each of Options::threads sender threads owns an equal share of the rate and spreads its
+ * requests round robin over the targets, e.g. one per channel or stream.
+ */
+class LoadGenerator
+{
+  public:
+    enum class Arrivals
+    {
+        Constant,
+        Poisson
+    };
+
+    struct Options
+    {
+        double rate = 1000.0; // requests per second over all threads
+        Arrivals arrivals = Arrivals::Poisson;
+        std::chrono::nanoseconds duration = std::chrono::seconds(10);
+        // requests intended to be sent during the warmup are issued but not recorded
+        std::chrono::nanoseconds warmup = std::chrono::seconds(0);
+        // how long to wait for outstanding requests after the last send
+        std::chrono::nanoseconds drain = std::chrono::seconds(10);
+        int threads = 1;
+        std::uint64_t seed = 42;
+    };
+
+    struct Report
+    {
+        Arrivals arrivals = Arrivals::Poisson;
+        double offered_rate = 0;
+        double achieved_rate = 0; // completed per second of the run
+        double elapsed = 0; // seconds from the first intended send to the last completion
+        std::uint64_t sent = 0;
+        std::uint64_t completed = 0;
+        std::uint64_t errors = 0;
+        std::uint64_t outstanding = 0; // neither completed nor failed when the drain timed out
+        ::trtlab::Histogram::Snapshot latency; // ns from the intended send time
+        ::trtlab::Histogram::Snapshot service_time; // ns from the actual send time
+
+        /**
+         * @brief Counts, rates and p50/p90/p99/p999/max/mean in microseconds as JSON
+         */
+        std::string ToJSON() const;
+    };
+
+    LoadGenerator(Options);
+
+    Report Run(const std::vector<std::shared_ptr<LoadTarget>>& targets);
+
+    static Arrivals ArrivalsFromString(const std::string&);
+
+  private:
+    Options m_Options;
+};
+
+/**
+ * @brief LoadTarget issuing unary calls through a ClientUnary
+ */
+template<typename Request, typename Response>
+class UnaryLoadTarget : public LoadTarget
+{
+  public:
+    using RequestFn = std::function<Request()>;
+    using Headers = std::map<std::string, std::string>;
+
+    UnaryLoadTarget(std::shared_ptr<ClientUnary<Request, Response>> client, RequestFn request_fn,
+                    Headers headers = Headers())
+        : m_Client(client), m_RequestFn(request_fn), m_Headers(headers)
+    {
+    }
+
+    void Send(Completion done) final override
+    {
+        m_Client->Enqueue(
+            m_RequestFn(),
+            [done](Request&, Response&, ::grpc::Status& status) { done(status.ok()); },
+            m_Headers);
+    }
+
+  private:
+    std::shared_ptr<ClientUnary<Request, Response>> m_Client;
+    RequestFn m_RequestFn;
+    Headers m_Headers; // sent with every request
+};
+
+/**
+ * @brief LoadTarget writing requests to one bidirectional stream
+ *
+ * The service must answer every request with exactly one response, in order; responses
+ * complete the oldest outstanding request.  Finish closes the stream and fails the requests
+ * left unanswered.
+ */
+template<typename Request, typename Response>
+class StreamingLoadTarget : public LoadTarget
+{
+  public:
+    using RequestFn = std::function<Request()>;
+    using PrepareFn = typename ClientStreaming<Request, Response>::PrepareFn;
+
+    StreamingLoadTarget(PrepareFn prepare_fn, std::shared_ptr<Executor> executor,
+                        RequestFn request_fn)
+        : m_RequestFn(request_fn), m_Pending(std::make_shared<Pending>())
+    {
+        m_Stream = std::make_unique<ClientStreaming<Request, Response>>(
+            prepare_fn, executor, [](Request&&) {},
+            [pending = m_Pending](Response&&) { pending->Complete(true); });
+    }
+
+    ~StreamingLoadTarget() override { Finish(); }
+
+    void Send(Completion done) final override
+    {
+        // requests must be queued in the order they are written
+        std::lock_guard<std::mutex> lock(m_SendMutex);
+        m_Pending->Push(std::move(done));
+        if(!m_Stream->Write(m_RequestFn()))
+        {
+            m_Pending->Complete(false);
+        }
+    }
+
+    void Finish() final override
+    {
+        if(!m_Stream)
+        {
+            return;
+        }
+        auto status = m_Stream->Done();
+        if(status.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+        {
+            // a stream that never started or closed still references its executor
+            LOG(WARNING) << "Stream did not close; leaking it";
+            m_Stream.release();
+        }
+        m_Stream.reset();
+        while(m_Pending->Complete(false))
+        {
+        }
+    }
+
+  private:
+    // outlives the stream's read callback
+    struct Pending
+    {
+        void Push(Completion done)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completions.push(std::move(done));
+        }
+
+        bool Complete(bool ok)
+        {
+            Completion done;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(completions.empty())
+                {
+                    return false;
+                }
+                done = std::move(completions.front());
+                completions.pop();
+            }
+            done(ok);
+            return true;
+        }
+
+        std::mutex mutex;
+        std::queue<Completion> completions;
+    };
+
+    RequestFn m_RequestFn;
+    std::mutex m_SendMutex;
+    std::shared_ptr<Pending> m_Pending;
+    std::unique_ptr<ClientStreaming<Request, Response>> m_Stream;
+};
+
+} // namespace client
+} // namespace nvrpc
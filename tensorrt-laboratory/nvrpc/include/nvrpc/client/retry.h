@@ -0,0 +1,98 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Bounds the extra load added by retries and hedged attempts
+ *
+ * Every call deposits ratio tokens, up to max_tokens, and every attempt after the first
+ * withdraws a whole token; attempts are only sent while a token is available.  Extra load is
+ * thus held to ratio times the call rate plus a burst of max_tokens, so an outage fails fast
+ * rather than being multiplied by the retries of every caller.
+ *
+ * Share one budget between the clients whose combined extra load should be bounded.
+ * Deposit and Withdraw are lock-free and safe to call from any thread.
+ */
+class RetryBudget
+{
+  public:
+    RetryBudget(double ratio = 0.1, double max_tokens = 10);
+
+    RetryBudget(const RetryBudget&) = delete;
+    RetryBudget& operator=(const RetryBudget&) = delete;
+
+    void Deposit();
+    bool Withdraw();
+
+    double Tokens() const;
+    // attempts granted and refused
+    std::size_t Withdrawn() const { return m_Withdrawn.load(std::memory_order_relaxed); }
+    std::size_t Refused() const { return m_Refused.load(std::memory_order_relaxed); }
+
+  private:
+    // tokens are kept in fixed point
+    static constexpr std::int64_t Scale = 1000;
+
+    std::int64_t m_Ratio;
+    std::int64_t m_MaxTokens;
+    std::atomic<std::int64_t> m_Tokens;
+    std::atomic<std::size_t> m_Withdrawn;
+    std::atomic<std::size_t> m_Refused;
+};
+
+/**
+ * @brief Retries and hedging of unary calls
+ *
+ * Up to max_attempts are sent per call.  An attempt failing with a retryable code is retried
+ * immediately, on the next endpoint picked by the Balancer if there is one.  With a
+ * hedge_delay, a further attempt is sent each time the outstanding ones have not finished
+ * within hedge_delay, e.g. the observed p95 latency; the first success wins and the others
+ * are cancelled.  Every attempt after the first must be granted by the budget.
+ */
+struct RetryPolicy
+{
+    std::size_t max_attempts = 1;
+    // zero disables hedging
+    std::chrono::nanoseconds hedge_delay = std::chrono::nanoseconds::zero();
+    std::vector<::grpc::StatusCode> retryable = {::grpc::StatusCode::UNAVAILABLE};
+    // unbounded when null
+    std::shared_ptr<RetryBudget> budget;
+};
+
+} // namespace client
+} // namespace nvrpc
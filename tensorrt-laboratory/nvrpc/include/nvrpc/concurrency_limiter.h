@@ -0,0 +1,117 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+namespace nvrpc {
+
+/**
+ * @brief Adaptive limit on the number of requests executing at once
+ *
+ * A gradient limiter: every window of completions, the average latency of the window is
+ * compared with a slowly moving baseline.  While the window stays within tolerance times the
+ * baseline the limit grows by its square root, leaving room for a small queue; beyond it, the
+ * limit shrinks in proportion, by at most half per window.  The limit only changes while the
+ * load actually uses at least half of it.  The baseline follows faster windows at once and
+ * slower ones within tolerance gradually.  Once every probe_windows updates the limit is
+ * briefly halved so that a service which was overloaded from the start, or has slowed down,
+ * still measures the latency of a short queue: the first window completed entirely under the
+ * probe re-measures the baseline and the limit returns to its value before the probe.
+ *
+ * Attach a limiter to the IRPCs of a service with IRPC::SetConcurrencyLimiter; share one
+ * limiter to gate the service as a whole, and pass it to the service's LocalClients to gate
+ * in-process calls as well.  Unary contexts over the limit are completed
+ * immediately with RESOURCE_EXHAUSTED, without running ExecuteRPC, so excess load is shed
+ * in microseconds instead of queueing for every context.
+ *
+ * TryAcquire and Release are safe to call from any thread.
+ */
+class ConcurrencyLimiter
+{
+  public:
+    struct Options
+    {
+        std::size_t initial_limit = 20;
+        std::size_t min_limit = 1;
+        std::size_t max_limit = 1000;
+        // completions per limit update
+        std::size_t window = 50;
+        // latency over the baseline tolerated before the limit shrinks
+        double tolerance = 1.5;
+        // weight of each window's new limit
+        double smoothing = 0.2;
+        // windows averaged into the baseline latency
+        std::size_t baseline_windows = 200;
+        // windows between probes which briefly lower the limit; 0 disables probing
+        std::size_t probe_windows = 100;
+    };
+
+    ConcurrencyLimiter();
+    ConcurrencyLimiter(Options);
+
+    ConcurrencyLimiter(const ConcurrencyLimiter&) = delete;
+    ConcurrencyLimiter& operator=(const ConcurrencyLimiter&) = delete;
+
+    /**
+     * @brief Admit a request; false, and counted as rejected, once the limit is reached
+     */
+    bool TryAcquire();
+
+    /**
+     * @brief Complete an admitted request which took latency to execute
+     */
+    void Release(std::chrono::nanoseconds latency);
+
+    std::size_t Limit() const { return m_Limit.load(std::memory_order_relaxed); }
+    std::size_t InFlight() const { return m_InFlight.load(std::memory_order_relaxed); }
+    std::size_t Rejected() const { return m_Rejected.load(std::memory_order_relaxed); }
+
+  private:
+    // requires m_Mutex
+    void Update(double latency, std::size_t max_in_flight);
+
+    const Options m_Options;
+    std::atomic<std::size_t> m_Limit;
+    std::atomic<std::size_t> m_InFlight;
+    std::atomic<std::size_t> m_Rejected;
+
+    std::mutex m_Mutex;
+    double m_Estimate;
+    double m_Baseline;
+    double m_WindowSum;
+    std::size_t m_WindowSamples;
+    std::size_t m_WindowMaxInFlight;
+    std::size_t m_Windows;
+    // limit of the probe in progress; 0 outside of a probe
+    std::size_t m_ProbeLimit;
+};
+
+} // namespace nvrpc
@@ -26,14 +26,16 @@
  */
 #pragma once
 
+#include "nvrpc/concurrency_limiter.h"
 #include "nvrpc/interfaces.h"
 #include "nvrpc/life_cycle_batching.h"
 #include "nvrpc/life_cycle_bidirectional.h"
 #include "nvrpc/life_cycle_streaming.h"
 #include "nvrpc/life_cycle_unary.h"
+#include "tensorrt/laboratory/core/trace.h"
 
 #ifdef NVRPC_METRICS_ENABLED
-#include "YAIS/Metrics.h"
+#include "nvrpc/metrics.h"
 #endif
 
 namespace nvrpc {
@@ -64,21 +66,53 @@ class BaseContext : public LifeCycle
     using QueueFuncType = typename LifeCycle::ExecutorQueueFuncType;
 
     using LifeCycleType = LifeCycle;
-    virtual ~BaseContext() override {}
+    virtual ~BaseContext() override;
 
   protected:
     const ResourcesType& GetResources() const { return m_Resources; }
     double Walltime() const;
 
+    /**
+     * @brief True once the client has cancelled the RPC, timed out or disconnected
+     *
+     * Cheap enough to poll from long-running work; work that observes a cancellation should
+     * stop early and complete the RPC with CancelResponse.
+     */
+    bool IsCancelled() const { return this->m_Cancellation.IsCancelled(); }
+
+    /**
+     * @brief Token observing IsCancelled that can be captured by work queued on other threads
+     */
+    CancellationToken GetCancellationToken() const { return this->m_Cancellation.Token(); }
+
+    /**
+     * @brief Trace Id of the current request; 0 unless sampled by ::trtlab::RequestTrace
+     *
+     * RequestTrace::Current() is set to it while the Executor runs this context; work handed
+     * to other threads should install it with a ::trtlab::TraceScope.
+     */
+    ::trtlab::RequestTrace::Id TraceId() const { return m_TraceId; }
+
     virtual void OnContextStart() {}
     virtual void OnContextReset() {}
 
   private:
     virtual void OnLifeCycleStart() final override;
     virtual void OnLifeCycleReset() final override;
+    virtual void OnLifeCycleFinish() final override;
+    virtual bool OnLifeCycleAdmit() final override;
 
     ResourcesType m_Resources;
     std::chrono::high_resolution_clock::time_point m_StartTime;
+    bool m_Admitted = false;
+    ::trtlab::RequestTrace::Id m_TraceId = 0;
+    std::uint64_t m_TraceStart = 0;
+    std::uint64_t m_TraceFinish = 0;
+#ifdef NVRPC_METRICS_ENABLED
+    Metrics::ContextMetrics* m_Metrics = nullptr;
+    bool m_Armed = false;
+    bool m_InFlight = false;
+#endif
 
     void FactoryInitializer(QueueFuncType, ResourcesType);
 
@@ -98,6 +132,22 @@ class BaseContext : public LifeCycle
 
 // Implementations
 
+template<class LifeCycle, class Resources>
+BaseContext<LifeCycle, Resources>::~BaseContext()
+{
+#ifdef NVRPC_METRICS_ENABLED
+    // contexts are destroyed with their executor, usually while armed
+    if(m_Metrics && m_InFlight)
+    {
+        m_Metrics->abandoned.Increment();
+    }
+    else if(m_Metrics && m_Armed)
+    {
+        m_Metrics->retired.Increment();
+    }
+#endif
+}
+
 /**
  * @brief Method invoked when a request is received and the per-call context lifecycle begins.
  */
@@ -105,8 +155,13 @@ template<class LifeCycle, class Resources>
 void BaseContext<LifeCycle, Resources>::OnLifeCycleStart()
 {
     m_StartTime = std::chrono::high_resolution_clock::now();
+    m_TraceId = ::trtlab::RequestTrace::Sample();
+    m_TraceStart = ::trtlab::RequestTrace::Stamp(m_TraceId);
+    ::trtlab::RequestTrace::SetCurrent(m_TraceId);
 #ifdef NVRPC_METRICS_ENABLED
-    Metrics::ExecutionQueueDepthIncrement();
+    m_Metrics->started.Increment();
+    m_Armed = false;
+    m_InFlight = true;
 #endif
     OnContextStart();
 }
@@ -117,12 +172,70 @@ void BaseContext<LifeCycle, Resources>::OnLifeCycleStart()
 template<class LifeCycle, class Resources>
 void BaseContext<LifeCycle, Resources>::OnLifeCycleReset()
 {
+    if(m_TraceId)
+    {
+        using ::trtlab::RequestTrace;
+        auto now = ::trtlab::TscClock::Now();
+        if(m_TraceFinish)
+        {
+            RequestTrace::Record(m_TraceId, "send", m_TraceFinish, now);
+        }
+        RequestTrace::Record(m_TraceId, "rpc", m_TraceStart, now);
+        m_TraceId = 0;
+        m_TraceFinish = 0;
+    }
 #ifdef NVRPC_METRICS_ENABLED
-    Metrics::ExecutionQueueDepthDecrement();
+    if(m_InFlight)
+    {
+        m_Metrics->latency.Record(std::chrono::high_resolution_clock::now() - m_StartTime);
+        m_Metrics->completed.Increment();
+        m_InFlight = false;
+    }
+    if(!m_Armed)
+    {
+        m_Metrics->armed.Increment();
+        m_Armed = true;
+    }
 #endif
     OnContextReset();
 }
 
+/**
+ * @brief Method invoked when the response is handed to gRPC; splits a sampled request into
+ * the time spent in the handler and the time spent sending
+ */
+template<class LifeCycle, class Resources>
+void BaseContext<LifeCycle, Resources>::OnLifeCycleFinish()
+{
+    if(m_Admitted)
+    {
+        m_Admitted = false;
+        this->GetConcurrencyLimiter()->Release(std::chrono::high_resolution_clock::now() -
+                                               m_StartTime);
+    }
+    if(m_TraceId)
+    {
+        m_TraceFinish = ::trtlab::TscClock::Now();
+        ::trtlab::RequestTrace::Record(m_TraceId, "handler", m_TraceStart, m_TraceFinish);
+    }
+}
+
+/**
+ * @brief Method invoked after OnLifeCycleStart by LifeCycles gated by a ConcurrencyLimiter;
+ * an admitted request is released, with its latency, by OnLifeCycleFinish
+ */
+template<class LifeCycle, class Resources>
+bool BaseContext<LifeCycle, Resources>::OnLifeCycleAdmit()
+{
+    auto limiter = this->GetConcurrencyLimiter();
+    if(!limiter)
+    {
+        return true;
+    }
+    m_Admitted = limiter->TryAcquire();
+    return m_Admitted;
+}
+
 /**
  * @brief Number of seconds since the start of the RPC
  */
@@ -154,6 +267,9 @@ std::unique_ptr<ContextType> ContextFactory(typename ContextType::QueueFuncType
     auto ctx = std::make_unique<ContextType>();
     auto base = ctx->GetBase();
     base->FactoryInitializer(queue_fn, resources);
+#ifdef NVRPC_METRICS_ENABLED
+    base->m_Metrics = &Metrics::ForContext(typeid(ContextType));
+#endif
     return ctx;
 }
 
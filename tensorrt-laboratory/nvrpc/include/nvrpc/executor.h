@@ -29,11 +29,11 @@
 #include "nvrpc/interfaces.h"
 #include "tensorrt/laboratory/core/resources.h"
 #include "tensorrt/laboratory/core/thread_pool.h"
+#include "tensorrt/laboratory/core/timer_wheel.h"
 
-#ifdef NVRPC_METRICS_ENABLED
-#include "YAIS/Metrics.h"
-#endif
-
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <thread>
 
 #include <glog/logging.h>
@@ -75,11 +75,17 @@ class Executor : public IExecutor
 
     void Shutdown() final override
     {
+        {
+            // no wake-up alarms may be set and no contexts re-armed on a CQ after it is
+            // shutdown
+            std::unique_lock<std::shared_mutex> reset_lock(m_ResetMutex);
+            std::lock_guard<std::mutex> lock(m_TimerMutex);
+            m_Running = false;
+        }
         for(auto& cq : m_ServerCompletionQueues)
         {
             LOG(INFO) << "Telling CQ to Shutdown: " << cq.get();
             cq->Shutdown();
-            m_Running = false;
         }
         // exit(911);
         LOG(INFO) << "Joining Executor Threads";
@@ -88,6 +94,9 @@ class Executor : public IExecutor
 
     void Run() final override
     {
+        // Must be set before the progress engines start; setting it from the engine threads
+        // races with an immediate Shutdown and resets contexts on a shutdown CQ forever
+        m_Running = true;
         // Launch the threads polling on their CQs
         for(int i = 0; i < m_ThreadPool->Size(); i++)
         {
@@ -97,23 +106,33 @@ class Executor : public IExecutor
         // Queue the Execution Contexts in the recieve queue
         for(int i = 0; i < m_Contexts.size(); i++)
         {
-            // Reseting the context decrements the gauge
-#ifdef NVRPC_METRICS_ENABLED
-            Metrics::ExecutionQueueDepthIncrement();
-#endif
             ResetContext(m_Contexts[i].get());
         }
     }
 
+    TimerId ScheduleTimer(std::chrono::nanoseconds, std::function<void()>) final override;
+    bool CancelTimer(TimerId) final override;
+    bool Post(::grpc::Alarm&, void*) final override;
+
   protected:
     void SetTimeout(time_point, std::function<void()>) final override;
 
   private:
     void ProgressEngine(int thread_id);
 
+    // AsyncNext deadline for the progress engines; the earliest pending timer
+    time_point NextTimerDeadline();
+    void FireTimers(std::vector<::trtlab::TimerWheel::Callback>& expired);
+    void WakeProgressEngine();
+
     volatile bool m_Running;
-    time_point m_TimeoutDeadline;
-    std::function<void()> m_TimeoutCallback;
+    // held shared by progress engines re-arming contexts
+    std::shared_mutex m_ResetMutex;
+    std::mutex m_TimerMutex;
+    ::trtlab::TimerWheel m_Timers;
+    std::atomic<std::size_t> m_PendingTimers;
+    std::atomic<bool> m_WakePending;
+    std::atomic<std::size_t> m_NextPostQueue;
     std::vector<std::unique_ptr<IContext>> m_Contexts;
     std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> m_ServerCompletionQueues;
     // std::vector<std::unique_ptr<PerThreadState>> m_ShutdownState;
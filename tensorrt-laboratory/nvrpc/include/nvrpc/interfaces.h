@@ -27,18 +27,29 @@
 #ifndef NVIS_INTERFACES_H_
 #define NVIS_INTERFACES_H_
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
 #include <grpc++/grpc++.h>
+#include <grpcpp/alarm.h>
 
+#include "nvrpc/cancellation.h"
 #include "tensorrt/laboratory/core/resources.h"
 
 namespace nvrpc {
 
+class ConcurrencyLimiter;
 class IContext;
 class IExecutor;
 class IContextLifeCycle;
 class IRPC;
 class IService;
 
+template<class ContextType>
+class LocalClient;
+
 /**
  * The IContext object and it's subsequent derivations are the single more important class
  * in this library. Contexts are responsible for maintaining the state of a message and
@@ -51,11 +62,39 @@ class IContext
     static IContext* Detag(void* tag) { return static_cast<IContext*>(tag); }
 
   protected:
-    IContext() : m_MasterContext(this) {}
-    IContext(IContext* master) : m_MasterContext(master) {}
+    using TimerId = std::uint64_t;
+
+    IContext() : m_MasterContext(this), m_Executor(nullptr) {}
+    IContext(IContext* master) : m_MasterContext(master), m_Executor(nullptr) {}
 
     void* Tag() { return reinterpret_cast<void*>(this); }
 
+    /**
+     * @brief Arm a timer on the Executor that owns this context
+     *
+     * The callback runs on one of the Executor's progress engine threads.  Useful for
+     * per-request deadlines, batching windows and retries without dedicated threads.
+     */
+    TimerId ArmTimer(std::chrono::nanoseconds timeout, std::function<void()> callback);
+
+    /**
+     * @brief Disarm a timer armed by ArmTimer; returns false if it already fired
+     */
+    bool CancelTimer(TimerId);
+
+    /**
+     * @brief Deliver this context's tag on one of the Executor's progress engines
+     *
+     * Starts in-process calls without a gRPC round trip; returns false if the Executor is
+     * not running, in which case the tag will not be delivered.
+     */
+    bool PostToExecutor(::grpc::Alarm&);
+
+    /**
+     * @brief Limiter of the IRPC this context was created for; nullptr if none was set
+     */
+    ConcurrencyLimiter* GetConcurrencyLimiter() const { return m_Limiter.get(); }
+
   protected:
     IContext* m_MasterContext;
 
@@ -63,8 +102,13 @@ class IContext
     virtual bool RunNextState(bool) = 0;
     virtual void Reset() = 0;
 
+    IExecutor* m_Executor;
+    std::shared_ptr<ConcurrencyLimiter> m_Limiter;
+
     friend class IRPC;
     friend class IExecutor;
+    template<class ContextType>
+    friend class LocalClient;
 };
 
 class IContextLifeCycle : public IContext
@@ -77,9 +121,17 @@ class IContextLifeCycle : public IContext
 
     virtual void OnLifeCycleStart() = 0;
     virtual void OnLifeCycleReset() = 0;
+    // Invoked by LifeCycles that complete with a single response as it is handed to gRPC
+    virtual void OnLifeCycleFinish() {}
+    // Invoked by LifeCycles that honor a ConcurrencyLimiter after OnLifeCycleStart; when it
+    // returns false the request is completed with RESOURCE_EXHAUSTED and never executed
+    virtual bool OnLifeCycleAdmit() { return true; }
 
     virtual void FinishResponse() = 0;
     virtual void CancelResponse() = 0;
+
+    // Set by the LifeCycle when the client cancels or disconnects; reset per RPC
+    CancellationSource m_Cancellation;
 };
 
 class IService
@@ -97,10 +149,24 @@ class IRPC
     IRPC() = default;
     virtual ~IRPC() {}
 
+    /**
+     * @brief Gate the contexts of this RPC with limiter; may be shared between IRPCs
+     *
+     * Applies to contexts registered after the call.  Only unary contexts are gated, and
+     * in-process calls only through LocalClients constructed with the same limiter.
+     */
+    void SetConcurrencyLimiter(std::shared_ptr<ConcurrencyLimiter> limiter)
+    {
+        m_Limiter = std::move(limiter);
+    }
+
   protected:
     virtual std::unique_ptr<IContext> CreateContext(::grpc::ServerCompletionQueue*,
                                                     std::shared_ptr<::trtlab::Resources>) = 0;
 
+  private:
+    std::shared_ptr<ConcurrencyLimiter> m_Limiter;
+
     friend class IExecutor;
 };
 
@@ -116,6 +182,24 @@ class IExecutor
                                   int numContextsPerThread) = 0;
     virtual void Shutdown() = 0;
 
+    using TimerId = std::uint64_t;
+
+    /**
+     * @brief Arm a timer driven by the Executor's progress engines
+     *
+     * Schedule and cancel are O(1) and safe to call from any thread.
+     */
+    virtual TimerId ScheduleTimer(std::chrono::nanoseconds timeout,
+                                  std::function<void()> callback) = 0;
+    virtual bool CancelTimer(TimerId) = 0;
+
+    /**
+     * @brief Set alarm to deliver tag immediately on one of the progress engines
+     *
+     * Returns false, without setting the alarm, unless the Executor is running.
+     */
+    virtual bool Post(::grpc::Alarm& alarm, void* tag) = 0;
+
   protected:
     using time_point = std::chrono::system_clock::time_point;
 
@@ -126,10 +210,26 @@ class IExecutor
     inline std::unique_ptr<IContext> CreateContext(IRPC* rpc, ::grpc::ServerCompletionQueue* cq,
                                                    std::shared_ptr<::trtlab::Resources> res)
     {
-        return rpc->CreateContext(cq, res);
+        auto ctx = rpc->CreateContext(cq, res);
+        ctx->m_Executor = this;
+        ctx->m_Limiter = rpc->m_Limiter;
+        return ctx;
     }
 };
 
+inline IContext::TimerId IContext::ArmTimer(std::chrono::nanoseconds timeout,
+                                            std::function<void()> callback)
+{
+    return m_Executor->ScheduleTimer(timeout, std::move(callback));
+}
+
+inline bool IContext::CancelTimer(TimerId id) { return m_Executor->CancelTimer(id); }
+
+inline bool IContext::PostToExecutor(::grpc::Alarm& alarm)
+{
+    return m_Executor->Post(alarm, Tag());
+}
+
 } // namespace nvrpc
 
 #endif // NVIS_INTERFACES_H_
@@ -26,7 +26,7 @@
 //
 #pragma once
 
-#include <queue>
+#include <deque>
 
 #include "nvrpc/interfaces.h"
 
@@ -39,6 +39,11 @@ namespace nvrpc {
 // arbitrary call order of ServerReaderWriter::Read() and
 // ServerReaderWriter::Write(), so we are able to handle
 // reading request and writing response seperately.
+//
+// By default one request is executed at a time.  A Context may call SetExecutionWindow from
+// its constructor to execute up to N requests of a stream concurrently; responses are held
+// until every earlier response has been written, so the client still receives them in
+// request order.
 template<class Request, class Response>
 class BidirectionalLifeCycleStreaming : public IContextLifeCycle
 {
@@ -82,15 +87,39 @@ class BidirectionalLifeCycleStreaming : public IContextLifeCycle
     BidirectionalLifeCycleStreaming();
     void SetQueueFunc(ExecutorQueueFuncType);
 
+    /**
+     * @brief Number of requests, counted from the oldest response not yet written, that may
+     * be handed to ExecuteRPC; defaults to 1.  Call from the Context's constructor.
+     *
+     * With a window larger than 1, ExecuteRPC may be running for several requests at once and
+     * each must be completed with FinishResponse(response).
+     */
+    void SetExecutionWindow(std::size_t window);
+
     // Function to actually process the request
     virtual void ExecuteRPC(RequestType& request, ResponseType& response) = 0;
 
+    // Completes the oldest executing request
     void FinishResponse() final override;
+    // Completes the request whose ExecuteRPC was given response
+    void FinishResponse(ResponseType& response);
     void CancelResponse() final override;
 
   private:
-    std::tuple<bool, bool, bool> EvaluateState();
-    void ProgressState(bool should_write, bool should_execute, bool should_finish);
+    // A request and its response; owned by the lifecycle from the moment the request is read
+    // until the response has been written
+    struct Exchange
+    {
+        RequestType request;
+        ResponseType response;
+        bool finished = false;
+    };
+
+    using Actions = std::tuple<Exchange*, Exchange*, bool>; // write, execute, finish
+
+    Actions EvaluateState();
+    void ProgressState(Actions&);
+    void FinishExchange(const ResponseType* response);
 
     // IContext Methods
     bool RunNextState(bool ok) final override;
@@ -110,18 +139,19 @@ class BidirectionalLifeCycleStreaming : public IContextLifeCycle
     bool (BidirectionalLifeCycleStreaming<RequestType, ResponseType>::*m_NextState)(bool);
 
     // Variables
-    // The mutex will be more useful once we can keep reading requests
-    // without waiting for response to be sent
+    // Exchanges in stream order; until the client calls WritesDone, the last one is the target
+    // of the outstanding Read.  Elements are only added and removed at the ends, so pointers
+    // taken under the mutex stay valid while the exchange is in the queue.
     std::mutex m_QueueMutex;
-    std::queue<RequestType> m_RequestQueue;
-    std::queue<ResponseType> m_ResponseQueue;
-    std::queue<ResponseType> m_ResponseWriteBackQueue;
+    std::deque<Exchange> m_Exchanges;
+    std::size_t m_Dispatched; // leading exchanges handed to ExecuteRPC
+    std::size_t m_Executing; // dispatched exchanges not yet finished
+    std::size_t m_Window;
 
     StateContext<RequestType, ResponseType> m_ReadStateContext;
     StateContext<RequestType, ResponseType> m_WriteStateContext;
 
     bool m_Writing;
-    bool m_Executing;
     bool m_WritesDone;
     bool m_Finishing;
 
@@ -178,9 +208,10 @@ bool BidirectionalLifeCycleStreaming<Request, Response>::RunNextState(
 
 template<class Request, class Response>
 BidirectionalLifeCycleStreaming<Request, Response>::BidirectionalLifeCycleStreaming()
-    : m_ReadStateContext(static_cast<IContext*>(this)),
-      m_WriteStateContext(static_cast<IContext*>(this)), m_WritesDone(false), m_Writing(false),
-      m_Executing(false), m_Finishing(false)
+    : m_Dispatched(0), m_Executing(0), m_Window(1),
+      m_ReadStateContext(static_cast<IContext*>(this)),
+      m_WriteStateContext(static_cast<IContext*>(this)), m_Writing(false), m_WritesDone(false),
+      m_Finishing(false)
 {
     m_ReadStateContext.m_NextState =
         &BidirectionalLifeCycleStreaming<RequestType, ResponseType>::StateRequestDone;
@@ -188,22 +219,26 @@ BidirectionalLifeCycleStreaming<Request, Response>::BidirectionalLifeCycleStream
         &BidirectionalLifeCycleStreaming<RequestType, ResponseType>::StateResponseDone;
 }
 
+template<class Request, class Response>
+void BidirectionalLifeCycleStreaming<Request, Response>::SetExecutionWindow(std::size_t window)
+{
+    CHECK_GT(window, 0);
+    m_Window = window;
+}
+
 template<class Request, class Response>
 void BidirectionalLifeCycleStreaming<Request, Response>::Reset()
 {
-    std::queue<RequestType> empty_request_queue;
-    std::queue<ResponseType> empty_response_queue;
-    std::queue<ResponseType> empty_response_write_back_queue;
+    std::deque<Exchange> empty_exchanges;
     OnLifeCycleReset();
     {
         std::lock_guard<std::mutex> lock(m_QueueMutex);
         m_Writing = false;
-        m_Executing = false;
         m_WritesDone = false;
         m_Finishing = false;
-        m_RequestQueue.swap(empty_request_queue);
-        m_ResponseQueue.swap(empty_response_queue);
-        m_ResponseWriteBackQueue.swap(empty_response_write_back_queue);
+        m_Dispatched = 0;
+        m_Executing = 0;
+        m_Exchanges.swap(empty_exchanges);
         m_Context.reset(new ::grpc::ServerContext);
         m_ReaderWriter.reset(
             new ::grpc::ServerAsyncReaderWriter<ResponseType, RequestType>(m_Context.get()));
@@ -214,54 +249,61 @@ void BidirectionalLifeCycleStreaming<Request, Response>::Reset()
     m_QueuingFunc(m_Context.get(), m_ReaderWriter.get(), IContext::Tag());
 }
 
+// Each event - a read, a write or an execution completing - frees at most one place in the
+// window, so at most one exchange is dispatched per evaluation
 template<class Request, class Response>
-std::tuple<bool, bool, bool> BidirectionalLifeCycleStreaming<Request, Response>::EvaluateState()
+typename BidirectionalLifeCycleStreaming<Request, Response>::Actions
+    BidirectionalLifeCycleStreaming<Request, Response>::EvaluateState()
 {
-    bool should_write = false;
-    bool should_execute = false;
+    Exchange* should_write = nullptr;
+    Exchange* should_execute = nullptr;
     bool should_finish = false;
 
-    if(!m_Executing && !m_ResponseQueue.empty())
+    auto received = m_Exchanges.size() - (m_WritesDone ? 0 : 1);
+    if(m_Dispatched < received && m_Dispatched < m_Window)
     {
-        should_execute = true;
-        m_Executing = true;
+        should_execute = &m_Exchanges[m_Dispatched];
+        m_Dispatched++;
+        m_Executing++;
     }
 
-    if(!m_Writing && !m_ResponseWriteBackQueue.empty())
+    if(!m_Writing && m_Dispatched && m_Exchanges.front().finished)
     {
-        should_write = true;
+        should_write = &m_Exchanges.front();
         m_Writing = true;
     }
 
     if(!should_write && !should_execute && !m_Writing && !m_Executing && !m_Finishing &&
-       m_WritesDone)
+       m_WritesDone && m_Exchanges.empty())
     {
         should_finish = true;
         m_Finishing = true;
         m_NextState = &BidirectionalLifeCycleStreaming<RequestType, ResponseType>::StateFinishDone;
     }
 
-    DLOG(INFO) << should_write << "; " << should_execute << "; " << should_finish << " -- "
-               << m_Writing << "; " << m_Executing << "; " << m_WritesDone;
+    DLOG(INFO) << (should_write ? 1 : 0) << "; " << (should_execute ? 1 : 0) << "; "
+               << should_finish << " -- " << m_Writing << "; " << m_Executing << "; "
+               << m_WritesDone;
 
     return std::make_tuple(should_write, should_execute, should_finish);
 }
 
 template<class Request, class Response>
-void BidirectionalLifeCycleStreaming<Request, Response>::ProgressState(bool should_write,
-                                                                       bool should_execute,
-                                                                       bool should_finish)
+void BidirectionalLifeCycleStreaming<Request, Response>::ProgressState(Actions& actions)
 {
+    Exchange* should_write = std::get<0>(actions);
+    Exchange* should_execute = std::get<1>(actions);
+    bool should_finish = std::get<2>(actions);
+
     if(should_write)
     {
         DLOG(INFO) << "Writing response";
-        m_ReaderWriter->Write(m_ResponseWriteBackQueue.front(),
-                              m_WriteStateContext.IContext::Tag());
+        m_ReaderWriter->Write(should_write->response, m_WriteStateContext.IContext::Tag());
     }
     if(should_execute)
     {
         DLOG(INFO) << "Executing";
-        ExecuteRPC(m_RequestQueue.front(), m_ResponseQueue.front());
+        ExecuteRPC(should_execute->request, should_execute->response);
     }
     if(should_finish)
     {
@@ -282,12 +324,14 @@ bool BidirectionalLifeCycleStreaming<Request, Response>::StateInitializedDone(bo
 
     OnLifeCycleStart();
     // Start reading once connection is created
+    RequestType* request;
     {
         std::lock_guard<std::mutex> lock(m_QueueMutex);
-        m_RequestQueue.emplace();
+        m_Exchanges.emplace_back();
+        request = &m_Exchanges.back().request;
         m_NextState = &BidirectionalLifeCycleStreaming<RequestType, ResponseType>::StateInvalid;
     }
-    m_ReaderWriter->Read(&m_RequestQueue.back(), m_ReadStateContext.IContext::Tag());
+    m_ReaderWriter->Read(request, m_ReadStateContext.IContext::Tag());
     return true;
 }
 
@@ -301,40 +345,34 @@ bool BidirectionalLifeCycleStreaming<Request, Response>::StateRequestDone(bool o
     // a request, then a ServerReaderWriter::Write() will be called. In that case,
     // let WriteStateContext handle the reset procedure.
 
-    bool should_write, should_execute, should_finish, should_read = true;
-
+    RequestType* should_read = nullptr;
+    Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_QueueMutex);
         DLOG(INFO) << "RequestDone Triggered";
 
-        if(!ok)
+        if(ok)
         {
-            {
-                // Client called WritesDone
-                DLOG(INFO) << "WritesDone received from Client; closing Server Reads";
-                m_WritesDone = true;
-            }
+            // Successfully received a request; post a read/recv on a new exchange
+            m_Exchanges.emplace_back();
+            should_read = &m_Exchanges.back().request;
         }
-
-        // Successfully receive request
-        should_read = !m_WritesDone;
-        if(should_read)
+        else
         {
-            m_ResponseQueue.emplace(); // add a response object which will be written on execution
-            m_RequestQueue.emplace(); // post a read/recv on a new request object
+            // Client called WritesDone
+            DLOG(INFO) << "WritesDone received from Client; closing Server Reads";
+            m_WritesDone = true;
+            m_Exchanges.pop_back();
         }
 
-        auto should_wef = EvaluateState();
-        should_write = std::get<0>(should_wef);
-        should_execute = std::get<1>(should_wef);
-        should_finish = std::get<2>(should_wef);
+        actions = EvaluateState();
     }
     if(should_read)
     {
         // Post Read/Receive
-        m_ReaderWriter->Read(&m_RequestQueue.back(), m_ReadStateContext.IContext::Tag());
+        m_ReaderWriter->Read(should_read, m_ReadStateContext.IContext::Tag());
     }
-    ProgressState(should_write, should_execute, should_finish);
+    ProgressState(actions);
     return true;
 }
 
@@ -355,20 +393,18 @@ bool BidirectionalLifeCycleStreaming<Request, Response>::StateResponseDone(bool
     }
 
     // Done writing back one response
-    bool should_write, should_execute, should_finish;
+    Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_QueueMutex);
-        DLOG(ERROR) << "Finished Writing a Response - ResponseDone";
+        DLOG(INFO) << "Finished Writing a Response - ResponseDone";
 
         m_Writing = false;
-        m_ResponseWriteBackQueue.pop();
+        m_Exchanges.pop_front();
+        m_Dispatched--;
 
-        auto should_wef = EvaluateState();
-        should_write = std::get<0>(should_wef);
-        should_execute = std::get<1>(should_wef);
-        should_finish = std::get<2>(should_wef);
+        actions = EvaluateState();
     }
-    ProgressState(should_write, should_execute, should_finish);
+    ProgressState(actions);
     return true;
 }
 
@@ -389,22 +425,41 @@ bool BidirectionalLifeCycleStreaming<Request, Response>::StateInvalid(bool ok)
 template<class Request, class Response>
 void BidirectionalLifeCycleStreaming<Request, Response>::FinishResponse()
 {
-    bool should_write, should_execute, should_finish;
+    FinishExchange(nullptr);
+}
+
+template<class Request, class Response>
+void BidirectionalLifeCycleStreaming<Request, Response>::FinishResponse(ResponseType& response)
+{
+    FinishExchange(&response);
+}
+
+// response identifies the exchange; nullptr selects the oldest one still executing
+template<class Request, class Response>
+void BidirectionalLifeCycleStreaming<Request, Response>::FinishExchange(
+    const ResponseType* response)
+{
+    Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_QueueMutex);
         DLOG(INFO) << "InFinishResponse";
 
-        m_Executing = false;
-        m_ResponseWriteBackQueue.push(std::move(m_ResponseQueue.front()));
-        m_RequestQueue.pop();
-        m_ResponseQueue.pop();
+        auto exchange = m_Exchanges.begin();
+        auto dispatched = exchange + m_Dispatched;
+        while(exchange != dispatched &&
+              (response ? &exchange->response != response : exchange->finished))
+        {
+            exchange++;
+        }
+        CHECK(exchange != dispatched && !exchange->finished)
+            << "FinishResponse called for a response that is not executing";
+
+        exchange->finished = true;
+        m_Executing--;
 
-        auto should_wef = EvaluateState();
-        should_write = std::get<0>(should_wef);
-        should_execute = std::get<1>(should_wef);
-        should_finish = std::get<2>(should_wef);
+        actions = EvaluateState();
     }
-    ProgressState(should_write, should_execute, should_finish);
+    ProgressState(actions);
 }
 
 template<class Request, class Response>
@@ -26,6 +26,8 @@
 //
 #pragma once
 
+#include <condition_variable>
+#include <limits>
 #include <queue>
 
 #include "nvrpc/interfaces.h"
@@ -55,6 +57,10 @@ namespace nvrpc {
  *     b) `CancelStream` or `FinishStream` is called on either the lifecycle or an external
  *        `ServerStream`.
  *
+ * Responses are queued on the stream until gRPC has written them.  The queue is unbounded
+ * unless the Context calls `SetWriteLimit` from its constructor, in which case a slow reader
+ * pushes back on the producer instead of growing server memory.
+ *
  * @tparam Request
  * @tparam Response
  */
@@ -75,6 +81,20 @@ class LifeCycleStreaming : public IContextLifeCycle
 
     class ServerStream;
 
+    // What ServerStream::WriteResponse does once the write limit is reached
+    enum class WriteOverflow
+    {
+        Block,
+        Fail
+    };
+
+    enum class WriteResult
+    {
+        Written,
+        WouldBlock,
+        Disconnected
+    };
+
   protected:
     LifeCycleStreaming();
     void SetQueueFunc(ExecutorQueueFuncType);
@@ -82,6 +102,22 @@ class LifeCycleStreaming : public IContextLifeCycle
     virtual void RequestReceived(Request&&, std::shared_ptr<ServerStream>) = 0;
     virtual void RequestsFinished(std::shared_ptr<ServerStream>) {}
 
+    /**
+     * @brief Bound the responses queued on each stream, including the one being written
+     *
+     * At the limit, ServerStream::WriteResponse blocks until a write completes or returns
+     * false, per overflow, and TryWriteResponse returns WouldBlock.  Blocking is only safe off
+     * the Executor's threads, which complete the writes; handlers running on them should use
+     * TryWriteResponse and resume from ResponsesWritable.
+     */
+    void SetWriteLimit(std::size_t max_outstanding, WriteOverflow overflow = WriteOverflow::Block);
+
+    /**
+     * @brief Invoked on the Executor when a write completes below the write limit after a
+     * response was refused
+     */
+    virtual void ResponsesWritable(std::shared_ptr<ServerStream>) {}
+
     // TODO: Add an OnInitialized virtual method
     // virtual void StreamContextInitialized() {}
 
@@ -91,7 +127,10 @@ class LifeCycleStreaming : public IContextLifeCycle
     {
       public:
         // ServerStream(LifeCycleStreaming<RequestType, ResponseType>* master) : m_Master(master) {}
-        ServerStream(LifeCycleStreaming<Request, Response>* master) : m_Master(master) {}
+        ServerStream(LifeCycleStreaming<Request, Response>* master)
+            : m_Master(master), m_Epoch(master->m_Epoch)
+        {
+        }
         ~ServerStream() {}
 
         bool IsConnected() { return m_Master; }
@@ -107,16 +146,59 @@ class LifeCycleStreaming : public IContextLifeCycle
             return reinterpret_cast<std::uint64_t>(m_Master->Tag());
         }
 
+        /**
+         * @brief Queue a response; returns false if it was not queued
+         *
+         * At the write limit, blocks or fails according to the Context's WriteOverflow.
+         */
         bool WriteResponse(ResponseType&& response)
+        {
+            std::unique_lock<std::recursive_mutex> lock(m_Mutex);
+            for(;;)
+            {
+                if(!IsConnected())
+                {
+                    DLOG(WARNING) << "Attempted to write to a disconnected stream";
+                    return false;
+                }
+                auto master = m_Master;
+                auto result = master->TryWriteResponse(response, m_Epoch);
+                if(result != WriteResult::WouldBlock)
+                {
+                    return result == WriteResult::Written;
+                }
+                if(master->m_WriteOverflow == WriteOverflow::Fail)
+                {
+                    return false;
+                }
+                // the stream may be closed while waiting; connectivity is re-checked after
+                lock.unlock();
+                master->WaitWritable(m_Epoch);
+                lock.lock();
+            }
+        }
+
+        /**
+         * @brief Queue a response without blocking; response is moved from only if Written
+         */
+        WriteResult TryWriteResponse(ResponseType&& response)
         {
             std::lock_guard<std::recursive_mutex> lock(m_Mutex);
             if(!IsConnected())
             {
                 DLOG(WARNING) << "Attempted to write to a disconnected stream";
-                return false;
+                return WriteResult::Disconnected;
             }
-            m_Master->WriteResponse(std::move(response));
-            return true;
+            return m_Master->TryWriteResponse(response, m_Epoch);
+        }
+
+        /**
+         * @brief Responses queued on the stream, including the one being written
+         */
+        std::size_t OutstandingWrites()
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+            return IsConnected() ? m_Master->OutstandingWrites(m_Epoch) : 0;
         }
 
         bool CancelStream()
@@ -153,6 +235,7 @@ class LifeCycleStreaming : public IContextLifeCycle
       private:
         std::recursive_mutex m_Mutex;
         LifeCycleStreaming<Request, Response>* m_Master;
+        std::uint64_t m_Epoch;
 
         friend class LifeCycleStreaming<Request, Response>;
     };
@@ -205,7 +288,9 @@ class LifeCycleStreaming : public IContextLifeCycle
     void ForwardProgress(Actions&);
 
     // User Actions
-    void WriteResponse(Response&& response);
+    WriteResult TryWriteResponse(Response& response, std::uint64_t epoch);
+    void WaitWritable(std::uint64_t epoch);
+    std::size_t OutstandingWrites(std::uint64_t epoch);
     void CloseStream(::grpc::Status);
 
     // Function pointers
@@ -217,6 +302,14 @@ class LifeCycleStreaming : public IContextLifeCycle
     std::queue<RequestType> m_RequestQueue;
     std::queue<ResponseType> m_ResponseQueue;
 
+    // Backpressure; m_Epoch counts the streams served by this context so that a ServerStream
+    // held past the end of its stream can never write to the next one
+    std::size_t m_WriteLimit;
+    WriteOverflow m_WriteOverflow;
+    bool m_WriteRefused;
+    std::uint64_t m_Epoch;
+    std::condition_variable_any m_WritableCondition;
+
     std::shared_ptr<ServerStream> m_ServerStream;
     std::weak_ptr<ServerStream> m_ExternalStream;
 
@@ -270,7 +363,9 @@ template<class Request, class Response>
 LifeCycleStreaming<Request, Response>::LifeCycleStreaming()
     : m_ReadStateContext(static_cast<IContext*>(this)),
       m_WriteStateContext(static_cast<IContext*>(this)), m_Reading(false), m_Writing(false),
-      m_Finishing(false), m_ReadsDone(false), m_WritesDone(false), m_ReadsFinished(false)
+      m_Finishing(false), m_ReadsDone(false), m_WritesDone(false), m_ReadsFinished(false),
+      m_WriteLimit(std::numeric_limits<std::size_t>::max()),
+      m_WriteOverflow(WriteOverflow::Block), m_WriteRefused(false), m_Epoch(0)
 {
     m_NextState = &LifeCycleStreaming<RequestType, ResponseType>::StateInvalid;
     m_ReadStateContext.m_NextState = &LifeCycleStreaming<RequestType, ResponseType>::StateInvalid;
@@ -291,6 +386,9 @@ void LifeCycleStreaming<Request, Response>::Reset()
         m_ReadsDone = false;
         m_WritesDone = false;
         m_ReadsFinished = false;
+        m_WriteRefused = false;
+        m_Epoch++;
+        m_WritableCondition.notify_all();
         m_RequestQueue.swap(empty_request_queue);
         m_ResponseQueue.swap(empty_response_queue);
         m_ServerStream.reset();
@@ -506,6 +604,7 @@ bool LifeCycleStreaming<Request, Response>::StateWriteDone(bool ok)
     // If write didn't go through, then the call is dead. Start reseting
 
     Actions actions;
+    std::shared_ptr<ServerStream> writable;
     {
         std::lock_guard<std::recursive_mutex> lock(m_QueueMutex);
         DLOG(INFO) << "WriteDone Event: " << (ok ? "OK" : "NOT OK");
@@ -522,9 +621,23 @@ bool LifeCycleStreaming<Request, Response>::StateWriteDone(bool ok)
         m_WriteStateContext.m_NextState =
             &LifeCycleStreaming<RequestType, ResponseType>::StateInvalid;
 
+        if(m_WriteRefused && m_ResponseQueue.size() < m_WriteLimit)
+        {
+            m_WriteRefused = false;
+            m_WritableCondition.notify_all();
+            if(!m_Status)
+            {
+                writable = m_ExternalStream.lock();
+            }
+        }
+
         actions = EvaluateState();
     }
     ForwardProgress(actions);
+    if(writable)
+    {
+        ResponsesWritable(writable);
+    }
     return true;
 }
 
@@ -555,17 +668,56 @@ void LifeCycleStreaming<Request, Response>::CancelResponse()
 }
 
 template<class Request, class Response>
-void LifeCycleStreaming<Request, Response>::WriteResponse(Response&& response)
+typename LifeCycleStreaming<Request, Response>::WriteResult
+    LifeCycleStreaming<Request, Response>::TryWriteResponse(Response& response,
+                                                            std::uint64_t epoch)
 {
     Actions actions;
     {
         std::lock_guard<std::recursive_mutex> lock(m_QueueMutex);
+        // a closing stream takes no more responses; WaitWritable returns once it closes, so
+        // a blocked writer must not be told to wait again
+        if(epoch != m_Epoch || m_Status)
+        {
+            return WriteResult::Disconnected;
+        }
+        if(m_ResponseQueue.size() >= m_WriteLimit)
+        {
+            m_WriteRefused = true;
+            return WriteResult::WouldBlock;
+        }
         DLOG(INFO) << "Queuing Response";
 
         m_ResponseQueue.push(std::move(response));
         actions = EvaluateState();
     }
     ForwardProgress(actions);
+    return WriteResult::Written;
+}
+
+template<class Request, class Response>
+void LifeCycleStreaming<Request, Response>::WaitWritable(std::uint64_t epoch)
+{
+    std::unique_lock<std::recursive_mutex> lock(m_QueueMutex);
+    m_WritableCondition.wait(lock, [this, epoch] {
+        return epoch != m_Epoch || m_Status || m_ResponseQueue.size() < m_WriteLimit;
+    });
+}
+
+template<class Request, class Response>
+std::size_t LifeCycleStreaming<Request, Response>::OutstandingWrites(std::uint64_t epoch)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_QueueMutex);
+    return epoch == m_Epoch ? m_ResponseQueue.size() : 0;
+}
+
+template<class Request, class Response>
+void LifeCycleStreaming<Request, Response>::SetWriteLimit(std::size_t max_outstanding,
+                                                          WriteOverflow overflow)
+{
+    CHECK_GT(max_outstanding, 0);
+    m_WriteLimit = max_outstanding;
+    m_WriteOverflow = overflow;
 }
 
 template<class Request, class Response>
@@ -578,6 +730,7 @@ void LifeCycleStreaming<Request, Response>::CloseStream(::grpc::Status status)
 
         m_WritesDone = true;
         m_Status = std::make_unique<::grpc::Status>(status);
+        m_WritableCondition.notify_all();
 
         if(!status.ok())
         {
@@ -25,6 +25,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <map>
+#include <string>
+
+#include <grpcpp/alarm.h>
+
 #include "nvrpc/interfaces.h"
 
 namespace nvrpc {
@@ -45,7 +50,7 @@ class LifeCycleUnary : public IContextLifeCycle
     ~LifeCycleUnary() override {}
 
   protected:
-    LifeCycleUnary() = default;
+    LifeCycleUnary() : m_DoneContext(this), m_DonePending(false), m_FinishedDone(false) {}
     void SetQueueFunc(ExecutorQueueFuncType);
 
     virtual void ExecuteRPC(RequestType& request, ResponseType& response) = 0;
@@ -53,8 +58,29 @@ class LifeCycleUnary : public IContextLifeCycle
     void FinishResponse() final override;
     void CancelResponse() final override;
 
+    // Completes the RPC with an error status instead of the response, e.g. INVALID_ARGUMENT
+    // for a request that fails validation in ExecuteRPC
+    void FinishWithError(const ::grpc::Status& status);
+
     const std::multimap<grpc::string_ref, grpc::string_ref>& ClientMetadata();
 
+    // Completion of ServerContext::AsyncNotifyWhenDone
+    class DoneContext final : public IContext
+    {
+      public:
+        DoneContext(IContext* master) : IContext(master) {}
+
+      private:
+        // IContext Methods
+        bool RunNextState(bool ok) final override
+        {
+            return static_cast<LifeCycleUnary*>(m_MasterContext)->StateDone(ok);
+        }
+        void Reset() final override { static_cast<LifeCycleUnary*>(m_MasterContext)->Reset(); }
+
+        friend class LifeCycleUnary<Request, Response>;
+    };
+
   private:
     // IContext Methods
     bool RunNextState(bool ok) final override;
@@ -63,6 +89,7 @@ class LifeCycleUnary : public IContextLifeCycle
     // LifeCycleUnary Specific Methods
     bool StateRequestDone(bool ok);
     bool StateFinishedDone(bool ok);
+    bool StateDone(bool ok);
 
     // Function pointers
     ExecutorQueueFuncType m_QueuingFunc;
@@ -74,6 +101,44 @@ class LifeCycleUnary : public IContextLifeCycle
     std::unique_ptr<::grpc::ServerContext> m_Context;
     std::unique_ptr<::grpc::ServerAsyncResponseWriter<ResponseType>> m_ResponseWriter;
 
+    // The finish and done tags may complete in either order; the Context is recycled only
+    // after both have been returned by the completion queue
+    DoneContext m_DoneContext;
+    bool m_DonePending;
+    bool m_FinishedDone;
+
+    friend class DoneContext;
+
+    // In-process calls handed to the context by a LocalClient; the request and response are
+    // owned by the caller and on_return completes the call
+    struct LocalCall
+    {
+        RequestType* request = nullptr;
+        ResponseType* response = nullptr;
+        std::map<std::string, std::string> headers;
+        std::function<void(::grpc::Status&)> on_return;
+    };
+
+    struct LocalState
+    {
+        LocalCall call;
+        std::multimap<grpc::string_ref, grpc::string_ref> metadata;
+        std::unique_ptr<::grpc::Alarm> alarm;
+        std::function<void()> recycle;
+    };
+
+    void InitializeLocal(std::function<void()> recycle);
+    bool StartLocal(LocalCall&&);
+    bool StateLocalStart(bool ok);
+    void ReturnLocal(::grpc::Status);
+    void FinishLocal(::grpc::Status);
+
+    // set on contexts owned by a LocalClient; they are never armed on the completion queue
+    std::unique_ptr<LocalState> m_Local;
+
+    template<class ContextType>
+    friend class LocalClient;
+
   public:
     template<class RequestFuncType, class ServiceType>
     static ServiceQueueFuncType BindServiceQueueFunc(
@@ -120,10 +185,19 @@ template<class Request, class Response>
 void LifeCycleUnary<Request, Response>::Reset()
 {
     OnLifeCycleReset();
+    if(m_Local)
+    {
+        m_Local->recycle();
+        return;
+    }
     m_Request = std::make_unique<RequestType>();
     m_Response = std::make_unique<ResponseType>();
     m_Context.reset(new ::grpc::ServerContext);
     m_ResponseWriter.reset(new ::grpc::ServerAsyncResponseWriter<ResponseType>(m_Context.get()));
+    m_Cancellation.Reset();
+    m_DonePending = true;
+    m_FinishedDone = false;
+    m_Context->AsyncNotifyWhenDone(m_DoneContext.IContext::Tag());
     m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateRequestDone;
     m_QueuingFunc(m_Context.get(), m_Request.get(), m_ResponseWriter.get(), IContext::Tag());
 }
@@ -132,7 +206,7 @@ template<class Request, class Response>
 const std::multimap<grpc::string_ref, grpc::string_ref>&
     LifeCycleUnary<Request, Response>::ClientMetadata()
 {
-    return m_Context->client_metadata();
+    return m_Local ? m_Local->metadata : m_Context->client_metadata();
 }
 
 template<class Request, class Response>
@@ -143,6 +217,15 @@ bool LifeCycleUnary<Request, Response>::StateRequestDone(bool ok)
         return false;
     }
     OnLifeCycleStart();
+    if(!OnLifeCycleAdmit())
+    {
+        // shed without executing; the context is recycled as soon as the status is sent
+        m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateFinishedDone;
+        m_ResponseWriter->FinishWithError(
+            ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, "concurrency limit reached"),
+            IContext::Tag());
+        return true;
+    }
     ExecuteRPC(*m_Request, *m_Response);
     return true;
 }
@@ -150,12 +233,31 @@ bool LifeCycleUnary<Request, Response>::StateRequestDone(bool ok)
 template<class Request, class Response>
 bool LifeCycleUnary<Request, Response>::StateFinishedDone(bool ok)
 {
-    return false;
+    m_FinishedDone = true;
+    return m_DonePending;
+}
+
+template<class Request, class Response>
+bool LifeCycleUnary<Request, Response>::StateDone(bool ok)
+{
+    // the rpc is over; IsCancelled is only valid after the done tag has been delivered
+    m_DonePending = false;
+    if(m_Context->IsCancelled())
+    {
+        m_Cancellation.Cancel();
+    }
+    return !m_FinishedDone;
 }
 
 template<class Request, class Response>
 void LifeCycleUnary<Request, Response>::FinishResponse()
 {
+    OnLifeCycleFinish();
+    if(m_Local)
+    {
+        FinishLocal(::grpc::Status::OK);
+        return;
+    }
     m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateFinishedDone;
     m_ResponseWriter->Finish(*m_Response, ::grpc::Status::OK, IContext::Tag());
 }
@@ -163,10 +265,98 @@ void LifeCycleUnary<Request, Response>::FinishResponse()
 template<class Request, class Response>
 void LifeCycleUnary<Request, Response>::CancelResponse()
 {
+    OnLifeCycleFinish();
+    if(m_Local)
+    {
+        FinishLocal(::grpc::Status::CANCELLED);
+        return;
+    }
     m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateFinishedDone;
     m_ResponseWriter->Finish(*m_Response, ::grpc::Status::CANCELLED, IContext::Tag());
 }
 
+template<class Request, class Response>
+void LifeCycleUnary<Request, Response>::FinishWithError(const ::grpc::Status& status)
+{
+    OnLifeCycleFinish();
+    if(m_Local)
+    {
+        FinishLocal(status);
+        return;
+    }
+    m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateFinishedDone;
+    m_ResponseWriter->FinishWithError(status, IContext::Tag());
+}
+
+template<class Request, class Response>
+void LifeCycleUnary<Request, Response>::InitializeLocal(std::function<void()> recycle)
+{
+    m_Local = std::make_unique<LocalState>();
+    m_Local->recycle = recycle;
+    // counted as armed like a context waiting on the completion queue
+    OnLifeCycleReset();
+}
+
+/**
+ * @brief Hands a call to the Executor; returns false, after completing the call with
+ * UNAVAILABLE, if the Executor is not running.  The context is not started in that case.
+ */
+template<class Request, class Response>
+bool LifeCycleUnary<Request, Response>::StartLocal(LocalCall&& call)
+{
+    m_Local->call = std::move(call);
+    m_Local->metadata.clear();
+    for(const auto& header : m_Local->call.headers)
+    {
+        m_Local->metadata.emplace(header.first, header.second);
+    }
+    m_Cancellation.Reset();
+    m_NextState = &LifeCycleUnary<RequestType, ResponseType>::StateLocalStart;
+    // an alarm is single use; the previous one has fired
+    m_Local->alarm = std::make_unique<::grpc::Alarm>();
+    if(PostToExecutor(*m_Local->alarm))
+    {
+        return true;
+    }
+    ReturnLocal(::grpc::Status(::grpc::StatusCode::UNAVAILABLE, "Executor is not running"));
+    return false;
+}
+
+template<class Request, class Response>
+bool LifeCycleUnary<Request, Response>::StateLocalStart(bool ok)
+{
+    // recycled by FinishLocal, never by the Executor
+    if(!ok)
+    {
+        FinishLocal(::grpc::Status(::grpc::StatusCode::UNAVAILABLE, "Executor is shutting down"));
+        return true;
+    }
+    OnLifeCycleStart();
+    if(!OnLifeCycleAdmit())
+    {
+        FinishLocal(
+            ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, "concurrency limit reached"));
+        return true;
+    }
+    ExecuteRPC(*m_Local->call.request, *m_Local->call.response);
+    return true;
+}
+
+template<class Request, class Response>
+void LifeCycleUnary<Request, Response>::ReturnLocal(::grpc::Status status)
+{
+    auto on_return = std::move(m_Local->call.on_return);
+    m_Local->call = LocalCall();
+    on_return(status);
+}
+
+template<class Request, class Response>
+void LifeCycleUnary<Request, Response>::FinishLocal(::grpc::Status status)
+{
+    ReturnLocal(status);
+    Reset();
+}
+
 template<class Request, class Response>
 void LifeCycleUnary<Request, Response>::SetQueueFunc(ExecutorQueueFuncType queue_fn)
 {
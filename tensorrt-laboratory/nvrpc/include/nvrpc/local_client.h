@@ -0,0 +1,260 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "nvrpc/context.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace nvrpc {
+
+/**
+ * @brief In-process client of a unary Context; no socket, HTTP/2 or protobuf serialization
+ *
+ * Owns a pool of ContextType instances built with the Resources of the gRPC path and bound to
+ * its Executor.  Each call is handed to a free context on one of the Executor's progress
+ * engines, where ExecuteRPC runs on the caller's request and response objects and
+ * FinishResponse or CancelResponse completes the call.  Calls beyond the size of the pool wait
+ * in FIFO order for a context to be recycled.  The Enqueue overloads match those of
+ * client::ClientUnary so co-located callers can swap one for the other.
+ *
+ * ClientMetadata() returns the headers passed to Enqueue and IsCancelled() is never set.
+ * Calls fail with UNAVAILABLE while the Executor is not running.  Given the ConcurrencyLimiter
+ * of the gRPC path, calls are admitted against the same limit and fail with
+ * RESOURCE_EXHAUSTED, without running ExecuteRPC, beyond it.  A LocalClient must be
+ * destroyed before its Executor; the destructor waits for outstanding calls.
+ */
+template<class ContextType>
+class LocalClient
+    : public ::trtlab::AsyncComputeWrapper<void(typename ContextType::RequestType&,
+                                                typename ContextType::ResponseType&,
+                                                ::grpc::Status&)>
+{
+  public:
+    using RequestType = typename ContextType::RequestType;
+    using ResponseType = typename ContextType::ResponseType;
+    using ResourcesType = typename ContextType::ResourcesType;
+    using Headers = std::map<std::string, std::string>;
+
+    static_assert(std::is_base_of<LifeCycleUnary<RequestType, ResponseType>, ContextType>::value,
+                  "LocalClient requires a unary Context");
+
+    LocalClient(IExecutor* executor, ResourcesType resources, int numContexts,
+                std::shared_ptr<ConcurrencyLimiter> limiter = nullptr);
+    ~LocalClient();
+
+    DELETE_COPYABILITY(LocalClient);
+    DELETE_MOVEABILITY(LocalClient);
+
+    template<typename OnReturnFn>
+    auto Enqueue(RequestType* request, ResponseType* response, OnReturnFn on_return,
+                 Headers& headers)
+    {
+        auto wrapped = this->Wrap(on_return);
+        auto future = wrapped->Future();
+        Launch(request, response, wrapped, headers);
+        return future.share();
+    }
+
+    template<typename OnReturnFn>
+    auto Enqueue(RequestType&& request, OnReturnFn on_return)
+    {
+        Headers empty_headers;
+        return Enqueue(std::move(request), on_return, empty_headers);
+    }
+
+    template<typename OnReturnFn>
+    auto Enqueue(RequestType&& request, OnReturnFn on_return, Headers& headers)
+    {
+        auto req = std::make_shared<RequestType>(std::move(request));
+        auto resp = std::make_shared<ResponseType>();
+
+        auto extended_on_return = [req, resp, on_return](RequestType& request,
+                                                         ResponseType& response,
+                                                         ::grpc::Status& status) mutable -> auto {
+            return on_return(request, response, status);
+        };
+
+        return Enqueue(req.get(), resp.get(), extended_on_return, headers);
+    }
+
+    /**
+     * @brief Enqueue variants returning a ::trtlab::AsyncFuture
+     *
+     * The result of on_return completes the AsyncFuture on the thread that finished the
+     * response, usually a progress engine of the server's Executor.
+     */
+    template<typename OnReturnFn>
+    auto EnqueueAsync(RequestType* request, ResponseType* response, OnReturnFn on_return,
+                      Headers& headers)
+    {
+        auto wrapped = this->WrapAsync(on_return);
+        auto future = wrapped->Future();
+        Launch(request, response, wrapped, headers);
+        return future;
+    }
+
+    template<typename OnReturnFn>
+    auto EnqueueAsync(RequestType&& request, OnReturnFn on_return)
+    {
+        Headers empty_headers;
+        return EnqueueAsync(std::move(request), on_return, empty_headers);
+    }
+
+    template<typename OnReturnFn>
+    auto EnqueueAsync(RequestType&& request, OnReturnFn on_return, Headers& headers)
+    {
+        auto req = std::make_shared<RequestType>(std::move(request));
+        auto resp = std::make_shared<ResponseType>();
+
+        auto extended_on_return = [req, resp, on_return](RequestType& request,
+                                                         ResponseType& response,
+                                                         ::grpc::Status& status) mutable -> auto {
+            return on_return(request, response, status);
+        };
+
+        return EnqueueAsync(req.get(), resp.get(), extended_on_return, headers);
+    }
+
+  private:
+    using LifeCycleType = LifeCycleUnary<RequestType, ResponseType>;
+    using LocalCall = typename LifeCycleType::LocalCall;
+
+    template<typename ComputeType>
+    void Launch(RequestType* request, ResponseType* response,
+                std::shared_ptr<ComputeType> wrapped, Headers& headers);
+
+    // a call on ctx completed or failed to start; start the next pending call or free ctx
+    void Recycle(LifeCycleType* ctx);
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::vector<std::unique_ptr<ContextType>> m_Contexts;
+    std::vector<LifeCycleType*> m_Free;
+    std::deque<LocalCall> m_Pending;
+    std::size_t m_Outstanding;
+};
+
+// Implementation
+
+template<class ContextType>
+LocalClient<ContextType>::LocalClient(IExecutor* executor, ResourcesType resources,
+                                      int numContexts, std::shared_ptr<ConcurrencyLimiter> limiter)
+    : m_Outstanding(0)
+{
+    CHECK_GT(numContexts, 0);
+    for(int i = 0; i < numContexts; i++)
+    {
+        auto ctx = ContextFactory<ContextType>(nullptr, resources);
+        static_cast<IContext*>(ctx.get())->m_Executor = executor;
+        static_cast<IContext*>(ctx.get())->m_Limiter = limiter;
+        LifeCycleType* base = ctx.get();
+        base->InitializeLocal([this, base] { Recycle(base); });
+        m_Free.push_back(base);
+        m_Contexts.push_back(std::move(ctx));
+    }
+}
+
+template<class ContextType>
+LocalClient<ContextType>::~LocalClient()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [this] { return m_Outstanding == 0; });
+}
+
+template<class ContextType>
+template<typename ComputeType>
+void LocalClient<ContextType>::Launch(RequestType* request, ResponseType* response,
+                                      std::shared_ptr<ComputeType> wrapped, Headers& headers)
+{
+    LocalCall call;
+    call.request = request;
+    call.response = response;
+    call.headers = headers;
+    call.on_return = [request, response, wrapped](::grpc::Status& status) mutable {
+        (*wrapped)(*request, *response, status);
+    };
+
+    LifeCycleType* ctx;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Outstanding++;
+        if(m_Free.empty())
+        {
+            m_Pending.push_back(std::move(call));
+            return;
+        }
+        ctx = m_Free.back();
+        m_Free.pop_back();
+    }
+    if(!ctx->StartLocal(std::move(call)))
+    {
+        Recycle(ctx);
+    }
+}
+
+template<class ContextType>
+void LocalClient<ContextType>::Recycle(LifeCycleType* ctx)
+{
+    // loops rather than recursing when calls fail to start, e.g. after a Shutdown
+    for(;;)
+    {
+        LocalCall next;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Outstanding--;
+            if(m_Pending.empty())
+            {
+                m_Free.push_back(ctx);
+                if(!m_Outstanding)
+                {
+                    m_Condition.notify_all();
+                }
+                return;
+            }
+            next = std::move(m_Pending.front());
+            m_Pending.pop_front();
+        }
+        if(ctx->StartLocal(std::move(next)))
+        {
+            return;
+        }
+    }
+}
+
+} // namespace nvrpc
@@ -0,0 +1,184 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <typeinfo>
+
+#include "tensorrt/laboratory/core/histogram.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace nvrpc {
+namespace metrics {
+
+/**
+ * @brief Number of shards of every Counter and Histogram
+ *
+ * Each thread records into the shard selected by its ThreadShard, so threads only contend
+ * when more than Shards threads record into the same metric.
+ */
+static constexpr int Shards = 16;
+
+int ThreadShard();
+
+/**
+ * @brief Monotonic counter sharded by thread; increments are a relaxed add on a cache line
+ * owned by the calling thread
+ */
+class Counter
+{
+  public:
+    Counter() = default;
+
+    DELETE_COPYABILITY(Counter);
+    DELETE_MOVEABILITY(Counter);
+
+    void Increment(std::uint64_t n = 1)
+    {
+        m_Shards[ThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Value() const;
+
+  private:
+    struct alignas(64) Shard
+    {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<Shard, Shards> m_Shards;
+};
+
+/**
+ * @brief ::trtlab::Histogram sharded by thread; values are durations in nanoseconds
+ */
+class Histogram
+{
+  public:
+    Histogram() = default;
+
+    DELETE_COPYABILITY(Histogram);
+    DELETE_MOVEABILITY(Histogram);
+
+    void Record(std::uint64_t ns) { m_Shards[ThreadShard()].Record(ns); }
+
+    void Record(std::chrono::nanoseconds duration) { Record((std::uint64_t)duration.count()); }
+
+    /**
+     * @brief Call fn and record how long it took, e.g. time spent blocked acquiring a resource
+     */
+    template<typename Fn>
+    auto Time(Fn&& fn) -> decltype(fn())
+    {
+        struct Timer
+        {
+            ~Timer() { histogram.Record(std::chrono::steady_clock::now() - start); }
+            Histogram& histogram;
+            std::chrono::steady_clock::time_point start;
+        } timer{*this, std::chrono::steady_clock::now()};
+        return fn();
+    }
+
+    ::trtlab::Histogram::Snapshot GetSnapshot() const;
+
+  private:
+    std::array<::trtlab::Histogram, Shards> m_Shards;
+};
+
+} // namespace metrics
+
+/**
+ * @brief Process wide registry of nvrpc metrics
+ *
+ * Built with NVRPC_METRICS_ENABLED, every Context records into the ContextMetrics of its
+ * type and every Executor counts the events it pulls from its completion queues.  Resource
+ * pool wait times are recorded by the application, e.g.
+ *
+ *     static auto& buffers_wait = Metrics::ResourceWait("buffers");
+ *     auto buffers = buffers_wait.Time([this] { return GetResources()->GetBuffers(); });
+ *
+ * Registry lookups take a lock; keep the returned references.  Scrape aggregates all shards
+ * into the Prometheus text exposition format; MetricsServer serves it over HTTP.
+ */
+class Metrics
+{
+  public:
+    struct ContextMetrics
+    {
+        metrics::Counter armed; // Reset and queued to receive a request
+        metrics::Counter started; // received a request
+        metrics::Counter completed; // reset after a request
+        metrics::Counter retired; // destroyed while armed
+        metrics::Counter abandoned; // destroyed while handling a request
+        metrics::Histogram latency; // from request received to reset
+    };
+
+    static ContextMetrics& ForContext(const std::type_info& context_type);
+    static metrics::Histogram& ResourceWait(const std::string& pool);
+    static metrics::Counter& CompletionQueueEvents();
+
+    /**
+     * @brief All metrics in the Prometheus text format, version 0.0.4
+     */
+    static std::string Scrape();
+};
+
+/**
+ * @brief Minimal HTTP/1.1 listener answering every GET with Metrics::Scrape()
+ *
+ * GET /trace answers with the sampled request spans of ::trtlab::RequestTrace as Chrome
+ * trace JSON.
+ * Serves one connection at a time on its own thread; intended for Prometheus scrapes only.
+ */
+class MetricsServer
+{
+  public:
+    /**
+     * @param port TCP port to listen on all interfaces; 0 picks a free port, see Port()
+     */
+    MetricsServer(int port);
+    ~MetricsServer();
+
+    DELETE_COPYABILITY(MetricsServer);
+    DELETE_MOVEABILITY(MetricsServer);
+
+    int Port() const { return m_Port; }
+
+  private:
+    void Serve();
+
+    int m_Socket;
+    int m_Port;
+    std::atomic<bool> m_Running;
+    std::thread m_Thread;
+};
+
+} // namespace nvrpc
@@ -0,0 +1,151 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/generic/generic_stub.h>
+
+#include "nvrpc/interfaces.h"
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace nvrpc {
+
+/**
+ * @brief Byte-level gRPC proxy on ::grpc::AsyncGenericService
+ *
+ * Every call the server does not otherwise implement is matched against the routes, in the
+ * order they were added, by method name prefix and optionally by the value of one client
+ * metadata header.  Messages are forwarded as raw ByteBuffers in both directions without being
+ * deserialized, so unary and streaming methods of any service are proxied alike.  Client
+ * metadata, the deadline, the backend's initial and trailing metadata and its status are passed
+ * through; a client cancellation cancels the backend call.  Calls without a route fail with
+ * UNIMPLEMENTED.
+ *
+ * The proxy cannot tell a unary method from a stream without its descriptor, so every call is
+ * pumped as a stream unless its method is declared with AddUnaryMethod; those are forwarded as
+ * one unary backend call, which takes a third of the completion queue round trips.
+ *
+ * Each backend may cap the number of calls in flight to it; further calls wait in FIFO order
+ * for one of them to finish.  The Proxy is also the IRPC whose contexts serve the calls:
+ *
+ *     auto proxy = server->RegisterProxy();
+ *     auto backend = proxy->AddBackend(client::CreateChannel("unix:/tmp/backend.sock"), 16);
+ *     proxy->AddRoute("/nvrpc.testing.TestService/", backend);
+ *     proxy->AddUnaryMethod("/nvrpc.testing.TestService/Unary");
+ *     executor->RegisterContexts(proxy, resources, 32);
+ *
+ * Backend calls complete on the completion queue of the Executor serving the proxied call.
+ * Routes and backends must be added before the Server is started.
+ */
+class Proxy final : public IService, public IRPC
+{
+  public:
+    using BackendId = std::size_t;
+
+    Proxy();
+    ~Proxy() override;
+
+    DELETE_COPYABILITY(Proxy);
+    DELETE_MOVEABILITY(Proxy);
+
+    /**
+     * @brief Adds a backend; max_concurrent of 0 leaves its calls in flight unbounded
+     */
+    BackendId AddBackend(std::shared_ptr<::grpc::ChannelInterface> channel,
+                         std::size_t max_concurrent = 0);
+
+    /**
+     * @brief Routes methods starting with method_prefix; an empty prefix matches every method
+     */
+    void AddRoute(const std::string& method_prefix, BackendId backend);
+
+    /**
+     * @brief Routes methods starting with method_prefix whose client metadata has the header
+     */
+    void AddRoute(const std::string& method_prefix, const std::string& header,
+                  const std::string& value, BackendId backend);
+
+    /**
+     * @brief Forwards calls to the fully qualified method, e.g. "/package.Service/Method", as
+     * unary calls; the method must take and return a single message
+     */
+    void AddUnaryMethod(const std::string& method);
+
+    /**
+     * @brief Calls in flight to a backend, not counting those waiting for it
+     */
+    std::size_t InFlight(BackendId backend);
+
+    void Initialize(::grpc::ServerBuilder&) final override;
+
+  protected:
+    std::unique_ptr<IContext> CreateContext(::grpc::ServerCompletionQueue*,
+                                            std::shared_ptr<::trtlab::Resources>) final override;
+
+  private:
+    class Call;
+
+    struct Backend
+    {
+        std::unique_ptr<::grpc::GenericStub> stub;
+        std::size_t max_concurrent;
+        std::size_t in_flight;
+        std::deque<Call*> waiting;
+        std::mutex mutex;
+    };
+
+    struct Route
+    {
+        std::string method_prefix;
+        std::string header;
+        std::string value;
+        BackendId backend;
+    };
+
+    Backend* Match(const ::grpc::GenericServerContext&);
+
+    // false if the call was queued; it is handed the slot of a finishing call
+    bool Acquire(Backend*, Call*);
+    void Release(Backend*);
+    // false if the call had already been handed a slot
+    bool Withdraw(Backend*, Call*);
+
+    ::grpc::AsyncGenericService m_Service;
+    std::vector<std::unique_ptr<Backend>> m_Backends;
+    std::vector<Route> m_Routes;
+    std::unordered_set<std::string> m_UnaryMethods;
+};
+
+} // namespace nvrpc
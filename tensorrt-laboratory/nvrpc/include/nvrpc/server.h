@@ -30,12 +30,24 @@
 
 #include <chrono>
 
+#include <sys/types.h>
+
 #include "nvrpc/service.h"
 
 namespace nvrpc {
 
 using std::chrono::milliseconds;
 
+class Proxy;
+
+/**
+ * @brief gRPC server driven by nvrpc Executors
+ *
+ * server_address is any address accepted by gRPC, e.g. "0.0.0.0:50051", or a Unix domain
+ * socket "unix:/path/to/socket" (also "unix:///path/to/socket") for co-located clients.  A
+ * stale socket file left by a server that did not shut down cleanly is removed on start, the
+ * socket is created with SetUnixSocketMode permissions and is unlinked on Shutdown.
+ */
 class Server
 {
   public:
@@ -46,6 +58,13 @@ class Server
     template<class ServiceType>
     AsyncService<typename ServiceType::AsyncService>* RegisterAsyncService();
 
+    /**
+     * @brief Serves every method not registered by a service through a byte-level Proxy
+     *
+     * gRPC allows one generic service per server, so a Proxy may only be registered once.
+     */
+    Proxy* RegisterProxy();
+
     IExecutor* RegisterExecutor(IExecutor* executor)
     {
         m_Executors.emplace_back(executor);
@@ -53,6 +72,11 @@ class Server
         return executor;
     }
 
+    /**
+     * @brief Permissions of a Unix domain socket; defaults to 0660, owner and group only
+     */
+    void SetUnixSocketMode(mode_t mode);
+
     void Run();
     void Run(milliseconds timeout, std::function<void()> control_fn);
     void AsyncStart();
@@ -67,6 +91,8 @@ class Server
     std::mutex m_Mutex;
     std::condition_variable m_Condition;
     std::string m_ServerAddress;
+    std::string m_UnixSocketPath;
+    mode_t m_UnixSocketMode;
     ::grpc::ServerBuilder m_Builder;
     std::unique_ptr<::grpc::Server> m_Server;
     std::vector<std::unique_ptr<IService>> m_Services;
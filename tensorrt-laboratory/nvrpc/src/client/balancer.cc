@@ -0,0 +1,186 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/balancer.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+namespace {
+// failures that say something about the endpoint rather than the request
+bool EndpointFailure(const ::grpc::Status& status)
+{
+    switch(status.error_code())
+    {
+        case ::grpc::StatusCode::UNAVAILABLE:
+        case ::grpc::StatusCode::UNKNOWN:
+        case ::grpc::StatusCode::INTERNAL:
+        case ::grpc::StatusCode::DEADLINE_EXCEEDED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr std::size_t kMaxEjectionMultiplier = 8;
+} // namespace
+
+Balancer::Balancer(std::size_t endpoints, Policy policy)
+    : m_Policy(policy), m_Endpoints(endpoints), m_Next(0), m_ConsecutiveFailures(5),
+      m_EjectionTime(std::chrono::seconds(1))
+{
+    CHECK_GT(endpoints, 0UL) << "Balancer requires at least one endpoint";
+}
+
+void Balancer::SetEjection(std::size_t consecutive_failures,
+                           std::chrono::milliseconds ejection_time)
+{
+    m_ConsecutiveFailures = consecutive_failures;
+    m_EjectionTime = ejection_time;
+}
+
+std::size_t Balancer::Acquire()
+{
+    auto endpoint = Pick(clock::now().time_since_epoch().count());
+    m_Endpoints[endpoint].in_flight.fetch_add(1, std::memory_order_relaxed);
+    return endpoint;
+}
+
+void Balancer::Release(std::size_t endpoint, const ::grpc::Status& status, bool observed)
+{
+    auto& state = m_Endpoints[endpoint];
+    state.in_flight.fetch_sub(1, std::memory_order_relaxed);
+    if(!observed)
+    {
+        return;
+    }
+    if(!EndpointFailure(status))
+    {
+        state.failures.store(0, std::memory_order_relaxed);
+        state.ejections.store(0, std::memory_order_relaxed);
+        return;
+    }
+    if(!m_ConsecutiveFailures ||
+       state.failures.fetch_add(1, std::memory_order_relaxed) + 1 < m_ConsecutiveFailures)
+    {
+        return;
+    }
+    // requests in flight when it was ejected fail in turn; the first one ejects it
+    state.failures.store(0, std::memory_order_relaxed);
+    auto now = clock::now();
+    if(state.ejected_until.load(std::memory_order_relaxed) > now.time_since_epoch().count())
+    {
+        return;
+    }
+    auto ejections = state.ejections.fetch_add(1, std::memory_order_relaxed) + 1;
+    ejections = std::min(ejections, kMaxEjectionMultiplier);
+    auto until = now + m_EjectionTime * static_cast<clock::rep>(ejections);
+    state.ejected_until.store(until.time_since_epoch().count(), std::memory_order_relaxed);
+    LOG(WARNING) << "Ejecting endpoint " << endpoint << " for "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count()
+                 << "ms after " << m_ConsecutiveFailures << " consecutive failures";
+}
+
+std::size_t Balancer::InFlight(std::size_t endpoint) const
+{
+    return m_Endpoints[endpoint].in_flight.load(std::memory_order_relaxed);
+}
+
+bool Balancer::Ejected(std::size_t endpoint) const
+{
+    return !Available(endpoint, clock::now().time_since_epoch().count(), false);
+}
+
+bool Balancer::Available(std::size_t endpoint, std::int64_t now, bool panic) const
+{
+    return panic || m_Endpoints[endpoint].ejected_until.load(std::memory_order_relaxed) <= now;
+}
+
+std::size_t Balancer::NextAvailable(std::size_t start, std::int64_t now) const
+{
+    for(std::size_t i = 0; i < m_Endpoints.size(); i++)
+    {
+        auto endpoint = (start + i) % m_Endpoints.size();
+        if(Available(endpoint, now, false))
+        {
+            return endpoint;
+        }
+    }
+    return start;
+}
+
+// Endpoints are ejected concurrently with Pick, so every scan falls back to panic mode on
+// its own when it finds nothing available; a pick is always a valid endpoint
+std::size_t Balancer::Pick(std::int64_t now)
+{
+    const auto size = m_Endpoints.size();
+    auto start = m_Next.fetch_add(1, std::memory_order_relaxed) % size;
+
+    if(m_Policy == Policy::RoundRobin)
+    {
+        return NextAvailable(start, now);
+    }
+
+    if(m_Policy == Policy::LeastOutstanding)
+    {
+        auto best = size;
+        for(int pass = 0; best == size; pass++)
+        {
+            bool panic = pass > 0;
+            auto least = std::numeric_limits<std::size_t>::max();
+            for(std::size_t i = 0; i < size; i++)
+            {
+                auto endpoint = (start + i) % size;
+                auto in_flight = InFlight(endpoint);
+                if(in_flight < least && Available(endpoint, now, panic))
+                {
+                    best = endpoint;
+                    least = in_flight;
+                }
+            }
+        }
+        return best;
+    }
+
+    // PowerOfTwoChoices
+    thread_local std::minstd_rand random(std::random_device{}());
+    auto first = NextAvailable(random() % size, now);
+    if(size == 1)
+    {
+        return first;
+    }
+    auto second = NextAvailable((first + 1 + random() % (size - 1)) % size, now);
+    return InFlight(second) < InFlight(first) ? second : first;
+}
+
+} // namespace client
+} // namespace nvrpc
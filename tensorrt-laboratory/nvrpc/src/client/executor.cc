@@ -29,16 +29,51 @@
 
 #include <glog/logging.h>
 
+#include <grpc/support/time.h>
+#include <grpcpp/alarm.h>
+
 using trtlab::ThreadPool;
+using trtlab::TimerWheel;
 
 namespace nvrpc {
 namespace client {
 
+namespace {
+// set on progress engine threads; timers armed there are picked up when the engine
+// recomputes its AsyncNext deadline, so no wake-up is required
+thread_local const Executor* t_ProgressEngine = nullptr;
+
+// One-shot alarm used to interrupt a progress engine blocked in AsyncNext when a timer
+// armed from a foreign thread becomes the earliest deadline
+class TimerWakeup final : public BaseContext
+{
+  public:
+    TimerWakeup(std::atomic<bool>& pending) : m_Pending(pending) {}
+    ~TimerWakeup() override {}
+
+    void Set(::grpc::CompletionQueue* cq) { m_Alarm.Set(cq, gpr_now(GPR_CLOCK_MONOTONIC), Tag()); }
+
+    bool RunNextState(bool) final override
+    {
+        m_Pending.store(false);
+        return false;
+    }
+
+    bool ExecutorShouldDeleteContext() const final override { return true; }
+
+  private:
+    ::grpc::Alarm m_Alarm;
+    std::atomic<bool>& m_Pending;
+};
+} // namespace
+
 Executor::Executor() : Executor(1) {}
 
 Executor::Executor(int numThreads) : Executor(std::make_unique<ThreadPool>(numThreads)) {}
 
-Executor::Executor(std::unique_ptr<ThreadPool> threadpool) : m_ThreadPool(std::move(threadpool))
+Executor::Executor(std::unique_ptr<ThreadPool> threadpool)
+    : m_Counter(0), m_Running(true), m_PendingTimers(0), m_WakePending(false),
+      m_ThreadPool(std::move(threadpool))
 {
     // for(decltype(m_ThreadPool->Size()) i = 0; i < m_ThreadPool->Size(); i++)
     for(auto i = 0; i < m_ThreadPool->Size(); i++)
@@ -54,6 +89,11 @@ Executor::~Executor() { ShutdownAndJoin(); }
 
 void Executor::ShutdownAndJoin()
 {
+    {
+        // no wake-up alarm may be set on a CQ after it is shutdown
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        m_Running = false;
+    }
     for(auto& cq : m_CQs)
     {
         cq->Shutdown();
@@ -65,26 +105,119 @@ void Executor::ProgressEngine(::grpc::CompletionQueue& cq)
 {
     void* tag;
     bool ok = false;
+    using NextStatus = ::grpc::CompletionQueue::NextStatus;
+    std::vector<TimerWheel::Callback> expired;
+    t_ProgressEngine = this;
 
-    while(cq.Next(&tag, &ok))
+    for(;;)
     {
-        // CHECK(ok);
-        BaseContext* ctx = BaseContext::Detag(tag);
-        if(!ctx->RunNextState(ok))
+        auto status = cq.AsyncNext(&tag, &ok, NextTimerDeadline());
+        if(status == NextStatus::SHUTDOWN)
         {
-            if(ctx->ExecutorShouldDeleteContext())
+            break;
+        }
+        if(status == NextStatus::GOT_EVENT)
+        {
+            // CHECK(ok);
+            BaseContext* ctx = BaseContext::Detag(tag);
+            if(!ctx->RunNextState(ok))
             {
-                DLOG(INFO) << "Deleting ClientContext: " << tag;
-                delete ctx;
+                if(ctx->ExecutorShouldDeleteContext())
+                {
+                    DLOG(INFO) << "Deleting ClientContext: " << tag;
+                    delete ctx;
+                }
             }
         }
+        FireTimers(expired);
     }
-    m_ThreadPool.reset();
+}
+
+Executor::TimerId Executor::ScheduleTimer(std::chrono::nanoseconds timeout,
+                                          std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    auto now = TimerWheel::clock::now();
+    auto deadline = now + timeout;
+    if(m_Timers.Empty())
+    {
+        // the progress engines skip an empty wheel; catch it up so the timer is not inserted
+        // against the tick of the last timer
+        m_Timers.Advance(now);
+    }
+    auto wake = t_ProgressEngine != this && m_Running && deadline < m_Timers.NextDeadline();
+    auto id = m_Timers.Schedule(deadline, std::move(callback));
+    m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    if(wake)
+    {
+        WakeProgressEngine();
+    }
+    return id;
+}
+
+bool Executor::CancelTimer(TimerId id)
+{
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    auto cancelled = m_Timers.Cancel(id);
+    m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    return cancelled;
+}
+
+std::chrono::system_clock::time_point Executor::NextTimerDeadline()
+{
+    using time_point = std::chrono::system_clock::time_point;
+    if(!m_PendingTimers.load(std::memory_order_relaxed))
+    {
+        return time_point::max();
+    }
+    TimerWheel::time_point next;
+    {
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        next = m_Timers.NextDeadline();
+    }
+    if(next == TimerWheel::time_point::max())
+    {
+        return time_point::max();
+    }
+    auto now = TimerWheel::clock::now();
+    auto wall = std::chrono::system_clock::now();
+    return next <= now ? wall : wall + std::chrono::duration_cast<time_point::duration>(next - now);
+}
+
+void Executor::FireTimers(std::vector<TimerWheel::Callback>& expired)
+{
+    if(!m_PendingTimers.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        m_Timers.Advance(TimerWheel::clock::now(), expired);
+        m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    }
+    // callbacks run without the lock so they can arm or cancel timers
+    for(auto& callback : expired)
+    {
+        callback();
+    }
+    expired.clear();
+}
+
+// requires m_TimerMutex; m_Running guarantees the CQ has not been shutdown
+void Executor::WakeProgressEngine()
+{
+    if(m_WakePending.exchange(true))
+    {
+        return;
+    }
+    auto wakeup = new TimerWakeup(m_WakePending);
+    wakeup->Set(m_CQs[0].get());
 }
 
 ::grpc::CompletionQueue* Executor::GetNextCQ() const
 {
-    auto idx = m_Counter % m_ThreadPool->Size();
+    // spread calls over the progress engines
+    auto idx = m_Counter.fetch_add(1, std::memory_order_relaxed) % m_CQs.size();
     return m_CQs[idx].get();
 }
 
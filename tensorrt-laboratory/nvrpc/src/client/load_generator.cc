@@ -0,0 +1,226 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <glog/logging.h>
+
+using trtlab::Histogram;
+
+namespace nvrpc {
+namespace client {
+
+namespace {
+using clock = std::chrono::steady_clock;
+
+std::uint64_t Nanoseconds(clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+// shared with the completions, which may outlive Run when the drain times out
+struct RunState
+{
+    RunState() : sent(0), completed(0), errors(0), last_completion(0) {}
+
+    clock::time_point start;
+    clock::time_point recording;
+    Histogram latency;
+    Histogram service_time;
+    std::atomic<std::uint64_t> sent;
+    std::atomic<std::uint64_t> completed;
+    std::atomic<std::uint64_t> errors;
+    std::atomic<std::uint64_t> last_completion; // ns since start
+
+    void Complete(bool ok, clock::time_point intended, clock::time_point sent_at)
+    {
+        auto now = clock::now();
+        if(ok && intended >= recording)
+        {
+            latency.Record(Nanoseconds(now - intended));
+            service_time.Record(Nanoseconds(now - sent_at));
+        }
+        auto since_start = Nanoseconds(now - start);
+        auto last = last_completion.load(std::memory_order_relaxed);
+        while(since_start > last &&
+              !last_completion.compare_exchange_weak(last, since_start, std::memory_order_relaxed))
+        {
+        }
+        // counted last; Run drains on the counts
+        (ok ? completed : errors).fetch_add(1, std::memory_order_release);
+    }
+};
+
+// sleeps while far from the deadline, then yields; never returns early
+void WaitUntil(clock::time_point deadline)
+{
+    constexpr auto slack = std::chrono::microseconds(100);
+    auto now = clock::now();
+    if(deadline - now > 2 * slack)
+    {
+        std::this_thread::sleep_until(deadline - slack);
+    }
+    while(clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void Sender(int thread, const LoadGenerator::Options& options,
+            const std::vector<std::shared_ptr<LoadTarget>>& targets,
+            const std::shared_ptr<RunState>& state)
+{
+    const bool poisson = options.arrivals == LoadGenerator::Arrivals::Poisson;
+    const double period = options.threads / options.rate;
+    std::mt19937_64 rng(options.seed + thread);
+    std::exponential_distribution<double> gap(1.0 / period);
+
+    // the threads' schedules are interleaved; each owns 1/threads of the rate
+    double offset = poisson ? gap(rng) : thread * period / options.threads;
+    auto end = state->start + options.duration;
+    for(std::uint64_t i = 0;; i++)
+    {
+        auto intended = state->start + std::chrono::duration_cast<clock::duration>(
+                                           std::chrono::duration<double>(offset));
+        if(intended >= end)
+        {
+            break;
+        }
+        WaitUntil(intended);
+        auto sent_at = clock::now();
+        auto& target = targets[(i * options.threads + thread) % targets.size()];
+        state->sent.fetch_add(1, std::memory_order_relaxed);
+        target->Send([state, intended, sent_at](bool ok) { state->Complete(ok, intended, sent_at); });
+        offset += poisson ? gap(rng) : period;
+    }
+}
+
+void WriteLatency(std::ostream& os, const Histogram::Snapshot& snapshot)
+{
+    auto us = [](double ns) { return ns / 1000.0; };
+    os << "{\"count\": " << snapshot.count << ", \"mean\": " << us(snapshot.Mean())
+       << ", \"p50\": " << us(snapshot.Percentile(50)) << ", \"p90\": "
+       << us(snapshot.Percentile(90)) << ", \"p99\": " << us(snapshot.Percentile(99))
+       << ", \"p999\": " << us(snapshot.Percentile(99.9)) << ", \"max\": " << us(snapshot.max)
+       << "}";
+}
+} // namespace
+
+LoadGenerator::LoadGenerator(Options options) : m_Options(options)
+{
+    CHECK_GT(m_Options.rate, 0.0);
+    CHECK_GT(m_Options.threads, 0);
+}
+
+LoadGenerator::Arrivals LoadGenerator::ArrivalsFromString(const std::string& name)
+{
+    if(name == "constant")
+    {
+        return Arrivals::Constant;
+    }
+    if(name == "poisson")
+    {
+        return Arrivals::Poisson;
+    }
+    LOG(FATAL) << "arrivals must be constant or poisson; got " << name;
+    return Arrivals::Poisson;
+}
+
+LoadGenerator::Report LoadGenerator::Run(const std::vector<std::shared_ptr<LoadTarget>>& targets)
+{
+    CHECK(!targets.empty()) << "LoadGenerator needs at least one target";
+    auto state = std::make_shared<RunState>();
+    // every thread starts from the same origin
+    state->start = clock::now() + std::chrono::milliseconds(1);
+    state->recording = state->start + m_Options.warmup;
+
+    std::vector<std::thread> senders;
+    for(int i = 0; i < m_Options.threads; i++)
+    {
+        senders.emplace_back(Sender, i, std::cref(m_Options), std::cref(targets), state);
+    }
+    for(auto& sender : senders)
+    {
+        sender.join();
+    }
+
+    auto sent = state->sent.load();
+    auto deadline = clock::now() + m_Options.drain;
+    while(state->completed.load(std::memory_order_acquire) +
+                  state->errors.load(std::memory_order_acquire) <
+              sent &&
+          clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for(auto& target : targets)
+    {
+        target->Finish();
+    }
+
+    Report report;
+    report.arrivals = m_Options.arrivals;
+    report.offered_rate = m_Options.rate;
+    report.sent = sent;
+    report.completed = state->completed.load(std::memory_order_acquire);
+    report.errors = state->errors.load(std::memory_order_acquire);
+    report.outstanding = sent - std::min(sent, report.completed + report.errors);
+    auto last = std::max(state->last_completion.load(), Nanoseconds(m_Options.duration));
+    report.elapsed = last / 1e9;
+    report.achieved_rate = report.completed / report.elapsed;
+    report.latency = state->latency.GetSnapshot();
+    report.service_time = state->service_time.GetSnapshot();
+    return report;
+}
+
+std::string LoadGenerator::Report::ToJSON() const
+{
+    std::ostringstream os;
+    os << "{\n  \"arrivals\": \""
+       << (arrivals == Arrivals::Constant ? "constant" : "poisson") << "\",\n"
+       << "  \"offered_rate\": " << offered_rate << ",\n"
+       << "  \"achieved_rate\": " << achieved_rate << ",\n"
+       << "  \"elapsed_s\": " << elapsed << ",\n"
+       << "  \"sent\": " << sent << ",\n"
+       << "  \"completed\": " << completed << ",\n"
+       << "  \"errors\": " << errors << ",\n"
+       << "  \"outstanding\": " << outstanding << ",\n"
+       << "  \"latency_us\": ";
+    WriteLatency(os, latency);
+    os << ",\n  \"service_time_us\": ";
+    WriteLatency(os, service_time);
+    os << "\n}\n";
+    return os.str();
+}
+
+} // namespace client
+} // namespace nvrpc
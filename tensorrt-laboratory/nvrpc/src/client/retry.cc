@@ -0,0 +1,76 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/retry.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+RetryBudget::RetryBudget(double ratio, double max_tokens)
+    : m_Ratio(static_cast<std::int64_t>(ratio * Scale)),
+      m_MaxTokens(static_cast<std::int64_t>(max_tokens * Scale)), m_Tokens(m_MaxTokens),
+      m_Withdrawn(0), m_Refused(0)
+{
+    CHECK_GE(ratio, 0.0);
+    CHECK_GE(max_tokens, 1.0) << "a budget below one token never grants an attempt";
+}
+
+void RetryBudget::Deposit()
+{
+    auto tokens = m_Tokens.load(std::memory_order_relaxed);
+    while(tokens < m_MaxTokens &&
+          !m_Tokens.compare_exchange_weak(tokens, std::min(tokens + m_Ratio, m_MaxTokens),
+                                          std::memory_order_relaxed))
+    {
+    }
+}
+
+bool RetryBudget::Withdraw()
+{
+    auto tokens = m_Tokens.load(std::memory_order_relaxed);
+    do
+    {
+        if(tokens < Scale)
+        {
+            m_Refused.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while(!m_Tokens.compare_exchange_weak(tokens, tokens - Scale, std::memory_order_relaxed));
+    m_Withdrawn.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+double RetryBudget::Tokens() const
+{
+    return static_cast<double>(m_Tokens.load(std::memory_order_relaxed)) / Scale;
+}
+
+} // namespace client
+} // namespace nvrpc
@@ -0,0 +1,132 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/concurrency_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+
+ConcurrencyLimiter::ConcurrencyLimiter() : ConcurrencyLimiter(Options()) {}
+
+ConcurrencyLimiter::ConcurrencyLimiter(Options options)
+    : m_Options(options), m_Limit(options.initial_limit), m_InFlight(0), m_Rejected(0),
+      m_Estimate(options.initial_limit), m_Baseline(0), m_WindowSum(0), m_WindowSamples(0),
+      m_WindowMaxInFlight(0), m_Windows(0), m_ProbeLimit(0)
+{
+    CHECK_GE(options.min_limit, 1UL);
+    CHECK_LE(options.min_limit, options.initial_limit);
+    CHECK_LE(options.initial_limit, options.max_limit);
+    CHECK_GE(options.window, 1UL);
+    CHECK_GE(options.tolerance, 1.0);
+}
+
+bool ConcurrencyLimiter::TryAcquire()
+{
+    auto in_flight = m_InFlight.load(std::memory_order_relaxed);
+    do
+    {
+        if(in_flight >= m_Limit.load(std::memory_order_relaxed))
+        {
+            m_Rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while(!m_InFlight.compare_exchange_weak(in_flight, in_flight + 1,
+                                              std::memory_order_relaxed));
+    return true;
+}
+
+void ConcurrencyLimiter::Release(std::chrono::nanoseconds latency)
+{
+    auto in_flight = m_InFlight.fetch_sub(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_WindowSum += std::chrono::duration<double>(latency).count();
+    m_WindowMaxInFlight = std::max(m_WindowMaxInFlight, in_flight);
+    if(++m_WindowSamples < m_Options.window)
+    {
+        return;
+    }
+    Update(m_WindowSum / m_WindowSamples, m_WindowMaxInFlight);
+    m_WindowSum = 0;
+    m_WindowSamples = 0;
+    m_WindowMaxInFlight = 0;
+}
+
+void ConcurrencyLimiter::Update(double latency, std::size_t max_in_flight)
+{
+    // a probe lasts until the queue admitted before it has drained and a window ran within
+    // the probe limit; that window re-measures the baseline, up or down, and the estimate
+    // from before the probe is restored
+    if(m_ProbeLimit)
+    {
+        if(max_in_flight <= m_ProbeLimit)
+        {
+            m_Baseline = latency;
+            m_ProbeLimit = 0;
+            m_Limit.store(static_cast<std::size_t>(m_Estimate), std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // follows a faster window at once and a slower one within tolerance only gradually; a
+    // queued window is never folded in, so a sustained overload cannot pass itself off as
+    // the latency of an idle service
+    if(m_Baseline == 0 || latency < m_Baseline)
+    {
+        m_Baseline = latency;
+    }
+    else if(latency <= m_Options.tolerance * m_Baseline)
+    {
+        m_Baseline += (latency - m_Baseline) * 2.0 / (m_Options.baseline_windows + 1);
+    }
+
+    // a limit the load does not use says nothing about the latency it would cause
+    if(max_in_flight < m_Estimate / 2)
+    {
+        return;
+    }
+
+    // halve the limit now and then so the queue drains and the baseline can find the
+    // latency of a lighter load
+    if(m_Options.probe_windows && ++m_Windows % m_Options.probe_windows == 0)
+    {
+        m_ProbeLimit = std::max(static_cast<std::size_t>(m_Estimate / 2), m_Options.min_limit);
+        m_Limit.store(m_ProbeLimit, std::memory_order_relaxed);
+        return;
+    }
+
+    auto gradient = std::clamp(m_Options.tolerance * m_Baseline / latency, 0.5, 1.0);
+    auto target = m_Estimate * gradient + std::sqrt(m_Estimate);
+    m_Estimate = m_Estimate * (1 - m_Options.smoothing) + target * m_Options.smoothing;
+    m_Estimate = std::clamp(m_Estimate, static_cast<double>(m_Options.min_limit),
+                            static_cast<double>(m_Options.max_limit));
+    m_Limit.store(static_cast<std::size_t>(m_Estimate), std::memory_order_relaxed);
+}
+
+} // namespace nvrpc
@@ -25,24 +25,61 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "nvrpc/executor.h"
+#include "tensorrt/laboratory/core/trace.h"
+
+#ifdef NVRPC_METRICS_ENABLED
+#include "nvrpc/metrics.h"
+#endif
 
 #include <glog/logging.h>
 
 #include <grpc/support/time.h>
+#include <grpcpp/alarm.h>
 #include <grpcpp/support/time.h>
 
+using trtlab::RequestTrace;
 using trtlab::ThreadPool;
+using trtlab::TimerWheel;
 
 namespace nvrpc {
 
+namespace {
+// set on progress engine threads; timers armed there are picked up when the engine
+// recomputes its AsyncNext deadline, so no wake-up is required
+thread_local const Executor* t_ProgressEngine = nullptr;
+
+// One-shot alarm used to interrupt a progress engine blocked in AsyncNext when a timer
+// armed from a foreign thread becomes the earliest deadline
+class TimerWakeup final : public IContext
+{
+  public:
+    TimerWakeup(std::atomic<bool>& pending) : m_Pending(pending) {}
+    ~TimerWakeup() override {}
+
+    void Set(::grpc::CompletionQueue* cq) { m_Alarm.Set(cq, gpr_now(GPR_CLOCK_MONOTONIC), Tag()); }
+
+  private:
+    bool RunNextState(bool) final override
+    {
+        m_Pending.store(false);
+        delete this;
+        return true;
+    }
+    void Reset() final override {}
+
+    ::grpc::Alarm m_Alarm;
+    std::atomic<bool>& m_Pending;
+};
+} // namespace
+
 Executor::Executor() : Executor(1) {}
 
 Executor::Executor(int numThreads) : Executor(std::make_unique<ThreadPool>(numThreads)) {}
 
 Executor::Executor(std::unique_ptr<ThreadPool> threadpool)
-    : IExecutor(), m_ThreadPool(std::move(threadpool)), m_Running(false)
+    : IExecutor(), m_ThreadPool(std::move(threadpool)), m_Running(false), m_PendingTimers(0),
+      m_WakePending(false), m_NextPostQueue(0)
 {
-    m_TimeoutCallback = [] {};
 }
 
 void Executor::ProgressEngine(int thread_id)
@@ -51,25 +88,139 @@ void Executor::ProgressEngine(int thread_id)
     void* tag;
     auto myCQ = m_ServerCompletionQueues[thread_id].get();
     using NextStatus = ::grpc::ServerCompletionQueue::NextStatus;
-    m_Running = true;
+    std::vector<TimerWheel::Callback> expired;
+    t_ProgressEngine = this;
+#ifdef NVRPC_METRICS_ENABLED
+    auto& cq_events = Metrics::CompletionQueueEvents();
+#endif
 
-    while(myCQ->Next(&tag, &ok))
+    for(;;)
     {
-        auto ctx = IContext::Detag(tag);
-        if(!RunContext(ctx, ok))
+        auto status = myCQ->AsyncNext(&tag, &ok, NextTimerDeadline());
+        if(status == NextStatus::SHUTDOWN)
+        {
+            break;
+        }
+        if(status == NextStatus::GOT_EVENT)
         {
-            if(m_Running)
+#ifdef NVRPC_METRICS_ENABLED
+            cq_events.Increment();
+#endif
+            auto ctx = IContext::Detag(tag);
+            if(!RunContext(ctx, ok))
             {
-                ResetContext(ctx);
+                std::shared_lock<std::shared_mutex> lock(m_ResetMutex);
+                if(m_Running)
+                {
+                    ResetContext(ctx);
+                }
             }
+            // set by contexts starting a sampled request
+            RequestTrace::SetCurrent(0);
         }
+        FireTimers(expired);
     }
 }
 
+Executor::TimerId Executor::ScheduleTimer(std::chrono::nanoseconds timeout,
+                                          std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    auto now = TimerWheel::clock::now();
+    auto deadline = now + timeout;
+    if(m_Timers.Empty())
+    {
+        // the progress engines skip an empty wheel; catch it up so the timer is not inserted
+        // against the tick of the last timer
+        m_Timers.Advance(now);
+    }
+    auto wake = t_ProgressEngine != this && m_Running && deadline < m_Timers.NextDeadline();
+    auto id = m_Timers.Schedule(deadline, std::move(callback));
+    m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    if(wake)
+    {
+        WakeProgressEngine();
+    }
+    return id;
+}
+
+bool Executor::CancelTimer(TimerId id)
+{
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    auto cancelled = m_Timers.Cancel(id);
+    m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    return cancelled;
+}
+
+bool Executor::Post(::grpc::Alarm& alarm, void* tag)
+{
+    // spread posted work over the progress engines
+    auto i = m_NextPostQueue.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    if(!m_Running)
+    {
+        return false;
+    }
+    // a deadline in the past completes the alarm immediately; gpr_now is rounded up to the
+    // millisecond resolution of gRPC's timers
+    alarm.Set(m_ServerCompletionQueues[i % m_ServerCompletionQueues.size()].get(),
+              gpr_inf_past(GPR_CLOCK_MONOTONIC), tag);
+    return true;
+}
+
 void Executor::SetTimeout(time_point deadline, std::function<void()> callback)
 {
-    m_TimeoutDeadline = deadline;
-    m_TimeoutCallback = callback;
+    ScheduleTimer(deadline - std::chrono::system_clock::now(), callback);
+}
+
+Executor::time_point Executor::NextTimerDeadline()
+{
+    if(!m_PendingTimers.load(std::memory_order_relaxed))
+    {
+        return time_point::max();
+    }
+    TimerWheel::time_point next;
+    {
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        next = m_Timers.NextDeadline();
+    }
+    if(next == TimerWheel::time_point::max())
+    {
+        return time_point::max();
+    }
+    auto now = TimerWheel::clock::now();
+    auto wall = std::chrono::system_clock::now();
+    return next <= now ? wall : wall + std::chrono::duration_cast<time_point::duration>(next - now);
+}
+
+void Executor::FireTimers(std::vector<TimerWheel::Callback>& expired)
+{
+    if(!m_PendingTimers.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        m_Timers.Advance(TimerWheel::clock::now(), expired);
+        m_PendingTimers.store(m_Timers.Size(), std::memory_order_relaxed);
+    }
+    // callbacks run without the lock so they can arm or cancel timers
+    for(auto& callback : expired)
+    {
+        callback();
+    }
+    expired.clear();
+}
+
+// requires m_TimerMutex; m_Running guarantees the CQ has not been shutdown
+void Executor::WakeProgressEngine()
+{
+    if(m_WakePending.exchange(true))
+    {
+        return;
+    }
+    auto wakeup = new TimerWakeup(m_WakePending);
+    wakeup->Set(m_ServerCompletionQueues[0].get());
 }
 
 } // namespace nvrpc
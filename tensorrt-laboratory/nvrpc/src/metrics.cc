@@ -0,0 +1,370 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/metrics.h"
+
+#include <arpa/inet.h>
+#include <cxxabi.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/trace.h"
+
+namespace nvrpc {
+namespace metrics {
+
+int ThreadShard()
+{
+    static std::atomic<int> next(0);
+    thread_local int shard = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+    return shard;
+}
+
+std::uint64_t Counter::Value() const
+{
+    std::uint64_t value = 0;
+    for(const auto& shard : m_Shards)
+    {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+::trtlab::Histogram::Snapshot Histogram::GetSnapshot() const
+{
+    ::trtlab::Histogram::Snapshot snapshot;
+    for(const auto& shard : m_Shards)
+    {
+        snapshot += shard.GetSnapshot();
+    }
+    return snapshot;
+}
+
+} // namespace metrics
+
+namespace {
+struct Registry
+{
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Metrics::ContextMetrics>> contexts;
+    std::map<std::string, std::unique_ptr<metrics::Histogram>> resource_waits;
+    metrics::Counter cq_events;
+
+    // CQ event rate between consecutive scrapes
+    std::uint64_t last_cq_events = 0;
+    std::chrono::steady_clock::time_point last_scrape = std::chrono::steady_clock::now();
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+std::string Demangle(const std::type_info& type)
+{
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> name(
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+    return status == 0 ? name.get() : type.name();
+}
+
+std::string EscapeLabel(const std::string& value)
+{
+    std::string escaped;
+    for(auto c : value)
+    {
+        if(c == '\\' || c == '"')
+        {
+            escaped += '\\';
+        }
+        escaped += (c == '\n') ? 'n' : c;
+    }
+    return escaped;
+}
+
+// Prometheus histograms have cumulative, fixed buckets; these are re-binned from the
+// log-linear buckets of ::trtlab::Histogram
+constexpr double BucketBounds[] = {50e-6, 100e-6, 250e-6, 500e-6, 1e-3, 2.5e-3, 5e-3,  10e-3,
+                                   25e-3, 50e-3,  100e-3, 250e-3, 500e-3, 1.0, 2.5,  5.0, 10.0};
+
+void WriteHistogram(std::ostream& os, const std::string& name, const std::string& labels,
+                    const ::trtlab::Histogram::Snapshot& snapshot)
+{
+    std::uint64_t cumulative = 0;
+    int index = 0;
+    for(auto bound : BucketBounds)
+    {
+        auto bound_ns = (std::uint64_t)(bound * 1e9);
+        for(; index < ::trtlab::Histogram::Buckets &&
+              ::trtlab::Histogram::BucketUpperBound(index) <= bound_ns;
+            index++)
+        {
+            cumulative += snapshot.buckets[index];
+        }
+        os << name << "_bucket{" << labels << ",le=\"" << bound << "\"} " << cumulative << "\n";
+    }
+    os << name << "_bucket{" << labels << ",le=\"+Inf\"} " << snapshot.count << "\n";
+    os << name << "_sum{" << labels << "} " << (double)snapshot.sum * 1e-9 << "\n";
+    os << name << "_count{" << labels << "} " << snapshot.count << "\n";
+}
+
+void WriteHeader(std::ostream& os, const char* name, const char* type, const char* help)
+{
+    os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+} // namespace
+
+Metrics::ContextMetrics& Metrics::ForContext(const std::type_info& context_type)
+{
+    auto name = Demangle(context_type);
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto& metrics = registry.contexts[name];
+    if(!metrics)
+    {
+        metrics = std::make_unique<ContextMetrics>();
+    }
+    return *metrics;
+}
+
+metrics::Histogram& Metrics::ResourceWait(const std::string& pool)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto& histogram = registry.resource_waits[pool];
+    if(!histogram)
+    {
+        histogram = std::make_unique<metrics::Histogram>();
+    }
+    return *histogram;
+}
+
+metrics::Counter& Metrics::CompletionQueueEvents() { return GetRegistry().cq_events; }
+
+std::string Metrics::Scrape()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::ostringstream os;
+
+    // a context moves armed -> started -> completed -> armed, or is retired or abandoned when
+    // destroyed; counters are read in the reverse order so the gauges never go negative
+    struct ContextCounts
+    {
+        std::string labels;
+        std::uint64_t completed, in_flight, idle;
+    };
+    std::vector<ContextCounts> counts;
+    for(const auto& entry : registry.contexts)
+    {
+        const auto& m = *entry.second;
+        auto completed = m.completed.Value();
+        auto started = m.started.Value();
+        auto armed = m.armed.Value();
+        auto ended = completed + m.abandoned.Value();
+        auto in_flight = started > ended ? started - ended : 0;
+        auto parked = started + m.retired.Value();
+        auto idle = armed > parked ? armed - parked : 0;
+        counts.push_back(
+            {"context=\"" + EscapeLabel(entry.first) + "\"", completed, in_flight, idle});
+    }
+
+    WriteHeader(os, "nvrpc_requests_total", "counter", "Requests completed by a context type");
+    for(const auto& c : counts)
+    {
+        os << "nvrpc_requests_total{" << c.labels << "} " << c.completed << "\n";
+    }
+    WriteHeader(os, "nvrpc_contexts_in_flight", "gauge",
+                "Contexts that received a request and have not been reset");
+    for(const auto& c : counts)
+    {
+        os << "nvrpc_contexts_in_flight{" << c.labels << "} " << c.in_flight << "\n";
+    }
+    WriteHeader(os, "nvrpc_contexts_idle", "gauge",
+                "Contexts armed on a completion queue waiting for a request");
+    for(const auto& c : counts)
+    {
+        os << "nvrpc_contexts_idle{" << c.labels << "} " << c.idle << "\n";
+    }
+    WriteHeader(os, "nvrpc_request_duration_seconds", "histogram",
+                "Time from a request being received to its context being reset");
+    for(const auto& entry : registry.contexts)
+    {
+        WriteHistogram(os, "nvrpc_request_duration_seconds",
+                       "context=\"" + EscapeLabel(entry.first) + "\"",
+                       entry.second->latency.GetSnapshot());
+    }
+
+    WriteHeader(os, "nvrpc_resource_wait_seconds", "histogram",
+                "Time spent blocked acquiring a resource from a pool");
+    for(const auto& entry : registry.resource_waits)
+    {
+        WriteHistogram(os, "nvrpc_resource_wait_seconds",
+                       "pool=\"" + EscapeLabel(entry.first) + "\"", entry.second->GetSnapshot());
+    }
+
+    auto events = registry.cq_events.Value();
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double>(now - registry.last_scrape).count();
+    auto rate = elapsed > 0 ? (events - registry.last_cq_events) / elapsed : 0.0;
+    registry.last_cq_events = events;
+    registry.last_scrape = now;
+    WriteHeader(os, "nvrpc_cq_events_total", "counter",
+                "Events pulled from server completion queues");
+    os << "nvrpc_cq_events_total " << events << "\n";
+    WriteHeader(os, "nvrpc_cq_events_per_second", "gauge",
+                "Completion queue event rate since the previous scrape");
+    os << "nvrpc_cq_events_per_second " << rate << "\n";
+
+    return os.str();
+}
+
+// MetricsServer
+
+MetricsServer::MetricsServer(int port) : m_Running(true)
+{
+    m_Socket = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_NE(m_Socket, -1) << "Unable to create metrics socket";
+    int reuse = 1;
+    setsockopt(m_Socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    CHECK_EQ(bind(m_Socket, (sockaddr*)&addr, sizeof(addr)), 0)
+        << "Unable to bind metrics port " << port;
+    CHECK_EQ(listen(m_Socket, 16), 0);
+
+    socklen_t len = sizeof(addr);
+    CHECK_EQ(getsockname(m_Socket, (sockaddr*)&addr, &len), 0);
+    m_Port = ntohs(addr.sin_port);
+    LOG(INFO) << "Serving nvrpc metrics on port " << m_Port;
+
+    m_Thread = std::thread([this] { Serve(); });
+}
+
+MetricsServer::~MetricsServer()
+{
+    m_Running = false;
+    // unblocks accept
+    shutdown(m_Socket, SHUT_RDWR);
+    m_Thread.join();
+    close(m_Socket);
+}
+
+void MetricsServer::Serve()
+{
+    // persistent errors, e.g. EMFILE, are retried after a growing pause instead of spinning
+    constexpr auto min_backoff = std::chrono::milliseconds(10);
+    constexpr auto max_backoff = std::chrono::milliseconds(250);
+    auto backoff = min_backoff;
+    while(m_Running)
+    {
+        int connection = accept(m_Socket, nullptr, nullptr);
+        if(connection == -1)
+        {
+            auto error = errno;
+            // shutdown of the listening socket fails accept with EINVAL
+            if(!m_Running || error == EINVAL || error == EBADF || error == ENOTSOCK)
+            {
+                break;
+            }
+            if(error != EINTR)
+            {
+                LOG(WARNING) << "metrics accept failed: " << std::strerror(error) << "; retrying in "
+                             << backoff.count() << "ms";
+                std::this_thread::sleep_for(backoff);
+                backoff = std::min(2 * backoff, max_backoff);
+            }
+            continue;
+        }
+        backoff = min_backoff;
+
+        // a stalled client must not block scrapes forever
+        timeval timeout{1, 0};
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buffer[1024];
+        while(request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+        {
+            auto n = read(connection, buffer, sizeof(buffer));
+            if(n <= 0) break;
+            request.append(buffer, n);
+        }
+
+        std::string status = "200 OK";
+        std::string content_type = "text/plain; version=0.0.4";
+        std::string body;
+        if(request.compare(0, 11, "GET /trace ") == 0)
+        {
+            std::ostringstream trace;
+            ::trtlab::RequestTrace::WriteChromeTrace(trace);
+            body = trace.str();
+            content_type = "application/json";
+        }
+        else if(request.compare(0, 4, "GET ") == 0)
+        {
+            body = Metrics::Scrape();
+        }
+        else
+        {
+            status = "405 Method Not Allowed";
+        }
+        std::ostringstream response;
+        response << "HTTP/1.1 " << status << "\r\n"
+                 << "Content-Type: " << content_type << "\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+        auto payload = response.str();
+        for(size_t sent = 0; sent < payload.size();)
+        {
+            auto n = send(connection, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+            if(n <= 0) break;
+            sent += n;
+        }
+        close(connection);
+    }
+}
+
+} // namespace nvrpc
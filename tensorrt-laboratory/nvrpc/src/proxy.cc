@@ -0,0 +1,527 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/proxy.h"
+
+#include <grpc/support/time.h>
+#include <grpcpp/alarm.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+
+namespace {
+// headers owned by the transport of each hop
+bool Forwarded(const ::grpc::string_ref& key)
+{
+    return !key.starts_with(":") && !key.starts_with("grpc-") && key != "user-agent" &&
+           key != "content-type" && key != "te";
+}
+
+std::string ToString(const ::grpc::string_ref& ref) { return std::string(ref.data(), ref.size()); }
+} // namespace
+
+/**
+ * @brief One proxied call; the server side of a generic call paired with a call to a backend
+ *
+ * Requests are pumped upstream (server Read, backend Write) and responses downstream (backend
+ * Read, server Write) independently, each with at most one operation outstanding.  A call to a
+ * unary method reads its request, makes one unary backend call and writes the response along
+ * with the status.  Every
+ * operation completes on this call's completion queue, so a Call is only ever touched by one
+ * progress engine; the backend's wait queue is the exception, and hands the call its slot by
+ * setting an alarm on that queue.  The call is recycled once its last operation completes.
+ */
+class Proxy::Call final : public IContext
+{
+  public:
+    Call(Proxy* proxy, ::grpc::ServerCompletionQueue* cq);
+    ~Call() override {}
+
+    // an alarm initializes the gRPC library, so one is only made for calls that wait
+    void Arm() { m_Alarm = std::make_unique<::grpc::Alarm>(); }
+
+    // deliver the slot of a finished call; invoked from any thread
+    void Wake() { m_Alarm->Set(m_CQ, gpr_inf_past(GPR_CLOCK_MONOTONIC), m_WokenOp.Tag()); }
+
+  private:
+    using Handler = void (Call::*)(bool);
+
+    class Operation final : public IContext
+    {
+      public:
+        Operation(Call* call, Handler handler) : IContext(call), m_Handler(handler) {}
+        ~Operation() override {}
+
+        void* Tag() { return IContext::Tag(); }
+
+      private:
+        bool RunNextState(bool ok) final override
+        {
+            return static_cast<Call*>(m_MasterContext)->Complete(m_Handler, ok);
+        }
+        void Reset() final override { static_cast<Call*>(m_MasterContext)->Reset(); }
+
+        Handler m_Handler;
+    };
+
+    // IContext Methods
+    bool RunNextState(bool ok) final override { return Complete(&Call::StateRequested, ok); }
+    void Reset() final override;
+
+    // runs the handler of a completed operation; false once nothing is outstanding
+    bool Complete(Handler, bool ok);
+    void* Issue(Operation& op)
+    {
+        ++m_Pending;
+        return op.Tag();
+    }
+
+    void StateRequested(bool ok);
+    void StateWoken(bool ok);
+    void StateStarted(bool ok);
+    void StateUpstreamRead(bool ok);
+    void StateUpstreamWritten(bool ok);
+    void StateUpstreamClosed(bool ok) {}
+    void StateDownstreamRead(bool ok);
+    void StateDownstreamWritten(bool ok);
+    void StateClientFinished(bool ok);
+    void StateServerFinished(bool ok) {}
+    void StateDone(bool ok);
+
+    void StartBackend();
+    void ReadUpstream();
+    void ReadDownstream();
+    void FinishClient();
+    void ForwardInitialMetadata();
+    void FinishServer(const ::grpc::Status&);
+
+    Proxy* m_Proxy;
+    ::grpc::ServerCompletionQueue* m_CQ;
+    Backend* m_Backend;
+    int m_Pending;
+    bool m_Unary;
+    bool m_Waiting;
+    bool m_Done;
+    bool m_ClientFinishing;
+    bool m_ServerFinishing;
+    bool m_InitialMetadataForwarded;
+
+    std::unique_ptr<::grpc::GenericServerContext> m_ServerContext;
+    std::unique_ptr<::grpc::GenericServerAsyncReaderWriter> m_ServerStream;
+    std::unique_ptr<::grpc::ClientContext> m_ClientContext;
+    std::unique_ptr<::grpc::GenericClientAsyncReaderWriter> m_ClientCall;
+    std::unique_ptr<::grpc::GenericClientAsyncResponseReader> m_UnaryCall;
+    std::unique_ptr<::grpc::Alarm> m_Alarm;
+    ::grpc::ByteBuffer m_Upstream;
+    ::grpc::ByteBuffer m_Downstream;
+    ::grpc::Status m_Status;
+
+    Operation m_WokenOp;
+    Operation m_StartedOp;
+    Operation m_UpstreamReadOp;
+    Operation m_UpstreamWrittenOp;
+    Operation m_UpstreamClosedOp;
+    Operation m_DownstreamReadOp;
+    Operation m_DownstreamWrittenOp;
+    Operation m_ClientFinishedOp;
+    Operation m_ServerFinishedOp;
+    Operation m_DoneOp;
+};
+
+Proxy::Call::Call(Proxy* proxy, ::grpc::ServerCompletionQueue* cq)
+    : m_Proxy(proxy), m_CQ(cq), m_Backend(nullptr), m_Pending(0), m_Unary(false),
+      m_Waiting(false), m_Done(false), m_ClientFinishing(false), m_ServerFinishing(false),
+      m_InitialMetadataForwarded(false), m_WokenOp(this, &Call::StateWoken),
+      m_StartedOp(this, &Call::StateStarted),
+      m_UpstreamReadOp(this, &Call::StateUpstreamRead),
+      m_UpstreamWrittenOp(this, &Call::StateUpstreamWritten),
+      m_UpstreamClosedOp(this, &Call::StateUpstreamClosed),
+      m_DownstreamReadOp(this, &Call::StateDownstreamRead),
+      m_DownstreamWrittenOp(this, &Call::StateDownstreamWritten),
+      m_ClientFinishedOp(this, &Call::StateClientFinished),
+      m_ServerFinishedOp(this, &Call::StateServerFinished), m_DoneOp(this, &Call::StateDone)
+{
+}
+
+void Proxy::Call::Reset()
+{
+    m_ClientCall.reset();
+    m_UnaryCall.reset();
+    m_ClientContext.reset();
+    m_ServerStream.reset();
+    m_ServerContext = std::make_unique<::grpc::GenericServerContext>();
+    m_ServerStream =
+        std::make_unique<::grpc::GenericServerAsyncReaderWriter>(m_ServerContext.get());
+    m_Backend = nullptr;
+    m_Unary = false;
+    m_Waiting = false;
+    m_Done = false;
+    m_ClientFinishing = false;
+    m_ServerFinishing = false;
+    m_InitialMetadataForwarded = false;
+    m_Pending = 0;
+    m_ServerContext->AsyncNotifyWhenDone(Issue(m_DoneOp));
+    ++m_Pending;
+    m_Proxy->m_Service.RequestCall(m_ServerContext.get(), m_ServerStream.get(), m_CQ, m_CQ, Tag());
+}
+
+bool Proxy::Call::Complete(Handler handler, bool ok)
+{
+    (this->*handler)(ok);
+    return --m_Pending > 0;
+}
+
+void Proxy::Call::StateRequested(bool ok)
+{
+    if(!ok)
+    {
+        // the server is shutting down; as with the LifeCycles, the done tag is not awaited
+        m_Pending = 1;
+        return;
+    }
+    m_Backend = m_Proxy->Match(*m_ServerContext);
+    if(!m_Backend)
+    {
+        FinishServer(::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED,
+                                    "no route for " + m_ServerContext->method()));
+        return;
+    }
+    m_Unary = m_Proxy->m_UnaryMethods.count(m_ServerContext->method());
+    if(m_Proxy->Acquire(m_Backend, this))
+    {
+        StartBackend();
+        return;
+    }
+    // the wake-up is delivered on this call's completion queue, so not before this returns
+    m_Waiting = true;
+    ++m_Pending;
+}
+
+void Proxy::Call::StateWoken(bool ok)
+{
+    m_Waiting = false;
+    if(!ok || m_Done)
+    {
+        m_Proxy->Release(m_Backend);
+        return;
+    }
+    StartBackend();
+}
+
+void Proxy::Call::StartBackend()
+{
+    m_ClientContext = std::make_unique<::grpc::ClientContext>();
+    for(const auto& header : m_ServerContext->client_metadata())
+    {
+        if(Forwarded(header.first))
+        {
+            m_ClientContext->AddMetadata(ToString(header.first), ToString(header.second));
+        }
+    }
+    m_ClientContext->set_deadline(m_ServerContext->deadline());
+    if(m_Unary)
+    {
+        // the backend call is made once the request is in
+        ReadUpstream();
+        return;
+    }
+    m_ClientCall = m_Backend->stub->PrepareCall(m_ClientContext.get(), m_ServerContext->method(),
+                                                m_CQ);
+    m_ClientCall->StartCall(Issue(m_StartedOp));
+    // the first Read also receives the backend's initial metadata
+    ReadDownstream();
+}
+
+void Proxy::Call::StateStarted(bool ok)
+{
+    // StartCall shares the backend call's write operations; requests are pumped once it is done
+    if(ok)
+    {
+        ReadUpstream();
+    }
+}
+
+void Proxy::Call::ForwardInitialMetadata()
+{
+    // sent with the first response or the status
+    m_InitialMetadataForwarded = true;
+    for(const auto& header : m_ClientContext->GetServerInitialMetadata())
+    {
+        if(Forwarded(header.first))
+        {
+            m_ServerContext->AddInitialMetadata(ToString(header.first), ToString(header.second));
+        }
+    }
+}
+
+void Proxy::Call::ReadUpstream()
+{
+    m_ServerStream->Read(&m_Upstream, Issue(m_UpstreamReadOp));
+}
+
+void Proxy::Call::StateUpstreamRead(bool ok)
+{
+    if(m_ClientFinishing)
+    {
+        return;
+    }
+    if(m_Unary)
+    {
+        if(!ok)
+        {
+            // the client half-closed without a request, or is gone
+            m_Proxy->Release(m_Backend);
+            FinishServer(::grpc::Status(::grpc::StatusCode::INTERNAL, "missing request"));
+            return;
+        }
+        m_UnaryCall = m_Backend->stub->PrepareUnaryCall(
+            m_ClientContext.get(), m_ServerContext->method(), m_Upstream, m_CQ);
+        m_UnaryCall->StartCall();
+        m_UnaryCall->Finish(&m_Downstream, &m_Status, Issue(m_ClientFinishedOp));
+        return;
+    }
+    if(ok)
+    {
+        m_ClientCall->Write(m_Upstream, Issue(m_UpstreamWrittenOp));
+        return;
+    }
+    // the client half-closed the stream
+    m_ClientCall->WritesDone(Issue(m_UpstreamClosedOp));
+}
+
+void Proxy::Call::StateUpstreamWritten(bool ok)
+{
+    if(ok && !m_ServerFinishing)
+    {
+        ReadUpstream();
+    }
+}
+
+void Proxy::Call::ReadDownstream()
+{
+    m_ClientCall->Read(&m_Downstream, Issue(m_DownstreamReadOp));
+}
+
+void Proxy::Call::StateDownstreamRead(bool ok)
+{
+    if(!m_InitialMetadataForwarded)
+    {
+        ForwardInitialMetadata();
+    }
+    if(!ok)
+    {
+        // the backend sent its status
+        FinishClient();
+        return;
+    }
+    m_ServerStream->Write(m_Downstream, Issue(m_DownstreamWrittenOp));
+}
+
+void Proxy::Call::StateDownstreamWritten(bool ok)
+{
+    if(!ok)
+    {
+        // the client is gone
+        m_ClientContext->TryCancel();
+        FinishClient();
+        return;
+    }
+    ReadDownstream();
+}
+
+void Proxy::Call::FinishClient()
+{
+    m_ClientFinishing = true;
+    m_ClientCall->Finish(&m_Status, Issue(m_ClientFinishedOp));
+}
+
+void Proxy::Call::StateClientFinished(bool ok)
+{
+    m_Proxy->Release(m_Backend);
+    if(!m_InitialMetadataForwarded)
+    {
+        ForwardInitialMetadata();
+    }
+    for(const auto& header : m_ClientContext->GetServerTrailingMetadata())
+    {
+        if(Forwarded(header.first))
+        {
+            m_ServerContext->AddTrailingMetadata(ToString(header.first), ToString(header.second));
+        }
+    }
+    if(m_Unary && m_Status.ok())
+    {
+        m_ServerFinishing = true;
+        m_ServerStream->WriteAndFinish(m_Downstream, ::grpc::WriteOptions(), m_Status,
+                                       Issue(m_ServerFinishedOp));
+        return;
+    }
+    // a pending upstream Read completes once the server call is finished
+    FinishServer(m_Status);
+}
+
+void Proxy::Call::FinishServer(const ::grpc::Status& status)
+{
+    m_ServerFinishing = true;
+    m_ServerStream->Finish(status, Issue(m_ServerFinishedOp));
+}
+
+void Proxy::Call::StateDone(bool ok)
+{
+    m_Done = true;
+    if(!m_ServerContext->IsCancelled())
+    {
+        return;
+    }
+    // a no-op once the backend call is over
+    if(m_ClientContext)
+    {
+        m_ClientContext->TryCancel();
+    }
+    if(m_Waiting && m_Proxy->Withdraw(m_Backend, this))
+    {
+        m_Waiting = false;
+        --m_Pending;
+    }
+}
+
+Proxy::Proxy() : IService(), IRPC() {}
+
+Proxy::~Proxy() {}
+
+Proxy::BackendId Proxy::AddBackend(std::shared_ptr<::grpc::ChannelInterface> channel,
+                                   std::size_t max_concurrent)
+{
+    auto backend = std::make_unique<Backend>();
+    backend->stub = std::make_unique<::grpc::GenericStub>(channel);
+    backend->max_concurrent = max_concurrent;
+    backend->in_flight = 0;
+    m_Backends.push_back(std::move(backend));
+    return m_Backends.size() - 1;
+}
+
+void Proxy::AddRoute(const std::string& method_prefix, BackendId backend)
+{
+    AddRoute(method_prefix, "", "", backend);
+}
+
+void Proxy::AddUnaryMethod(const std::string& method) { m_UnaryMethods.insert(method); }
+
+void Proxy::AddRoute(const std::string& method_prefix, const std::string& header,
+                     const std::string& value, BackendId backend)
+{
+    CHECK_LT(backend, m_Backends.size()) << "Unknown backend";
+    m_Routes.push_back(Route{method_prefix, header, value, backend});
+}
+
+std::size_t Proxy::InFlight(BackendId backend)
+{
+    CHECK_LT(backend, m_Backends.size()) << "Unknown backend";
+    std::lock_guard<std::mutex> lock(m_Backends[backend]->mutex);
+    return m_Backends[backend]->in_flight;
+}
+
+void Proxy::Initialize(::grpc::ServerBuilder& builder)
+{
+    builder.RegisterAsyncGenericService(&m_Service);
+}
+
+std::unique_ptr<IContext> Proxy::CreateContext(::grpc::ServerCompletionQueue* cq,
+                                               std::shared_ptr<::trtlab::Resources>)
+{
+    return std::make_unique<Call>(this, cq);
+}
+
+Proxy::Backend* Proxy::Match(const ::grpc::GenericServerContext& context)
+{
+    const auto& method = context.method();
+    for(const auto& route : m_Routes)
+    {
+        if(method.compare(0, route.method_prefix.size(), route.method_prefix))
+        {
+            continue;
+        }
+        if(!route.header.empty())
+        {
+            const auto& headers = context.client_metadata();
+            auto range = headers.equal_range(route.header);
+            auto match = [&route](const auto& kv) { return kv.second == route.value; };
+            if(std::find_if(range.first, range.second, match) == range.second)
+            {
+                continue;
+            }
+        }
+        return m_Backends[route.backend].get();
+    }
+    return nullptr;
+}
+
+bool Proxy::Acquire(Backend* backend, Call* call)
+{
+    std::lock_guard<std::mutex> lock(backend->mutex);
+    if(!backend->max_concurrent || backend->in_flight < backend->max_concurrent)
+    {
+        ++backend->in_flight;
+        return true;
+    }
+    call->Arm();
+    backend->waiting.push_back(call);
+    return false;
+}
+
+void Proxy::Release(Backend* backend)
+{
+    Call* next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(backend->mutex);
+        if(backend->waiting.empty())
+        {
+            --backend->in_flight;
+            return;
+        }
+        next = backend->waiting.front();
+        backend->waiting.pop_front();
+    }
+    // the slot passes straight to the next call
+    next->Wake();
+}
+
+bool Proxy::Withdraw(Backend* backend, Call* call)
+{
+    std::lock_guard<std::mutex> lock(backend->mutex);
+    auto it = std::find(backend->waiting.begin(), backend->waiting.end(), call);
+    if(it == backend->waiting.end())
+    {
+        return false;
+    }
+    backend->waiting.erase(it);
+    return true;
+}
+
+} // namespace nvrpc
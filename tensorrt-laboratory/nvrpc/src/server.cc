@@ -25,20 +25,81 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "nvrpc/server.h"
+#include "nvrpc/proxy.h"
 
 #include <csignal>
+#include <cstring>
 #include <thread>
 
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 
 namespace {
 std::function<void(int)> shutdown_handler;
 void signal_handler(int signal) { shutdown_handler(signal); }
+
+// filesystem path of a "unix:path" or "unix:///path" address; empty for other addresses
+std::string UnixSocketPath(const std::string& address)
+{
+    const std::string scheme = "unix:";
+    if(address.compare(0, scheme.size(), scheme))
+    {
+        return "";
+    }
+    auto path = address.substr(scheme.size());
+    if(!path.compare(0, 2, "//"))
+    {
+        path = path.substr(2);
+    }
+    return path;
+}
+
+// a socket file nobody is accepting on is left over from a server that did not shut down
+void RemoveStaleUnixSocket(const std::string& path)
+{
+    struct stat st;
+    if(lstat(path.c_str(), &st))
+    {
+        return;
+    }
+    if(!S_ISSOCK(st.st_mode))
+    {
+        throw std::runtime_error("Error: " + path + " exists and is not a socket");
+    }
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::runtime_error("Error: socket path too long: " + path);
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    CHECK_GE(fd, 0) << "Unable to create socket: " << std::strerror(errno);
+    auto rc = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    auto err = errno;
+    close(fd);
+    if(!rc)
+    {
+        throw std::runtime_error("Error: " + path + " is in use by another server");
+    }
+    if(err == ECONNREFUSED)
+    {
+        LOG(INFO) << "Removing stale socket: " << path;
+        unlink(path.c_str());
+    }
+}
 } // namespace
 
 namespace nvrpc {
 
-Server::Server(std::string server_address) : m_ServerAddress(server_address), m_Running(false)
+Server::Server(std::string server_address)
+    : m_ServerAddress(server_address), m_UnixSocketPath(UnixSocketPath(server_address)),
+      m_UnixSocketMode(0660), m_Running(false)
 {
     LOG(INFO) << "gRPC listening on: " << m_ServerAddress;
     m_Builder.AddListeningPort(m_ServerAddress, ::grpc::InsecureServerCredentials());
@@ -50,6 +111,12 @@ Server::Server(std::string server_address) : m_ServerAddress(server_address), m_
     return m_Builder;
 }
 
+void Server::SetUnixSocketMode(mode_t mode)
+{
+    LOG_IF(FATAL, m_Running) << "Unable to change socket permissions after the Server is running.";
+    m_UnixSocketMode = mode;
+}
+
 void Server::Run()
 {
     Run(std::chrono::milliseconds(1000), [] {});
@@ -84,7 +151,30 @@ void Server::AsyncStart()
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
         CHECK_EQ(m_Running, false) << "Server is already running";
-        m_Server = m_Builder.BuildAndStart();
+        if(!m_UnixSocketPath.empty())
+        {
+            RemoveStaleUnixSocket(m_UnixSocketPath);
+        }
+        if(m_UnixSocketPath.empty())
+        {
+            m_Server = m_Builder.BuildAndStart();
+        }
+        else
+        {
+            // the socket is bound, and accepts connections, within BuildAndStart; a umask
+            // that admits no more than the requested mode closes the window before the chmod.
+            // The umask is process wide, so it is held only for the duration of the bind.
+            auto umask_before = umask(~m_UnixSocketMode & 0777);
+            m_Server = m_Builder.BuildAndStart();
+            umask(umask_before);
+        }
+        CHECK(m_Server) << "Unable to listen on: " << m_ServerAddress;
+        // set the mode exactly, whatever the socket was bound with; never serve a socket with
+        // permissions other than the ones asked for
+        LOG_IF(FATAL, !m_UnixSocketPath.empty() &&
+                          chmod(m_UnixSocketPath.c_str(), m_UnixSocketMode))
+            << "Unable to set permissions of " << m_UnixSocketPath << ": "
+            << std::strerror(errno);
 
         shutdown_handler = [this](int signal) {
             LOG(INFO) << "Trapped Signal: " << signal;
@@ -112,11 +202,27 @@ void Server::Shutdown()
         {
             executor->Shutdown();
         }
+        if(!m_UnixSocketPath.empty())
+        {
+            unlink(m_UnixSocketPath.c_str());
+        }
         m_Running = false;
     }
     m_Condition.notify_all();
 }
 
+Proxy* Server::RegisterProxy()
+{
+    if(m_Running)
+    {
+        throw std::runtime_error("Error: cannot register a proxy on a running server");
+    }
+    auto proxy = new Proxy;
+    m_Services.emplace_back(static_cast<IService*>(proxy));
+    proxy->Initialize(m_Builder);
+    return proxy;
+}
+
 bool Server::Running()
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
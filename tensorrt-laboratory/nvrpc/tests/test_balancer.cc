@@ -0,0 +1,242 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/client/balancer.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nvrpc {
+namespace testing {
+
+class BalancerTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+// count calls from a closed loop of workers, each issuing its next call from the callback of
+// the previous one; returns the latency of every call in milliseconds, sorted
+static std::vector<double> ClosedLoop(client::ClientUnary<Input, Output>& client,
+                                      std::size_t workers, std::size_t count)
+{
+    using clock = std::chrono::steady_clock;
+    std::mutex mutex;
+    std::size_t issued = 0;
+    std::vector<double> latencies;
+    std::promise<void> finished;
+
+    std::function<void()> issue = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(issued == count)
+            {
+                return;
+            }
+            ++issued;
+        }
+        auto start = clock::now();
+        client.Enqueue(Input(), [&, start](Input&, Output&, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+            auto latency = std::chrono::duration<double, std::milli>(clock::now() - start);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                latencies.push_back(latency.count());
+                if(latencies.size() == count)
+                {
+                    finished.set_value();
+                    return;
+                }
+            }
+            issue();
+        });
+    };
+    for(std::size_t i = 0; i < workers; i++)
+    {
+        issue();
+    }
+    finished.get_future().wait();
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+TEST_F(BalancerTest, AvoidsSlowReplica)
+{
+    m_Server = BuildServer<PingPongUnaryDelayContext<0>, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    auto fast = BuildServer<PingPongUnaryDelayContext<0>, PingPongStreamingContext>(
+        "0.0.0.0:13378");
+    fast->AsyncStart();
+    auto slow = BuildServer<PingPongUnaryDelayContext<100>, PingPongStreamingContext>(
+        "0.0.0.0:13379");
+    slow->AsyncStart();
+    std::vector<std::string> addresses = {"localhost:13377", "localhost:13378",
+                                          "localhost:13379"};
+
+    using Policy = client::Balancer::Policy;
+    auto p99 = [](const std::vector<double>& latencies) {
+        return latencies[latencies.size() * 99 / 100];
+    };
+    auto run = [&](Policy policy, std::size_t count) {
+        auto balancer = std::make_shared<client::Balancer>(addresses.size(), policy);
+        auto client = BuildBalancedUnaryClient(addresses, balancer);
+        auto latencies = ClosedLoop(*client, 3, count);
+        for(std::size_t i = 0; i < addresses.size(); i++)
+        {
+            EXPECT_EQ(balancer->InFlight(i), 0UL);
+        }
+        return p99(latencies);
+    };
+
+    // one in three calls waits on the slow replica; a short run suffices
+    auto round_robin = run(Policy::RoundRobin, 60);
+    // the slow replica is only picked while it holds fewer calls than the others
+    auto least_outstanding = run(Policy::LeastOutstanding, 1000);
+    auto two_choices = run(Policy::PowerOfTwoChoices, 1000);
+    LOG(INFO) << "p99 ms; round robin: " << round_robin
+              << "; least outstanding: " << least_outstanding
+              << "; power of two choices: " << two_choices;
+    EXPECT_GE(round_robin, 100.0);
+    EXPECT_LT(least_outstanding, round_robin / 2);
+    EXPECT_LT(two_choices, round_robin / 2);
+
+    slow->Shutdown();
+    fast->Shutdown();
+    m_Server->Shutdown();
+}
+
+TEST_F(BalancerTest, EjectsFailingEndpoint)
+{
+    m_Server = BuildServer<PingPongUnaryDelayContext<0>, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+
+    constexpr std::size_t threshold = 3;
+    auto balancer =
+        std::make_shared<client::Balancer>(2, client::Balancer::Policy::LeastOutstanding);
+    balancer->SetEjection(threshold, std::chrono::seconds(10));
+    // nothing listens on the second endpoint
+    auto client = BuildBalancedUnaryClient({"localhost:13377", "localhost:1"}, balancer);
+
+    std::size_t failures = 0;
+    for(int i = 0; i < 40; i++)
+    {
+        auto status = client->Enqueue(Input(), [](Input&, Output&, ::grpc::Status& status) {
+                                return status;
+                            }).get();
+        if(!status.ok())
+        {
+            EXPECT_EQ(status.error_code(), ::grpc::StatusCode::UNAVAILABLE);
+            ++failures;
+        }
+    }
+    EXPECT_EQ(failures, threshold);
+    EXPECT_FALSE(balancer->Ejected(0));
+    EXPECT_TRUE(balancer->Ejected(1));
+
+    m_Server->Shutdown();
+}
+
+TEST_F(BalancerTest, UnobservedReleaseKeepsFailureStreak)
+{
+    client::Balancer balancer(1);
+    balancer.SetEjection(3, std::chrono::seconds(10));
+    auto release = [&balancer](const ::grpc::Status& status, bool observed) {
+        balancer.Release(balancer.Acquire(), status, observed);
+    };
+    ::grpc::Status unavailable(::grpc::StatusCode::UNAVAILABLE, "");
+
+    // a hedge loser cancelled between failures neither resets nor extends the streak
+    release(unavailable, true);
+    release(unavailable, true);
+    release(::grpc::Status::CANCELLED, false);
+    EXPECT_FALSE(balancer.Ejected(0));
+    release(unavailable, true);
+    EXPECT_TRUE(balancer.Ejected(0));
+    EXPECT_EQ(balancer.InFlight(0), 0UL);
+}
+
+TEST_F(BalancerTest, PicksValidEndpointWhileEjecting)
+{
+    // endpoints are ejected, and ejections expire, while other threads pick; every pick must
+    // still be one of the endpoints
+    using Policy = client::Balancer::Policy;
+    for(auto policy : {Policy::RoundRobin, Policy::LeastOutstanding, Policy::PowerOfTwoChoices})
+    {
+        constexpr std::size_t endpoints = 2;
+        client::Balancer balancer(endpoints, policy);
+        balancer.SetEjection(1, std::chrono::milliseconds(1));
+        ::grpc::Status unavailable(::grpc::StatusCode::UNAVAILABLE, "");
+        std::atomic<std::size_t> invalid(0);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 8; t++)
+        {
+            threads.emplace_back([&balancer, &invalid, &unavailable] {
+                for(int i = 0; i < 20000; i++)
+                {
+                    auto endpoint = balancer.Acquire();
+                    if(endpoint >= endpoints)
+                    {
+                        invalid++;
+                        continue;
+                    }
+                    // successes keep the ejections short, so they keep expiring
+                    balancer.Release(endpoint, i % 2 ? ::grpc::Status::OK : unavailable, true);
+                }
+            });
+        }
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(invalid, 0UL);
+    }
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -0,0 +1,129 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace nvrpc {
+namespace testing {
+
+// Executes up to kWindow requests of a stream at once on the resources' thread pool; later
+// requests are given shorter delays so they finish before earlier ones
+class PingPongBidirectionalWindowContext final
+    : public BidirectionalContext<Input, Output, TestResources>
+{
+  public:
+    static constexpr std::size_t kWindow = 4;
+
+    PingPongBidirectionalWindowContext() { SetExecutionWindow(kWindow); }
+
+    static std::atomic<std::size_t> s_Executing;
+    static std::atomic<std::size_t> s_MaxExecuting;
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+std::atomic<std::size_t> PingPongBidirectionalWindowContext::s_Executing(0);
+std::atomic<std::size_t> PingPongBidirectionalWindowContext::s_MaxExecuting(0);
+
+void PingPongBidirectionalWindowContext::ExecuteRPC(Input& input, Output& output)
+{
+    auto executing = ++s_Executing;
+    auto max = s_MaxExecuting.load();
+    while(executing > max && !s_MaxExecuting.compare_exchange_weak(max, executing))
+    {
+    }
+    GetResources()->AcquireThreadPool().enqueue([this, &input, &output] {
+        auto delay = kWindow - input.batch_id() % kWindow;
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        output.set_batch_id(input.batch_id());
+        --s_Executing;
+        FinishResponse(output);
+    });
+}
+
+class BidirectionalWindowTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(BidirectionalWindowTest, ExecutesInParallel)
+{
+    using Context = PingPongBidirectionalWindowContext;
+    m_Server = BuildServer<PingPongUnaryContext, Context>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    constexpr std::uint64_t send_count = 40;
+    std::mutex mutex;
+    std::uint64_t recv_count = 0;
+
+    // responses arrive in request order even though they finish out of order
+    auto on_recv = [&mutex, &recv_count](Output&& response) {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(++recv_count, response.batch_id());
+    };
+
+    auto stream = BuildStreamingClient([](Input&&) {}, on_recv);
+
+    for(std::uint64_t i = 1; i <= send_count; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        EXPECT_TRUE(stream->Write(std::move(input)));
+    }
+
+    auto status = stream->Done().get();
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(recv_count, send_count);
+    EXPECT_GT(Context::s_MaxExecuting.load(), 1UL);
+    EXPECT_LE(Context::s_MaxExecuting.load(), Context::kWindow);
+}
+
+} // namespace testing
+} // namespace nvrpc
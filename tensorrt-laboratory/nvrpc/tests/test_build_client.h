@@ -29,6 +29,7 @@
 #include "nvrpc/executor.h"
 #include "nvrpc/server.h"
 
+#include "nvrpc/client/channel.h"
 #include "nvrpc/client/client_streaming.h"
 #include "nvrpc/client/client_unary.h"
 
@@ -40,11 +41,12 @@
 namespace nvrpc {
 namespace testing {
 
-std::unique_ptr<client::ClientUnary<Input, Output>> BuildUnaryClient()
+inline std::unique_ptr<client::ClientUnary<Input, Output>>
+    BuildUnaryClient(std::string address = "localhost:13377")
 {
     auto executor = std::make_shared<client::Executor>(1);
 
-    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    auto channel = client::CreateChannel(address);
     std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
 
     auto infer_prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
@@ -56,9 +58,29 @@ std::unique_ptr<client::ClientUnary<Input, Output>> BuildUnaryClient()
     return std::make_unique<client::ClientUnary<Input, Output>>(infer_prepare_fn, executor);
 }
 
-std::unique_ptr<client::ClientStreaming<Input, Output>>
+inline std::unique_ptr<client::ClientUnary<Input, Output>>
+    BuildBalancedUnaryClient(const std::vector<std::string>& addresses,
+                             std::shared_ptr<client::Balancer> balancer)
+{
+    auto executor = std::make_shared<client::Executor>(1);
+
+    std::vector<client::ClientUnary<Input, Output>::PrepareFn> prepare_fns;
+    for(const auto& address : addresses)
+    {
+        std::shared_ptr<TestService::Stub> stub =
+            TestService::NewStub(client::CreateChannel(address));
+        prepare_fns.push_back([stub](::grpc::ClientContext * context, const Input& request,
+                                     ::grpc::CompletionQueue* cq) -> auto {
+            return std::move(stub->PrepareAsyncUnary(context, request, cq));
+        });
+    }
+
+    return std::make_unique<client::ClientUnary<Input, Output>>(prepare_fns, executor, balancer);
+}
+
+inline std::unique_ptr<client::ClientStreaming<Input, Output>>
     BuildStreamingClient(std::function<void(Input&&)> on_sent,
-                         std::function<void(Output&&)> on_recv)
+                         std::function<void(Output&&)> on_recv, std::size_t write_ring_size = 64)
 {
     auto executor = std::make_shared<client::Executor>(1);
 
@@ -72,7 +94,8 @@ std::unique_ptr<client::ClientStreaming<Input, Output>>
     };
 
     return std::make_unique<client::ClientStreaming<Input, Output>>(infer_prepare_fn, executor,
-                                                                    on_sent, on_recv);
+                                                                    on_sent, on_recv,
+                                                                    write_ring_size);
 }
 
 } // namespace testing
@@ -53,9 +53,9 @@ std::unique_ptr<Server> BuildStreamingServer()
 }
 
 template<typename UnaryContext, typename StreamingContext>
-std::unique_ptr<Server> BuildServer()
+std::unique_ptr<Server> BuildServer(std::string address = "0.0.0.0:13377")
 {
-    auto server = std::make_unique<Server>("0.0.0.0:13377");
+    auto server = std::make_unique<Server>(address);
     auto resources = std::make_shared<TestResources>(3);
     auto executor = server->RegisterExecutor(new Executor(1));
     auto service = server->RegisterAsyncService<TestService>();
@@ -0,0 +1,237 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/client/load_generator.h"
+#include "nvrpc/concurrency_limiter.h"
+#include "nvrpc/local_client.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace nvrpc {
+namespace testing {
+
+// Sleeps WorkUs on the resources' thread pool; latency stays flat until every thread is busy
+class PingPongUnarySleepContext final : public Context<Input, Output, TestResources>
+{
+  public:
+    static constexpr int WorkUs = 5000;
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+void PingPongUnarySleepContext::ExecuteRPC(Input& input, Output& output)
+{
+    output.set_batch_id(input.batch_id());
+    GetResources()->AcquireThreadPool().enqueue([this] {
+        std::this_thread::sleep_for(std::chrono::microseconds(WorkUs));
+        FinishResponse();
+    });
+}
+
+class ConcurrencyLimiterTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(ConcurrencyLimiterTest, ShedsOverload)
+{
+    // one sleeping worker and far more contexts than it can keep busy, so without a limiter
+    // the backlog queues on the thread pool and every request waits behind it.  The handler
+    // sleeps rather than burns CPU: the client and the server share the machine, and every
+    // rejection still costs a round trip, so with a CPU-bound handler on a single core the
+    // rejections themselves take cycles from the handler and goodput falls with offered load
+    // for reasons unrelated to the limiter (see bench_concurrency_limit).
+    constexpr int workers = 1;
+    constexpr double capacity = workers * 1e6 / PingPongUnarySleepContext::WorkUs;
+    m_Server = std::make_unique<Server>("0.0.0.0:13377");
+    auto executor = m_Server->RegisterExecutor(new Executor(1));
+    auto service = m_Server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<PingPongUnarySleepContext>(
+        &TestService::AsyncService::RequestUnary);
+    ConcurrencyLimiter::Options limits;
+    limits.initial_limit = 10;
+    limits.window = 20;
+    auto limiter = std::make_shared<ConcurrencyLimiter>(limits);
+    rpc->SetConcurrencyLimiter(limiter);
+    executor->RegisterContexts(rpc, std::make_shared<TestResources>(workers), 200);
+    m_Server->AsyncStart();
+
+    auto run = [](double rate) {
+        client::LoadGenerator::Options options;
+        options.rate = rate;
+        options.duration = std::chrono::seconds(1);
+        options.warmup = std::chrono::milliseconds(250);
+        auto target = std::make_shared<client::UnaryLoadTarget<Input, Output>>(
+            BuildUnaryClient(), [] { return Input(); });
+        return client::LoadGenerator(options).Run({target});
+    };
+
+    // well within capacity nothing is shed
+    auto nominal = run(0.25 * capacity);
+    EXPECT_EQ(nominal.errors, 0);
+    EXPECT_EQ(limiter->Rejected(), 0);
+
+    // just past capacity the workers are saturated; this is the goodput to hold on to
+    auto saturated = run(1.5 * capacity);
+    EXPECT_GT(saturated.achieved_rate, 0.7 * capacity);
+    LOG(INFO) << "1.5x: " << saturated.ToJSON() << " limit: " << limiter->Limit();
+
+    // far past capacity the excess is rejected with RESOURCE_EXHAUSTED while the admitted
+    // requests keep their latency and the server its goodput
+    for(auto factor : {5.0, 25.0})
+    {
+        auto overload = run(factor * capacity);
+        EXPECT_GT(overload.errors, 0) << factor << "x";
+        EXPECT_EQ(overload.outstanding, 0) << factor << "x";
+        EXPECT_GE(overload.achieved_rate, 0.8 * saturated.achieved_rate) << factor << "x";
+        EXPECT_LT(overload.latency.Percentile(50), 5e6 * PingPongUnarySleepContext::WorkUs / 1e3)
+            << factor << "x";
+        EXPECT_LT(overload.latency.Percentile(99), 15e6 * PingPongUnarySleepContext::WorkUs / 1e3)
+            << factor << "x";
+        LOG(INFO) << factor << "x: " << overload.ToJSON() << " limit: " << limiter->Limit();
+    }
+    EXPECT_GT(limiter->Rejected(), 0);
+
+    m_Server->Shutdown();
+}
+
+TEST_F(ConcurrencyLimiterTest, GrowsToWorkerConcurrency)
+{
+    // several workers with flat latency; starting low, the limit must climb to at least the
+    // concurrency they sustain and return there after every probe
+    constexpr int workers = 4;
+    m_Server = std::make_unique<Server>("0.0.0.0:13377");
+    auto executor = m_Server->RegisterExecutor(new Executor(1));
+    auto service = m_Server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<PingPongUnarySleepContext>(
+        &TestService::AsyncService::RequestUnary);
+    ConcurrencyLimiter::Options limits;
+    limits.initial_limit = 1;
+    // short windows so that the run spans several probes
+    limits.window = 10;
+    auto limiter = std::make_shared<ConcurrencyLimiter>(limits);
+    rpc->SetConcurrencyLimiter(limiter);
+    executor->RegisterContexts(rpc, std::make_shared<TestResources>(workers), 200);
+    m_Server->AsyncStart();
+
+    // offered twice what the workers can complete
+    client::LoadGenerator::Options options;
+    options.rate = 2.0 * workers * 1e6 / PingPongUnarySleepContext::WorkUs;
+    options.duration = std::chrono::seconds(2);
+    // the limit climbs from the initial limit during the warmup
+    options.warmup = std::chrono::seconds(1);
+    auto target = std::make_shared<client::UnaryLoadTarget<Input, Output>>(
+        BuildUnaryClient(), [] { return Input(); });
+
+    std::atomic<bool> running(true);
+    std::vector<std::size_t> samples;
+    std::thread sampler([&] {
+        std::this_thread::sleep_for(options.warmup);
+        while(running)
+        {
+            samples.push_back(limiter->Limit());
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    auto report = client::LoadGenerator(options).Run({target});
+    running = false;
+    sampler.join();
+
+    // latency stays within tolerance of the baseline up to tolerance times the workers, so
+    // the limit settles at least there; probes are rare and brief, so it seldom dips below
+    // the workers themselves
+    ASSERT_FALSE(samples.empty());
+    std::sort(samples.begin(), samples.end());
+    auto median = samples[samples.size() / 2];
+    EXPECT_GE(median, limits.tolerance * workers);
+    EXPECT_GE(samples[samples.size() / 10], workers);
+    EXPECT_GT(report.achieved_rate, 0.6 * workers * 1e6 / PingPongUnarySleepContext::WorkUs);
+    LOG(INFO) << "limit: median " << median << " min " << samples.front() << " max "
+              << samples.back() << " rate: " << report.achieved_rate;
+
+    m_Server->Shutdown();
+}
+
+TEST_F(ConcurrencyLimiterTest, GatesLocalClient)
+{
+    // a limit of one, shared with the gRPC path; an in-process call made while another is in
+    // flight is shed like a gRPC one
+    m_Server = std::make_unique<Server>("0.0.0.0:13377");
+    auto resources = std::make_shared<TestResources>(4);
+    auto executor = m_Server->RegisterExecutor(new Executor(1));
+    auto service = m_Server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<PingPongUnarySleepContext>(
+        &TestService::AsyncService::RequestUnary);
+    ConcurrencyLimiter::Options limits;
+    limits.initial_limit = 1;
+    limits.max_limit = 1;
+    auto limiter = std::make_shared<ConcurrencyLimiter>(limits);
+    rpc->SetConcurrencyLimiter(limiter);
+    executor->RegisterContexts(rpc, resources, 4);
+    LocalClient<PingPongUnarySleepContext> local(executor, resources, 4, limiter);
+    m_Server->AsyncStart();
+
+    auto status_code = [](Input&, Output&, ::grpc::Status& status) {
+        return status.error_code();
+    };
+    auto first = local.Enqueue(Input(), status_code);
+    auto second = local.Enqueue(Input(), status_code);
+    EXPECT_EQ(first.get(), ::grpc::StatusCode::OK);
+    EXPECT_EQ(second.get(), ::grpc::StatusCode::RESOURCE_EXHAUSTED);
+    EXPECT_EQ(limiter->Rejected(), 1UL);
+
+    // the admitted local call released its slot
+    EXPECT_EQ(limiter->InFlight(), 0UL);
+    EXPECT_EQ(local.Enqueue(Input(), status_code).get(), ::grpc::StatusCode::OK);
+
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
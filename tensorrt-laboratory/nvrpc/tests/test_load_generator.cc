@@ -0,0 +1,130 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/client/load_generator.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+namespace nvrpc {
+namespace testing {
+
+class LoadGeneratorTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+static void ExpectConsistent(const client::LoadGenerator::Report& report)
+{
+    EXPECT_EQ(report.errors, 0);
+    EXPECT_EQ(report.outstanding, 0);
+    EXPECT_EQ(report.completed, report.sent);
+    EXPECT_EQ(report.latency.count, report.completed);
+    EXPECT_LE(report.latency.Percentile(50), report.latency.Percentile(99));
+    EXPECT_LE(report.latency.Percentile(99), report.latency.Percentile(99.9));
+    EXPECT_LE(report.latency.Percentile(99.9), report.latency.max);
+    // measured from the intended send time, latency can only exceed the service time
+    EXPECT_GE(report.latency.sum, report.service_time.sum);
+    EXPECT_GE(report.latency.max, report.service_time.max);
+
+    auto json = report.ToJSON();
+    EXPECT_NE(json.find("\"latency_us\": {\"count\": " + std::to_string(report.completed)),
+              std::string::npos);
+    EXPECT_NE(json.find("\"p999\": "), std::string::npos);
+}
+
+TEST_F(LoadGeneratorTest, OpenLoop)
+{
+    using client::LoadGenerator;
+    using client::LoadTarget;
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingEchoContext>();
+    m_Server->AsyncStart();
+
+    auto request_fn = [] {
+        Input input;
+        input.set_batch_id(1);
+        return input;
+    };
+
+    // unary calls over two channels with Poisson arrivals
+    std::vector<std::shared_ptr<LoadTarget>> unary;
+    for(int i = 0; i < 2; i++)
+    {
+        unary.push_back(std::make_shared<client::UnaryLoadTarget<Input, Output>>(
+            BuildUnaryClient(), request_fn,
+            std::map<std::string, std::string>{{"x-content-model", "flowers-152"}}));
+    }
+    LoadGenerator::Options options;
+    options.rate = 2000;
+    options.duration = std::chrono::milliseconds(500);
+    options.threads = 2;
+    options.arrivals = LoadGenerator::ArrivalsFromString("poisson");
+    auto report = LoadGenerator(options).Run(unary);
+    EXPECT_GT(report.sent, 850);
+    EXPECT_LT(report.sent, 1150);
+    ExpectConsistent(report);
+
+    // two streams with constant arrivals send exactly rate * duration requests
+    auto executor = std::make_shared<client::Executor>(1);
+    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+    auto prepare_fn = [stub](::grpc::ClientContext* context, ::grpc::CompletionQueue* cq) {
+        return stub->PrepareAsyncStreaming(context, cq);
+    };
+    std::vector<std::shared_ptr<LoadTarget>> streams;
+    for(int i = 0; i < 2; i++)
+    {
+        streams.push_back(std::make_shared<client::StreamingLoadTarget<Input, Output>>(
+            prepare_fn, executor, request_fn));
+    }
+    options.duration = std::chrono::milliseconds(250);
+    options.arrivals = LoadGenerator::Arrivals::Constant;
+    report = LoadGenerator(options).Run(streams);
+    EXPECT_EQ(report.sent, 500);
+    ExpectConsistent(report);
+
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
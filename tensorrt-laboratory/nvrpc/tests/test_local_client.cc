@@ -0,0 +1,127 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/local_client.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+
+namespace nvrpc {
+namespace testing {
+
+class LocalClientTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(LocalClientTest, Unary)
+{
+    m_Server = std::make_unique<Server>("0.0.0.0:13377");
+    auto resources = std::make_shared<TestResources>(3);
+    auto executor = m_Server->RegisterExecutor(new Executor(1));
+    auto service = m_Server->RegisterAsyncService<TestService>();
+    auto rpc_unary =
+        service->RegisterRPC<PingPongUnaryContext>(&TestService::AsyncService::RequestUnary);
+    executor->RegisterContexts(rpc_unary, resources, 10);
+
+    // fewer contexts than calls; the rest wait for a context to be recycled
+    LocalClient<PingPongUnaryContext> local(executor, resources, 4);
+    LocalClient<PingPongUnaryTimerContext> local_timer(executor, resources, 2);
+    std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+
+    auto status_code = [](Input& input, Output& output, ::grpc::Status& status) {
+        return status.error_code();
+    };
+    Input input;
+    EXPECT_EQ(local.Enqueue(std::move(input), status_code, headers).get(),
+              ::grpc::StatusCode::UNAVAILABLE);
+
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    std::atomic<std::size_t> recv_count(0);
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= 100; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        auto on_return = [&recv_count, i](Input& input, Output& output, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+            EXPECT_EQ(output.batch_id(), i);
+            ++recv_count;
+        };
+        if(i % 10)
+        {
+            futures.push_back(local.Enqueue(std::move(input), on_return, headers));
+        }
+        else
+        {
+            // timers are armed on the Executor the contexts are bound to
+            futures.push_back(local_timer.Enqueue(std::move(input), on_return));
+        }
+    }
+
+    // the same contexts keep serving gRPC clients
+    auto client = BuildUnaryClient();
+    input.set_batch_id(7);
+    auto grpc_batch_id = client->Enqueue(
+        std::move(input),
+        [](Input& input, Output& output, ::grpc::Status& status) { return output.batch_id(); },
+        headers);
+    EXPECT_EQ(grpc_batch_id.get(), 7);
+
+    for(auto& future : futures)
+    {
+        future.wait();
+    }
+    EXPECT_EQ(recv_count, 100);
+
+    m_Server->Shutdown();
+    EXPECT_EQ(local.Enqueue(std::move(input), status_code, headers).get(),
+              ::grpc::StatusCode::UNAVAILABLE);
+}
+
+} // namespace testing
+} // namespace nvrpc
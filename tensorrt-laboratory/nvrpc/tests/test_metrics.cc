@@ -0,0 +1,138 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_metrics.h"
+#include "test_pingpong.h"
+
+#include "nvrpc/metrics.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+namespace nvrpc {
+namespace testing {
+
+class MetricsTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+// value of the sample whose name and labels are exactly `series`, or -1 if absent
+static double SampleValue(const std::string& text, const std::string& series)
+{
+    auto pos = text.find("\n" + series + " ");
+    if(pos == std::string::npos)
+    {
+        return -1;
+    }
+    return std::stod(text.substr(pos + series.size() + 2));
+}
+
+TEST_F(MetricsTest, Scrape)
+{
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    MetricsServer metrics_server(0);
+
+    auto& wait = Metrics::ResourceWait("pingpong");
+    auto waited = wait.Time([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return 42;
+    });
+    EXPECT_EQ(waited, 42);
+
+#ifdef NVRPC_METRICS_ENABLED
+    auto& context_metrics = Metrics::ForContext(typeid(PingPongUnaryContext));
+    auto completed = context_metrics.completed.Value();
+
+    auto client = BuildUnaryClient();
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= PINGPONG_SEND_COUNT; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+        futures.push_back(client->Enqueue(
+            std::move(input), [](Input&, Output&, ::grpc::Status& status) {}, headers));
+    }
+    for(auto& future : futures)
+    {
+        future.wait();
+    }
+
+    // contexts are reset after the response is sent, which can trail the client callback
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(context_metrics.completed.Value() < completed + PINGPONG_SEND_COUNT &&
+          std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+
+    auto text = ScrapeMetrics(metrics_server.Port());
+    EXPECT_NE(text.find("# TYPE nvrpc_request_duration_seconds histogram"), std::string::npos);
+    std::string bucket = "nvrpc_resource_wait_seconds_bucket{pool=\"pingpong\",le=";
+    EXPECT_EQ(SampleValue(text, "nvrpc_resource_wait_seconds_count{pool=\"pingpong\"}"), 1);
+    EXPECT_EQ(SampleValue(text, bucket + "\"0.001\"}"), 0);
+    EXPECT_EQ(SampleValue(text, bucket + "\"+Inf\"}"), 1);
+
+#ifdef NVRPC_METRICS_ENABLED
+    std::string labels = "{context=\"nvrpc::testing::PingPongUnaryContext\"}";
+    EXPECT_EQ(SampleValue(text, "nvrpc_requests_total" + labels), completed + PINGPONG_SEND_COUNT);
+    EXPECT_EQ(SampleValue(text, "nvrpc_contexts_in_flight" + labels), 0);
+    EXPECT_EQ(SampleValue(text, "nvrpc_contexts_idle" + labels), 10);
+    EXPECT_EQ(SampleValue(text, "nvrpc_request_duration_seconds_count" + labels),
+              completed + PINGPONG_SEND_COUNT);
+    EXPECT_GE(SampleValue(text, "nvrpc_cq_events_total"), 2 * PINGPONG_SEND_COUNT);
+
+    // the streaming contexts were armed but never received a request
+    std::string streaming = "{context=\"nvrpc::testing::PingPongStreamingContext\"}";
+    EXPECT_EQ(SampleValue(text, "nvrpc_contexts_idle" + streaming), 10);
+#endif
+
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -34,7 +34,9 @@
 
 #include <gtest/gtest.h>
 
-#define PINGPONG_SEND_COUNT 10
+#include <atomic>
+#include <future>
+#include <thread>
 
 namespace nvrpc {
 namespace testing {
@@ -49,6 +51,48 @@ void PingPongUnaryContext::ExecuteRPC(Input& input, Output& output)
     FinishResponse();
 }
 
+void PingPongUnaryTimerContext::ExecuteRPC(Input& input, Output& output)
+{
+    output.set_batch_id(input.batch_id());
+    auto delay = std::chrono::milliseconds(5);
+    if(input.batch_id() % 2)
+    {
+        // armed on the progress engine thread
+        ArmTimer(delay, [this] { FinishResponse(); });
+        return;
+    }
+    // armed from a foreign thread; the executor must wake its blocked progress engine
+    GetResources()->AcquireThreadPool().enqueue(
+        [this, delay] { ArmTimer(delay, [this] { FinishResponse(); }); });
+}
+
+std::atomic<std::size_t> PingPongUnaryCancelContext::s_CancelledWork(0);
+
+void PingPongUnaryCancelContext::ExecuteRPC(Input& input, Output& output)
+{
+    output.set_batch_id(input.batch_id());
+    if(!input.batch_id())
+    {
+        FinishResponse();
+        return;
+    }
+    auto token = GetCancellationToken();
+    GetResources()->AcquireThreadPool().enqueue([this, token] {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(std::chrono::steady_clock::now() < deadline)
+        {
+            if(token.IsCancelled())
+            {
+                ++s_CancelledWork;
+                CancelResponse();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        FinishResponse();
+    });
+}
+
 void PingPongStreamingContext::RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream)
 {
     static size_t counter = 0;
@@ -60,6 +104,14 @@ void PingPongStreamingContext::RequestReceived(Input&& input, std::shared_ptr<Se
     stream->WriteResponse(std::move(output));
 }
 
+void PingPongStreamingEchoContext::RequestReceived(Input&& input,
+                                                   std::shared_ptr<ServerStream> stream)
+{
+    Output output;
+    output.set_batch_id(input.batch_id());
+    stream->WriteResponse(std::move(output));
+}
+
 /**
  * @brief Server->Client stream closes with OK before Client->Server stream
  *
@@ -211,6 +263,137 @@ TEST_F(PingPongTest, UnaryTest)
     EXPECT_FALSE(m_Server->Running());
 }
 
+TEST_F(PingPongTest, UnaryAsyncTest)
+{
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    std::size_t send_count = PINGPONG_SEND_COUNT;
+
+    auto client = BuildUnaryClient();
+
+    std::vector<::trtlab::AsyncFuture<int>> futures;
+
+    for(int i = 1; i <= send_count; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+        auto future = client->EnqueueAsync(
+            std::move(input),
+            [i](Input& input, Output& output, ::grpc::Status& status) -> int {
+                EXPECT_EQ(output.batch_id(), i);
+                EXPECT_TRUE(status.ok());
+                return output.batch_id();
+            },
+            headers);
+        futures.push_back(future.then([](int batch_id) { return batch_id * 2; }));
+    }
+
+    auto results = ::trtlab::when_all(std::move(futures)).get();
+
+    ASSERT_EQ(results.size(), send_count);
+    for(int i = 1; i <= send_count; i++)
+    {
+        EXPECT_EQ(results[i - 1], 2 * i);
+    }
+    EXPECT_TRUE(m_Server->Running());
+
+    m_Server->Shutdown();
+    EXPECT_FALSE(m_Server->Running());
+}
+
+TEST_F(PingPongTest, UnaryTimerTest)
+{
+    m_Server = BuildServer<PingPongUnaryTimerContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    std::size_t send_count = PINGPONG_SEND_COUNT;
+
+    auto client = BuildUnaryClient();
+
+    std::vector<std::shared_future<void>> futures;
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 1; i <= send_count; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        futures.push_back(client->Enqueue(
+            std::move(input),
+            [i, start](Input& input, Output& output, ::grpc::Status& status) {
+                EXPECT_EQ(output.batch_id(), i);
+                EXPECT_TRUE(status.ok());
+                EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+            }));
+    }
+
+    for(auto& future : futures)
+    {
+        EXPECT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    }
+    EXPECT_TRUE(m_Server->Running());
+
+    m_Server->Shutdown();
+    EXPECT_FALSE(m_Server->Running());
+}
+
+TEST_F(PingPongTest, UnaryClientCancelTest)
+{
+    m_Server = BuildServer<PingPongUnaryCancelContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    auto stub = TestService::NewStub(channel);
+    auto& cancelled = PingPongUnaryCancelContext::s_CancelledWork;
+    cancelled = 0;
+
+    Input input;
+    Output output;
+    input.set_batch_id(1);
+
+    {
+        // client gives up on its deadline
+        ::grpc::ClientContext context;
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(50));
+        auto status = stub->Unary(&context, input, &output);
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::DEADLINE_EXCEEDED);
+    }
+    {
+        // client cancels mid-flight
+        ::grpc::ClientContext context;
+        std::thread cancel([&context] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            context.TryCancel();
+        });
+        auto status = stub->Unary(&context, input, &output);
+        cancel.join();
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::CANCELLED);
+    }
+
+    // the pooled work observes both cancellations long before its 5s budget
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(cancelled < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(cancelled, 2UL);
+
+    {
+        // cancelled contexts are recycled and keep serving
+        ::grpc::ClientContext context;
+        input.set_batch_id(0);
+        auto status = stub->Unary(&context, input, &output);
+        EXPECT_TRUE(status.ok());
+    }
+
+    m_Server->Shutdown();
+    EXPECT_FALSE(m_Server->Running());
+}
+
 TEST_F(PingPongTest, StreamingTest)
 {
     m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
@@ -255,6 +438,33 @@ TEST_F(PingPongTest, StreamingTest)
     EXPECT_FALSE(m_Server->Running());
 }
 
+TEST_F(PingPongTest, StreamingClientWriteOverflow)
+{
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingEchoContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    constexpr std::uint64_t send_count = 500;
+    std::uint64_t recv_count = 0;
+    auto on_recv = [&recv_count](Output&& output) { EXPECT_EQ(output.batch_id(), ++recv_count); };
+
+    // a ring of two slots spills most writes into the overflow queue; order must hold across both
+    auto stream = BuildStreamingClient([](Input&&) {}, on_recv, 2);
+    stream->SetWriteCoalescing(true);
+    for(std::uint64_t i = 1; i <= send_count; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        EXPECT_TRUE(stream->Write(std::move(input)));
+    }
+
+    auto status = stream->Done().get();
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(recv_count, send_count);
+
+    m_Server->Shutdown();
+}
+
 TEST_F(PingPongTest, ServerEarlyFinish)
 {
     m_Server = BuildStreamingServer<PingPongStreamingEarlyFinishContext>();
@@ -351,4 +561,4 @@ TEST_F(PingPongTest, ServerEarlyCancel)
 }
 
 } // namespace testing
-} // namespace nvrpc
\ No newline at end of file
+} // namespace nvrpc
@@ -26,6 +26,8 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#include <atomic>
+
 #include "nvrpc/context.h"
 
 #include "test_resources.h"
@@ -33,6 +35,8 @@
 #include "testing.grpc.pb.h"
 #include "testing.pb.h"
 
+#define PINGPONG_SEND_COUNT 10
+
 namespace nvrpc {
 namespace testing {
 
@@ -41,11 +45,53 @@ class PingPongUnaryContext final : public Context<Input, Output, TestResources>
     void ExecuteRPC(Input& input, Output& output) final override;
 };
 
+// Responds after a short delay using an executor timer rather than blocking a thread
+class PingPongUnaryTimerContext final : public Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+// Holds the response on the resources' thread pool until the client cancels the call; counts
+// the calls whose work observed the cancellation
+class PingPongUnaryCancelContext final : public Context<Input, Output, TestResources>
+{
+  public:
+    static std::atomic<std::size_t> s_CancelledWork;
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+// Responds after DelayMs using an executor timer; stands in for a slow replica
+template<int DelayMs>
+class PingPongUnaryDelayContext final : public Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+template<int DelayMs>
+void PingPongUnaryDelayContext<DelayMs>::ExecuteRPC(Input& input, Output& output)
+{
+    output.set_batch_id(input.batch_id());
+    if(!DelayMs)
+    {
+        FinishResponse();
+        return;
+    }
+    ArmTimer(std::chrono::milliseconds(DelayMs), [this] { FinishResponse(); });
+}
+
 class PingPongStreamingContext final : public StreamingContext<Input, Output, TestResources>
 {
     void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override;
 };
 
+// Answers every request with one response, in order, regardless of its batch_id
+class PingPongStreamingEchoContext final : public StreamingContext<Input, Output, TestResources>
+{
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override;
+};
+
 class PingPongStreamingEarlyFinishContext final
     : public StreamingContext<Input, Output, TestResources>
 {
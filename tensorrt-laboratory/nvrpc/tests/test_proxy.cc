@@ -0,0 +1,267 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/proxy.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace nvrpc {
+namespace testing {
+
+// Holds each response on an executor timer and records how many calls it holds at once
+class PingPongUnaryConcurrencyContext final : public Context<Input, Output, TestResources>
+{
+  public:
+    static std::atomic<std::size_t> s_Executing;
+    static std::atomic<std::size_t> s_MaxExecuting;
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+std::atomic<std::size_t> PingPongUnaryConcurrencyContext::s_Executing(0);
+std::atomic<std::size_t> PingPongUnaryConcurrencyContext::s_MaxExecuting(0);
+
+void PingPongUnaryConcurrencyContext::ExecuteRPC(Input& input, Output& output)
+{
+    auto executing = ++s_Executing;
+    auto max = s_MaxExecuting.load();
+    while(executing > max && !s_MaxExecuting.compare_exchange_weak(max, executing)) {}
+    output.set_batch_id(input.batch_id());
+    ArmTimer(std::chrono::milliseconds(2), [this] {
+        --s_Executing;
+        FinishResponse();
+    });
+}
+
+class ProxyTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(ProxyTest, Routes)
+{
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingEchoContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    auto proxy_server = std::make_unique<Server>("0.0.0.0:13378");
+    auto executor = proxy_server->RegisterExecutor(new Executor(1));
+    auto proxy = proxy_server->RegisterProxy();
+    auto backend = proxy->AddBackend(client::CreateChannel("localhost:13377"));
+    auto unreachable = proxy->AddBackend(client::CreateChannel("localhost:1"));
+    proxy->AddRoute("/nvrpc.testing.TestService/", "x-backend", "unreachable", unreachable);
+    proxy->AddRoute("/nvrpc.testing.TestService/Unary", "x-content-model", "flowers-152", backend);
+    proxy->AddRoute("/nvrpc.testing.TestService/Streaming", backend);
+    executor->RegisterContexts(proxy, std::make_shared<TestResources>(1), 10);
+    proxy_server->AsyncStart();
+
+    // pumped as a stream; the backend checks the forwarded metadata
+    auto client = BuildUnaryClient("localhost:13378");
+    std::vector<std::shared_future<void>> futures;
+    for(std::uint64_t i = 1; i <= PINGPONG_SEND_COUNT; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+        futures.push_back(client->Enqueue(
+            std::move(input),
+            [i](Input&, Output& output, ::grpc::Status& status) {
+                EXPECT_TRUE(status.ok());
+                EXPECT_EQ(output.batch_id(), i);
+            },
+            headers));
+    }
+    for(auto& future : futures)
+    {
+        future.wait();
+    }
+
+    auto stub = TestService::NewStub(client::CreateChannel("localhost:13378"));
+    {
+        // streaming
+        constexpr std::uint64_t count = 100;
+        ::grpc::ClientContext context;
+        auto stream = stub->Streaming(&context);
+        for(std::uint64_t i = 1; i <= count; i++)
+        {
+            Input input;
+            input.set_batch_id(i);
+            ASSERT_TRUE(stream->Write(input));
+        }
+        stream->WritesDone();
+        Output output;
+        std::uint64_t received = 0;
+        while(stream->Read(&output))
+        {
+            EXPECT_EQ(output.batch_id(), ++received);
+        }
+        EXPECT_TRUE(stream->Finish().ok());
+        EXPECT_EQ(received, count);
+    }
+    {
+        // routed by metadata
+        ::grpc::ClientContext context;
+        context.AddMetadata("x-content-model", "flowers-152");
+        context.AddMetadata("x-backend", "unreachable");
+        Input input;
+        Output output;
+        EXPECT_EQ(stub->Unary(&context, input, &output).error_code(),
+                  ::grpc::StatusCode::UNAVAILABLE);
+    }
+    {
+        // no route
+        ::grpc::ClientContext context;
+        Input input;
+        Output output;
+        EXPECT_EQ(stub->Unary(&context, input, &output).error_code(),
+                  ::grpc::StatusCode::UNIMPLEMENTED);
+    }
+
+    proxy_server->Shutdown();
+    m_Server->Shutdown();
+}
+
+TEST_F(ProxyTest, BackendConcurrencyLimit)
+{
+    using Context = PingPongUnaryConcurrencyContext;
+    m_Server = BuildServer<Context, PingPongStreamingEchoContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    constexpr std::size_t limit = 2;
+    auto proxy_server = std::make_unique<Server>("0.0.0.0:13378");
+    auto executor = proxy_server->RegisterExecutor(new Executor(1));
+    auto proxy = proxy_server->RegisterProxy();
+    auto backend = proxy->AddBackend(client::CreateChannel("localhost:13377"), limit);
+    proxy->AddRoute("", backend);
+    proxy->AddUnaryMethod("/nvrpc.testing.TestService/Unary");
+    executor->RegisterContexts(proxy, std::make_shared<TestResources>(1), 10);
+    proxy_server->AsyncStart();
+
+    auto client = BuildUnaryClient("localhost:13378");
+    std::vector<std::shared_future<void>> futures;
+    for(std::uint64_t i = 1; i <= 50; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        futures.push_back(
+            client->Enqueue(std::move(input), [i](Input&, Output& output, ::grpc::Status& status) {
+                EXPECT_TRUE(status.ok());
+                EXPECT_EQ(output.batch_id(), i);
+            }));
+    }
+    for(auto& future : futures)
+    {
+        future.wait();
+    }
+
+    // more calls than the limit waited on the proxy rather than at the backend
+    EXPECT_EQ(Context::s_MaxExecuting.load(), limit);
+    EXPECT_EQ(proxy->InFlight(backend), 0UL);
+
+    proxy_server->Shutdown();
+    m_Server->Shutdown();
+}
+
+TEST_F(ProxyTest, ClientCancel)
+{
+    m_Server = BuildServer<PingPongUnaryCancelContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    auto proxy_server = std::make_unique<Server>("0.0.0.0:13378");
+    auto executor = proxy_server->RegisterExecutor(new Executor(1));
+    auto proxy = proxy_server->RegisterProxy();
+    auto backend = proxy->AddBackend(client::CreateChannel("localhost:13377"));
+    proxy->AddRoute("", backend);
+    proxy->AddUnaryMethod("/nvrpc.testing.TestService/Unary");
+    executor->RegisterContexts(proxy, std::make_shared<TestResources>(1), 10);
+    proxy_server->AsyncStart();
+
+    auto stub = TestService::NewStub(client::CreateChannel("localhost:13378"));
+    auto& cancelled = PingPongUnaryCancelContext::s_CancelledWork;
+    cancelled = 0;
+
+    Input input;
+    Output output;
+    input.set_batch_id(1);
+
+    {
+        // the deadline is forwarded to the backend
+        ::grpc::ClientContext context;
+        context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(50));
+        auto status = stub->Unary(&context, input, &output);
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::DEADLINE_EXCEEDED);
+    }
+    {
+        // as is a cancellation
+        ::grpc::ClientContext context;
+        std::thread cancel([&context] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            context.TryCancel();
+        });
+        auto status = stub->Unary(&context, input, &output);
+        cancel.join();
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::CANCELLED);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(cancelled < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(cancelled, 2UL);
+    EXPECT_EQ(proxy->InFlight(backend), 0UL);
+
+    proxy_server->Shutdown();
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -0,0 +1,176 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/client/balancer.h"
+#include "nvrpc/client/retry.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+namespace nvrpc {
+namespace testing {
+
+// Stalls one response in twenty, at random, on an executor timer; counts executions
+class PingPongUnaryStallContext final : public Context<Input, Output, TestResources>
+{
+  public:
+    static constexpr int StallMs = 50;
+    static std::atomic<std::size_t> s_Executions;
+
+  private:
+    void ExecuteRPC(Input& input, Output& output) final override;
+};
+
+std::atomic<std::size_t> PingPongUnaryStallContext::s_Executions(0);
+
+void PingPongUnaryStallContext::ExecuteRPC(Input& input, Output& output)
+{
+    // a single executor thread; seeded so runs are repeatable
+    static std::minstd_rand random(13);
+    ++s_Executions;
+    output.set_batch_id(input.batch_id());
+    if(random() % 20)
+    {
+        FinishResponse();
+        return;
+    }
+    ArmTimer(std::chrono::milliseconds(StallMs), [this] { FinishResponse(); });
+}
+
+class RetryPolicyTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(RetryPolicyTest, Hedging)
+{
+    m_Server = BuildServer<PingPongUnaryStallContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    auto client = BuildUnaryClient();
+
+    using clock = std::chrono::steady_clock;
+    auto p99 = [&client](std::size_t count) {
+        std::vector<double> latencies;
+        for(std::size_t i = 0; i < count; i++)
+        {
+            auto start = clock::now();
+            auto status = client->Enqueue(Input(), [](Input&, Output&, ::grpc::Status& status) {
+                                    return status;
+                                }).get();
+            EXPECT_TRUE(status.ok());
+            latencies.push_back(
+                std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        return latencies[count * 99 / 100];
+    };
+
+    auto unhedged = p99(200);
+    EXPECT_GE(unhedged, PingPongUnaryStallContext::StallMs);
+
+    constexpr std::size_t count = 400;
+    client::RetryPolicy policy;
+    policy.max_attempts = 2;
+    policy.hedge_delay = std::chrono::milliseconds(5);
+    policy.budget = std::make_shared<client::RetryBudget>(0.1, 10);
+    client->SetRetryPolicy(policy);
+    PingPongUnaryStallContext::s_Executions = 0;
+    auto hedged = p99(count);
+    auto hedges = policy.budget->Withdrawn();
+    LOG(INFO) << "p99 ms; unhedged: " << unhedged << "; hedged: " << hedged << " with "
+              << hedges << " hedges for " << count << " calls";
+
+    EXPECT_LT(hedged, PingPongUnaryStallContext::StallMs / 2);
+    // one hedge per stall, bounded by the budget
+    EXPECT_GT(hedges, 0UL);
+    EXPECT_LE(hedges, 10 + count / 10);
+    EXPECT_LE(PingPongUnaryStallContext::s_Executions.load(), count + hedges);
+
+    m_Server->Shutdown();
+}
+
+TEST_F(RetryPolicyTest, Budget)
+{
+    m_Server = BuildServer<PingPongUnaryDelayContext<0>, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    constexpr std::size_t count = 100;
+    auto status_of = [](Input&, Output&, ::grpc::Status& status) { return status; };
+
+    // nothing listens on the second endpoint; round robin sends the first attempt of every
+    // call after the first there and the retry to the live endpoint, one retry per call
+    auto balancer =
+        std::make_shared<client::Balancer>(2, client::Balancer::Policy::RoundRobin);
+    balancer->SetEjection(0, std::chrono::milliseconds(0));
+    auto balanced = BuildBalancedUnaryClient({"localhost:13377", "localhost:1"}, balancer);
+    client::RetryPolicy policy;
+    policy.max_attempts = 2;
+    policy.budget = std::make_shared<client::RetryBudget>(1.0, 10);
+    balanced->SetRetryPolicy(policy);
+    for(std::size_t i = 0; i < count; i++)
+    {
+        EXPECT_TRUE(balanced->Enqueue(Input(), status_of).get().ok());
+    }
+    EXPECT_EQ(policy.budget->Withdrawn(), count - 1);
+
+    // during an outage the budget caps retries at ratio * calls + max_tokens
+    auto dead = BuildUnaryClient("localhost:1");
+    policy.max_attempts = 3;
+    policy.budget = std::make_shared<client::RetryBudget>(0.1, 5);
+    dead->SetRetryPolicy(policy);
+    for(std::size_t i = 0; i < count; i++)
+    {
+        auto status = dead->Enqueue(Input(), status_of).get();
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::UNAVAILABLE);
+    }
+    EXPECT_LE(policy.budget->Withdrawn(), 5 + count / 10);
+    EXPECT_GT(policy.budget->Refused(), 0UL);
+
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -0,0 +1,235 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/server.h"
+
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace nvrpc {
+namespace testing {
+
+// Answers a request with batch_id responses produced on the resources' thread pool; the stream
+// holds at most kWriteLimit responses, so a slow reader stalls the producer
+class PingPongStreamingBackpressureContext final
+    : public StreamingContext<Input, Output, TestResources>
+{
+  public:
+    static constexpr std::size_t kWriteLimit = 4;
+
+    PingPongStreamingBackpressureContext() { SetWriteLimit(kWriteLimit); }
+
+    static std::atomic<std::size_t> s_MaxOutstanding;
+    static std::atomic<std::size_t> s_WouldBlock;
+
+  private:
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override;
+};
+
+std::atomic<std::size_t> PingPongStreamingBackpressureContext::s_MaxOutstanding(0);
+std::atomic<std::size_t> PingPongStreamingBackpressureContext::s_WouldBlock(0);
+
+void PingPongStreamingBackpressureContext::RequestReceived(Input&& input,
+                                                           std::shared_ptr<ServerStream> stream)
+{
+    auto count = input.batch_id();
+    GetResources()->AcquireThreadPool().enqueue([stream, count] {
+        for(std::uint64_t i = 1; i <= count; i++)
+        {
+            Output output;
+            output.set_batch_id(i);
+            // output is only moved from if it was written
+            if(stream->TryWriteResponse(std::move(output)) == WriteResult::WouldBlock)
+            {
+                ++s_WouldBlock;
+                EXPECT_TRUE(stream->WriteResponse(std::move(output)));
+            }
+            auto outstanding = stream->OutstandingWrites();
+            auto max = s_MaxOutstanding.load();
+            while(outstanding > max && !s_MaxOutstanding.compare_exchange_weak(max, outstanding))
+            {
+            }
+        }
+    });
+}
+
+// Writes until the stream refuses a response while another task finishes the stream; the
+// client does not read, so the producer is blocked on the write limit when it is finished
+class PingPongStreamingFinishWhileBlockedContext final
+    : public StreamingContext<Input, Output, TestResources>
+{
+  public:
+    PingPongStreamingFinishWhileBlockedContext() { SetWriteLimit(2); }
+
+    static std::atomic<bool> s_Finished;
+    static std::atomic<bool> s_Stopped;
+
+  private:
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override;
+};
+
+std::atomic<bool> PingPongStreamingFinishWhileBlockedContext::s_Finished(false);
+std::atomic<bool> PingPongStreamingFinishWhileBlockedContext::s_Stopped(false);
+
+void PingPongStreamingFinishWhileBlockedContext::RequestReceived(
+    Input&& input, std::shared_ptr<ServerStream> stream)
+{
+    GetResources()->AcquireThreadPool().enqueue([stream] {
+        for(std::uint64_t i = 1; i < 1000000; i++)
+        {
+            Output output;
+            output.set_batch_id(i);
+            if(!stream->WriteResponse(std::move(output)))
+            {
+                break;
+            }
+        }
+        s_Stopped = true;
+    });
+    GetResources()->AcquireThreadPool().enqueue([stream] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        s_Finished = true;
+        stream->FinishStream();
+    });
+}
+
+class StreamingBackpressureTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(StreamingBackpressureTest, SlowReader)
+{
+    using Context = PingPongStreamingBackpressureContext;
+    m_Server = BuildServer<PingPongUnaryContext, Context>();
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    // keep the transport from absorbing the responses of a stalled reader
+    ::grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, 0);
+    args.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, 1024);
+    auto channel =
+        ::grpc::CreateCustomChannel("localhost:13377", ::grpc::InsecureChannelCredentials(), args);
+    auto stub = TestService::NewStub(channel);
+
+    constexpr std::uint64_t count = 20000;
+    constexpr std::uint64_t stalled = 50;
+    ::grpc::ClientContext context;
+    auto stream = stub->Streaming(&context);
+    Input input;
+    input.set_batch_id(count);
+    ASSERT_TRUE(stream->Write(input));
+    stream->WritesDone();
+
+    Output output;
+    std::uint64_t received = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto resumed = start;
+    while(stream->Read(&output))
+    {
+        EXPECT_EQ(output.batch_id(), ++received);
+        if(received < stalled)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        else if(received == stalled)
+        {
+            resumed = std::chrono::steady_clock::now();
+        }
+    }
+    auto finished = std::chrono::steady_clock::now();
+    EXPECT_TRUE(stream->Finish().ok());
+    EXPECT_EQ(received, count);
+
+    // the stalled producer picks up at full speed once the reader does
+    auto stalled_rate = stalled / std::chrono::duration<double>(resumed - start).count();
+    auto resumed_rate =
+        (count - stalled) / std::chrono::duration<double>(finished - resumed).count();
+    LOG(INFO) << "stalled: " << stalled_rate << " responses/s; resumed: " << resumed_rate;
+    EXPECT_GT(resumed_rate, 10 * stalled_rate);
+
+    LOG(INFO) << "max outstanding: " << Context::s_MaxOutstanding
+              << "; refused writes: " << Context::s_WouldBlock;
+    EXPECT_LE(Context::s_MaxOutstanding.load(), Context::kWriteLimit);
+    EXPECT_GT(Context::s_WouldBlock.load(), 0UL);
+}
+
+TEST_F(StreamingBackpressureTest, FinishReleasesBlockedWriter)
+{
+    using Context = PingPongStreamingFinishWhileBlockedContext;
+    m_Server = BuildServer<PingPongUnaryContext, Context>();
+    m_Server->AsyncStart();
+
+    ::grpc::ChannelArguments args;
+    args.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, 0);
+    args.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, 1024);
+    auto channel =
+        ::grpc::CreateCustomChannel("localhost:13377", ::grpc::InsecureChannelCredentials(), args);
+    auto stub = TestService::NewStub(channel);
+
+    ::grpc::ClientContext context;
+    auto stream = stub->Streaming(&context);
+    ASSERT_TRUE(stream->Write(Input()));
+    stream->WritesDone();
+
+    // nothing is read, so the queue stays full; finishing the stream must still release the
+    // producer instead of leaving it spinning on the full queue
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(!Context::s_Stopped && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(Context::s_Finished);
+    EXPECT_TRUE(Context::s_Stopped);
+
+    Output output;
+    while(stream->Read(&output))
+    {
+    }
+    EXPECT_TRUE(stream->Finish().ok());
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -0,0 +1,120 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_metrics.h"
+#include "test_pingpong.h"
+
+#include "tensorrt/laboratory/core/trace.h"
+
+#include "nvrpc/metrics.h"
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+namespace nvrpc {
+namespace testing {
+
+class TraceTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+static int CountOccurrences(const std::string& text, const std::string& pattern)
+{
+    int count = 0;
+    for(auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+TEST_F(TraceTest, SampledRequests)
+{
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    m_Server->AsyncStart();
+    MetricsServer metrics_server(0);
+
+    auto spans = [&metrics_server](const std::string& stage) {
+        auto trace = ScrapeMetrics(metrics_server.Port(), "/trace");
+        return CountOccurrences(trace, "{\"name\":\"" + stage + "\"");
+    };
+    auto rpcs = spans("rpc");
+    auto handlers = spans("handler");
+
+    ::trtlab::RequestTrace::SetSampleRate(1.0);
+    auto client = BuildUnaryClient();
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= 10; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+        futures.push_back(client->Enqueue(
+            std::move(input), [](Input&, Output&, ::grpc::Status& status) {}, headers));
+    }
+    for(auto& future : futures)
+    {
+        future.wait();
+    }
+
+    // the rpc span is recorded when the context is reset, which can trail the client callback
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(spans("rpc") < rpcs + 10 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ::trtlab::RequestTrace::SetSampleRate(0.0);
+
+    auto trace = ScrapeMetrics(metrics_server.Port(), "/trace");
+    EXPECT_EQ(trace.compare(0, 15, "{\"displayTimeUn"), 0);
+    EXPECT_EQ(CountOccurrences(trace, "{\"name\":\"rpc\""), rpcs + 10);
+    EXPECT_EQ(CountOccurrences(trace, "{\"name\":\"handler\""), handlers + 10);
+    EXPECT_GE(CountOccurrences(trace, "{\"name\":\"send\""), 10);
+
+    m_Server->Shutdown();
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -0,0 +1,114 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test_pingpong.h"
+
+#include "nvrpc/server.h"
+
+#include "test_build_client.h"
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace nvrpc {
+namespace testing {
+
+class UnixSocketTest : public ::testing::Test
+{
+    void SetUp() override {}
+
+    void TearDown() override
+    {
+        if(m_Server)
+        {
+            m_Server->Shutdown();
+            m_Server.reset();
+        }
+    }
+
+  protected:
+    std::unique_ptr<Server> m_Server;
+};
+
+TEST_F(UnixSocketTest, PingPong)
+{
+    auto path = "/tmp/nvrpc_test_" + std::to_string(getpid()) + ".sock";
+
+    // leave a socket behind as if a server had crashed
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    close(fd);
+
+    auto process_umask = umask(0);
+    umask(process_umask);
+    m_Server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>("unix:" + path);
+    m_Server->AsyncStart();
+    EXPECT_TRUE(m_Server->Running());
+
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    EXPECT_TRUE(S_ISSOCK(st.st_mode));
+    EXPECT_EQ(st.st_mode & 0777, 0660);
+    // the socket is bound under a narrower umask, which is then restored
+    EXPECT_EQ(umask(process_umask), process_umask);
+
+    // a live socket is not stale
+    Server second("unix://" + path);
+    EXPECT_THROW(second.AsyncStart(), std::runtime_error);
+
+    auto client = BuildUnaryClient(path);
+    std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+    for(int i = 1; i <= PINGPONG_SEND_COUNT; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        auto batch_id = client->Enqueue(
+            std::move(input),
+            [](Input& input, Output& output, ::grpc::Status& status) {
+                EXPECT_TRUE(status.ok());
+                return output.batch_id();
+            },
+            headers);
+        EXPECT_EQ(batch_id.get(), i);
+    }
+
+    m_Server->Shutdown();
+    EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+} // namespace testing
+} // namespace nvrpc
@@ -31,7 +31,9 @@
 
 namespace py = pybind11;
 
+#include <chrono>
 #include <future>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -40,6 +42,9 @@ namespace py = pybind11;
 
 #include "tensorrt/laboratory/bindings.h"
 #include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/memory/copy.h"
+#include "tensorrt/laboratory/core/response_cache.h"
+#include "tensorrt/laboratory/core/single_flight.h"
 #include "tensorrt/laboratory/core/thread_pool.h"
 #include "tensorrt/laboratory/infer_bench.h"
 #include "tensorrt/laboratory/infer_runner.h"
@@ -73,9 +78,14 @@ using nvrpc::Server;
 
 namespace trtis = ::nvidia::inferenceserver;
 
-void BasicInferService(std::shared_ptr<InferenceManager> resources, int port = 50052,
+class PyInferenceManager;
+
+void BasicInferService(std::shared_ptr<PyInferenceManager> resources, int port = 50052,
                        const std::string& max_recv_msg_size = "100MiB");
 
+using InferResponseCache = ResponseCache<::trtis::InferResponse>;
+using InferFlights = SingleFlight<::trtis::InferResponse>;
+
 class TrtisModel;
 class PyInferRunner;
 class PyInferRemoteRunner;
@@ -119,6 +129,54 @@ class PyInferenceManager final : public InferenceManager
         ForEachModel([&model_names](const Model& model) { model_names.push_back(model.Name()); });
         return model_names;
     }
+
+    // Opt-in; must be enabled before serving.  A ttl of 0 keeps responses until evicted.
+    void EnableResponseCache(const std::string& capacity, double ttl_seconds)
+    {
+        auto ttl = std::chrono::duration<double>(ttl_seconds);
+        m_ResponseCache = std::make_shared<InferResponseCache>(
+            StringToBytes(capacity),
+            std::chrono::duration_cast<InferResponseCache::duration>(ttl));
+    }
+
+    const std::shared_ptr<InferResponseCache>& GetResponseCache() const
+    {
+        return m_ResponseCache;
+    }
+
+    std::map<std::string, std::size_t> ResponseCacheStats() const
+    {
+        if(!m_ResponseCache)
+        {
+            return {};
+        }
+        auto stats = m_ResponseCache->GetStats();
+        return {{"hits", stats.hits},
+                {"misses", stats.misses},
+                {"evictions", stats.evictions},
+                {"expirations", stats.expirations},
+                {"entries", stats.entries},
+                {"bytes", stats.bytes}};
+    }
+
+    // Opt-in; must be enabled before serving.  Identical requests arriving while one is
+    // executing share its response instead of executing again.
+    void EnableRequestCoalescing() { m_Flights = std::make_shared<InferFlights>(); }
+
+    const std::shared_ptr<InferFlights>& GetFlights() const { return m_Flights; }
+
+    std::map<std::string, std::size_t> RequestCoalescingStats() const
+    {
+        if(!m_Flights)
+        {
+            return {};
+        }
+        return {{"executions", m_Flights->Executions()}, {"coalesced", m_Flights->Coalesced()}};
+    }
+
+  private:
+    std::shared_ptr<InferResponseCache> m_ResponseCache;
+    std::shared_ptr<InferFlights> m_Flights;
 };
 
 class PyRemoteInferenceManager
@@ -474,7 +532,7 @@ struct PyInferRunner : public InferRunner
                     auto host = bindings->HostAddress(id);
                     // TODO: enhance the Copy method for py::buffer_info objects
                     DLOG(INFO) << "Copying data from " << ptr << " to " << host << " " << size << "bytes";
-                    std::memcpy(host, ptr, size);
+                    ::trtlab::HostCopy(host, ptr, size);
                 }
             }
         }
@@ -594,54 +652,150 @@ class StatusContext final
 };
 
 class InferContext final
-    : public Context<::trtis::InferRequest, ::trtis::InferResponse, InferenceManager>
+    : public Context<::trtis::InferRequest, ::trtis::InferResponse, PyInferenceManager>
 {
+    // the request header selects the batch size and outputs, so it is part of the key
+    static ResponseCacheKey CacheKey(const RequestType& input)
+    {
+        // the inputs are digested where they are; only the small header is serialized
+        std::string header;
+        input.meta_data().SerializeToString(&header);
+        RequestDigest digest;
+        digest.Append(header.data(), header.size());
+        for(const auto& raw : input.raw_input())
+        {
+            digest.Append(raw.data(), raw.size());
+        }
+        return ResponseCacheKey{input.model_name(), input.version(), digest};
+    }
+
     void ExecuteRPC(RequestType& input, ResponseType& output) final override
     {
         // Executing on a Executor threads - we don't want to block message handling, so we offload
         GetResources()->AcquireThreadPool("pre").enqueue([this, &input, &output]() {
-            // Executed on a thread from CudaThreadPool
-            auto model = GetResources()->GetModel(input.model_name());
-            auto buffers = GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
-            auto bindings = buffers->CreateBindings(model);
-
-            // prepare input bindings - copy data from input
-            const auto& meta_data = input.meta_data();
-            bindings->SetBatchSize(meta_data.batch_size());
-            for(int input_idx = 0; input_idx < input.raw_input_size(); input_idx++)
+            // hashing the inputs is left to the pre thread pool as well; a hit needs no buffers
+            const auto& cache = GetResources()->GetResponseCache();
+            const auto& flights = GetResources()->GetFlights();
+            ResponseCacheKey key;
+            if(cache || flights)
             {
-                const auto& in = meta_data.input(input_idx);
-                auto binding_idx = model->BindingId(in.name());
-                const std::string& raw = input.raw_input(input_idx);
-                CHECK_EQ(raw.size(), bindings->BindingSize(binding_idx));
-                DLOG(INFO) << "Copying binding " << in.name() << " from raw_input " << input_idx
-                           << " to binding " << binding_idx;
-                std::memcpy(bindings->HostAddress(binding_idx), raw.c_str(), raw.size());
+                key = CacheKey(input);
             }
-            InferRunner runner(model, GetResources());
-            runner.Infer(bindings, [this, &input, &output](std::shared_ptr<Bindings>& bindings) {
-                // post processing function - write response
-                // for each output binding - write populate the response from data in bindings
-                const auto& input_meta_data = input.meta_data();
-                auto output_meta_data = output.mutable_meta_data();
-                output_meta_data->set_model_name(bindings->GetModel()->Name());
-                output_meta_data->set_batch_size(bindings->BatchSize());
-                for(int idx = 0; idx < input_meta_data.output_size(); idx++)
+            if(cache)
+            {
+                if(auto cached = cache->Find(key))
                 {
-                    const auto& out = input_meta_data.output(idx);
-                    auto binding_idx = bindings->GetModel()->BindingId(out.name());
-                    auto meta = output_meta_data->add_output();
-                    meta->set_name(out.name());
-                    output.add_raw_output(bindings->HostAddress(binding_idx),
-                                          bindings->BindingSize(binding_idx));
+                    output.CopyFrom(*cached);
+                    this->FinishResponse();
+                    return;
                 }
-                this->FinishResponse();
-            });
+            }
+            std::shared_ptr<InferFlights::Guard> flight;
+            if(flights)
+            {
+                // duplicates attach to the flight in progress and are answered when it lands;
+                // the leader's response is already in place
+                auto leader = std::make_shared<bool>(false);
+                auto joined = flights->Join(key, [this, &output, leader](
+                                                     const InferFlights::Result& result,
+                                                     std::exception_ptr exception) {
+                    if(exception)
+                    {
+                        this->CancelResponse();
+                        return;
+                    }
+                    if(!*leader)
+                    {
+                        output.CopyFrom(*result);
+                    }
+                    this->FinishResponse();
+                });
+                if(!joined)
+                {
+                    return;
+                }
+                *leader = true;
+                // travels with the post processing function; if a later stage drops it, the
+                // flight fails instead of holding the key forever
+                flight = std::make_shared<InferFlights::Guard>(*flights, key);
+            }
+
+            try
+            {
+                Infer(input, output, key, flight);
+            }
+            catch(...)
+            {
+                if(!flight)
+                {
+                    throw;
+                }
+                flight->Fail(std::current_exception());
+            }
+        });
+    }
+
+    void Infer(RequestType& input, ResponseType& output, ResponseCacheKey key,
+               std::shared_ptr<InferFlights::Guard> flight)
+    {
+        // Executed on a thread from CudaThreadPool
+        auto model = GetResources()->GetModel(input.model_name());
+        auto buffers = GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
+        auto bindings = buffers->CreateBindings(model);
+
+        // prepare input bindings - copy data from input
+        const auto& meta_data = input.meta_data();
+        bindings->SetBatchSize(meta_data.batch_size());
+        for(int input_idx = 0; input_idx < input.raw_input_size(); input_idx++)
+        {
+            const auto& in = meta_data.input(input_idx);
+            auto binding_idx = model->BindingId(in.name());
+            const std::string& raw = input.raw_input(input_idx);
+            CHECK_EQ(raw.size(), bindings->BindingSize(binding_idx));
+            DLOG(INFO) << "Copying binding " << in.name() << " from raw_input " << input_idx
+                       << " to binding " << binding_idx;
+            ::trtlab::HostCopy(bindings->HostAddress(binding_idx), raw.c_str(), raw.size());
+        }
+        InferRunner runner(model, GetResources());
+        runner.Infer(bindings, [this, &input, &output, key = std::move(key),
+                                flight = std::move(flight)](std::shared_ptr<Bindings>& bindings) {
+            // post processing function - write response
+            // for each output binding - write populate the response from data in bindings
+            const auto& input_meta_data = input.meta_data();
+            auto output_meta_data = output.mutable_meta_data();
+            output_meta_data->set_model_name(bindings->GetModel()->Name());
+            output_meta_data->set_batch_size(bindings->BatchSize());
+            for(int idx = 0; idx < input_meta_data.output_size(); idx++)
+            {
+                const auto& out = input_meta_data.output(idx);
+                auto binding_idx = bindings->GetModel()->BindingId(out.name());
+                auto meta = output_meta_data->add_output();
+                meta->set_name(out.name());
+                output.add_raw_output(bindings->HostAddress(binding_idx),
+                                      bindings->BindingSize(binding_idx));
+            }
+            const auto& cache = GetResources()->GetResponseCache();
+            std::shared_ptr<const ResponseType> shared;
+            if(cache || flight)
+            {
+                shared = std::make_shared<const ResponseType>(output);
+            }
+            if(cache)
+            {
+                cache->Insert(key, shared, shared->ByteSizeLong());
+            }
+            if(flight)
+            {
+                // answers the leader and every duplicate
+                flight->Complete(shared);
+                return;
+            }
+            this->FinishResponse();
         });
     }
 };
 
-void BasicInferService(std::shared_ptr<InferenceManager> resources, int port,
+void BasicInferService(std::shared_ptr<PyInferenceManager> resources, int port,
                        const std::string& max_recv_msg_size)
 {
     // registerAllTensorRTPlugins();
@@ -691,6 +845,11 @@ PYBIND11_MODULE(trtlab, m)
         .def("infer_runner", &PyInferenceManager::InferRunner)
         .def("get_model", &PyInferenceManager::GetModel)
         .def("get_models", &PyInferenceManager::Models)
+        .def("enable_response_cache", &PyInferenceManager::EnableResponseCache,
+             py::arg("capacity") = "64MiB", py::arg("ttl_seconds") = 0.0)
+        .def("response_cache_stats", &PyInferenceManager::ResponseCacheStats)
+        .def("enable_request_coalescing", &PyInferenceManager::EnableRequestCoalescing)
+        .def("request_coalescing_stats", &PyInferenceManager::RequestCoalescingStats)
         .def("serve", &PyInferenceManager::Serve, py::arg("port") = 50052);
     // py::call_guard<py::gil_scoped_release>());
 
@@ -78,17 +78,21 @@ class FixedBuffers : public Buffers
         : m_HostStack(std::make_unique<MemoryStack<HostMemoryType>>(host_size)),
           m_DeviceStack(std::make_unique<MemoryStack<DeviceMemoryType>>(device_size)), Buffers()
     {
+        // aggregated over all FixedBuffers; the utilization at Reset sizes the stacks
+        m_HostStack->TrackUsage("FixedBuffers/HostStack");
+        m_DeviceStack->TrackUsage("FixedBuffers/DeviceStack");
     }
 
     ~FixedBuffers() override {}
 
   protected:
     template<typename MemoryType>
-    class BufferStackDescriptor final : public Descriptor<MemoryType>
+    class BufferStackDescriptor final : public Descriptor<MemoryType>,
+                                        public PooledStorage<BufferStackDescriptor<MemoryType>>
     {
       public:
         BufferStackDescriptor(void* ptr, size_t size)
-            : Descriptor<MemoryType>(ptr, size, MemoryType::Type() + "Desc")
+            : Descriptor<MemoryType>(ptr, size, "FixedBuffers")
         {
         }
         ~BufferStackDescriptor() final override {}
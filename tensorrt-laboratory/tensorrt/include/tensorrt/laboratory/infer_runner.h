@@ -28,6 +28,8 @@
 
 #include "tensorrt/laboratory/bindings.h"
 #include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/trace.h"
+#include "tensorrt/laboratory/cuda/stream_trace.h"
 #include "tensorrt/laboratory/inference_manager.h"
 #include "tensorrt/laboratory/model.h"
 
@@ -70,33 +72,83 @@ struct InferRunner : public AsyncComputeWrapper<void(std::shared_ptr<Bindings>&)
         return future.share();
     }
 
+    /**
+     * @brief Infer variants returning an AsyncFuture
+     *
+     * The AsyncFuture is completed on the "post" thread pool; continuations can be chained
+     * with then() instead of parking a thread on a std::shared_future.
+     */
+    template<typename Post>
+    auto InferAsync(PreFn pre, Post post)
+    {
+        auto compute = WrapAsync(post);
+        auto future = compute->Future();
+        Enqueue(pre, compute);
+        return future;
+    }
+
+    template<typename Post>
+    auto InferAsync(std::shared_ptr<Bindings> bindings, Post post)
+    {
+        auto compute = WrapAsync(post);
+        auto future = compute->Future();
+        Enqueue(bindings, compute);
+        return future;
+    }
+
   protected:
-    template<typename T>
-    void Enqueue(PreFn Pre, std::shared_ptr<AsyncCompute<T>> Post)
+    // Sampled requests (RequestTrace::Current() on the calling thread) carry their trace
+    // through the pre, cuda and post pools, recording the queue waits and every stage
+    template<typename T, template<typename> class P>
+    void Enqueue(PreFn Pre, std::shared_ptr<AsyncCompute<T, P>> Post)
     {
-        Workers("pre").enqueue([this, Pre, Post]() mutable {
+        auto trace = RequestTrace::Current();
+        auto queued = RequestTrace::Stamp(trace);
+        Workers("pre").enqueue([this, Pre, Post, trace, queued]() mutable {
+            TraceScope scope(trace);
+            RequestTrace::RecordSince(trace, "pre_queue", queued);
             auto bindings = InitializeBindings();
-            Pre(*bindings);
+            {
+                TraceSpan span("pre");
+                Pre(*bindings);
+            }
             Enqueue(bindings, Post);
         });
     }
 
-    template<typename T>
-    void Enqueue(std::shared_ptr<Bindings> bindings, std::shared_ptr<AsyncCompute<T>> Post)
+    template<typename T, template<typename> class P>
+    void Enqueue(std::shared_ptr<Bindings> bindings, std::shared_ptr<AsyncCompute<T, P>> Post)
     {
-        Workers("cuda").enqueue([this, bindings, Post]() mutable {
+        auto trace = RequestTrace::Current();
+        auto queued = RequestTrace::Stamp(trace);
+        Workers("cuda").enqueue([this, bindings, Post, trace, queued]() mutable {
+            TraceScope scope(trace);
+            RequestTrace::RecordSince(trace, "cuda_queue", queued);
+            StreamTrace stream(trace, bindings->Stream());
             DLOG(INFO) << "H2D";
             bindings->CopyToDevice(bindings->InputBindings());
+            stream.Mark("h2d");
             DLOG(INFO) << "Compute";
-            auto trt_ctx = Compute(bindings);
+            auto trt_ctx = Compute(bindings, &stream);
             bindings->CopyFromDevice(bindings->OutputBindings());
-            Workers("post").enqueue([this, bindings, trt_ctx, Post]() mutable {
-                trt_ctx->Synchronize();
-                trt_ctx.reset();
-                DLOG(INFO) << "Sync TRT";
-                bindings->Synchronize();
-                DLOG(INFO) << "Sync D2H";
-                (*Post)(bindings);
+            stream.Mark("d2h");
+            stream.Finish();
+            queued = RequestTrace::Stamp(trace);
+            Workers("post").enqueue([this, bindings, trt_ctx, Post, trace, queued]() mutable {
+                TraceScope scope(trace);
+                RequestTrace::RecordSince(trace, "post_queue", queued);
+                {
+                    TraceSpan span("sync");
+                    trt_ctx->Synchronize();
+                    trt_ctx.reset();
+                    DLOG(INFO) << "Sync TRT";
+                    bindings->Synchronize();
+                    DLOG(INFO) << "Sync D2H";
+                }
+                {
+                    TraceSpan span("post");
+                    (*Post)(bindings);
+                }
                 bindings.reset();
                 DLOG(INFO) << "Execute Finished";
             });
@@ -109,10 +161,17 @@ struct InferRunner : public AsyncComputeWrapper<void(std::shared_ptr<Bindings>&)
         return buffers->CreateBindings(m_Model);
     }
 
-    auto Compute(BindingsHandle& bindings) -> std::shared_ptr<ExecutionContext>
+    /**
+     * @brief Acquire an ExecutionContext and launch; the optional StreamTrace marks the device
+     * idle time spent waiting on the acquisition as "launch" and the inference as "compute"
+     */
+    auto Compute(BindingsHandle& bindings, StreamTrace* stream = nullptr)
+        -> std::shared_ptr<ExecutionContext>
     {
         auto trt_ctx = m_Resources->GetExecutionContext(bindings->GetModel());
+        if(stream) stream->Mark("launch");
         trt_ctx->Infer(bindings);
+        if(stream) stream->Mark("compute");
         return trt_ctx;
     }
 
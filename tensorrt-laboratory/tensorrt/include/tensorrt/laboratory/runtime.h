@@ -34,6 +34,7 @@
 
 #include "tensorrt/laboratory/allocator.h"
 #include "tensorrt/laboratory/common.h"
+#include "tensorrt/laboratory/core/memory/mapped_file.h"
 #include "tensorrt/laboratory/model.h"
 
 namespace trtlab {
@@ -65,7 +66,7 @@ class Runtime : public std::enable_shared_from_this<Runtime>
     Runtime();
 
     ::nvinfer1::IRuntime& NvRuntime() const;
-    std::vector<char> ReadEngineFile(const std::string&) const;
+    DescriptorHandle<MappedFile> MapEngineFile(const std::string&) const;
 
   private:
     class Logger : public ::nvinfer1::ILogger
@@ -28,12 +28,14 @@
 
 #include <glog/logging.h>
 
+#include "tensorrt/laboratory/core/trace.h"
 #include "tensorrt/laboratory/cuda/device_info.h"
 #include "tensorrt/laboratory/cuda/memory/cuda_device.h"
 #include "tensorrt/laboratory/cuda/memory/cuda_pinned_host.h"
 
 using trtlab::CudaDeviceMemory;
 using trtlab::CudaPinnedHostMemory;
+using trtlab::TraceSpan;
 
 namespace trtlab {
 namespace TensorRT {
@@ -232,6 +234,7 @@ auto InferenceManager::GetModel(std::string model_name) -> std::shared_ptr<Model
 auto InferenceManager::GetBuffers() -> std::shared_ptr<Buffers>
 {
     CHECK(m_Buffers) << "Call AllocateResources() before trying to acquire a Buffers object.";
+    TraceSpan span("buffers");
     return m_Buffers->Pop([](Buffers* ptr) {
         ptr->Reset();
         DLOG(INFO) << "Releasing Buffers";
@@ -258,6 +261,7 @@ auto InferenceManager::GetExecutionContext(const Model* model) -> std::shared_pt
     auto item = m_ModelExecutionContexts.find(model);
     CHECK(item != m_ModelExecutionContexts.end())
         << "No ExectionContext for model " << model->Name();
+    TraceSpan span("execution_context");
     // This is the global concurrency limiter - it owns the activation scratch memory
     auto ctx = m_ExecutionContexts->Pop([](ExecutionContext* ptr) {
         ptr->Reset();
@@ -51,16 +51,16 @@ Runtime::~Runtime() { DLOG(INFO) << "Destorying Runtime " << this; }
 std::shared_ptr<Model> Runtime::DeserializeEngine(const std::string& plan_file)
 {
     DLOG(INFO) << "Deserializing TensorRT ICudaEngine from file: " << plan_file;
-    const auto& buffer = ReadEngineFile(plan_file);
-    return DeserializeEngine(buffer.data(), buffer.size(), nullptr);
+    auto mapped = MapEngineFile(plan_file);
+    return DeserializeEngine(mapped->Data(), mapped->Size(), nullptr);
 }
 
 std::shared_ptr<Model> Runtime::DeserializeEngine(const std::string& plan_file,
                                                   ::nvinfer1::IPluginFactory* plugin_factory)
 {
     DLOG(INFO) << "Deserializing TensorRT ICudaEngine from file: " << plan_file;
-    const auto& buffer = ReadEngineFile(plan_file);
-    return DeserializeEngine(buffer.data(), buffer.size(), plugin_factory);
+    auto mapped = MapEngineFile(plan_file);
+    return DeserializeEngine(mapped->Data(), mapped->Size(), plugin_factory);
 }
 
 std::shared_ptr<Model> Runtime::DeserializeEngine(const void* data, size_t size)
@@ -68,15 +68,11 @@ std::shared_ptr<Model> Runtime::DeserializeEngine(const void* data, size_t size)
     return DeserializeEngine(data, size, nullptr);
 }
 
-std::vector<char> Runtime::ReadEngineFile(const std::string& plan_file) const
+DescriptorHandle<MappedFile> Runtime::MapEngineFile(const std::string& plan_file) const
 {
-    DLOG(INFO) << "Reading Engine: " << plan_file;
-    std::ifstream file(plan_file, std::ios::binary | std::ios::ate);
-    std::streamsize size = file.tellg();
-    std::vector<char> buffer(size);
-    file.seekg(0, std::ios::beg);
-    CHECK(file.read(buffer.data(), size)) << "Unable to read engine file: " << plan_file;
-    return buffer;
+    DLOG(INFO) << "Mapping Engine: " << plan_file;
+    // the plan is consumed front to back once; populate so deserialization never faults
+    return MappedFile::Open(plan_file, true);
 }
 
 Runtime::Logger::~Logger() { DLOG(INFO) << "Destroying Logger"; }